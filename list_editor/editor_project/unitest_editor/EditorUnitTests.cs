@@ -362,4 +362,12 @@ public class Tests
         Assert.That(runtimeData.DriverAllowList[1].Soc, Is.EqualTo("Chipz2000"));
         Assert.That(runtimeData.DriverAllowList[1].DriverFingerprint, Is.EqualTo("OpenGL ES 3.2 V@0615.80 (GIT@406382a20f, I986008d073, 1704447428) (Date:01/05/24)"));
     }
+
+    [Test]
+    public void ChecksumTest()
+    {
+        byte[] checkBytes = System.Text.Encoding.ASCII.GetBytes("123456789");
+        Assert.That(RuntimeDataExporter.Crc32c(checkBytes), Is.EqualTo(0xE3069283U));
+        Assert.That(RuntimeDataExporter.Crc32c(ReadOnlySpan<byte>.Empty), Is.EqualTo(0U));
+    }
 }
@@ -19,19 +19,20 @@ namespace vkqlisteditor.editor;
 
 public class DeviceListExport
 {
-    private readonly SortedList<string, DeviceAllowListRecord> _deviceTableSorted = new(new DeviceStringSorter());
+    private readonly SortedList<(string Brand, string Device), DeviceAllowListRecord> _deviceTableSorted =
+        new(new RuntimeDeviceSorter());
 
     public void AddDeviceToTable(DeviceAllowListRecord device)
     {
         // Use Brand+Device for a key
-        var key = $"{device.Brand},{device.Device}";
+        var key = (device.Brand, device.Device);
         _deviceTableSorted.TryAdd(key, device);
     }
 
     public int GetDeviceIndex(DeviceAllowListRecord device)
     {
         // Use Brand+Device for a key
-        var key = $"{device.Brand},{device.Device}";
+        var key = (device.Brand, device.Device);
         if (_deviceTableSorted.ContainsKey(key))
         {
             return _deviceTableSorted.IndexOfKey(key);
@@ -70,6 +71,100 @@ public class DeviceListExport
         return exportDeviceCount;
     }
 
+    public int CalculateShortcutTableSize()
+    {
+        // 27 x uint32, A-Z and everything else
+        return RuntimeDeviceSorter.ShortcutCount * 4;
+    }
+
+    // Each entry is the index of the first device in its brand bucket, empty
+    // buckets point at the next bucket start
+    public void ExportShortcutTable(Span<byte> tableBuffer)
+    {
+        var shortcutTable = MemoryMarshal.Cast<byte, uint>(tableBuffer);
+        int nextShortcut = 0;
+        uint deviceIndex = 0;
+        foreach (var currentDevice in _deviceTableSorted)
+        {
+            var deviceShortcut = RuntimeDeviceSorter.GetShortcutIndex(currentDevice.Key.Brand);
+            while (nextShortcut <= deviceShortcut)
+            {
+                shortcutTable[nextShortcut++] = deviceIndex;
+            }
+            ++deviceIndex;
+        }
+
+        while (nextShortcut < RuntimeDeviceSorter.ShortcutCount)
+        {
+            shortcutTable[nextShortcut++] = deviceIndex;
+        }
+    }
+
+    public int CalculateBrandIndexSize(StringTable stringTable)
+    {
+        // vkquality_file_format.h VkQualityBrandIndexHeader, 2 x uint32
+        // then a VkQualityBrandIndexEntry (3 x uint32) per brand and a uint32 per device
+        return 8 + (BuildBrandIndex(stringTable).Count * 12) + (_deviceTableSorted.Count * 4);
+    }
+
+    // Brands in strcmp order of their exported string, and for each brand the
+    // device table indices in strcmp order of the exported device string
+    public void ExportBrandIndex(Span<byte> tableBuffer, StringTable stringTable)
+    {
+        var brandIndex = BuildBrandIndex(stringTable);
+        var indexTable = MemoryMarshal.Cast<byte, uint>(tableBuffer);
+        indexTable[0] = (uint) brandIndex.Count; // brand_count
+        indexTable[1] = (uint) _deviceTableSorted.Count; // device_index_count
+        var entryOffset = 2;
+        var deviceOffset = 2 + (brandIndex.Count * 3);
+        var deviceIndexStart = 0;
+        foreach (var (brandStringIndex, deviceIndices) in brandIndex)
+        {
+            indexTable[entryOffset] = (uint) brandStringIndex;
+            indexTable[entryOffset + 1] = (uint) deviceIndexStart;
+            indexTable[entryOffset + 2] = (uint) deviceIndices.Count;
+            entryOffset += 3;
+            foreach (var deviceIndex in deviceIndices)
+            {
+                indexTable[deviceOffset++] = (uint) deviceIndex;
+            }
+            deviceIndexStart += deviceIndices.Count;
+        }
+    }
+
+    private List<(int BrandStringIndex, List<int> DeviceIndices)> BuildBrandIndex(StringTable stringTable)
+    {
+        // Group by string index, the string table merges brands that only differ by case
+        var brandDevices = new Dictionary<int, List<int>>();
+        var deviceIndex = 0;
+        foreach (var currentDevice in _deviceTableSorted)
+        {
+            var brandStringIndex = stringTable.GetStringIndex(currentDevice.Key.Brand);
+            if (!brandDevices.TryGetValue(brandStringIndex, out var deviceIndices))
+            {
+                deviceIndices = new List<int>();
+                brandDevices.Add(brandStringIndex, deviceIndices);
+            }
+            deviceIndices.Add(deviceIndex++);
+        }
+
+        var deviceKeys = _deviceTableSorted.Keys;
+        var brandIndex = new List<(int BrandStringIndex, List<int> DeviceIndices)>();
+        foreach (var (brandStringIndex, deviceIndices) in brandDevices)
+        {
+            // OrderBy is a stable sort, so equal device strings stay in device table order
+            var sortedIndices = deviceIndices.OrderBy(
+                index => stringTable.GetExportedString(deviceKeys[index].Device),
+                Comparer<string>.Create(RuntimeDeviceSorter.CompareOrdinal)).ToList();
+            brandIndex.Add((brandStringIndex, sortedIndices));
+        }
+
+        brandIndex.Sort((a, b) => RuntimeDeviceSorter.CompareOrdinal(
+            stringTable.GetExportedString(deviceKeys[a.DeviceIndices[0]].Brand),
+            stringTable.GetExportedString(deviceKeys[b.DeviceIndices[0]].Brand)));
+        return brandIndex;
+    }
+
     public uint GetCount()
     {
         return (uint) _deviceTableSorted.Count;
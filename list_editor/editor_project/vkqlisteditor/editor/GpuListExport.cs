@@ -64,6 +64,42 @@ public class GpuListExport
         return exportDeviceCount;
     }
 
+    public int CalculateGpuColumnsSize()
+    {
+        // vkquality_file_format.h VkQualityGpuColumnsHeader, 4 x uint32
+        // then 5 columns of uint32, padded to a multiple of 4 entries
+        return 16 + (GetColumnStride() * 5 * 4);
+    }
+
+    // Same entries as ExportDeviceTable, as struct-of-arrays columns
+    public void ExportGpuColumns(Span<byte> tableBuffer, StringTable stringTable)
+    {
+        var columnTable = MemoryMarshal.Cast<byte, uint>(tableBuffer);
+        var columnStride = GetColumnStride();
+        columnTable[0] = (uint) _gpuTableSorted.Count; // entry_count
+        columnTable[1] = (uint) columnStride; // column_stride
+        columnTable[2] = 0; // reserved
+        columnTable[3] = 0; // reserved
+        var columns = columnTable.Slice(4);
+        var entryIndex = 0;
+        foreach (var currentGpu in _gpuTableSorted)
+        {
+            var nameIndex = stringTable.GetStringIndex(currentGpu.Value.DeviceName);
+            if (nameIndex < 0) continue;
+            columns[entryIndex] = (uint) nameIndex;
+            columns[columnStride + entryIndex] = (uint) currentGpu.Value.MinApi;
+            columns[(columnStride * 2) + entryIndex] = currentGpu.Value.DeviceId;
+            columns[(columnStride * 3) + entryIndex] = currentGpu.Value.VendorId;
+            columns[(columnStride * 4) + entryIndex] = currentGpu.Value.DriverVersion;
+            ++entryIndex;
+        }
+    }
+
+    private int GetColumnStride()
+    {
+        return (_gpuTableSorted.Count + 3) & ~3;
+    }
+
     public uint GetCount()
     {
         return (uint) _gpuTableSorted.Count;
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+using System.Numerics;
 using System.Runtime.InteropServices;
 
 namespace vkqlisteditor.editor;
@@ -21,14 +22,28 @@ namespace vkqlisteditor.editor;
 public static class RuntimeDataExporter
 {
     private const int FileHeaderSizeBytes = (22 * 4);
-    private const int ShortcutTableSizeBytes = (27 * 4);
+    // vkquality_file_format.h VkQualityFileSectionTable, then 4 x uint32 VkQualityFileSectionEntry
+    private const int SectionTableHeaderSizeBytes = (2 * 4);
+    private const int SectionEntrySizeBytes = (4 * 4);
+    private const uint SectionTableIdentifier = 0x564b5153;
+    private const uint SectionIdBrandIndex = 1;
+    private const uint SectionIdGpuAllowColumns = 2;
+    private const uint SectionIdGpuDenyColumns = 3;
+    private const uint SectionIdChecksum = 5;
+    // vkquality_file_format.h VkQualityChecksumSection, 4 x uint32
+    private const int ChecksumSectionSizeBytes = (4 * 4);
+    private const uint ChecksumCrc32c = 1;
     private const uint FileIdentifier = 0x564b5141;
-    private const uint FileFormatVersion = 0x010200;
+    private const uint FileFormatVersion = 0x010400;
     private const uint MinimumLibraryVersion = 0x010200;
 
     private struct RuntimeFileSizes
     {
         public int HeaderSize = 0;
+        public int SectionTableSize = 0;
+        public int BrandIndexSize = 0;
+        public int GpuAllowColumnsSize = 0;
+        public int GpuDenyColumnsSize = 0;
         public int DeviceListSize = 0;
         public int DriverAllowListSize = 0;
         public int DriverDenyListSize = 0;
@@ -38,6 +53,7 @@ public static class RuntimeDataExporter
         public int SocAllowListSize = 0;
         public int SocDenyListSize = 0;
         public int StringTableSize = 0;
+        public int ChecksumSize = 0;
         public int TotalSize = 0;
 
         public RuntimeFileSizes()
@@ -74,8 +90,34 @@ public static class RuntimeDataExporter
         var headerSpan = fileSpan.Slice(0, currentBufferOffset);
         var fileHeader = MemoryMarshal.Cast<byte, uint>(headerSpan);
 
+        // The section table immediately follows the header
+        var sectionTableSpan = fileSpan.Slice(currentBufferOffset, fileSizes.SectionTableSize);
+        var sectionTable = MemoryMarshal.Cast<byte, uint>(sectionTableSpan);
+        currentBufferOffset += fileSizes.SectionTableSize;
+        var sectionEntries = new List<(uint Id, uint Offset, int Size)>();
+
+        // GPU column sections must start on a 16 byte boundary. The header, section table
+        // and column sections are all multiples of 16 bytes, so place them first.
+        if (gpuAllowTable.GetCount() > 0)
+        {
+            var gpuAllowColumnsSpan = fileSpan.Slice(currentBufferOffset, fileSizes.GpuAllowColumnsSize);
+            gpuAllowTable.ExportGpuColumns(gpuAllowColumnsSpan, stringTable);
+            sectionEntries.Add((SectionIdGpuAllowColumns, (uint) currentBufferOffset,
+                fileSizes.GpuAllowColumnsSize));
+            currentBufferOffset += fileSizes.GpuAllowColumnsSize;
+        }
+
+        if (gpuDenyTable.GetCount() > 0)
+        {
+            var gpuDenyColumnsSpan = fileSpan.Slice(currentBufferOffset, fileSizes.GpuDenyColumnsSize);
+            gpuDenyTable.ExportGpuColumns(gpuDenyColumnsSpan, stringTable);
+            sectionEntries.Add((SectionIdGpuDenyColumns, (uint) currentBufferOffset,
+                fileSizes.GpuDenyColumnsSize));
+            currentBufferOffset += fileSizes.GpuDenyColumnsSize;
+        }
+
         var stringTableSpan = fileSpan.Slice(currentBufferOffset, fileSizes.StringTableSize);
-        stringTable.ExportStringTable(stringTableSpan, FileHeaderSizeBytes);
+        stringTable.ExportStringTable(stringTableSpan, (uint) currentBufferOffset);
         var stringTableOffset = (uint) currentBufferOffset;
         currentBufferOffset += fileSizes.StringTableSize;
 
@@ -84,10 +126,16 @@ public static class RuntimeDataExporter
         var deviceListOffset = (uint) currentBufferOffset;
         currentBufferOffset += fileSizes.DeviceListSize;
 
-        // TODO: this is currently initialized to 0 (start index), is a future optimization
+        var deviceListShortcutsSpan = fileSpan.Slice(currentBufferOffset, fileSizes.ShortcutListSize);
+        deviceTable.ExportShortcutTable(deviceListShortcutsSpan);
         var deviceListShortcutsOffset = (uint) currentBufferOffset;
         currentBufferOffset += fileSizes.ShortcutListSize;
 
+        var brandIndexSpan = fileSpan.Slice(currentBufferOffset, fileSizes.BrandIndexSize);
+        deviceTable.ExportBrandIndex(brandIndexSpan, stringTable);
+        sectionEntries.Add((SectionIdBrandIndex, (uint) currentBufferOffset, fileSizes.BrandIndexSize));
+        currentBufferOffset += fileSizes.BrandIndexSize;
+
         if (gpuAllowTable.GetCount() > 0)
         {
             var gpuAllowTableSpan = fileSpan.Slice(currentBufferOffset, fileSizes.GpuAllowListSize);
@@ -125,8 +173,13 @@ public static class RuntimeDataExporter
             var driverDenyTableSpan = fileSpan.Slice(currentBufferOffset, fileSizes.DriverDenyListSize);
             driverDenyTable.ExportFingerprintTable(driverDenyTableSpan, stringTable);
             driverDenyListOffset = (uint) currentBufferOffset;
+            currentBufferOffset += fileSizes.DriverDenyListSize;
         }
-        
+
+        // The checksum is computed once the rest of the file is written
+        var checksumOffset = currentBufferOffset;
+        sectionEntries.Add((SectionIdChecksum, (uint) checksumOffset, fileSizes.ChecksumSize));
+
         // Populate header information
         // vkquality_file_format.h - VkQualityFileHeader
         fileHeader[0] = FileIdentifier; // file_identifier
@@ -151,7 +204,30 @@ public static class RuntimeDataExporter
         fileHeader[19] = socAllowListOffset; // soc_allow_offset
         fileHeader[20] = socDenyListOffset; // soc_deny_offset
         fileHeader[21] = stringTableOffset; // string_table_offset
-        
+
+        // vkquality_file_format.h - VkQualityFileSectionTable, VkQualityFileSectionEntry
+        sectionTable[0] = SectionTableIdentifier; // section_table_identifier
+        sectionTable[1] = (uint) sectionEntries.Count; // section_count
+        var sectionOffset = 2;
+        foreach (var (sectionId, offset, size) in sectionEntries)
+        {
+            sectionTable[sectionOffset] = sectionId; // section_id
+            sectionTable[sectionOffset + 1] = offset; // section_offset
+            sectionTable[sectionOffset + 2] = (uint) size; // section_size
+            sectionTable[sectionOffset + 3] = 0; // section_flags
+            sectionOffset += 4;
+        }
+
+        // vkquality_file_format.h - VkQualityChecksumSection, the checksum covers the
+        // whole file with the checksum field read as zero
+        var checksumSection = MemoryMarshal.Cast<byte, uint>(
+            fileSpan.Slice(checksumOffset, fileSizes.ChecksumSize));
+        checksumSection[0] = ChecksumCrc32c; // algorithm
+        checksumSection[1] = 0; // checksum
+        checksumSection[2] = (uint) fileSizes.TotalSize; // file_size
+        checksumSection[3] = 0; // reserved
+        checksumSection[1] = Crc32c(fileBuffer);
+
         using var exportStream = new FileStream(exportPath, FileMode.Create);
         exportStream.Write(fileBuffer);
 
@@ -164,20 +240,48 @@ public static class RuntimeDataExporter
         ref RuntimeFileSizes fileSizes)
     {
         fileSizes.HeaderSize = FileHeaderSizeBytes;
+        // Brand index and checksum
+        var sectionCount = 2;
+        fileSizes.BrandIndexSize = deviceTable.CalculateBrandIndexSize(stringTable);
+        if (gpuAllowTable.GetCount() > 0)
+        {
+            fileSizes.GpuAllowColumnsSize = gpuAllowTable.CalculateGpuColumnsSize();
+            ++sectionCount;
+        }
+        if (gpuDenyTable.GetCount() > 0)
+        {
+            fileSizes.GpuDenyColumnsSize = gpuDenyTable.CalculateGpuColumnsSize();
+            ++sectionCount;
+        }
+        fileSizes.SectionTableSize = SectionTableHeaderSizeBytes + (sectionCount * SectionEntrySizeBytes);
         fileSizes.DeviceListSize = deviceTable.CalculateDeviceTableSize();
         fileSizes.DriverAllowListSize = driverAllowTable.GetFingerprintTableSize();
         fileSizes.DriverDenyListSize = driverDenyTable.GetFingerprintTableSize();
         fileSizes.GpuAllowListSize = gpuAllowTable.CalculateGpuTableSize();
         fileSizes.GpuDenyListSize = gpuDenyTable.CalculateGpuTableSize();
-        fileSizes.ShortcutListSize = ShortcutTableSizeBytes;
+        fileSizes.ShortcutListSize = deviceTable.CalculateShortcutTableSize();
         fileSizes.SocAllowListSize = driverAllowTable.GetSocTableSize();
         fileSizes.SocDenyListSize = driverDenyTable.GetSocTableSize();
         fileSizes.StringTableSize = stringTable.CalculateStringTableSize();
-        fileSizes.TotalSize = fileSizes.HeaderSize + fileSizes.DeviceListSize + fileSizes.DriverAllowListSize
+        fileSizes.ChecksumSize = ChecksumSectionSizeBytes;
+        fileSizes.TotalSize = fileSizes.HeaderSize + fileSizes.SectionTableSize
+                              + fileSizes.BrandIndexSize + fileSizes.GpuAllowColumnsSize
+                              + fileSizes.GpuDenyColumnsSize + fileSizes.DeviceListSize + fileSizes.DriverAllowListSize
                               + fileSizes.DriverDenyListSize + fileSizes.SocAllowListSize
                               + fileSizes.SocDenyListSize + fileSizes.GpuAllowListSize
                               + fileSizes.GpuDenyListSize + fileSizes.ShortcutListSize 
-                              + fileSizes.StringTableSize;
+                              + fileSizes.StringTableSize + fileSizes.ChecksumSize;
+    }
+
+    // CRC-32C (Castagnoli), matching VkQualityChecksum::Crc32c in the runtime library
+    public static uint Crc32c(ReadOnlySpan<byte> data)
+    {
+        uint crc = 0xFFFFFFFF;
+        foreach (var dataByte in data)
+        {
+            crc = BitOperations.Crc32C(crc, dataByte);
+        }
+        return ~crc;
     }
 
     private static StringTable GenerateStringTable(RuntimeData runtimeData)
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+using System.Collections;
+using System.Text;
+
+namespace vkqlisteditor.editor;
+
+// Sorts the exported device list to match the device search in
+// vkquality_prediction_file.cpp:
+// Brand shortcut bucket, A-Z by first letter then everything else
+// Brand, then device, comparing UTF-8 bytes with ASCII letters folded to upper case
+// The runtime stops searching a bucket once it passes the brand, so this
+// must stay in sync with VkQualityPredictionFile::CompareBrandOrder
+public class RuntimeDeviceSorter : IComparer<(string Brand, string Device)>
+{
+    public const int ShortcutCount = 27;
+
+    public static int GetShortcutIndex(string brand)
+    {
+        if (brand.Length == 0) return ShortcutCount - 1;
+        var firstLetter = brand[0];
+        if (firstLetter is >= 'a' and <= 'z') return firstLetter - 'a';
+        if (firstLetter is >= 'A' and <= 'Z') return firstLetter - 'A';
+        return ShortcutCount - 1;
+    }
+
+    public static int CompareBrandOrder(string x, string y)
+    {
+        return CompareUtf8(x, y, true);
+    }
+
+    // strcmp order, used by the brand index section
+    public static int CompareOrdinal(string x, string y)
+    {
+        return CompareUtf8(x, y, false);
+    }
+
+    public int Compare((string Brand, string Device) x, (string Brand, string Device) y)
+    {
+        var shortcutCompare = GetShortcutIndex(x.Brand) - GetShortcutIndex(y.Brand);
+        if (shortcutCompare != 0) return shortcutCompare;
+        var brandCompare = CompareBrandOrder(x.Brand, y.Brand);
+        if (brandCompare != 0) return brandCompare;
+        return CompareBrandOrder(x.Device, y.Device);
+    }
+
+    private static int CompareUtf8(string x, string y, bool foldCase)
+    {
+        var xBytes = Encoding.UTF8.GetBytes(x);
+        var yBytes = Encoding.UTF8.GetBytes(y);
+        var compareLength = Math.Min(xBytes.Length, yBytes.Length);
+        for (var i = 0; i < compareLength; ++i)
+        {
+            var xChar = foldCase ? FoldUpper(xBytes[i]) : xBytes[i];
+            var yChar = foldCase ? FoldUpper(yBytes[i]) : yBytes[i];
+            if (xChar != yChar) return xChar - yChar;
+        }
+
+        return xBytes.Length - yBytes.Length;
+    }
+
+    private static int FoldUpper(byte value)
+    {
+        return value is >= (byte) 'a' and <= (byte) 'z' ? value - ('a' - 'A') : value;
+    }
+}
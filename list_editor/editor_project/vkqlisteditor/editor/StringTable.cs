@@ -47,6 +47,13 @@ public class StringTable
         return -1;
     }
 
+    // The string as exported, lookups ignore case so this can differ from stringToFind
+    public string GetExportedString(string stringToFind)
+    {
+        if (GetStringIndex(stringToFind) <= 0) return "";
+        return _stringTableSorted[stringToFind];
+    }
+
     public int CalculateStringTableSize()
     {
         // 32-bit offset entries in the string table, so 4 bytes per entry
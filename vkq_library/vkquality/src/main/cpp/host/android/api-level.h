@@ -0,0 +1,27 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Host stand-in for the NDK android/api-level.h, the API level is taken from
+// the fake device set with vkquality::host::SetHostDevice
+
+#ifndef VKQUALITY_HOST_ANDROID_API_LEVEL_H_
+#define VKQUALITY_HOST_ANDROID_API_LEVEL_H_
+
+#define __ANDROID_API_Q__ 29
+
+int android_get_device_api_level();
+
+#endif // VKQUALITY_HOST_ANDROID_API_LEVEL_H_
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Host stand-in for the NDK android/asset_manager.h, assets are files under a
+// directory, see vkquality::host::CreateHostAssetManager
+
+#ifndef VKQUALITY_HOST_ANDROID_ASSET_MANAGER_H_
+#define VKQUALITY_HOST_ANDROID_ASSET_MANAGER_H_
+
+#include <sys/types.h>
+
+struct AAssetManager;
+typedef struct AAssetManager AAssetManager;
+
+struct AAsset;
+typedef struct AAsset AAsset;
+
+enum {
+  AASSET_MODE_UNKNOWN = 0,
+  AASSET_MODE_RANDOM = 1,
+  AASSET_MODE_STREAMING = 2,
+  AASSET_MODE_BUFFER = 3
+};
+
+AAsset *AAssetManager_open(AAssetManager *mgr, const char *filename, int mode);
+
+int AAsset_read(AAsset *asset, void *buf, size_t count);
+
+off_t AAsset_getLength(AAsset *asset);
+
+void AAsset_close(AAsset *asset);
+
+#endif // VKQUALITY_HOST_ANDROID_ASSET_MANAGER_H_
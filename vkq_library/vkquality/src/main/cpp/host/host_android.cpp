@@ -0,0 +1,103 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vkquality_host.h"
+#include <android/api-level.h>
+#include <android/asset_manager_jni.h>
+#include <android/log.h>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+#include <sys/stat.h>
+
+struct AAssetManager : public _jobject {
+  std::string asset_path;
+};
+
+struct AAsset {
+  FILE *fp;
+  off_t length;
+};
+
+AAsset *AAssetManager_open(AAssetManager *mgr, const char *filename, int /*mode*/) {
+  if (mgr == nullptr || filename == nullptr) {
+    return nullptr;
+  }
+  const std::string full_path = mgr->asset_path + "/" + filename;
+  FILE *fp = fopen(full_path.c_str(), "rb");
+  if (fp == nullptr) {
+    return nullptr;
+  }
+  struct stat file_stats{};
+  if (fstat(fileno(fp), &file_stats) != 0 || !S_ISREG(file_stats.st_mode)) {
+    fclose(fp);
+    return nullptr;
+  }
+  return new AAsset{fp, file_stats.st_size};
+}
+
+int AAsset_read(AAsset *asset, void *buf, size_t count) {
+  const size_t read_count = fread(buf, 1, count, asset->fp);
+  if (read_count == 0 && ferror(asset->fp)) {
+    return -1;
+  }
+  return static_cast<int>(read_count);
+}
+
+off_t AAsset_getLength(AAsset *asset) {
+  return asset->length;
+}
+
+void AAsset_close(AAsset *asset) {
+  fclose(asset->fp);
+  delete asset;
+}
+
+AAssetManager *AAssetManager_fromJava(JNIEnv */*env*/, jobject assetManager) {
+  return dynamic_cast<AAssetManager *>(assetManager);
+}
+
+int __android_log_print(int /*prio*/, const char *tag, const char *fmt, ...) {
+  va_list va_args;
+  va_start(va_args, fmt);
+  fprintf(stderr, "%s: ", tag);
+  const int result = vfprintf(stderr, fmt, va_args);
+  fputc('\n', stderr);
+  va_end(va_args);
+  return result;
+}
+
+int android_get_device_api_level() {
+  return vkquality::host::GetHostDevice().api_level;
+}
+
+namespace vkquality::host {
+
+AAssetManager *CreateHostAssetManager(const char *asset_path) {
+  auto *asset_manager = new AAssetManager();
+  asset_manager->asset_path = asset_path;
+  return asset_manager;
+}
+
+void DestroyHostAssetManager(AAssetManager *asset_manager) {
+  delete asset_manager;
+}
+
+jobject GetHostAssetManagerObject(AAssetManager *asset_manager) {
+  return asset_manager;
+}
+
+} // namespace vkquality::host
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Host replacements for gles_util.cpp and vulkan_util.cpp, which need EGL,
+// GLES and Vulkan. Values come from the fake device instead of graphics API
+// instances.
+
+#include "gles_util.h"
+#include "vulkan_util.h"
+#include "vkquality_host.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace vkquality {
+
+namespace {
+
+std::mutex physical_device_mutex;
+std::vector<host::HostPhysicalDevice> host_physical_devices;
+
+std::vector<host::HostPhysicalDevice> GetPhysicalDevices() {
+  std::lock_guard<std::mutex> lock(physical_device_mutex);
+  return host_physical_devices;
+}
+
+} // anonymous namespace
+
+void host::SetHostPhysicalDevices(const std::vector<HostPhysicalDevice> &physical_devices) {
+  std::lock_guard<std::mutex> lock(physical_device_mutex);
+  host_physical_devices = physical_devices;
+}
+
+std::string GLESUtil::GetGLESVersionString() {
+  return host::GetHostDevice().gles_version;
+}
+
+uint32_t VulkanUtil::GetVulkanApiVersionForApiLevel(const int device_api_level) {
+  if (device_api_level >= kMinimum_vk13_api_level) {
+    return (1U << 22) | (3U << 12);
+  } else if (device_api_level >= kMinimum_vk11_api_level) {
+    return (1U << 22) | (1U << 12);
+  }
+  return (1U << 22);
+}
+
+vkQualityInitResult VulkanUtil::CopyDeviceVulkanInfo(DeviceInfo &device_info,
+    void *vk_physical_device_properties) {
+  if (vk_physical_device_properties == nullptr) {
+    return kErrorNoVulkan;
+  }
+  const auto &device_properties =
+      *(reinterpret_cast<const host::HostPhysicalDeviceProperties *>(
+          vk_physical_device_properties));
+  device_info.vk_api_version = device_properties.apiVersion;
+  device_info.vk_driver_version = device_properties.driverVersion;
+  device_info.vk_device_id = device_properties.deviceID;
+  device_info.vk_vendor_id = device_properties.vendorID;
+  device_info.vk_device_name = device_properties.deviceName;
+  return kSuccess;
+}
+
+vkQualityInitResult VulkanUtil::GetDeviceVulkanInfo(DeviceInfo &device_info,
+                                                    VkQualityDeviceCandidates &candidates) {
+  candidates.count = 0;
+  const DeviceInfo &host_device = host::GetHostDevice();
+  if (host_device.vk_api_version == 0) {
+    return kErrorNoVulkan;
+  }
+  std::vector<host::HostPhysicalDevice> physical_devices = GetPhysicalDevices();
+  if (physical_devices.empty()) {
+    host::HostPhysicalDevice physical_device{};
+    physical_device.properties.apiVersion = host_device.vk_api_version;
+    physical_device.properties.driverVersion = host_device.vk_driver_version;
+    physical_device.properties.vendorID = host_device.vk_vendor_id;
+    physical_device.properties.deviceID = host_device.vk_device_id;
+    strncpy(physical_device.properties.deviceName, host_device.vk_device_name.c_str(),
+            sizeof(physical_device.properties.deviceName) - 1);
+    physical_device.queue_flags = VkQualityDeviceProbe::kQueueGraphicsBit;
+    physical_device.capabilities = host_device.vk_capabilities;
+    physical_devices.push_back(physical_device);
+  }
+
+  // The same probe as the Android build, with handles pointing at the host devices
+  VkQualityDeviceProbe::Loader loader;
+  loader.user_data = &physical_devices;
+  loader.enumerate_physical_devices = [](void *user_data, uint32_t *device_count,
+                                         void **devices) -> int32_t {
+    auto &host_devices = *reinterpret_cast<std::vector<host::HostPhysicalDevice> *>(user_data);
+    const uint32_t host_count = static_cast<uint32_t>(host_devices.size());
+    if (devices == nullptr) {
+      *device_count = host_count;
+      return VkQualityDeviceProbe::kResultSuccess;
+    }
+    const uint32_t copy_count = std::min(*device_count, host_count);
+    for (uint32_t i = 0; i < copy_count; ++i) {
+      devices[i] = &host_devices[i];
+    }
+    *device_count = copy_count;
+    return (copy_count < host_count) ? VkQualityDeviceProbe::kResultIncomplete :
+        VkQualityDeviceProbe::kResultSuccess;
+  };
+  loader.get_queue_family_flags = [](void */*user_data*/, void *physical_device,
+                                     uint32_t *family_count, uint32_t *queue_flags) {
+    if (*family_count > 0) {
+      queue_flags[0] = reinterpret_cast<host::HostPhysicalDevice *>(physical_device)->queue_flags;
+    }
+    *family_count = 1;
+  };
+  loader.get_device_properties = [](void */*user_data*/, void *physical_device,
+                                    VkQualityDeviceCandidate &candidate) {
+    const host::HostPhysicalDeviceProperties &properties =
+        reinterpret_cast<host::HostPhysicalDevice *>(physical_device)->properties;
+    candidate.api_version = properties.apiVersion;
+    candidate.driver_version = properties.driverVersion;
+    candidate.vendor_id = properties.vendorID;
+    candidate.device_id = properties.deviceID;
+    candidate.device_type = properties.deviceType;
+    memcpy(candidate.device_name, properties.deviceName, sizeof(candidate.device_name));
+  };
+  loader.get_capabilities = [](void */*user_data*/, void *physical_device,
+                                uint64_t *capabilities) -> bool {
+    *capabilities = reinterpret_cast<host::HostPhysicalDevice *>(physical_device)->capabilities;
+    return true;
+  };
+  if (!VkQualityDeviceProbe::Probe(loader, candidates)) {
+    return kErrorNoVulkan;
+  }
+  VkQualityDeviceProbe::CopyCandidate(candidates.candidates[0], device_info);
+  return kSuccess;
+}
+
+int VulkanUtil::GetFutureApiLevelRecommendation() {
+  return kMinimum_vk_always_api_level;
+}
+
+} // namespace vkquality
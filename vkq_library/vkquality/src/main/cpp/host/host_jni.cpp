@@ -0,0 +1,224 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vkquality_host.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+struct _jfieldID {
+  const char *name;
+};
+
+namespace vkquality::host {
+
+namespace {
+
+constexpr const char *kBuildClassName = "android/os/Build";
+constexpr const char *kStringSignature = "Ljava/lang/String;";
+
+class HostString : public _jstring {
+ public:
+  explicit HostString(const std::string &value) : value_(value) {}
+  const std::string &GetValue() const { return value_; }
+ private:
+  std::string value_;
+};
+
+class HostDirectBuffer : public _jobject {
+ public:
+  HostDirectBuffer(void *address, size_t capacity) : address_(address), capacity_(capacity) {}
+  void *GetAddress() const { return address_; }
+  size_t GetCapacity() const { return capacity_; }
+ private:
+  void *address_;
+  size_t capacity_;
+};
+
+_jclass build_class;
+_jfieldID brand_field{"BRAND"};
+_jfieldID device_field{"DEVICE"};
+_jfieldID soc_field{"SOC_MODEL"};
+
+std::mutex device_mutex;
+DeviceInfo host_device;
+thread_local bool exception_pending = false;
+std::atomic<size_t> global_ref_count{0};
+
+jclass FindClass(JNIEnv *, const char *name) {
+  if (strcmp(name, kBuildClassName) == 0) {
+    return &build_class;
+  }
+  exception_pending = true;
+  return nullptr;
+}
+
+jboolean ExceptionCheck(JNIEnv *) {
+  return exception_pending ? 1 : 0;
+}
+
+void ExceptionClear(JNIEnv *) {
+  exception_pending = false;
+}
+
+jobject NewGlobalRef(JNIEnv *, jobject obj) {
+  ++global_ref_count;
+  return obj;
+}
+
+void DeleteGlobalRef(JNIEnv *, jobject) {
+  --global_ref_count;
+}
+
+void DeleteLocalRef(JNIEnv *, jobject obj) {
+  // Only strings returned from GetStaticObjectField are local references
+  // owned by the caller
+  delete dynamic_cast<HostString *>(obj);
+}
+
+jfieldID GetStaticFieldID(JNIEnv *, jclass clazz, const char *name, const char *sig) {
+  if (clazz == &build_class && strcmp(sig, kStringSignature) == 0) {
+    for (jfieldID field : {&brand_field, &device_field, &soc_field}) {
+      if (strcmp(field->name, name) == 0) {
+        return field;
+      }
+    }
+  }
+  exception_pending = true;
+  return nullptr;
+}
+
+jobject GetStaticObjectField(JNIEnv *, jclass clazz, jfieldID field_id) {
+  if (clazz != &build_class || field_id == nullptr) {
+    exception_pending = true;
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(device_mutex);
+  if (field_id == &brand_field) {
+    return new HostString(host_device.brand);
+  } else if (field_id == &device_field) {
+    return new HostString(host_device.device);
+  }
+  return new HostString(host_device.soc);
+}
+
+jsize GetStringUTFLength(JNIEnv *, jstring string) {
+  return static_cast<jsize>(static_cast<HostString *>(string)->GetValue().size());
+}
+
+const char *GetStringUTFChars(JNIEnv *, jstring string, jboolean *is_copy) {
+  if (is_copy != nullptr) {
+    *is_copy = 0;
+  }
+  return static_cast<HostString *>(string)->GetValue().c_str();
+}
+
+void ReleaseStringUTFChars(JNIEnv *, jstring, const char *) {
+}
+
+jint GetJavaVM(JNIEnv *, JavaVM **vm);
+
+void *GetDirectBufferAddress(JNIEnv *, jobject buf) {
+  auto *direct_buffer = dynamic_cast<HostDirectBuffer *>(buf);
+  return (direct_buffer != nullptr) ? direct_buffer->GetAddress() : nullptr;
+}
+
+jlong GetDirectBufferCapacity(JNIEnv *, jobject buf) {
+  auto *direct_buffer = dynamic_cast<HostDirectBuffer *>(buf);
+  return (direct_buffer != nullptr) ? static_cast<jlong>(direct_buffer->GetCapacity()) : -1;
+}
+
+const JNINativeInterface native_interface = {
+    FindClass,
+    ExceptionCheck,
+    ExceptionClear,
+    NewGlobalRef,
+    DeleteGlobalRef,
+    DeleteLocalRef,
+    GetStaticFieldID,
+    GetStaticObjectField,
+    GetStringUTFLength,
+    GetStringUTFChars,
+    ReleaseStringUTFChars,
+    GetJavaVM,
+    GetDirectBufferAddress,
+    GetDirectBufferCapacity,
+};
+
+JNIEnv host_env{&native_interface};
+
+jint GetEnv(JavaVM *, void **env, jint) {
+  *env = &host_env;
+  return JNI_OK;
+}
+
+jint AttachCurrentThread(JavaVM *, JNIEnv **env, void *) {
+  *env = &host_env;
+  return JNI_OK;
+}
+
+jint DetachCurrentThread(JavaVM *) {
+  return JNI_OK;
+}
+
+const JNIInvokeInterface invoke_interface = {
+    GetEnv,
+    AttachCurrentThread,
+    DetachCurrentThread,
+};
+
+JavaVM host_vm{&invoke_interface};
+
+jint GetJavaVM(JNIEnv *, JavaVM **vm) {
+  *vm = &host_vm;
+  return JNI_OK;
+}
+
+} // anonymous namespace
+
+void SetHostDevice(const DeviceInfo &device_info) {
+  SetHostPhysicalDevices({});
+  std::lock_guard<std::mutex> lock(device_mutex);
+  host_device = device_info;
+}
+
+const DeviceInfo &GetHostDevice() {
+  std::lock_guard<std::mutex> lock(device_mutex);
+  return host_device;
+}
+
+JNIEnv *GetHostJNIEnv() {
+  return &host_env;
+}
+
+jobject NewHostDirectBuffer(void *address, size_t capacity) {
+  return new HostDirectBuffer(address, capacity);
+}
+
+jstring NewHostString(const char *utf) {
+  return new HostString(utf);
+}
+
+void DeleteHostObject(jobject object) {
+  delete object;
+}
+
+size_t GetHostGlobalRefCount() {
+  return global_ref_count;
+}
+
+} // namespace vkquality::host
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Host stand-in for jni.h, declaring only the subset of JNI used by VkQuality.
+// The function tables are implemented by host_jni.cpp against a fake device
+// described by vkquality_host.h. Not used by Android builds.
+
+#ifndef VKQUALITY_HOST_JNI_H_
+#define VKQUALITY_HOST_JNI_H_
+
+#include <cstdint>
+
+#define JNIEXPORT __attribute__((visibility("default")))
+#define JNICALL
+
+#define JNI_OK 0
+#define JNI_ERR (-1)
+#define JNI_EDETACHED (-2)
+
+#define JNI_VERSION_1_6 0x00010006
+
+typedef uint8_t jboolean;
+typedef int32_t jint;
+typedef int64_t jlong;
+typedef jint jsize;
+
+class _jobject {
+ public:
+  virtual ~_jobject() = default;
+};
+class _jclass : public _jobject {};
+class _jstring : public _jobject {};
+
+typedef _jobject *jobject;
+typedef _jclass *jclass;
+typedef _jstring *jstring;
+
+struct _jfieldID;
+typedef struct _jfieldID *jfieldID;
+
+struct _JNIEnv;
+struct _JavaVM;
+typedef _JNIEnv JNIEnv;
+typedef _JavaVM JavaVM;
+
+struct JNINativeInterface {
+  jclass (*FindClass)(JNIEnv *, const char *);
+  jboolean (*ExceptionCheck)(JNIEnv *);
+  void (*ExceptionClear)(JNIEnv *);
+  jobject (*NewGlobalRef)(JNIEnv *, jobject);
+  void (*DeleteGlobalRef)(JNIEnv *, jobject);
+  void (*DeleteLocalRef)(JNIEnv *, jobject);
+  jfieldID (*GetStaticFieldID)(JNIEnv *, jclass, const char *, const char *);
+  jobject (*GetStaticObjectField)(JNIEnv *, jclass, jfieldID);
+  jsize (*GetStringUTFLength)(JNIEnv *, jstring);
+  const char *(*GetStringUTFChars)(JNIEnv *, jstring, jboolean *);
+  void (*ReleaseStringUTFChars)(JNIEnv *, jstring, const char *);
+  jint (*GetJavaVM)(JNIEnv *, JavaVM **);
+  void *(*GetDirectBufferAddress)(JNIEnv *, jobject);
+  jlong (*GetDirectBufferCapacity)(JNIEnv *, jobject);
+};
+
+struct _JNIEnv {
+  const struct JNINativeInterface *functions;
+
+  jclass FindClass(const char *name) { return functions->FindClass(this, name); }
+  jboolean ExceptionCheck() { return functions->ExceptionCheck(this); }
+  void ExceptionClear() { functions->ExceptionClear(this); }
+  jobject NewGlobalRef(jobject obj) { return functions->NewGlobalRef(this, obj); }
+  void DeleteGlobalRef(jobject obj) { functions->DeleteGlobalRef(this, obj); }
+  void DeleteLocalRef(jobject obj) { functions->DeleteLocalRef(this, obj); }
+  jfieldID GetStaticFieldID(jclass clazz, const char *name, const char *sig) {
+    return functions->GetStaticFieldID(this, clazz, name, sig);
+  }
+  jobject GetStaticObjectField(jclass clazz, jfieldID field_id) {
+    return functions->GetStaticObjectField(this, clazz, field_id);
+  }
+  jsize GetStringUTFLength(jstring string) {
+    return functions->GetStringUTFLength(this, string);
+  }
+  const char *GetStringUTFChars(jstring string, jboolean *is_copy) {
+    return functions->GetStringUTFChars(this, string, is_copy);
+  }
+  void ReleaseStringUTFChars(jstring string, const char *utf) {
+    functions->ReleaseStringUTFChars(this, string, utf);
+  }
+  jint GetJavaVM(JavaVM **vm) { return functions->GetJavaVM(this, vm); }
+  void *GetDirectBufferAddress(jobject buf) {
+    return functions->GetDirectBufferAddress(this, buf);
+  }
+  jlong GetDirectBufferCapacity(jobject buf) {
+    return functions->GetDirectBufferCapacity(this, buf);
+  }
+};
+
+struct JNIInvokeInterface {
+  jint (*GetEnv)(JavaVM *, void **, jint);
+  jint (*AttachCurrentThread)(JavaVM *, JNIEnv **, void *);
+  jint (*DetachCurrentThread)(JavaVM *);
+};
+
+struct _JavaVM {
+  const struct JNIInvokeInterface *functions;
+
+  jint GetEnv(void **env, jint version) { return functions->GetEnv(this, env, version); }
+  jint AttachCurrentThread(JNIEnv **env, void *args) {
+    return functions->AttachCurrentThread(this, env, args);
+  }
+  jint DetachCurrentThread() { return functions->DetachCurrentThread(this); }
+};
+
+#endif // VKQUALITY_HOST_JNI_H_
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VKQUALITY_HOST_H_
+#define VKQUALITY_HOST_H_
+
+#include <android/asset_manager.h>
+#include <jni.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "vkquality_device_info.h"
+
+// Host stand-ins for the Android pieces VkQualityManager depends on, so the
+// full initialization path can be tested, benchmarked and profiled off-device.
+// The fake device supplies the android.os.Build fields read through JNI, the
+// Android API level, and the GLES and Vulkan information normally retrieved by
+// creating graphics API instances.
+namespace vkquality::host {
+
+// Prefix of VkPhysicalDeviceProperties read by VulkanUtil::CopyDeviceVulkanInfo
+struct HostPhysicalDeviceProperties {
+  uint32_t apiVersion;
+  uint32_t driverVersion;
+  uint32_t vendorID;
+  uint32_t deviceID;
+  int32_t deviceType;
+  char deviceName[256];
+};
+
+// A physical device enumerated by the host Vulkan loader, with a single queue
+// family and the features and extensions of the VkQualityCapabilities bits
+struct HostPhysicalDevice {
+  HostPhysicalDeviceProperties properties;
+  uint32_t queue_flags;
+  uint64_t capabilities;
+};
+
+// An empty brand or device makes the Build field lookup fail, a zero
+// vk_api_version makes the Vulkan lookup report kErrorNoVulkan. vk_capabilities
+// are the features and extensions of the default physical device. Clears the
+// physical devices set by SetHostPhysicalDevices
+void SetHostDevice(const DeviceInfo &device_info);
+
+// Physical devices the host Vulkan loader enumerates instead of a single
+// graphics device with the Vulkan fields of the host device
+void SetHostPhysicalDevices(const std::vector<HostPhysicalDevice> &physical_devices);
+
+const DeviceInfo &GetHostDevice();
+
+// The JNIEnv for the calling thread, all threads are attached
+JNIEnv *GetHostJNIEnv();
+
+// Assets are opened relative to asset_path
+AAssetManager *CreateHostAssetManager(const char *asset_path);
+
+void DestroyHostAssetManager(AAssetManager *asset_manager);
+
+// The object passed as a Java AssetManager to the JNI entry points
+jobject GetHostAssetManagerObject(AAssetManager *asset_manager);
+
+// A stand-in for a direct java.nio.ByteBuffer, must be deleted with
+// DeleteHostObject once there are no global references to it
+jobject NewHostDirectBuffer(void *address, size_t capacity);
+
+jstring NewHostString(const char *utf);
+
+void DeleteHostObject(jobject object);
+
+// Global references created by NewGlobalRef and not yet deleted
+size_t GetHostGlobalRefCount();
+
+} // namespace vkquality::host
+
+#endif // VKQUALITY_HOST_H_
@@ -0,0 +1,1226 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gtest/gtest.h"
+#include "vkquality.h"
+#include "vkquality_capabilities.h"
+#include "vkquality_compression.h"
+#include "vkquality_driver_version.h"
+#include "vkquality_file_writer.h"
+#include "vkquality_host.h"
+#include "vkquality_paged_file.h"
+#include "vkquality_patch.h"
+#include "vkquality_prediction_file.h"
+#include "vkquality_version.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace vkquality;
+
+extern "C" jint Java_com_google_android_games_vkquality_VKQuality_startVkQualityFromBuffer(
+    JNIEnv *env, jobject activity, jobject jdata_buffer, jint offset, jint length,
+    jstring jstorage_path, jint flags);
+
+extern "C" void Java_com_google_android_games_vkquality_VKQuality_stopVkQuality(
+    JNIEnv *env, jobject activity);
+
+namespace {
+
+constexpr const char *kListFilename = "vkqualitydata.vkq";
+constexpr const char *kCacheFilename = "vkqcache.bin";
+constexpr int32_t kFutureApi = 40;
+
+DeviceInfo MakeHostDevice() {
+  return DeviceInfo{
+      "google",
+      "raven",
+      "Tensor",
+      "Mali-G78",
+      "OpenGL ES 3.2 v1.r32p1-00pxl0.b7e5868a59a273f4a9f58d1657ef99de",
+      34,
+      (1U << 22) | (3U << 12),
+      0x92020010,
+      0x2A000,
+      0x13B5};
+}
+
+std::vector<uint8_t> MakeList(const uint32_t list_version, const bool include_device) {
+  VkQualityFileWriter writer(list_version, kFutureApi);
+  writer.AddDevice({"samsung", "beyond1", 0, 0});
+  if (include_device) {
+    writer.AddDevice({"google", "raven", 0, 0});
+  }
+  writer.AddGpuDeny({"PowerVR Rogue GE8320", 0, 0, 0, 0});
+  return writer.Write();
+}
+
+bool WriteList(const std::string &path, const std::vector<uint8_t> &list_data) {
+  FILE *fp = fopen(path.c_str(), "wb");
+  if (fp == nullptr) {
+    return false;
+  }
+  const bool wrote = fwrite(list_data.data(), list_data.size(), 1, fp) == 1;
+  fclose(fp);
+  return wrote;
+}
+
+std::string MakeTempDirectory() {
+  char path_template[] = "/tmp/vkqhostXXXXXX";
+  const char *path = mkdtemp(path_template);
+  return (path != nullptr) ? path : "";
+}
+
+void CountRelease(void */*list_data*/, void *user_data) {
+  ++(*reinterpret_cast<int *>(user_data));
+}
+
+VkQualityFileWriter MakeShardedListWriter(const uint32_t list_version) {
+  VkQualityFileWriter writer(list_version, kFutureApi);
+  writer.AddDevice({"samsung", "beyond1", 0, 0});
+  writer.AddDevice({"google", "raven", 0, 0});
+  writer.AddDevice({"google", "oriole", 0, 0});
+  writer.AddDevice({"1plus", "one", 0, 0});
+  writer.AddGpuDeny({"PowerVR Rogue GE8320", 0, 0, 0, 0});
+  return writer;
+}
+
+class VkQualityHostTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    host::SetHostDevice(MakeHostDevice());
+    asset_path_ = MakeTempDirectory();
+    storage_path_ = MakeTempDirectory();
+    ASSERT_FALSE(asset_path_.empty());
+    ASSERT_FALSE(storage_path_.empty());
+    asset_manager_ = host::CreateHostAssetManager(asset_path_.c_str());
+  }
+
+  void TearDown() override {
+    vkQuality_destroy(host::GetHostJNIEnv());
+    host::DestroyHostAssetManager(asset_manager_);
+    for (const std::string &extra_path : extra_paths_) {
+      unlink(extra_path.c_str());
+    }
+    for (const std::string *path : {&asset_path_, &storage_path_}) {
+      unlink((*path + "/" + kListFilename).c_str());
+      unlink((*path + "/" + kCacheFilename).c_str());
+      rmdir(path->c_str());
+    }
+  }
+
+  vkQualityInitResult Initialize() {
+    return vkQuality_initialize(host::GetHostJNIEnv(), asset_manager_, storage_path_.c_str(),
+                                kListFilename);
+  }
+
+  std::string asset_path_;
+  std::string storage_path_;
+  // Files besides the list and cache that a test writes, removed on tear down
+  std::vector<std::string> extra_paths_;
+  AAssetManager *asset_manager_ = nullptr;
+};
+
+} // anonymous namespace
+
+TEST_F(VkQualityHostTest, InitFromAsset) {
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename, MakeList(1, true)));
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecauseDeviceMatch);
+
+  struct stat cache_stats{};
+  EXPECT_EQ(stat((storage_path_ + "/" + kCacheFilename).c_str(), &cache_stats), 0);
+}
+
+TEST_F(VkQualityHostTest, MissingDataFile) {
+  EXPECT_EQ(Initialize(), kErrorMissingDataFile);
+}
+
+TEST_F(VkQualityHostTest, OldDevice) {
+  DeviceInfo device_info = MakeHostDevice();
+  device_info.api_level = 28;
+  host::SetHostDevice(device_info);
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationGLESBecauseOldDevice);
+}
+
+TEST_F(VkQualityHostTest, CachedRecommendation) {
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename, MakeList(1, true)));
+  EXPECT_EQ(Initialize(), kSuccess);
+  vkQuality_destroy(host::GetHostJNIEnv());
+
+  // Same list contents, the cached recommendation is used. Mark the cache so
+  // its recommendation can be told apart from a new evaluation
+  const std::string cache_path = storage_path_ + "/" + kCacheFilename;
+  FILE *cache_fp = fopen(cache_path.c_str(), "r+b");
+  ASSERT_NE(cache_fp, nullptr);
+  const int32_t cached_recommendation = kRecommendationVulkanBecausePredictionMatch;
+  fseek(cache_fp, 2 * sizeof(int32_t), SEEK_SET);
+  fwrite(&cached_recommendation, sizeof(cached_recommendation), 1, cache_fp);
+  fclose(cache_fp);
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecausePredictionMatch);
+  vkQuality_destroy(host::GetHostJNIEnv());
+
+  // Same list version with different contents, the content checksum tells
+  // them apart and the recommendation is evaluated again
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename, MakeList(1, false)));
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationGLESBecauseNoDeviceMatch);
+  vkQuality_destroy(host::GetHostJNIEnv());
+
+  // New list version, the recommendation is evaluated again
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename, MakeList(2, true)));
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecauseDeviceMatch);
+}
+
+TEST_F(VkQualityHostTest, NewestListWins) {
+  // Stale downloaded list in storage, newer list in the assets
+  ASSERT_TRUE(WriteList(storage_path_ + "/" + kListFilename, MakeList(1, true)));
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename, MakeList(2, false)));
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationGLESBecauseNoDeviceMatch);
+  vkQuality_destroy(host::GetHostJNIEnv());
+
+  ASSERT_TRUE(WriteList(storage_path_ + "/" + kListFilename, MakeList(3, true)));
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecauseDeviceMatch);
+}
+
+TEST_F(VkQualityHostTest, InitFromMemory) {
+  std::vector<uint8_t> list_data = MakeList(1, true);
+  int release_count = 0;
+  EXPECT_EQ(vkQuality_initializeFromMemory(host::GetHostJNIEnv(), list_data.data(),
+                                           list_data.size(), CountRelease, &release_count,
+                                           nullptr, nullptr, 0), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecauseDeviceMatch);
+  // Released once the recommendation is determined
+  EXPECT_EQ(release_count, 1);
+  vkQuality_destroy(host::GetHostJNIEnv());
+  EXPECT_EQ(release_count, 1);
+
+  // Released even when the data can't be used
+  list_data[0] = 0;
+  EXPECT_EQ(vkQuality_initializeFromMemory(host::GetHostJNIEnv(), list_data.data(),
+                                           list_data.size(), CountRelease, &release_count,
+                                           nullptr, nullptr, 0), kErrorInvalidDataFile);
+  EXPECT_EQ(release_count, 2);
+}
+
+TEST_F(VkQualityHostTest, InitFromDirectBuffer) {
+  std::vector<uint8_t> list_data = MakeList(1, true);
+  jobject direct_buffer = host::NewHostDirectBuffer(list_data.data(), list_data.size());
+  jstring storage_path = host::NewHostString(storage_path_.c_str());
+  EXPECT_EQ(Java_com_google_android_games_vkquality_VKQuality_startVkQualityFromBuffer(
+      host::GetHostJNIEnv(), nullptr, direct_buffer, 0,
+      static_cast<jint>(list_data.size()), storage_path, 0), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecauseDeviceMatch);
+  EXPECT_EQ(host::GetHostGlobalRefCount(), 0U);
+  Java_com_google_android_games_vkquality_VKQuality_stopVkQuality(host::GetHostJNIEnv(),
+                                                                  nullptr);
+  EXPECT_EQ(host::GetHostGlobalRefCount(), 0U);
+  host::DeleteHostObject(storage_path);
+  host::DeleteHostObject(direct_buffer);
+}
+
+TEST_F(VkQualityHostTest, GraphicsAPIInfo) {
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename, MakeList(1, false)));
+  host::HostPhysicalDeviceProperties device_properties{};
+  device_properties.apiVersion = (1U << 22) | (3U << 12);
+  snprintf(device_properties.deviceName, sizeof(device_properties.deviceName),
+           "PowerVR Rogue GE8320");
+  vkqGraphicsAPIInfo api_info{"OpenGL ES 3.2 build 1.13@5776728", &device_properties};
+  EXPECT_EQ(vkQuality_initializeFlagsInfo(host::GetHostJNIEnv(), asset_manager_, nullptr,
+                                          kListFilename, &api_info, 0), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationGLESBecausePredictionMatch);
+  EXPECT_EQ(vkQuality_getRecommendedDeviceIndex(), -1);
+}
+
+TEST_F(VkQualityHostTest, IndependentContexts) {
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename, MakeList(1, true)));
+  vkQualityContext context_a = vkQuality_createContext(asset_manager_, nullptr,
+                                                       kListFilename, 0);
+  vkQualityContext context_b = vkQuality_createContext(asset_manager_, nullptr,
+                                                       "missing.vkq", 0);
+  ASSERT_NE(context_a, nullptr);
+  ASSERT_NE(context_b, nullptr);
+  EXPECT_EQ(vkQuality_evaluateContext(context_a, host::GetHostJNIEnv(), nullptr), kSuccess);
+  EXPECT_EQ(vkQuality_evaluateContext(context_b, host::GetHostJNIEnv(), nullptr),
+            kErrorMissingDataFile);
+  EXPECT_EQ(vkQuality_getContextRecommendation(context_a),
+            kRecommendationVulkanBecauseDeviceMatch);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationErrorNotInitialized);
+  vkQuality_destroyContext(context_a);
+  vkQuality_destroyContext(context_b);
+}
+
+TEST_F(VkQualityHostTest, PhysicalDevices) {
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename, MakeList(1, false)));
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendedDeviceIndex(), 0);
+  vkQuality_destroy(host::GetHostJNIEnv());
+
+  // A compute only device, a denied GPU and an allowed GPU, the allowed one
+  // is recommended
+  VkQualityFileWriter writer(2, kFutureApi);
+  writer.AddGpuAllow({"Mali-G78", 0, 0, 0, 0});
+  writer.AddGpuDeny({"PowerVR Rogue GE8320", 0, 0, 0, 0});
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename, writer.Write()));
+  const DeviceInfo device_info = MakeHostDevice();
+  std::vector<host::HostPhysicalDevice> physical_devices(3);
+  for (size_t i = 0; i < physical_devices.size(); ++i) {
+    physical_devices[i].properties.apiVersion = device_info.vk_api_version;
+    physical_devices[i].properties.driverVersion = device_info.vk_driver_version;
+    physical_devices[i].properties.vendorID = device_info.vk_vendor_id;
+    physical_devices[i].properties.deviceID = static_cast<uint32_t>(i + 1);
+    physical_devices[i].queue_flags = 0x1;
+  }
+  physical_devices[0].queue_flags = 0x2;
+  snprintf(physical_devices[0].properties.deviceName,
+           sizeof(physical_devices[0].properties.deviceName), "Mali-G78");
+  snprintf(physical_devices[1].properties.deviceName,
+           sizeof(physical_devices[1].properties.deviceName), "PowerVR Rogue GE8320");
+  snprintf(physical_devices[2].properties.deviceName,
+           sizeof(physical_devices[2].properties.deviceName), "Mali-G78");
+  host::SetHostPhysicalDevices(physical_devices);
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecausePredictionMatch);
+  EXPECT_EQ(vkQuality_getRecommendedDeviceIndex(), 2);
+  vkQuality_destroy(host::GetHostJNIEnv());
+
+  // The cache is for the recommended device, not the first one
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecausePredictionMatch);
+  EXPECT_EQ(vkQuality_getRecommendedDeviceIndex(), 2);
+  vkQuality_destroy(host::GetHostJNIEnv());
+
+  // Without the allowed GPU, the first graphics device is kept
+  physical_devices.resize(2);
+  host::SetHostPhysicalDevices(physical_devices);
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationGLESBecausePredictionMatch);
+  EXPECT_EQ(vkQuality_getRecommendedDeviceIndex(), 1);
+}
+
+TEST_F(VkQualityHostTest, CapabilityRules) {
+  // Devices without dynamic rendering are denied, whatever the GPU lists say
+  const uint64_t dynamic_rendering =
+      VkQualityCapabilities::GetBit(VkQualityCapabilities::kCapability_DynamicRendering);
+  VkQualityFileWriter writer(1, kFutureApi);
+  writer.AddGpuAllow({"Mali-G78", 0, 0, 0, 0});
+  writer.AddCapabilityDenyRule({0, dynamic_rendering, 0});
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename, writer.Write()));
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationGLESBecausePredictionMatch);
+  vkQuality_destroy(host::GetHostJNIEnv());
+
+  // Of two devices the one with the capability is recommended
+  const DeviceInfo device_info = MakeHostDevice();
+  std::vector<host::HostPhysicalDevice> physical_devices(2);
+  for (size_t i = 0; i < physical_devices.size(); ++i) {
+    physical_devices[i].properties.apiVersion = device_info.vk_api_version;
+    physical_devices[i].properties.driverVersion = device_info.vk_driver_version;
+    physical_devices[i].properties.vendorID = device_info.vk_vendor_id;
+    physical_devices[i].properties.deviceID = static_cast<uint32_t>(i + 1);
+    snprintf(physical_devices[i].properties.deviceName,
+             sizeof(physical_devices[i].properties.deviceName), "Mali-G78");
+    physical_devices[i].queue_flags = 0x1;
+  }
+  physical_devices[1].capabilities = dynamic_rendering;
+  host::SetHostPhysicalDevices(physical_devices);
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecausePredictionMatch);
+  EXPECT_EQ(vkQuality_getRecommendedDeviceIndex(), 1);
+  vkQuality_destroy(host::GetHostJNIEnv());
+
+  // Capabilities of properties passed in vkqGraphicsAPIInfo are unknown
+  vkqGraphicsAPIInfo api_info{nullptr, &physical_devices[0].properties};
+  EXPECT_EQ(vkQuality_initializeFlagsInfo(host::GetHostJNIEnv(), asset_manager_, nullptr,
+                                          kListFilename, &api_info, 0), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecausePredictionMatch);
+
+  // The rules round trip through the writer
+  std::vector<uint8_t> list_data = writer.Write();
+  VkQualityPredictionFile file;
+  ASSERT_EQ(file.ParseFileData(list_data.data(), list_data.size(), VKQUALITY_PACKED_VERSION,
+                               nullptr),
+            VkQualityPredictionFile::kFileParseResult_Success);
+  EXPECT_TRUE(file.HasCapabilityRules());
+  DeviceInfo probed_info = device_info;
+  probed_info.vk_capabilities = VkQualityCapabilities::kCapability_Probed;
+  uint32_t match_index = 1;
+  EXPECT_EQ(file.FindDeviceMatch(probed_info, 0, &match_index),
+            VkQualityPredictionFile::kFileMatch_CapabilityDeny);
+  EXPECT_EQ(match_index, 0U);
+}
+
+TEST(VkQualityShardedList, ShardSearch) {
+  std::vector<VkQualityFileWriter::ShardFile> shard_files;
+  std::vector<uint8_t> root_data = MakeShardedListWriter(1).WriteSharded("vkqualitydata",
+                                                                         shard_files);
+  ASSERT_EQ(shard_files.size(), 3U);
+  EXPECT_EQ(shard_files[0].name, "vkqualitydata_g.vkq");
+  EXPECT_EQ(shard_files[2].name, "vkqualitydata_other.vkq");
+
+  std::map<std::string, std::vector<uint8_t>> shard_data;
+  for (const VkQualityFileWriter::ShardFile &shard_file : shard_files) {
+    shard_data[shard_file.name] = shard_file.data;
+  }
+  int load_count = 0;
+  auto shard_loader = [&](const char *shard_name, size_t &shard_size) -> void * {
+    ++load_count;
+    auto shard = shard_data.find(shard_name);
+    if (shard == shard_data.end()) {
+      return nullptr;
+    }
+    shard_size = shard->second.size();
+    void *shard_bytes = malloc(shard_size);
+    memcpy(shard_bytes, shard->second.data(), shard_size);
+    return shard_bytes;
+  };
+
+  DeviceInfo device_info = MakeHostDevice();
+  uint32_t match_index = 0;
+  {
+    VkQualityPredictionFile file;
+    file.SetShardLoader(shard_loader);
+    ASSERT_EQ(file.ParseFileData(root_data.data(), root_data.size(), VKQUALITY_PACKED_VERSION,
+                                 nullptr), VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_TRUE(file.HasDeviceShards());
+    // Only the bucket of the searched brand is loaded, once
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_ExactDevice);
+    device_info.device = "oriole";
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_ExactDevice);
+    EXPECT_EQ(load_count, 1);
+    device_info.brand = "1plus";
+    device_info.device = "one";
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_ExactDevice);
+    EXPECT_EQ(load_count, 2);
+    // Buckets without a shard have no devices
+    device_info.brand = "xiaomi";
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_None);
+    EXPECT_EQ(load_count, 2);
+  }
+
+  // Shards from another list version are ignored
+  device_info = MakeHostDevice();
+  shard_data["vkqualitydata_g.vkq"] = MakeList(2, true);
+  {
+    VkQualityPredictionFile file;
+    file.SetShardLoader(shard_loader);
+    ASSERT_EQ(file.ParseFileData(root_data.data(), root_data.size(), VKQUALITY_PACKED_VERSION,
+                                 nullptr), VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_None);
+  }
+
+  VkQualityPredictionFile file;
+  ASSERT_EQ(file.ParseFileData(root_data.data(), root_data.size(), VKQUALITY_PACKED_VERSION,
+                               nullptr), VkQualityPredictionFile::kFileParseResult_Success);
+  EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+            VkQualityPredictionFile::kFileMatch_None);
+}
+
+// Shard names that could open files outside the directory of the root file are invalid
+TEST(VkQualityShardedList, UnsafeShardNames) {
+  const char *unsafe_prefixes[] = {"../vkqualitydata", "/data/local/tmp/vkqualitydata",
+                                   "lists/vkqualitydata", "vkqualitydata.."};
+  for (const char *unsafe_prefix : unsafe_prefixes) {
+    std::vector<VkQualityFileWriter::ShardFile> shard_files;
+    std::vector<uint8_t> root_data = MakeShardedListWriter(1).WriteSharded(unsafe_prefix,
+                                                                           shard_files);
+    VkQualityPredictionFile file;
+    EXPECT_EQ(file.ParseFileData(root_data.data(), root_data.size(), VKQUALITY_PACKED_VERSION,
+                                 nullptr),
+              VkQualityPredictionFile::kFileParseResult_Error_DeviceShardsInvalid)
+        << unsafe_prefix;
+  }
+}
+
+TEST_F(VkQualityHostTest, ShardedListFromAsset) {
+  std::vector<VkQualityFileWriter::ShardFile> shard_files;
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename,
+                        MakeShardedListWriter(1).WriteSharded("vkqualitydata", shard_files)));
+  for (const VkQualityFileWriter::ShardFile &shard_file : shard_files) {
+    extra_paths_.push_back(asset_path_ + "/" + shard_file.name);
+    ASSERT_TRUE(WriteList(extra_paths_.back(), shard_file.data));
+  }
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecauseDeviceMatch);
+}
+
+TEST(VkQualityCompressedList, RoundTrip) {
+  VkQualityFileWriter writer(1, kFutureApi);
+  for (uint32_t i = 0; i < 2000; ++i) {
+    writer.AddDevice({"brand" + std::to_string(i % 40), "device" + std::to_string(i), 0, i});
+    writer.AddDriverDeny({"soc" + std::to_string(i % 16),
+                          "OpenGL ES 3.2 V@" + std::to_string(400 + (i % 300)) + ".0"});
+  }
+  const std::vector<uint8_t> file_data = writer.Write();
+
+  // Small blocks exercise matches into earlier blocks
+  for (const uint32_t block_size : {VkQualityFileWriter::kCompressedBlockSize, 256U}) {
+    const std::vector<uint8_t> container = VkQualityFileWriter::Compress(file_data,
+                                                                         block_size);
+    ASSERT_TRUE(VkQualityCompression::IsCompressed(container.data(), container.size()));
+    EXPECT_LT(container.size(), file_data.size());
+    size_t decoded_size = 0;
+    void *decoded = VkQualityCompression::Decompress(container.data(), container.size(),
+                                                     decoded_size);
+    ASSERT_NE(decoded, nullptr);
+    ASSERT_EQ(decoded_size, file_data.size());
+    EXPECT_EQ(memcmp(decoded, file_data.data(), decoded_size), 0);
+    free(decoded);
+
+    // Truncated containers are rejected
+    EXPECT_EQ(VkQualityCompression::Decompress(container.data(), container.size() - 1,
+                                               decoded_size), nullptr);
+  }
+
+  // Incompressible input still round trips
+  std::vector<uint8_t> random_data = file_data;
+  uint32_t seed = 1;
+  for (size_t i = sizeof(VkQualityFileHeader); i < random_data.size(); ++i) {
+    seed = (seed * 1103515245U) + 12345U;
+    random_data[i] = static_cast<uint8_t>(seed >> 16);
+  }
+  const std::vector<uint8_t> random_container = VkQualityFileWriter::Compress(random_data);
+  size_t decoded_size = 0;
+  void *decoded = VkQualityCompression::Decompress(random_container.data(),
+                                                   random_container.size(), decoded_size);
+  ASSERT_NE(decoded, nullptr);
+  ASSERT_EQ(decoded_size, random_data.size());
+  EXPECT_EQ(memcmp(decoded, random_data.data(), decoded_size), 0);
+  free(decoded);
+}
+
+TEST_F(VkQualityHostTest, CompressedList) {
+  // The compressed list in storage is newer than the list in the assets
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename, MakeList(1, false)));
+  ASSERT_TRUE(WriteList(storage_path_ + "/" + kListFilename,
+                        VkQualityFileWriter::Compress(MakeList(2, true))));
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecauseDeviceMatch);
+  vkQuality_destroy(host::GetHostJNIEnv());
+
+  std::vector<uint8_t> container = VkQualityFileWriter::Compress(MakeList(1, true));
+  int release_count = 0;
+  EXPECT_EQ(vkQuality_initializeFromMemory(host::GetHostJNIEnv(), container.data(),
+                                           container.size(), CountRelease, &release_count,
+                                           nullptr, nullptr, 0), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecauseDeviceMatch);
+  EXPECT_EQ(release_count, 1);
+}
+
+TEST(VkQualityListPatch, CreatePatch) {
+  VkQualityFileWriter base_writer(1, kFutureApi);
+  VkQualityFileWriter target_writer(2, kFutureApi);
+  for (uint32_t i = 0; i < 2000; ++i) {
+    const VkQualityFileWriter::DeviceEntry device{"brand" + std::to_string(i % 40),
+                                                  "device" + std::to_string(i), 0, i};
+    base_writer.AddDevice(device);
+    target_writer.AddDevice(device);
+  }
+  target_writer.AddDevice({"google", "raven", 0, 0});
+  const std::vector<uint8_t> base = base_writer.Write();
+  const std::vector<uint8_t> target = target_writer.Write();
+
+  // An update that adds one device is much smaller than the list
+  const std::vector<uint8_t> patch = VkQualityFileWriter::CreatePatch(base, target);
+  ASSERT_GE(patch.size(), sizeof(VkQualityPatchHeader));
+  EXPECT_LT(patch.size(), target.size() / 4);
+  VkQualityPatchHeader patch_header;
+  memcpy(&patch_header, patch.data(), sizeof(patch_header));
+  EXPECT_EQ(patch_header.patch_identifier, VkQualityPatch::kPatch_File_Identifier);
+  EXPECT_EQ(patch_header.base_list_version, 1U);
+  EXPECT_EQ(patch_header.target_list_version, 2U);
+  EXPECT_EQ(patch_header.target_size, target.size());
+
+  // Patches between compressed containers carry their list versions too
+  const std::vector<uint8_t> container_patch = VkQualityFileWriter::CreatePatch(
+      VkQualityFileWriter::Compress(base), VkQualityFileWriter::Compress(target));
+  ASSERT_GE(container_patch.size(), sizeof(VkQualityPatchHeader));
+  memcpy(&patch_header, container_patch.data(), sizeof(patch_header));
+  EXPECT_EQ(patch_header.base_list_version, 1U);
+  EXPECT_EQ(patch_header.target_list_version, 2U);
+
+  EXPECT_TRUE(VkQualityFileWriter::CreatePatch(base, std::vector<uint8_t>(16)).empty());
+}
+
+TEST_F(VkQualityHostTest, PatchedList) {
+  const std::vector<uint8_t> base = MakeList(1, false);
+  const std::vector<uint8_t> target = MakeList(2, true);
+  const std::string list_path = storage_path_ + "/" + kListFilename;
+  const std::string patch_path = storage_path_ + "/update.vkqp";
+  extra_paths_.push_back(patch_path);
+  ASSERT_TRUE(WriteList(list_path, base));
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationGLESBecauseNoDeviceMatch);
+
+  // A patch made against a different list is rejected without touching the list
+  ASSERT_TRUE(WriteList(patch_path, VkQualityFileWriter::CreatePatch(MakeList(3, false),
+                                                                     target)));
+  EXPECT_EQ(vkQuality_applyListPatch(storage_path_.c_str(), kListFilename, patch_path.c_str()),
+            kErrorInvalidDataVersion);
+
+  ASSERT_TRUE(WriteList(patch_path, VkQualityFileWriter::CreatePatch(base, target)));
+  EXPECT_EQ(vkQuality_applyListPatch(storage_path_.c_str(), kListFilename, patch_path.c_str()),
+            kSuccess);
+  EXPECT_NE(access((list_path + ".patching").c_str(), F_OK), 0);
+  EXPECT_EQ(vkQuality_reload(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecauseDeviceMatch);
+}
+
+namespace {
+
+std::unique_ptr<VkQualityPredictionFile> ParseOwnedList(const std::vector<uint8_t> &list_data) {
+  void *file_bytes = malloc(list_data.size());
+  memcpy(file_bytes, list_data.data(), list_data.size());
+  auto file = std::make_unique<VkQualityPredictionFile>();
+  if (file->ParseFileData(file_bytes, list_data.size(), VKQUALITY_PACKED_VERSION) !=
+      VkQualityPredictionFile::kFileParseResult_Success) {
+    free(file_bytes);
+    return nullptr;
+  }
+  return file;
+}
+
+} // anonymous namespace
+
+TEST(VkQualityListOverlay, MergedLookup) {
+  const DeviceInfo device_info = MakeHostDevice();
+  VkQualityFileWriter base_writer(1, kFutureApi);
+  for (uint32_t i = 0; i < 100; ++i) {
+    base_writer.AddDevice({"samsung", "device" + std::to_string(i), 0, 0});
+    base_writer.AddGpuAllow({"Mali-G" + std::to_string(i), 0, 0, 0x13B5, 0});
+  }
+  std::unique_ptr<VkQualityPredictionFile> base = ParseOwnedList(base_writer.Write());
+  ASSERT_NE(base, nullptr);
+  uint32_t match_index = 0;
+  EXPECT_EQ(base->FindDeviceMatch(device_info, 0, &match_index),
+            VkQualityPredictionFile::kFileMatch_GpuAllow);
+
+  // An overlay no newer than the base is stale
+  VkQualityFileWriter stale_writer(1, kFutureApi);
+  stale_writer.AddGpuDeny({"Mali-G78", 0, 0, 0, 0});
+  EXPECT_FALSE(base->AddOverlay(ParseOwnedList(stale_writer.Write())));
+  EXPECT_EQ(base->GetOverlayCount(), 0U);
+
+  // A hotfix deny for the GPU takes precedence over the base allow entry
+  VkQualityFileWriter hotfix_writer(2, kFutureApi);
+  hotfix_writer.AddGpuDeny({"", 0, 0x92020010, 0x13B5, 0});
+  ASSERT_TRUE(base->AddOverlay(ParseOwnedList(hotfix_writer.Write())));
+  EXPECT_EQ(base->GetOverlayListVersion(), 2U);
+  EXPECT_EQ(base->FindDeviceMatch(device_info, 0, &match_index),
+            VkQualityPredictionFile::kFileMatch_GpuDeny);
+  EXPECT_EQ(match_index, 0U);
+
+  // Precedence is per stage, a device match in the base comes before the GPU stage
+  DeviceInfo listed_device = device_info;
+  listed_device.brand = "samsung";
+  listed_device.device = "device7";
+  EXPECT_EQ(base->FindDeviceMatch(listed_device, 0, &match_index),
+            VkQualityPredictionFile::kFileMatch_ExactDevice);
+
+  // Other GPUs don't match the hotfix and fall through to the base
+  DeviceInfo other_gpu = device_info;
+  other_gpu.vk_device_name = "Mali-G12";
+  other_gpu.vk_device_id = 0x12;
+  EXPECT_EQ(base->FindDeviceMatch(other_gpu, 0, &match_index),
+            VkQualityPredictionFile::kFileMatch_GpuAllow);
+
+  // A higher overlay takes precedence over a lower one, and its pattern entries
+  // are searched for every GPU
+  VkQualityFileWriter pattern_writer(3, kFutureApi);
+  pattern_writer.AddGpuAllow({"*G7", 0, 0, 0, 0});
+  pattern_writer.AddDriverDeny({"tensor", device_info.gles_version});
+  ASSERT_TRUE(base->AddOverlay(ParseOwnedList(pattern_writer.Write())));
+  EXPECT_EQ(base->GetOverlayCount(), 2U);
+  EXPECT_EQ(base->FindDeviceMatch(device_info,
+                                  kInitFlagSkipFingerprintRecommendationCheck, &match_index),
+            VkQualityPredictionFile::kFileMatch_GpuAllow);
+  // SoC names match ignoring case
+  EXPECT_EQ(base->FindDeviceMatch(device_info, 0, &match_index),
+            VkQualityPredictionFile::kFileMatch_DriverDeny);
+  EXPECT_FALSE(base->AddOverlay(ParseOwnedList(hotfix_writer.Write())));
+
+  // Only ASCII letters fold, other bytes are keyed as they are
+  DeviceInfo accented_device = device_info;
+  accented_device.soc = "t\xC9nsor";
+  EXPECT_EQ(base->FindDeviceMatch(accented_device, 0, &match_index),
+            VkQualityPredictionFile::kFileMatch_GpuAllow);
+  VkQualityFileWriter accented_writer(4, kFutureApi);
+  accented_writer.AddDriverDeny({"T\xC9NSOR", device_info.gles_version});
+  ASSERT_TRUE(base->AddOverlay(ParseOwnedList(accented_writer.Write())));
+  EXPECT_EQ(base->FindDeviceMatch(accented_device, 0, &match_index),
+            VkQualityPredictionFile::kFileMatch_DriverDeny);
+}
+
+// Overlays own their file data, rejected overlays release it right away
+TEST(VkQualityListOverlay, ReleaseData) {
+  int release_count = 0;
+  auto parse_counted = [&release_count](const std::vector<uint8_t> &list_data) {
+    auto file = std::make_unique<VkQualityPredictionFile>();
+    EXPECT_EQ(file->ParseFileData(const_cast<uint8_t *>(list_data.data()), list_data.size(),
+                                  VKQUALITY_PACKED_VERSION, CountRelease, &release_count),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    return file;
+  };
+  const std::vector<uint8_t> base_data = MakeList(2, true);
+  const std::vector<uint8_t> stale_data = MakeList(1, true);
+  const std::vector<uint8_t> hotfix_data = MakeList(3, true);
+  std::vector<VkQualityFileWriter::ShardFile> shard_files;
+  const std::vector<uint8_t> sharded_data =
+      MakeShardedListWriter(4).WriteSharded("vkqualitydata", shard_files);
+  {
+    std::unique_ptr<VkQualityPredictionFile> base = parse_counted(base_data);
+    EXPECT_FALSE(base->AddOverlay(parse_counted(stale_data)));
+    EXPECT_EQ(release_count, 1);
+    // The shards of an overlay are never loaded
+    EXPECT_FALSE(base->AddOverlay(parse_counted(sharded_data)));
+    EXPECT_EQ(release_count, 2);
+    EXPECT_TRUE(base->AddOverlay(parse_counted(hotfix_data)));
+    EXPECT_EQ(release_count, 2);
+  }
+  // Accepted overlays are released with the base file
+  EXPECT_EQ(release_count, 4);
+}
+
+// The writer stores brand keys with aliases resolved, so casing variants share
+// rows, and every search path finds them through the brand key of the device
+TEST(VkQualityBrandKeys, WriterAliases) {
+  VkQualityFileWriter writer(1, kFutureApi);
+  writer.AddDevice({"Samsung", "SM-1", 0, 0});
+  writer.AddDevice({"samsung", "SM-1", 0, 0});
+  writer.AddDevice({"SAMSUNG ", "", 99, 0});
+  writer.AddDevice({"Redmi", "r1", 0, 0});
+  writer.AddDevice({"xiaomi", "x1", 0, 0});
+  writer.AddBrandAlias("Redmi", "Xiaomi");
+  // Aliases aren't chained, and the first alias of a brand key is used
+  writer.AddBrandAlias("POCO", "redmi");
+  writer.AddBrandAlias("redmi ", "samsung");
+  const std::vector<uint8_t> list_data = writer.Write();
+  std::unique_ptr<VkQualityPredictionFile> file = ParseOwnedList(list_data);
+  ASSERT_NE(file, nullptr);
+  EXPECT_TRUE(file->HasBrandAliases());
+  const VkQualityFileHeader *header =
+      reinterpret_cast<const VkQualityFileHeader *>(list_data.data());
+  EXPECT_EQ(header->file_format_version, VkQualityPredictionFile::kBrandKey_File_Format_Version);
+  EXPECT_EQ(header->device_list_count, 4U);
+
+  std::vector<VkQualityFileWriter::ShardFile> shard_files;
+  const std::vector<uint8_t> root_data = writer.WriteSharded("vkqualitydata", shard_files);
+  ASSERT_EQ(shard_files.size(), 2U);
+  EXPECT_EQ(shard_files[1].name, "vkqualitydata_x.vkq");
+  std::unique_ptr<VkQualityPredictionFile> root_file = ParseOwnedList(root_data);
+  ASSERT_NE(root_file, nullptr);
+  root_file->SetShardLoader([&shard_files](const char *shard_name, size_t &shard_size) {
+    for (const VkQualityFileWriter::ShardFile &shard_file : shard_files) {
+      if (shard_file.name == shard_name) {
+        shard_size = shard_file.data.size();
+        void *shard_bytes = malloc(shard_size);
+        memcpy(shard_bytes, shard_file.data.data(), shard_size);
+        return shard_bytes;
+      }
+    }
+    return static_cast<void *>(nullptr);
+  });
+
+  // A base file without xiaomi devices, and a hotfix that adds them
+  VkQualityFileWriter base_writer(1, kFutureApi);
+  base_writer.AddDevice({"samsung", "SM-1", 0, 0});
+  base_writer.AddDevice({"samsung", "", 99, 0});
+  std::unique_ptr<VkQualityPredictionFile> layered_file = ParseOwnedList(base_writer.Write());
+  ASSERT_NE(layered_file, nullptr);
+  VkQualityFileWriter hotfix_writer(2, kFutureApi);
+  hotfix_writer.AddDevice({"Xiaomi", "r1", 0, 0});
+  hotfix_writer.AddDevice({"Xiaomi", "x1", 0, 0});
+  hotfix_writer.AddBrandAlias("redmi", "xiaomi");
+  ASSERT_TRUE(layered_file->AddOverlay(ParseOwnedList(hotfix_writer.Write())));
+
+  const struct {
+    const char *brand;
+    const char *device;
+    VkQualityPredictionFile::FileMatchResult match_result;
+  } brand_matches[] = {
+      {"samsung", "SM-1", VkQualityPredictionFile::kFileMatch_ExactDevice},
+      {"Samsung", "SM-2", VkQualityPredictionFile::kFileMatch_None},
+      {"Redmi", "r1", VkQualityPredictionFile::kFileMatch_ExactDevice},
+      {"REDMI", "x1", VkQualityPredictionFile::kFileMatch_ExactDevice},
+      {" Xiaomi", "r1", VkQualityPredictionFile::kFileMatch_ExactDevice},
+      {"poco", "x1", VkQualityPredictionFile::kFileMatch_None},
+      {"xiaomi", "x2", VkQualityPredictionFile::kFileMatch_None}
+  };
+  for (const auto &brand_match : brand_matches) {
+    DeviceInfo device_info = MakeHostDevice();
+    device_info.brand = brand_match.brand;
+    device_info.device = brand_match.device;
+    uint32_t match_index = 0;
+    EXPECT_EQ(file->SearchDeviceList(device_info, match_index), brand_match.match_result)
+        << brand_match.brand << " " << brand_match.device;
+    EXPECT_EQ(root_file->SearchDeviceList(device_info, match_index), brand_match.match_result)
+        << brand_match.brand << " " << brand_match.device;
+    VkQualityPagedFile paged_file(
+        [&list_data](uint64_t offset, void *buffer, size_t size) {
+          memcpy(buffer, list_data.data() + offset, size);
+          return size;
+        },
+        list_data.size(), 256, 2);
+    ASSERT_EQ(paged_file.Open(VKQUALITY_PACKED_VERSION),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_EQ(paged_file.FindDeviceMatch(device_info, 0),
+              file->FindDeviceMatch(device_info, 0))
+        << brand_match.brand << " " << brand_match.device;
+    EXPECT_EQ(layered_file->FindDeviceMatch(device_info, 0),
+              file->FindDeviceMatch(device_info, 0))
+        << brand_match.brand << " " << brand_match.device;
+  }
+}
+
+// Rules match a range of driver builds of a SoC, after the exact fingerprints
+TEST(VkQualityDriverRules, WriterRules) {
+  const DeviceInfo device_info = MakeHostDevice();
+  VkQualityFileWriter writer(1, kFutureApi);
+  writer.AddDevice({"google", "raven", 0, 0});
+  writer.AddDriverAllow({"Tensor", "OpenGL ES 3.2 v1.r38p0"});
+  writer.AddDriverAllowRule({"tensor", VkQualityDriverVersion::kVersionFormat_Arm,
+                             VkQualityDriverVersion::MakeVersion(38, 0, 0), 0});
+  writer.AddDriverDenyRule({"Exynos 2100", VkQualityDriverVersion::kVersionFormat_Arm, 0, 0});
+  writer.AddDriverDenyRule({"Tensor", VkQualityDriverVersion::kVersionFormat_Arm,
+                            VkQualityDriverVersion::MakeVersion(30, 0, 0),
+                            VkQualityDriverVersion::MakeVersion(32, 0xFFFF, 0)});
+  const std::vector<uint8_t> list_data = writer.Write();
+  std::unique_ptr<VkQualityPredictionFile> file = ParseOwnedList(list_data);
+  ASSERT_NE(file, nullptr);
+  EXPECT_TRUE(file->HasDriverRules());
+
+  // Rules ship in the root file of a sharded list
+  std::vector<VkQualityFileWriter::ShardFile> shard_files;
+  std::unique_ptr<VkQualityPredictionFile> root_file =
+      ParseOwnedList(writer.WriteSharded("vkqualitydata", shard_files));
+  ASSERT_NE(root_file, nullptr);
+
+  // The same rules from a hotfix over a base without them
+  VkQualityFileWriter base_writer(1, kFutureApi);
+  base_writer.AddDevice({"google", "raven", 0, 0});
+  std::unique_ptr<VkQualityPredictionFile> layered_file = ParseOwnedList(base_writer.Write());
+  ASSERT_NE(layered_file, nullptr);
+  VkQualityFileWriter hotfix_writer(2, kFutureApi);
+  hotfix_writer.AddDriverDenyRule({"TENSOR", VkQualityDriverVersion::kVersionFormat_Arm,
+                                   VkQualityDriverVersion::MakeVersion(30, 0, 0),
+                                   VkQualityDriverVersion::MakeVersion(32, 0xFFFF, 0)});
+  ASSERT_TRUE(layered_file->AddOverlay(ParseOwnedList(hotfix_writer.Write())));
+
+  const struct {
+    const char *gles_version;
+    VkQualityPredictionFile::FileMatchResult match_result;
+  } rule_matches[] = {
+      {"OpenGL ES 3.2 v1.r38p0", VkQualityPredictionFile::kFileMatch_DriverAllow},
+      {"OpenGL ES 3.2 v1.r38p1-01eac0", VkQualityPredictionFile::kFileMatch_DriverRuleAllow},
+      {"OpenGL ES 3.2 v1.r32p1-00pxl0.b7e5868a59a273f4a9f58d1657ef99de",
+       VkQualityPredictionFile::kFileMatch_DriverRuleDeny},
+      {"OpenGL ES 3.2 v1.r29p0", VkQualityPredictionFile::kFileMatch_ExactDevice},
+      {"OpenGL ES 3.2 v1.g2p0", VkQualityPredictionFile::kFileMatch_ExactDevice}
+  };
+  for (const auto &rule_match : rule_matches) {
+    DeviceInfo rule_device = device_info;
+    rule_device.gles_version = rule_match.gles_version;
+    EXPECT_EQ(file->FindDeviceMatch(rule_device, 0), rule_match.match_result)
+        << rule_match.gles_version;
+    // Without a shard loader the root file finds no devices
+    EXPECT_EQ(root_file->FindDeviceMatch(rule_device, 0),
+              (rule_match.match_result == VkQualityPredictionFile::kFileMatch_ExactDevice) ?
+              VkQualityPredictionFile::kFileMatch_None : rule_match.match_result)
+        << rule_match.gles_version;
+    VkQualityPagedFile paged_file(
+        [&list_data](uint64_t offset, void *buffer, size_t size) {
+          memcpy(buffer, list_data.data() + offset, size);
+          return size;
+        },
+        list_data.size(), 256, 2);
+    ASSERT_EQ(paged_file.Open(VKQUALITY_PACKED_VERSION),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_EQ(paged_file.FindDeviceMatch(rule_device, 0), rule_match.match_result)
+        << rule_match.gles_version;
+    if (rule_match.match_result != VkQualityPredictionFile::kFileMatch_DriverRuleDeny) {
+      EXPECT_EQ(layered_file->FindDeviceMatch(rule_device, 0),
+                VkQualityPredictionFile::kFileMatch_ExactDevice) << rule_match.gles_version;
+    } else {
+      EXPECT_EQ(layered_file->FindDeviceMatch(rule_device, 0),
+                VkQualityPredictionFile::kFileMatch_DriverRuleDeny) << rule_match.gles_version;
+    }
+  }
+
+  // Rule matches are reported as their own match type, indexed within their section
+  vkqDeviceDescription device_description{};
+  device_description.brand = device_info.brand.c_str();
+  device_description.device = device_info.device.c_str();
+  device_description.soc = device_info.soc.c_str();
+  device_description.gles_version = device_info.gles_version.c_str();
+  device_description.vk_device_name = device_info.vk_device_name.c_str();
+  device_description.api_level = device_info.api_level;
+  device_description.vk_api_version = device_info.vk_api_version;
+  device_description.vk_driver_version = device_info.vk_driver_version;
+  device_description.vk_device_id = device_info.vk_device_id;
+  device_description.vk_vendor_id = device_info.vk_vendor_id;
+  vkqEvaluationResult result{};
+  EXPECT_EQ(vkQuality_evaluateDevice(&device_description, list_data.data(), list_data.size(),
+                                     0, &result),
+            kSuccess);
+  EXPECT_EQ(result.recommendation, kRecommendationGLESBecausePredictionMatch);
+  EXPECT_EQ(result.match_type, kMatchTypeDriverRuleDeny);
+  EXPECT_EQ(result.match_index, 1);
+  device_description.gles_version = "OpenGL ES 3.2 v1.r40p0";
+  EXPECT_EQ(vkQuality_evaluateDevice(&device_description, list_data.data(), list_data.size(),
+                                     0, &result),
+            kSuccess);
+  EXPECT_EQ(result.recommendation, kRecommendationVulkanBecausePredictionMatch);
+  EXPECT_EQ(result.match_type, kMatchTypeDriverRuleAllow);
+  EXPECT_EQ(result.match_index, 0);
+}
+
+// Vulkan format rules match the driverVersion decoded by vendor, and list
+// authors encode raw minimum versions from the same decoded form
+TEST(VkQualityDriverRules, VulkanDriverVersion) {
+  VkQualityFileWriter writer(1, kFutureApi);
+  writer.AddDriverDenyRule({"SM8450", VkQualityDriverVersion::kVersionFormat_Vulkan, 0,
+                            VkQualityDriverVersion::MakeVersion(614, 0xFFFF, 0)});
+  writer.AddDriverAllowRule({"Tensor", VkQualityDriverVersion::kVersionFormat_Vulkan,
+                             VkQualityDriverVersion::MakeVersion(38, 1, 0), 0});
+  // Build.SOC is empty before API level 31, a rule without a SoC matches by vendor
+  writer.AddDriverDenyRule({"", VkQualityDriverVersion::kVersionFormat_Vulkan, 0,
+                            VkQualityDriverVersion::MakeVersion(512, 0xFFFF, 0),
+                            VkQualityDriverVersion::kVendorId_Qualcomm});
+  writer.AddGpuAllow({"Adreno (TM) 730", 0, 0, 0,
+                      VkQualityDriverVersion::EncodeVulkanDriverVersion(
+                          VkQualityDriverVersion::kVendorId_Qualcomm,
+                          VkQualityDriverVersion::MakeVersion(676, 0, 0))});
+  const std::vector<uint8_t> list_data = writer.Write();
+  std::unique_ptr<VkQualityPredictionFile> file = ParseOwnedList(list_data);
+  ASSERT_NE(file, nullptr);
+  VkQualityPagedFile paged_file(
+      [&list_data](uint64_t offset, void *buffer, size_t size) {
+        memcpy(buffer, list_data.data() + offset, size);
+        return size;
+      },
+      list_data.size(), 256, 2);
+  ASSERT_EQ(paged_file.Open(VKQUALITY_PACKED_VERSION),
+            VkQualityPredictionFile::kFileParseResult_Success);
+
+  DeviceInfo adreno_device = MakeHostDevice();
+  adreno_device.soc = "SM8450";
+  adreno_device.vk_device_name = "Adreno (TM) 730";
+  adreno_device.vk_vendor_id = VkQualityDriverVersion::kVendorId_Qualcomm;
+  DeviceInfo legacy_adreno_device = adreno_device;
+  legacy_adreno_device.soc = "";
+  DeviceInfo mali_device = MakeHostDevice();
+  const struct {
+    const DeviceInfo &device_info;
+    uint32_t vk_driver_version;
+    VkQualityPredictionFile::FileMatchResult match_result;
+  } rule_matches[] = {
+      {adreno_device, 0x80266000U, VkQualityPredictionFile::kFileMatch_DriverRuleDeny},
+      {adreno_device, 0x80267000U, VkQualityPredictionFile::kFileMatch_None},
+      {adreno_device, 2150252544U, VkQualityPredictionFile::kFileMatch_GpuAllow},
+      {adreno_device, 0, VkQualityPredictionFile::kFileMatch_None},
+      {legacy_adreno_device, 0x80200000U, VkQualityPredictionFile::kFileMatch_DriverRuleDeny},
+      {legacy_adreno_device, 0x80266000U, VkQualityPredictionFile::kFileMatch_None},
+      {mali_device, (32U << 22), VkQualityPredictionFile::kFileMatch_None},
+      {mali_device, (38U << 22) | (1U << 12), VkQualityPredictionFile::kFileMatch_DriverRuleAllow},
+      {mali_device, (38U << 22), VkQualityPredictionFile::kFileMatch_None}
+  };
+  for (const auto &rule_match : rule_matches) {
+    DeviceInfo device_info = rule_match.device_info;
+    device_info.vk_driver_version = rule_match.vk_driver_version;
+    EXPECT_EQ(file->FindDeviceMatch(device_info, 0), rule_match.match_result)
+        << device_info.soc << " " << rule_match.vk_driver_version;
+    EXPECT_EQ(paged_file.FindDeviceMatch(device_info, 0), rule_match.match_result)
+        << device_info.soc << " " << rule_match.vk_driver_version;
+  }
+}
+
+TEST_F(VkQualityHostTest, HotfixList) {
+  const std::string hotfix_path = storage_path_ + "/vkqualitydata_hotfix.vkq";
+  extra_paths_.push_back(hotfix_path);
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename, MakeList(2, true)));
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecauseDeviceMatch);
+
+  // The hotfix deny applies on reload, and invalidates the cached recommendation
+  VkQualityFileWriter hotfix_writer(3, kFutureApi);
+  hotfix_writer.AddDriverDeny({"Tensor", MakeHostDevice().gles_version});
+  ASSERT_TRUE(WriteList(hotfix_path, hotfix_writer.Write()));
+  EXPECT_EQ(vkQuality_reload(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationGLESBecausePredictionMatch);
+  vkQuality_destroy(host::GetHostJNIEnv());
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationGLESBecausePredictionMatch);
+  vkQuality_destroy(host::GetHostJNIEnv());
+
+  // A hotfix older than an updated list is ignored
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename, MakeList(4, true)));
+  EXPECT_EQ(Initialize(), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecauseDeviceMatch);
+}
+
+TEST(VkQualityChecksumSection, Verify) {
+  std::vector<uint8_t> list_data = MakeList(1, true);
+  uint32_t content_checksum = 0;
+  {
+    VkQualityPredictionFile file;
+    ASSERT_EQ(file.ParseFileData(list_data.data(), list_data.size(), VKQUALITY_PACKED_VERSION,
+                                 nullptr), VkQualityPredictionFile::kFileParseResult_Success);
+    content_checksum = file.GetContentChecksum();
+    EXPECT_NE(content_checksum, 0U);
+  }
+  EXPECT_NE(ParseOwnedList(MakeList(1, false))->GetContentChecksum(), content_checksum);
+
+  // Change the case of a letter in a string, which every other check accepts
+  VkQualityFileHeader header;
+  memcpy(&header, list_data.data(), sizeof(header));
+  size_t corrupt_offset = list_data.size();
+  for (uint32_t i = 0; i < header.string_table_count; ++i) {
+    uint32_t string_offset;
+    memcpy(&string_offset, list_data.data() + header.string_table_offset + i * sizeof(uint32_t),
+           sizeof(string_offset));
+    if (list_data[string_offset] != 0) {
+      corrupt_offset = string_offset;
+      break;
+    }
+  }
+  ASSERT_LT(corrupt_offset, list_data.size());
+  std::vector<uint8_t> corrupt_data = list_data;
+  corrupt_data[corrupt_offset] ^= 0x20;
+  {
+    VkQualityPredictionFile file;
+    EXPECT_EQ(file.ParseFileData(corrupt_data.data(), corrupt_data.size(),
+                                 VKQUALITY_PACKED_VERSION, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Error_ChecksumMismatch);
+  }
+  {
+    VkQualityPredictionFile file;
+    file.SetValidationMode(VkQualityPredictionFile::kValidation_Lazy);
+    EXPECT_EQ(file.ParseFileData(corrupt_data.data(), corrupt_data.size(),
+                                 VKQUALITY_PACKED_VERSION, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Error_ChecksumMismatch);
+  }
+  {
+    VkQualityPredictionFile file;
+    file.SetVerifyChecksum(false);
+    EXPECT_EQ(file.ParseFileData(corrupt_data.data(), corrupt_data.size(),
+                                 VKQUALITY_PACKED_VERSION, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_EQ(file.GetContentChecksum(), content_checksum);
+  }
+
+  // Extra data appended to the file fails the size check
+  std::vector<uint8_t> extended_data = list_data;
+  extended_data.push_back(0);
+  VkQualityPredictionFile extended_file;
+  EXPECT_EQ(extended_file.ParseFileData(extended_data.data(), extended_data.size(),
+                                        VKQUALITY_PACKED_VERSION, nullptr),
+            VkQualityPredictionFile::kFileParseResult_Error_ChecksumMismatch);
+}
+
+TEST(VkQualityPagedList, MatchesInMemory) {
+  VkQualityFileWriter writer(1, kFutureApi);
+  const char *brands[] = {"google", "samsung", "Sony", "xiaomi", "1plus", "motorola"};
+  for (const char *brand : brands) {
+    writer.AddDevice({brand, "", 33, 0});
+    for (uint32_t i = 0; i < 200; ++i) {
+      writer.AddDevice({brand, "device" + std::to_string(i), (i % 3 == 0) ? 34U : 0U, 0});
+    }
+  }
+  for (uint32_t i = 0; i < 100; ++i) {
+    writer.AddGpuAllow({"Adreno (TM) " + std::to_string(600 + i), 0, 0, 0, 0});
+    writer.AddGpuDeny({"", 0, 0x1000 + i, 0x5143, 0});
+    writer.AddDriverAllow({"SM8" + std::to_string(i), "OpenGL ES 3.2 V@" + std::to_string(i)});
+  }
+  writer.AddGpuDeny({"^PowerVR", 0, 0, 0, 0});
+  writer.AddDriverDeny({"Tensor", "OpenGL ES 3.2 bad"});
+  std::vector<uint8_t> list_data = writer.Write();
+
+  VkQualityPredictionFile file;
+  ASSERT_EQ(file.ParseFileData(list_data.data(), list_data.size(), VKQUALITY_PACKED_VERSION,
+                               nullptr), VkQualityPredictionFile::kFileParseResult_Success);
+  const std::vector<uint8_t> *read_data = &list_data;
+  auto read_function = [&read_data](uint64_t offset, void *buffer, size_t size) {
+    memcpy(buffer, read_data->data() + offset, size);
+    return size;
+  };
+  VkQualityPagedFile paged_file(read_function, list_data.size(), 256, 4);
+  ASSERT_EQ(paged_file.Open(VKQUALITY_PACKED_VERSION),
+            VkQualityPredictionFile::kFileParseResult_Success);
+
+  std::vector<DeviceInfo> device_infos;
+  for (const char *brand : {"google", "samsung", "Sony", "sony", "xiaomi", "1plus", "nokia"}) {
+    for (const char *device : {"", "device0", "device1", "device199", "device200"}) {
+      for (const int32_t api_level : {33, 34}) {
+        DeviceInfo device_info = MakeHostDevice();
+        device_info.brand = brand;
+        device_info.device = device;
+        device_info.api_level = api_level;
+        device_infos.push_back(device_info);
+      }
+    }
+  }
+  for (const char *gpu_name : {"Adreno (TM) 640", "Adreno (TM) 700", "PowerVR Rogue GE8320"}) {
+    DeviceInfo device_info = MakeHostDevice();
+    device_info.brand = "nokia";
+    device_info.vk_device_name = gpu_name;
+    device_infos.push_back(device_info);
+  }
+  DeviceInfo gpu_id_device = MakeHostDevice();
+  gpu_id_device.brand = "nokia";
+  gpu_id_device.vk_device_id = 0x1010;
+  gpu_id_device.vk_vendor_id = 0x5143;
+  device_infos.push_back(gpu_id_device);
+  for (const char *soc : {"sm850", "SM850", "Tensor"}) {
+    DeviceInfo device_info = MakeHostDevice();
+    device_info.soc = soc;
+    device_info.gles_version = "OpenGL ES 3.2 V@50";
+    device_infos.push_back(device_info);
+  }
+  device_infos.back().gles_version = "OpenGL ES 3.2 bad";
+
+  for (const DeviceInfo &device_info : device_infos) {
+    uint32_t match_index = UINT32_MAX;
+    uint32_t paged_match_index = UINT32_MAX;
+    const VkQualityPredictionFile::FileMatchResult match_result =
+        file.FindDeviceMatch(device_info, 0, &match_index);
+    EXPECT_EQ(paged_file.FindDeviceMatch(device_info, 0, &paged_match_index), match_result)
+        << device_info.brand << " " << device_info.device << " " << device_info.vk_device_name;
+    EXPECT_EQ(paged_match_index, match_index);
+  }
+
+  // The brand index keeps a device search to a small part of the file
+  const uint64_t page_reads = paged_file.GetPageReadCount();
+  const uint64_t file_pages = list_data.size() / 256;
+  DeviceInfo device_info = MakeHostDevice();
+  device_info.brand = "xiaomi";
+  device_info.device = "device150";
+  EXPECT_EQ(paged_file.FindDeviceMatch(device_info, kInitFlagSkipFingerprintRecommendationCheck),
+            file.FindDeviceMatch(device_info, kInitFlagSkipFingerprintRecommendationCheck));
+  EXPECT_GT(file_pages, 128U);
+  EXPECT_LT(paged_file.GetPageReadCount() - page_reads, file_pages / 4);
+
+  // The checksum is verified while streaming
+  std::vector<uint8_t> corrupt_data = list_data;
+  corrupt_data[corrupt_data.size() / 2] ^= 0x01;
+  read_data = &corrupt_data;
+  {
+    VkQualityPagedFile corrupt_file(read_function, corrupt_data.size(), 256, 4);
+    EXPECT_EQ(corrupt_file.Open(VKQUALITY_PACKED_VERSION),
+              VkQualityPredictionFile::kFileParseResult_Error_ChecksumMismatch);
+  }
+  {
+    VkQualityPagedFile corrupt_file(read_function, corrupt_data.size(), 256, 4);
+    corrupt_file.SetVerifyChecksum(false);
+    EXPECT_EQ(corrupt_file.Open(VKQUALITY_PACKED_VERSION),
+              VkQualityPredictionFile::kFileParseResult_Success);
+  }
+
+  // Compressed containers need decoding as a whole
+  std::vector<uint8_t> compressed_data = VkQualityFileWriter::Compress(list_data);
+  read_data = &compressed_data;
+  VkQualityPagedFile compressed_file(read_function, compressed_data.size());
+  EXPECT_EQ(compressed_file.Open(VKQUALITY_PACKED_VERSION),
+            VkQualityPredictionFile::kFileParseResult_Error_InvalidIdentifier);
+}
+
+TEST(VkQualityInternedStrings, MatchesStringSearch) {
+  VkQualityFileWriter writer(1, kFutureApi);
+  for (const char *brand : {"google", "Google", "samsung"}) {
+    writer.AddDevice({brand, "", 34, 0});
+    for (uint32_t i = 0; i < 20; ++i) {
+      writer.AddDevice({brand, "device" + std::to_string(i), (i % 2 == 0) ? 34U : 0U, 0});
+    }
+  }
+  for (uint32_t i = 0; i < 20; ++i) {
+    writer.AddDriverAllow({"SM8" + std::to_string(i), "OpenGL ES 3.2 V@" + std::to_string(i)});
+    writer.AddDriverDeny({"sm8" + std::to_string(i), "OpenGL ES 3.2 V@" + std::to_string(i + 5)});
+  }
+  std::vector<uint8_t> list_data = writer.Write();
+  VkQualityPredictionFile file;
+  VkQualityPredictionFile interned_file;
+  interned_file.SetStringIndex(true);
+  ASSERT_EQ(file.ParseFileData(list_data.data(), list_data.size(), VKQUALITY_PACKED_VERSION,
+                               nullptr), VkQualityPredictionFile::kFileParseResult_Success);
+  ASSERT_EQ(interned_file.ParseFileData(list_data.data(), list_data.size(),
+                                        VKQUALITY_PACKED_VERSION, nullptr),
+            VkQualityPredictionFile::kFileParseResult_Success);
+  ASSERT_TRUE(interned_file.HasInternedStrings());
+
+  uint32_t tested_matches = 0;
+  for (const char *brand : {"google", "Google", "GOOGLE", "samsung", ""}) {
+    for (const char *device : {"", "device0", "device1", "device20"}) {
+      for (const char *soc : {"", "SM81", "sm81", "Sm819", "SM899"}) {
+        for (const char *fingerprint : {"", "OpenGL ES 3.2 V@1", "OpenGL ES 3.2 V@6"}) {
+          for (const int32_t api_level : {33, 34}) {
+            DeviceInfo device_info = MakeHostDevice();
+            device_info.brand = brand;
+            device_info.device = device;
+            device_info.soc = soc;
+            device_info.gles_version = fingerprint;
+            device_info.api_level = api_level;
+            uint32_t match_index = UINT32_MAX;
+            uint32_t interned_match_index = UINT32_MAX;
+            const VkQualityPredictionFile::FileMatchResult match_result =
+                file.FindDeviceMatch(device_info, 0, &match_index);
+            EXPECT_EQ(interned_file.FindDeviceMatch(device_info, 0, &interned_match_index),
+                      match_result) << brand << " " << device << " " << soc << " "
+                                    << fingerprint;
+            EXPECT_EQ(interned_match_index, match_index);
+            tested_matches += (match_result != VkQualityPredictionFile::kFileMatch_None);
+          }
+        }
+      }
+    }
+  }
+  EXPECT_GT(tested_matches, 100U);
+}
+
+TEST_F(VkQualityHostTest, CorruptList) {
+  std::vector<uint8_t> list_data = MakeList(1, true);
+  list_data.back() ^= 0xFF;
+  ASSERT_TRUE(WriteList(storage_path_ + "/" + kListFilename, list_data));
+  EXPECT_EQ(Initialize(), kErrorInvalidDataFile);
+  vkQuality_destroy(host::GetHostJNIEnv());
+
+  // Only app bundle assets can skip verification
+  EXPECT_EQ(vkQuality_initializeFlags(host::GetHostJNIEnv(), asset_manager_,
+                                      storage_path_.c_str(), kListFilename,
+                                      kInitFlagSkipAssetChecksum), kErrorInvalidDataFile);
+  vkQuality_destroy(host::GetHostJNIEnv());
+  unlink((storage_path_ + "/" + kListFilename).c_str());
+  ASSERT_TRUE(WriteList(asset_path_ + "/" + kListFilename, list_data));
+  EXPECT_EQ(Initialize(), kErrorInvalidDataFile);
+  vkQuality_destroy(host::GetHostJNIEnv());
+  EXPECT_EQ(vkQuality_initializeFlags(host::GetHostJNIEnv(), asset_manager_,
+                                      storage_path_.c_str(), kListFilename,
+                                      kInitFlagSkipAssetChecksum), kSuccess);
+  EXPECT_EQ(vkQuality_getRecommendation(), kRecommendationVulkanBecauseDeviceMatch);
+}
@@ -20,132 +20,16 @@
 #include <android/asset_manager.h>
 #include <cstdint>
 #include <jni.h>
+#include "vkquality_core.h"
 
 /**
- * @brief Flag bitfields that cam be passed to ::vkQuality_initializeFlags
- * in the flags parameter.
+ * @brief Opaque handle to an independent VkQuality recommendation context.
+ * Contexts do not share state with each other or with the default context
+ * used by ::vkQuality_initialize and related functions, so multiple quality
+ * data files can be evaluated concurrently in a single process.
+ * @see vkQuality_createContext
  */
- enum vkQualityInitFlags : int32_t {
-     /**
-      * @brief Disable the quality check against the SoC/driver fingerprint additional
-      * allow/deny list introduced in version 1.2
-      */
-     kInitFlagSkipFingerprintRecommendationCheck = (1 << 2)
- };
-
-/**
- * @brief Result codes returned by ::vkQuality_initialize.
- */
-enum vkQualityInitResult : int32_t {
-  /**
-   * @brief VKQuality initialization was successful.
-   */
-  kSuccess = 0,
-  /**
-   * @brief VkQuality failed to initialize, unspecified reason
-   */
-  kErrorInitializationFailure = -1,
-  /**
-   * @brief VkQuality failed to initialize, Vulkan was either
-   * not available on the device or couldn't be initialized
-   */
-  kErrorNoVulkan = -2,
-  /**
-   * @brief VkQuality failed to initialize, specified quality
-   * data file was an incompatible version
-   */
-  kErrorInvalidDataVersion = -3,
-  /**
-   * @brief VkQuality failed to initialize, specified quality
-   * data file was invalid
-   */
-  kErrorInvalidDataFile = -4,
-  /**
-   * @brief VkQuality failed to initialize, specified quality
-   * data file could not be found in the app bundle or
-   * in the storage directory
-   */
-  kErrorMissingDataFile = -5
-};
-
-/**
- * @brief API recommendation returned by ::vkQuality_getRecommendation.
- */
-enum vkQualityRecommendation : int32_t {
-  /**
-   * @brief A recommendation is not yet ready, call ::vkQuality_getRecommendation
-   * again after a brief interval.
-   */
-  kRecommendationNotReady = -2,
-  /**
-   * @brief VkQuality is not initialized. Either ::vkQuality_initialize was
-   * not called or it returned a failure code.
-   */
-  kRecommendationErrorNotInitialized = -1,
-  /**
-   * @brief Recommend using the Vulkan API. Reason is a device match
-   * was found in the device allow list
-   */
-  kRecommendationVulkanBecauseDeviceMatch = 0,
-  /**
-   * @brief Recommend using the Vulkan API. Reason is a GPU/driver match
-   * was found in the predicted quality allow list
-   */
-  kRecommendationVulkanBecausePredictionMatch,
-  /**
-   * @brief Recommend using the Vulkan API. Reason is device is running
-   * on a higher version of Android beyond what is covered by this
-   * release of VkQuality
-   */
-  kRecommendationVulkanBecauseFutureAndroid,
-  /**
-   * @brief Recommend using the OpenGL ES API. Reason is the device
-   * is running on a version of Android lower than 10, or only
-   * supports Vulkan 1.0.x
-   */
-  kRecommendationGLESBecauseOldDevice,
-  /**
-   * @brief Recommend using the GLES API. Reason is a device match
-   * was found in the device allow list, but its Vulkan driver version
-   * was below a specified minimum version number
-   */
-  kRecommendationGLESBecauseOldDriver,
-  /**
-   * @brief Recommend using the OpenGL ES API. Reason is no matches
-   * were found in the Vulkan device allow list or Vulkan predicted
-   * quality list
-   */
-  kRecommendationGLESBecauseNoDeviceMatch,
-  /**
-   * @brief Recommend using the OpenGL ES API. Reason is a GPU/driver match
-   * was found in the predicted quality deny list
-   */
-  kRecommendationGLESBecausePredictionMatch
-};
-
-/**
- * @brief Struct used to optionally pass graphics API information to
- * ::vkQuality_initializeFlagsInfo so the library can use it for
- * making a recommendation without having to stand up a graphics API
- * instance to query. Pointers in the struct may be null and are
- * only expected to be valid until return from ::vkQuality_initializeFlagsInfo
- */
-typedef struct vkqGraphicsAPIInfo {
-  /**
-   * @brief If non-null, expected to be a pointer containing the contents
-   * of calling glGetString with the GL_VERSION enum. If a string is provided,
-   * the library will not create a GL instance and instead use the string.
-   */
-   const char *gles_version_string;
-
-  /**
-   * @brief If non-null, expected to be a pointer to a valid 
-   * `vkGetPhysicalDeviceProperties` structure. If provided, the library
-   * will use the data in this structure instead of creating a Vulkan
-   * instance to retrieve it.
-   */
-   void *vk_physical_device_properties;
-} vkqGraphicsAPIInfo;
+typedef struct vkQualityContext_T *vkQualityContext;
 
 #ifdef __cplusplus
 extern "C" {
@@ -165,7 +49,9 @@ extern "C" {
  * and quality data file lookup outside the application bundle.
  * @param asset_filename The name of the quality data file. This can be a partial
  * path, but must exist in either the app bundle assets, or in the directory
- * referenced by `storage_path`
+ * referenced by `storage_path`. A hotfix file in the storage directory, named
+ * like the quality data file with `_hotfix` before the `.vkq` extension, is
+ * layered over the quality data file and takes precedence where they differ.
  * @return `kSuccess` if successful, otherwise an error code relating
  * to initialization failure.
  * @see vkQuality_destroy
@@ -232,6 +118,39 @@ vkQualityInitResult vkQuality_initializeFlags(JNIEnv *env, AAssetManager *asset_
                                          const vkqGraphicsAPIInfo *api_info,
                                          int32_t flags);                                        
 
+/**
+ * @brief Initialize VkQuality using quality data file contents that are
+ * already in memory, such as a file extracted from an application archive or
+ * downloaded by the application. The data is used in place without copying.
+ * @param env The JNIEnv attached to the thread calling the function.
+ * @param list_data Pointer to the contents of a quality data file.
+ * @param list_size Size of the quality data file in bytes.
+ * @param release_function Function called when VkQuality no longer needs
+ * `list_data`. It is always called exactly once, including when initialization
+ * fails, and may be called before this function returns. It is called once the
+ * recommendation has been determined. If nullptr, the data is borrowed: it must remain valid and
+ * unmodified until it would have been released, or ::vkQuality_destroy returns.
+ * @param release_user_data User data passed to `release_function`.
+ * @param storage_path An optional absolute path to a storage directory used for
+ * the recommendation cache file. The quality data file is not looked up in this
+ * directory. Passing nullptr will disable recommendation caching.
+ * @param api_info An optional pointer to a ::vkqGraphicsAPIInfo structure, with
+ * the same behavior as the `api_info` parameter of ::vkQuality_initializeFlagsInfo.
+ * @param flags A bit field of ::vkQualityInitFlags enum values specifying
+ * initialization flags to alter default behavior. `kInitFlagWatchStoragePath`
+ * is ignored, and ::vkQuality_reload has no data file to reload.
+ * @return `kSuccess` if successful, otherwise an error code relating
+ * to initialization failure.
+ * @see vkQuality_destroy
+ */
+vkQualityInitResult vkQuality_initializeFromMemory(JNIEnv *env, const void *list_data,
+                                                   size_t list_size,
+                                                   vkqListDataRelease release_function,
+                                                   void *release_user_data,
+                                                   const char *storage_path,
+                                                   const vkqGraphicsAPIInfo *api_info,
+                                                   int32_t flags);
+
 /**
  * @brief Destroy resources that VkQuality has created.
  * @param env The JNIEnv attached to the thread calling the function.
@@ -245,6 +164,94 @@ void vkQuality_destroy(JNIEnv *env);
  */
 vkQualityRecommendation vkQuality_getRecommendation();
 
+/**
+ * @brief Retrieve the physical device the recommendation is for. When a device
+ * has more than one physical device with a graphics queue, each is evaluated
+ * and a device recommended for Vulkan is preferred.
+ * @return The index of the physical device in the order returned by
+ * `vkEnumeratePhysicalDevices`, or -1 if the Vulkan information came from
+ * the `api_info` parameter or no physical device was found.
+ */
+int32_t vkQuality_getRecommendedDeviceIndex();
+
+/**
+ * @brief Reload the quality data file and re-evaluate the recommendation
+ * using the device information gathered at initialization. Intended to be
+ * called from a background thread after a new data file has been downloaded
+ * into the storage directory. The new data file and recommendation are
+ * published atomically, calls to ::vkQuality_getRecommendation on other threads
+ * are never blocked by a reload in progress.
+ * @return `kSuccess` if successful, otherwise an error code relating
+ * to the reload failure. On failure the previous recommendation is retained.
+ * @see kInitFlagWatchStoragePath
+ */
+vkQualityInitResult vkQuality_reload();
+
+/**
+ * @brief Create an independent recommendation context. No data is loaded
+ * and no device information is retrieved until ::vkQuality_evaluateContext
+ * is called.
+ * @param asset_manager A pointer to an active NDK Asset Manager instance.
+ * Passing nullptr will disable lookup of the quality data file from the
+ * app bundle.
+ * @param storage_path An absolute path to a storage directory, with the same
+ * behavior as the `storage_path` parameter of ::vkQuality_initialize. Contexts
+ * sharing a storage directory also share its recommendation cache file, pass
+ * nullptr to disable caching for contexts used by tools.
+ * @param asset_filename The name of the quality data file.
+ * @param flags A bit field of ::vkQualityInitFlags enum values specifying
+ * initialization flags to alter default behavior
+ * @return A new context handle, or nullptr if the context could not be created.
+ * @see vkQuality_destroyContext
+ */
+vkQualityContext vkQuality_createContext(AAssetManager *asset_manager,
+                                         const char *storage_path,
+                                         const char *asset_filename,
+                                         int32_t flags);
+
+/**
+ * @brief Retrieve device information, load the quality data file and
+ * generate a recommendation for a context. Should only be called once per context.
+ * @param context A context created by ::vkQuality_createContext.
+ * @param env The JNIEnv attached to the thread calling the function.
+ * @param api_info An optional pointer to a ::vkqGraphicsAPIInfo structure, with
+ * the same behavior as the `api_info` parameter of ::vkQuality_initializeFlagsInfo.
+ * @return `kSuccess` if successful, otherwise an error code relating
+ * to initialization failure.
+ */
+vkQualityInitResult vkQuality_evaluateContext(vkQualityContext context, JNIEnv *env,
+                                              const vkqGraphicsAPIInfo *api_info);
+
+/**
+ * @brief Retrieve the graphics API recommendation of a context.
+ * @param context A context created by ::vkQuality_createContext.
+ * @return An recommendation defined by the ::vkQualityRecommendation enum
+ */
+vkQualityRecommendation vkQuality_getContextRecommendation(vkQualityContext context);
+
+/**
+ * @brief Retrieve the physical device index of the recommendation of a
+ * context, see ::vkQuality_getRecommendedDeviceIndex.
+ * @param context A context created by ::vkQuality_createContext.
+ * @return A physical device index, or -1.
+ */
+int32_t vkQuality_getContextRecommendedDeviceIndex(vkQualityContext context);
+
+/**
+ * @brief Reload the quality data file of a context and re-evaluate its
+ * recommendation, see ::vkQuality_reload.
+ * @param context A context created by ::vkQuality_createContext.
+ * @return `kSuccess` if successful, otherwise an error code relating
+ * to the reload failure.
+ */
+vkQualityInitResult vkQuality_reloadContext(vkQualityContext context);
+
+/**
+ * @brief Destroy a context and the resources it has created.
+ * @param context A context created by ::vkQuality_createContext, may be nullptr.
+ */
+void vkQuality_destroyContext(vkQualityContext context);
+
 #ifdef __cplusplus
 }
 #endif
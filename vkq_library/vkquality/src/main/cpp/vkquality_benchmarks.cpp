@@ -0,0 +1,610 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+#include "vkquality.h"
+#include "vkquality_checksum.h"
+#include "vkquality_compression.h"
+#include "vkquality_file_writer.h"
+#include "vkquality_host.h"
+#include "vkquality_matching.h"
+#include "vkquality_paged_file.h"
+#include "vkquality_prediction_file.h"
+#include "vkquality_version.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace vkquality;
+
+namespace {
+
+constexpr int64_t kMinEntryCount = 100;
+constexpr int64_t kMaxEntryCount = 1000000;
+constexpr uint32_t kSyntheticListVersion = 1;
+constexpr int32_t kSyntheticFutureApi = 34;
+constexpr uint32_t kSyntheticSeed = 0x564b5141;
+
+constexpr uint32_t kVendorIdQualcomm = 0x5143;
+constexpr uint32_t kVendorIdArm = 0x13B5;
+constexpr uint32_t kVendorIdImgTec = 0x1010;
+constexpr uint32_t kVendorIdSamsung = 0x144D;
+
+// Build.DEVICE codename styles differ enough per brand to matter for string
+// compares, weights roughly follow the share of Android devices in the field
+struct SyntheticBrand {
+  const char *brand;
+  const char *device_prefix;
+  double weight;
+};
+
+constexpr SyntheticBrand kSyntheticBrands[] = {
+    {"samsung", "SM-", 28.0},
+    {"xiaomi", "", 11.0},
+    {"Redmi", "", 8.0},
+    {"OPPO", "OP", 7.0},
+    {"vivo", "PD", 7.0},
+    {"realme", "RE", 5.0},
+    {"motorola", "moto_", 5.0},
+    {"google", "", 3.0},
+    {"OnePlus", "OP", 3.0},
+    {"HUAWEI", "HW", 3.0},
+    {"HONOR", "HN", 3.0},
+    {"TECNO", "TECNO-", 3.0},
+    {"Infinix", "Infinix-X", 2.0},
+    {"lenovo", "TB", 2.0},
+    {"Sony", "SO-", 2.0},
+    {"Nokia", "", 1.0},
+    {"ZTE", "Z", 1.0},
+    {"asus", "ASUS_", 1.0},
+    {"lge", "", 1.0},
+    {"POCO", "", 1.0},
+    {"10or", "", 0.5},
+};
+
+constexpr const char *kCodenameSyllables[] = {
+    "ra", "ven", "blue", "jay", "sun", "fish", "ori", "ole", "cheet", "ah",
+    "lyn", "x", "mar", "lin", "taimen", "a", "star", "beyond", "crown", "dm",
+};
+
+struct SyntheticList {
+  std::vector<uint8_t> file_data;
+  DeviceInfo device_hit;
+  DeviceInfo device_miss;
+  DeviceInfo driver_hit;
+  DeviceInfo driver_miss;
+  DeviceInfo gpu_hit;
+  DeviceInfo gpu_miss;
+};
+
+// Fixed width so that no generated token is a prefix of another, which keeps
+// wildcard list entries from matching probes meant for other entries
+std::string ToBase36(uint32_t value) {
+  static constexpr char kDigits[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+  static constexpr size_t kTokenWidth = 7;
+  std::string result(kTokenWidth, '0');
+  for (size_t i = kTokenWidth; i > 0 && value != 0; --i) {
+    result[i - 1] = kDigits[value % 36];
+    value /= 36;
+  }
+  return result;
+}
+
+DeviceInfo MakeProbeDevice() {
+  DeviceInfo device_info;
+  device_info.brand = "probe";
+  device_info.device = "probe";
+  device_info.soc = "SM0000-probe";
+  device_info.gles_version = "OpenGL ES 3.2 probe";
+  device_info.vk_device_name = "probe";
+  device_info.api_level = kSyntheticFutureApi;
+  device_info.vk_api_version = (1U << 22) | (3U << 12);
+  device_info.vk_device_id = 0xFFFFFFF0;
+  device_info.vk_vendor_id = kVendorIdArm;
+  device_info.vk_driver_version = 0xFFFFFFF0;
+  return device_info;
+}
+
+VkQualityFileWriter::GpuEntry MakeGpuEntry(std::mt19937 &rng, const uint32_t index) {
+  VkQualityFileWriter::GpuEntry entry;
+  const std::string unique = ToBase36(index);
+  const uint32_t family = rng() % 100;
+  if (family < 45) {
+    entry.vendor_id = kVendorIdQualcomm;
+    entry.device_name = "Adreno (TM) " + std::to_string(505 + rng() % 250) + "-" + unique;
+  } else if (family < 85) {
+    entry.vendor_id = kVendorIdArm;
+    entry.device_name = "Mali-G" + std::to_string(31 + rng() % 700) + " MC" +
+        std::to_string(1 + rng() % 24) + "-" + unique;
+  } else if (family < 95) {
+    entry.vendor_id = kVendorIdImgTec;
+    entry.device_name = "PowerVR Rogue GE" + std::to_string(8100 + rng() % 300) + "-" + unique;
+  } else {
+    entry.vendor_id = kVendorIdSamsung;
+    entry.device_name = "Samsung Xclipse " + std::to_string(900 + rng() % 50) + "-" + unique;
+  }
+
+  // Most entries match by name, some use wildcard patterns and a few match
+  // by device and vendor id
+  const uint32_t style = rng() % 100;
+  if (style < 10) {
+    entry.device_name = "^" + entry.device_name;
+  } else if (style < 15) {
+    entry.device_name = "*" + entry.device_name;
+  } else if (style < 17) {
+    entry.device_name = entry.device_name.substr(0, 4) + "*" + unique + "*";
+  } else if (style < 20) {
+    entry.device_id = index + 1;
+  }
+  if (rng() % 4 == 0) {
+    entry.min_driver_version = rng() % 0x1000000;
+  }
+  return entry;
+}
+
+std::string MakeFingerprint(std::mt19937 &rng, const uint32_t soc_index,
+                            const uint32_t fingerprint_index) {
+  const std::string unique = ToBase36(soc_index) + "." + ToBase36(fingerprint_index);
+  if ((soc_index % 2) == 0) {
+    return "OpenGL ES 3.2 V@0" + std::to_string(500 + rng() % 300) + "." + unique +
+        " (GIT@" + ToBase36(rng()) + ", I" + ToBase36(rng()) + ", " +
+        std::to_string(1600000000 + rng() % 100000000) + ") (Date:02/03/23)";
+  }
+  return "OpenGL ES 3.2 v1.r" + std::to_string(20 + rng() % 30) + "p0-01eac0." + unique +
+      ToBase36(rng()) + ToBase36(rng());
+}
+
+std::unique_ptr<SyntheticList> GenerateSyntheticList(const uint32_t entry_count) {
+  std::mt19937 rng(kSyntheticSeed ^ entry_count);
+  VkQualityFileWriter writer(kSyntheticListVersion, kSyntheticFutureApi);
+  auto list = std::make_unique<SyntheticList>();
+
+  // Device allow list
+  std::vector<double> brand_weights;
+  for (const auto &brand : kSyntheticBrands) {
+    brand_weights.push_back(brand.weight);
+  }
+  std::discrete_distribution<size_t> brand_distribution(brand_weights.begin(),
+                                                        brand_weights.end());
+  constexpr size_t kSyllableCount = sizeof(kCodenameSyllables) / sizeof(kCodenameSyllables[0]);
+  for (uint32_t i = 0; i < entry_count; ++i) {
+    const SyntheticBrand &brand = kSyntheticBrands[brand_distribution(rng)];
+    VkQualityFileWriter::DeviceEntry entry;
+    entry.brand = brand.brand;
+    entry.device = std::string(brand.device_prefix) +
+        kCodenameSyllables[rng() % kSyllableCount] +
+        kCodenameSyllables[rng() % kSyllableCount] + ToBase36(i);
+    if (rng() % 8 == 0) {
+      entry.min_api_version = 30 + rng() % 4;
+    }
+    if (i == entry_count / 2) {
+      list->device_hit = MakeProbeDevice();
+      list->device_hit.brand = entry.brand;
+      list->device_hit.device = entry.device;
+    }
+    writer.AddDevice(entry);
+  }
+  list->device_miss = MakeProbeDevice();
+  list->device_miss.brand = "samsung";
+  list->device_miss.device = "SM-notinlist";
+
+  // Driver fingerprint allow list, grouped under SoCs
+  constexpr uint32_t kFingerprintsPerSoC = 32;
+  const uint32_t soc_count = std::max(1U, entry_count / kFingerprintsPerSoC);
+  for (uint32_t soc_index = 0; soc_index < soc_count; ++soc_index) {
+    const std::string soc = ((soc_index % 2) == 0 ? "SM" : "MT") +
+        std::to_string(6000 + (soc_index % 3000)) + "-" + ToBase36(soc_index);
+    for (uint32_t fingerprint_index = 0; fingerprint_index < kFingerprintsPerSoC &&
+        (soc_index * kFingerprintsPerSoC + fingerprint_index) < entry_count;
+        ++fingerprint_index) {
+      const std::string fingerprint = MakeFingerprint(rng, soc_index, fingerprint_index);
+      if (soc_index == soc_count / 2 && fingerprint_index == kFingerprintsPerSoC / 2) {
+        list->driver_hit = MakeProbeDevice();
+        list->driver_hit.soc = soc;
+        list->driver_hit.gles_version = fingerprint;
+      }
+      writer.AddDriverAllow({soc, fingerprint});
+    }
+  }
+  list->driver_miss = MakeProbeDevice();
+  list->driver_miss.soc = "SM9999-notinlist";
+  list->driver_miss.gles_version = "OpenGL ES 3.2 V@0999.0";
+
+  // GPU predict allow and deny lists, deny lists are typically much shorter
+  for (uint32_t i = 0; i < entry_count; ++i) {
+    VkQualityFileWriter::GpuEntry entry = MakeGpuEntry(rng, i);
+    if (i >= entry_count / 2 && list->gpu_hit.vk_device_name.empty() &&
+        entry.device_id == 0 && entry.min_driver_version == 0 &&
+        entry.device_name.find('*') == std::string::npos &&
+        entry.device_name[0] != '^') {
+      list->gpu_hit = MakeProbeDevice();
+      list->gpu_hit.vk_device_name = entry.device_name;
+      list->gpu_hit.vk_vendor_id = entry.vendor_id;
+    }
+    writer.AddGpuAllow(entry);
+  }
+  for (uint32_t i = 0; i < std::max(1U, entry_count / 10); ++i) {
+    writer.AddGpuDeny(MakeGpuEntry(rng, entry_count + i));
+  }
+  list->gpu_miss = MakeProbeDevice();
+  list->gpu_miss.vk_device_name = "Mali-G9999 MC99";
+
+  list->file_data = writer.Write();
+  return list;
+}
+
+// Synthetic lists are expensive to generate at the larger sizes, so they are
+// shared between benchmarks and kept for the lifetime of the process
+const SyntheticList &GetSyntheticList(const int64_t entry_count) {
+  static std::map<int64_t, std::unique_ptr<SyntheticList>> synthetic_lists;
+  auto &list = synthetic_lists[entry_count];
+  if (list == nullptr) {
+    list = GenerateSyntheticList(static_cast<uint32_t>(entry_count));
+  }
+  return *list;
+}
+
+bool ParseSyntheticList(benchmark::State &state, const SyntheticList &list,
+                        VkQualityPredictionFile &file) {
+  // Parse in place, the synthetic list owns the data
+  const auto result = file.ParseFileData(const_cast<uint8_t *>(list.file_data.data()),
+                                         list.file_data.size(), VKQUALITY_PACKED_VERSION,
+                                         nullptr);
+  if (result != VkQualityPredictionFile::kFileParseResult_Success) {
+    state.SkipWithError(file.GetParseErrorString().c_str());
+    return false;
+  }
+  return true;
+}
+
+void EntryCounts(benchmark::internal::Benchmark *benchmark) {
+  benchmark->RangeMultiplier(10)->Range(kMinEntryCount, kMaxEntryCount);
+}
+
+enum SearchList {
+  kSearchList_Device,
+  kSearchList_Driver,
+  kSearchList_Gpu
+};
+
+// Interned searches build the string index before timing, its cost is
+// measured by BM_BuildStringIndex
+template<SearchList search_list, bool hit, bool interned = false>
+void BM_SearchList(benchmark::State &state) {
+  const SyntheticList &list = GetSyntheticList(state.range(0));
+  VkQualityPredictionFile file;
+  file.SetStringIndex(interned);
+  if (!ParseSyntheticList(state, list, file)) {
+    return;
+  }
+  if (interned && !file.HasInternedStrings()) {
+    state.SkipWithError("Synthetic list strings can't be interned");
+    return;
+  }
+
+  const DeviceInfo *device_info;
+  if (search_list == kSearchList_Device) {
+    device_info = hit ? &list.device_hit : &list.device_miss;
+  } else if (search_list == kSearchList_Driver) {
+    device_info = hit ? &list.driver_hit : &list.driver_miss;
+  } else {
+    device_info = hit ? &list.gpu_hit : &list.gpu_miss;
+  }
+
+  uint32_t match_index = 0;
+  VkQualityPredictionFile::FileMatchResult result = VkQualityPredictionFile::kFileMatch_None;
+  for (auto _ : state) {
+    if constexpr (search_list == kSearchList_Device) {
+      result = file.SearchDeviceList(*device_info, match_index);
+    } else if constexpr (search_list == kSearchList_Driver) {
+      result = file.SearchDriverList(*device_info, VkQualityPredictionFile::kFileMatch_DriverAllow,
+                                     match_index);
+    } else {
+      result = file.SearchGpuList(*device_info, VkQualityPredictionFile::kFileMatch_GpuAllow,
+                                  match_index);
+    }
+    benchmark::DoNotOptimize(result);
+    benchmark::DoNotOptimize(match_index);
+  }
+
+  if ((result != VkQualityPredictionFile::kFileMatch_None) != hit) {
+    state.SkipWithError(hit ? "Expected a list match" : "Unexpected list match");
+    return;
+  }
+  state.counters["match_index"] = hit ? match_index : 0;
+}
+
+// A miss searches every stage, with and without a small hotfix overlay stacked
+// on the list
+template<bool overlay>
+void BM_FindDeviceMatch(benchmark::State &state) {
+  const SyntheticList &list = GetSyntheticList(state.range(0));
+  VkQualityPredictionFile file;
+  if (!ParseSyntheticList(state, list, file)) {
+    return;
+  }
+  std::vector<uint8_t> hotfix_data;
+  if (overlay) {
+    std::mt19937 rng(kSyntheticSeed);
+    VkQualityFileWriter hotfix_writer(kSyntheticListVersion + 1, kSyntheticFutureApi);
+    for (uint32_t i = 0; i < 16; ++i) {
+      hotfix_writer.AddDevice({"samsung", "SM-hotfix" + ToBase36(i), 0, 0});
+      hotfix_writer.AddDriverDeny({"SM8550-" + ToBase36(i), MakeFingerprint(rng, i, 0)});
+      hotfix_writer.AddGpuDeny(MakeGpuEntry(rng, i));
+    }
+    hotfix_data = hotfix_writer.Write();
+    auto hotfix = std::make_unique<VkQualityPredictionFile>();
+    if (hotfix->ParseFileData(hotfix_data.data(), hotfix_data.size(), VKQUALITY_PACKED_VERSION,
+                              nullptr) != VkQualityPredictionFile::kFileParseResult_Success ||
+        !file.AddOverlay(std::move(hotfix))) {
+      state.SkipWithError("Unable to stack the hotfix overlay");
+      return;
+    }
+  }
+
+  uint32_t match_index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(file.FindDeviceMatch(list.gpu_miss, 0, &match_index));
+    benchmark::DoNotOptimize(match_index);
+  }
+}
+
+// Opening a list read through the page cache and searching it once, as
+// vkQuality_evaluateDeviceStream does, without the checksum pass
+void BM_PagedFindDeviceMatch(benchmark::State &state) {
+  const SyntheticList &list = GetSyntheticList(state.range(0));
+  auto read_function = [&list](uint64_t offset, void *buffer, size_t size) {
+    memcpy(buffer, list.file_data.data() + offset, size);
+    return size;
+  };
+  uint64_t page_reads = 0;
+  for (auto _ : state) {
+    VkQualityPagedFile paged_file(read_function, list.file_data.size());
+    paged_file.SetVerifyChecksum(false);
+    if (paged_file.Open(VKQUALITY_PACKED_VERSION) !=
+        VkQualityPredictionFile::kFileParseResult_Success) {
+      state.SkipWithError(paged_file.GetParseErrorString().c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(paged_file.FindDeviceMatch(list.device_hit, 0));
+    page_reads = paged_file.GetPageReadCount();
+  }
+  state.counters["page_reads"] = static_cast<double>(page_reads);
+}
+
+void BM_BuildStringIndex(benchmark::State &state) {
+  const SyntheticList &list = GetSyntheticList(state.range(0));
+  for (auto _ : state) {
+    VkQualityPredictionFile file;
+    file.SetStringIndex(true);
+    if (!ParseSyntheticList(state, list, file)) {
+      break;
+    }
+    benchmark::DoNotOptimize(file.HasInternedStrings());
+  }
+}
+
+void BM_ParseFileData(benchmark::State &state) {
+  const SyntheticList &list = GetSyntheticList(state.range(0));
+  for (auto _ : state) {
+    VkQualityPredictionFile file;
+    if (!ParseSyntheticList(state, list, file)) {
+      break;
+    }
+    benchmark::DoNotOptimize(file.GetListVersion());
+  }
+  state.counters["file_bytes"] = static_cast<double>(list.file_data.size());
+}
+
+template<bool portable>
+void BM_Crc32c(benchmark::State &state) {
+  const SyntheticList &list = GetSyntheticList(state.range(0));
+  if (!portable && !VkQualityChecksum::HasHardwareCrc32c()) {
+    state.SkipWithError("No CRC32C instructions");
+    return;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(portable ?
+        VkQualityChecksum::Crc32cPortable(0, list.file_data.data(), list.file_data.size()) :
+        VkQualityChecksum::Crc32c(0, list.file_data.data(), list.file_data.size()));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(list.file_data.size()));
+}
+
+void BM_Decompress(benchmark::State &state) {
+  const SyntheticList &list = GetSyntheticList(state.range(0));
+  if (list.file_data.size() > VkQualityCompression::kMax_Uncompressed_Size) {
+    state.SkipWithError("List larger than the compressed container limit");
+    return;
+  }
+  const std::vector<uint8_t> container = VkQualityFileWriter::Compress(list.file_data);
+  for (auto _ : state) {
+    size_t file_size = 0;
+    void *file_data = VkQualityCompression::Decompress(container.data(), container.size(),
+                                                       file_size);
+    if (file_data == nullptr) {
+      state.SkipWithError("Decompress failed");
+      break;
+    }
+    benchmark::DoNotOptimize(file_data);
+    free(file_data);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(list.file_data.size()));
+  state.counters["file_bytes"] = static_cast<double>(list.file_data.size());
+  state.counters["compressed_bytes"] = static_cast<double>(container.size());
+}
+
+struct StringMatchCase {
+  const char *label;
+  const char *device_string;
+  const char *list_string;
+};
+
+constexpr StringMatchCase kStringMatchCases[] = {
+    {"exact_hit", "Mali-G78 MC24", "Mali-G78 MC24"},
+    {"exact_miss", "Mali-G78 MC24", "Mali-G78 MC20"},
+    {"prefix_hit", "Adreno (TM) 650", "^Adreno (TM) 6"},
+    {"prefix_miss", "Mali-G78 MC24", "^Adreno (TM) 6"},
+    {"substring_hit", "Samsung Xclipse 920", "*Xclipse"},
+    {"substring_miss", "Mali-G78 MC24", "*Xclipse"},
+    {"wildcards_hit", "Mali-G78 MC24", "Mali*G7*MC2"},
+    {"wildcards_miss", "Mali-G57 MC2", "Mali*G7*MC2"},
+};
+
+void BM_StringMatches(benchmark::State &state) {
+  const StringMatchCase &match_case = kStringMatchCases[state.range(0)];
+  const std::string_view device_view(match_case.device_string);
+  const std::string_view list_view(match_case.list_string);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(VkQualityMatching::StringMatches(device_view, list_view));
+  }
+  state.SetLabel(match_case.label);
+}
+
+// Synthetic lists written out as the asset of a directory-backed host asset
+// manager, and an empty storage directory for the recommendation cache
+class ManagerFixture {
+ public:
+  static constexpr const char *kListFilename = "vkqualitydata.vkq";
+  static constexpr const char *kCacheFilename = "vkqcache.bin";
+
+  ManagerFixture() {
+    char asset_template[] = "/tmp/vkqbenchXXXXXX";
+    char storage_template[] = "/tmp/vkqbenchXXXXXX";
+    if (mkdtemp(asset_template) != nullptr) {
+      asset_root_ = asset_template;
+    }
+    if (mkdtemp(storage_template) != nullptr) {
+      storage_path_ = storage_template;
+    }
+  }
+
+  ~ManagerFixture() {
+    for (const auto &asset_manager : asset_managers_) {
+      const std::string asset_path = GetAssetPath(asset_manager.first);
+      unlink((asset_path + "/" + kListFilename).c_str());
+      rmdir(asset_path.c_str());
+      host::DestroyHostAssetManager(asset_manager.second);
+    }
+    unlink((storage_path_ + "/" + kCacheFilename).c_str());
+    rmdir(storage_path_.c_str());
+    rmdir(asset_root_.c_str());
+  }
+
+  AAssetManager *GetAssetManager(const SyntheticList &list, const int64_t entry_count) {
+    AAssetManager *&asset_manager = asset_managers_[entry_count];
+    if (asset_manager == nullptr) {
+      const std::string asset_path = GetAssetPath(entry_count);
+      mkdir(asset_path.c_str(), 0700);
+      FILE *fp = fopen((asset_path + "/" + kListFilename).c_str(), "wb");
+      if (fp != nullptr) {
+        fwrite(list.file_data.data(), list.file_data.size(), 1, fp);
+        fclose(fp);
+      }
+      asset_manager = host::CreateHostAssetManager(asset_path.c_str());
+    }
+    return asset_manager;
+  }
+
+  const std::string &GetStoragePath() const { return storage_path_; }
+
+  void ClearCache() const {
+    unlink((storage_path_ + "/" + kCacheFilename).c_str());
+  }
+
+ private:
+  std::string GetAssetPath(const int64_t entry_count) const {
+    return asset_root_ + "/" + std::to_string(entry_count);
+  }
+
+  std::string asset_root_;
+  std::string storage_path_;
+  std::map<int64_t, AAssetManager *> asset_managers_;
+};
+
+ManagerFixture &GetManagerFixture() {
+  static ManagerFixture manager_fixture;
+  return manager_fixture;
+}
+
+// Full vkQuality_initialize path through the host stand-ins: Build fields
+// through JNI, graphics API info, cache and data file loading, parsing and
+// matching. The device matches the middle of the device list.
+template<bool cached>
+void BM_ManagerInit(benchmark::State &state) {
+  const SyntheticList &list = GetSyntheticList(state.range(0));
+  ManagerFixture &fixture = GetManagerFixture();
+  AAssetManager *asset_manager = fixture.GetAssetManager(list, state.range(0));
+  host::SetHostDevice(list.device_hit);
+  JNIEnv *env = host::GetHostJNIEnv();
+
+  fixture.ClearCache();
+  if (cached) {
+    vkQuality_initialize(env, asset_manager, fixture.GetStoragePath().c_str(),
+                         ManagerFixture::kListFilename);
+    vkQuality_destroy(env);
+  }
+
+  vkQualityInitResult result = kSuccess;
+  for (auto _ : state) {
+    result = vkQuality_initialize(env, asset_manager,
+                                  cached ? fixture.GetStoragePath().c_str() : nullptr,
+                                  ManagerFixture::kListFilename);
+    benchmark::DoNotOptimize(vkQuality_getRecommendation());
+    vkQuality_destroy(env);
+    if (result != kSuccess) {
+      state.SkipWithError("vkQuality_initialize failed");
+      break;
+    }
+  }
+}
+
+} // anonymous namespace
+
+BENCHMARK(BM_ParseFileData)->Apply(EntryCounts);
+BENCHMARK(BM_Decompress)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_Crc32c, false)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_Crc32c, true)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_SearchList, kSearchList_Device, true)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_SearchList, kSearchList_Device, false)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_SearchList, kSearchList_Driver, true)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_SearchList, kSearchList_Driver, false)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_SearchList, kSearchList_Device, true, true)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_SearchList, kSearchList_Device, false, true)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_SearchList, kSearchList_Driver, true, true)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_SearchList, kSearchList_Driver, false, true)->Apply(EntryCounts);
+BENCHMARK(BM_BuildStringIndex)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_SearchList, kSearchList_Gpu, true)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_SearchList, kSearchList_Gpu, false)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_FindDeviceMatch, false)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_FindDeviceMatch, true)->Apply(EntryCounts);
+BENCHMARK(BM_PagedFindDeviceMatch)->Apply(EntryCounts);
+BENCHMARK(BM_StringMatches)->DenseRange(
+    0, (sizeof(kStringMatchCases) / sizeof(kStringMatchCases[0])) - 1);
+
+BENCHMARK_TEMPLATE(BM_ManagerInit, false)->Apply(EntryCounts);
+BENCHMARK_TEMPLATE(BM_ManagerInit, true)->Apply(EntryCounts);
+
+BENCHMARK_MAIN();
@@ -15,32 +15,13 @@
  */
 #include "vkquality.h"
 #include "vkquality_manager.h"
+#include "vkquality_version.h"
 #include <android/asset_manager_jni.h>
 #include <jni.h>
+#include <new>
 
 extern "C" {
 
-#define VKQUALITY_MAJOR_VERSION 1
-#define VKQUALITY_MINOR_VERSION 2
-#define VKQUALITY_BUGFIX_VERSION 2
-
-#define VKQUALITY_GENERATE_PACKED_VERSION(MAJOR, MINOR, BUGFIX) \
-    ((MAJOR << 16) | (MINOR << 8) | (BUGFIX))
-
-#define VKQUALITY_PACKED_VERSION                               \
-    VKQUALITY_GENERATE_PACKED_VERSION(VKQUALITY_MAJOR_VERSION, \
-                                      VKQUALITY_MINOR_VERSION, \
-                                      VKQUALITY_BUGFIX_VERSION)
-
-#define VKQUALITY_VERSION_CONCAT_NX(PREFIX, MAJOR, MINOR, BUGFIX) \
-    PREFIX##_##MAJOR##_##MINOR##_##BUGFIX
-#define VKQUALITY_VERSION_CONCAT(PREFIX, MAJOR, MINOR, BUGFIX) \
-    VKQUALITY_VERSION_CONCAT_NX(PREFIX, MAJOR, MINOR, BUGFIX)
-#define VKQUALITY_VERSION_SYMBOL                                           \
-    VKQUALITY_VERSION_CONCAT(VKQUALITY_version, VKQUALITY_MAJOR_VERSION, \
-                              VKQUALITY_MINOR_VERSION,                     \
-                              VKQUALITY_BUGFIX_VERSION)
-
 void VKQUALITY_VERSION_SYMBOL();
 
 // Private, used internally by file manager
@@ -72,6 +53,19 @@ vkQualityInitResult vkQuality_initializeFlagsInfo(JNIEnv *env, AAssetManager *as
                                              api_info, flags);
 }
 
+vkQualityInitResult vkQuality_initializeFromMemory(JNIEnv *env, const void *list_data,
+                                                   size_t list_size,
+                                                   vkqListDataRelease release_function,
+                                                   void *release_user_data,
+                                                   const char *storage_path,
+                                                   const vkqGraphicsAPIInfo *api_info,
+                                                   int32_t flags) {
+  return vkquality::VkQualityManager::InitFromMemory(env, const_cast<void *>(list_data),
+                                                     list_size, release_function,
+                                                     release_user_data, storage_path,
+                                                     api_info, flags);
+}
+
 void vkQuality_destroy(JNIEnv *env) {
   vkquality::VkQualityManager::DestroyInstance(env);
 }
@@ -80,6 +74,63 @@ vkQualityRecommendation vkQuality_getRecommendation() {
   return vkquality::VkQualityManager::GetQualityRecommendation();
 }
 
+int32_t vkQuality_getRecommendedDeviceIndex() {
+  return vkquality::VkQualityManager::GetQualityRecommendedDeviceIndex();
+}
+
+vkQualityInitResult vkQuality_reload() {
+  return vkquality::VkQualityManager::Reload();
+}
+
+static vkquality::VkQualityManager *GetContextManager(vkQualityContext context) {
+  return reinterpret_cast<vkquality::VkQualityManager *>(context);
+}
+
+vkQualityContext vkQuality_createContext(AAssetManager *asset_manager,
+                                         const char *storage_path,
+                                         const char *asset_filename,
+                                         int32_t flags) {
+  if (asset_filename == nullptr) {
+    return nullptr;
+  }
+  auto *manager = new (std::nothrow) vkquality::VkQualityManager(asset_manager, storage_path,
+                                                                 asset_filename, flags);
+  return reinterpret_cast<vkQualityContext>(manager);
+}
+
+vkQualityInitResult vkQuality_evaluateContext(vkQualityContext context, JNIEnv *env,
+                                              const vkqGraphicsAPIInfo *api_info) {
+  if (context == nullptr) {
+    return kErrorInitializationFailure;
+  }
+  return GetContextManager(context)->StartRecommendation(env, api_info);
+}
+
+vkQualityRecommendation vkQuality_getContextRecommendation(vkQualityContext context) {
+  if (context == nullptr) {
+    return kRecommendationErrorNotInitialized;
+  }
+  return GetContextManager(context)->GetRecommendation();
+}
+
+int32_t vkQuality_getContextRecommendedDeviceIndex(vkQualityContext context) {
+  if (context == nullptr) {
+    return -1;
+  }
+  return GetContextManager(context)->GetRecommendedDeviceIndex();
+}
+
+vkQualityInitResult vkQuality_reloadContext(vkQualityContext context) {
+  if (context == nullptr) {
+    return kErrorInitializationFailure;
+  }
+  return GetContextManager(context)->ReloadRecommendation();
+}
+
+void vkQuality_destroyContext(vkQualityContext context) {
+  delete GetContextManager(context);
+}
+
 JNIEXPORT jint JNICALL
 Java_com_google_android_games_vkquality_VKQuality_startVkQualityFlags(
     JNIEnv *env, jobject activity, jobject jasset_manager,
@@ -101,6 +152,69 @@ Java_com_google_android_games_vkquality_VKQuality_startVkQualityFlags(
                               flags);
 }
 
+// Keeps a direct ByteBuffer reachable while VkQuality is using its contents
+struct DirectBufferReference {
+  JavaVM *vm;
+  jobject buffer;
+};
+
+static void ReleaseDirectBuffer(void */*list_data*/, void *user_data) {
+  auto *reference = reinterpret_cast<DirectBufferReference *>(user_data);
+  JNIEnv *env = nullptr;
+  bool attached = false;
+  if (reference->vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) == JNI_EDETACHED) {
+    // Released from a thread the JVM doesn't know about
+    if (reference->vm->AttachCurrentThread(&env, nullptr) == JNI_OK) {
+      attached = true;
+    } else {
+      env = nullptr;
+    }
+  }
+  if (env != nullptr) {
+    env->DeleteGlobalRef(reference->buffer);
+  }
+  if (attached) {
+    reference->vm->DetachCurrentThread();
+  }
+  delete reference;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_google_android_games_vkquality_VKQuality_startVkQualityFromBuffer(
+    JNIEnv *env, jobject activity, jobject jdata_buffer, jint offset, jint length,
+    jstring jstorage_path, jint flags) {
+  auto *buffer_address = reinterpret_cast<uint8_t *>(env->GetDirectBufferAddress(jdata_buffer));
+  const jlong buffer_capacity = env->GetDirectBufferCapacity(jdata_buffer);
+  if (buffer_address == nullptr || offset < 0 || length <= 0 ||
+      static_cast<jlong>(offset) + length > buffer_capacity) {
+    return kErrorInvalidDataFile;
+  }
+
+  auto *reference = new (std::nothrow) DirectBufferReference{nullptr, nullptr};
+  if (reference == nullptr) {
+    return kErrorInitializationFailure;
+  }
+  if (env->GetJavaVM(&reference->vm) != JNI_OK) {
+    delete reference;
+    return kErrorInitializationFailure;
+  }
+  reference->buffer = env->NewGlobalRef(jdata_buffer);
+
+  std::string storage_path;
+  if (jstorage_path != nullptr) {
+    auto path_cstr = env->GetStringUTFChars(jstorage_path, nullptr);
+    auto path_length = env->GetStringUTFLength(jstorage_path);
+    storage_path.assign(path_cstr, path_length);
+    env->ReleaseStringUTFChars(jstorage_path, path_cstr);
+  }
+
+  return vkQuality_initializeFromMemory(env, buffer_address + offset,
+                                        static_cast<size_t>(length), ReleaseDirectBuffer,
+                                        reference,
+                                        storage_path.empty() ? nullptr : storage_path.c_str(),
+                                        nullptr, flags);
+}
+
 JNIEXPORT jint JNICALL
 Java_com_google_android_games_vkquality_VKQuality_startVkQuality(
         JNIEnv *env, jobject activity, jobject jasset_manager,
@@ -117,6 +231,12 @@ Java_com_google_android_games_vkquality_VKQuality_getVkQuality(
   return vkQuality_getRecommendation();
 }
 
+JNIEXPORT jint JNICALL
+Java_com_google_android_games_vkquality_VKQuality_reloadVkQuality(
+    JNIEnv *env, jobject activity) {
+  return vkQuality_reload();
+}
+
 JNIEXPORT void JNICALL
 Java_com_google_android_games_vkquality_VKQuality_stopVkQuality(
     JNIEnv *env, jobject activity) {
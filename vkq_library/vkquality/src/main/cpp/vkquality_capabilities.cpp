@@ -0,0 +1,69 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vkquality_capabilities.h"
+#include <string.h>
+
+namespace vkquality {
+
+namespace {
+
+struct ExtensionCapability {
+  const char *extension_name;
+  VkQualityCapabilities::CapabilityBit capability;
+};
+
+constexpr ExtensionCapability kExtensionCapabilities[] = {
+    {"VK_KHR_dynamic_rendering", VkQualityCapabilities::kCapability_DynamicRendering},
+    {"VK_KHR_synchronization2", VkQualityCapabilities::kCapability_Synchronization2},
+    {"VK_EXT_descriptor_indexing", VkQualityCapabilities::kCapability_DescriptorIndexing},
+    {"VK_KHR_timeline_semaphore", VkQualityCapabilities::kCapability_TimelineSemaphore},
+    {"VK_KHR_buffer_device_address", VkQualityCapabilities::kCapability_BufferDeviceAddress},
+    {"VK_EXT_extended_dynamic_state", VkQualityCapabilities::kCapability_ExtendedDynamicState},
+    {"VK_KHR_create_renderpass2", VkQualityCapabilities::kCapability_CreateRenderpass2},
+    {"VK_KHR_shader_float16_int8", VkQualityCapabilities::kCapability_ShaderFloat16Int8},
+    {"VK_KHR_fragment_shading_rate", VkQualityCapabilities::kCapability_FragmentShadingRate},
+    {"VK_EXT_fragment_density_map", VkQualityCapabilities::kCapability_FragmentDensityMap},
+    {"VK_KHR_maintenance4", VkQualityCapabilities::kCapability_Maintenance4},
+    {"VK_ANDROID_external_memory_android_hardware_buffer",
+     VkQualityCapabilities::kCapability_ExternalMemoryAndroidHardwareBuffer},
+    {"VK_KHR_external_fence_fd", VkQualityCapabilities::kCapability_ExternalFenceFd},
+    {"VK_EXT_memory_budget", VkQualityCapabilities::kCapability_MemoryBudget},
+    {"VK_KHR_pipeline_library", VkQualityCapabilities::kCapability_PipelineLibrary},
+    {"VK_EXT_graphics_pipeline_library",
+     VkQualityCapabilities::kCapability_GraphicsPipelineLibrary},
+};
+
+static_assert(sizeof(kExtensionCapabilities) / sizeof(kExtensionCapabilities[0]) ==
+              VkQualityCapabilities::kCapability_ExtensionEnd -
+              VkQualityCapabilities::kCapability_FirstExtension,
+              "Every extension capability needs an extension name");
+static_assert(VkQualityCapabilities::kCapability_ExtensionEnd < 63,
+              "Capability bits overlap the probed bit");
+
+} // anonymous namespace
+
+uint64_t VkQualityCapabilities::GetExtensionCapability(const char *extension_name) {
+  // Devices report a few hundred extensions at most, once per probe
+  for (const ExtensionCapability &extension_capability : kExtensionCapabilities) {
+    if (strcmp(extension_capability.extension_name, extension_name) == 0) {
+      return GetBit(extension_capability.capability);
+    }
+  }
+  return 0;
+}
+
+} // namespace vkquality
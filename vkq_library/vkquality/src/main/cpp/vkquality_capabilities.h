@@ -0,0 +1,85 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VKQUALITY_CAPABILITIES_H_
+#define VKQUALITY_CAPABILITIES_H_
+
+#include <cstdint>
+
+namespace vkquality {
+
+// A bit set of the Vulkan features and device extensions that capability rules
+// can require or forbid. Bit positions are part of the file format, new
+// capabilities are only ever added at unused positions.
+class VkQualityCapabilities {
+public:
+  enum CapabilityBit : uint32_t {
+    // VkPhysicalDeviceFeatures
+    kCapability_TextureCompressionETC2 = 0,
+    kCapability_TextureCompressionASTC_LDR = 1,
+    kCapability_SamplerAnisotropy = 2,
+    kCapability_ShaderInt16 = 3,
+    kCapability_MultiDrawIndirect = 4,
+    kCapability_DrawIndirectFirstInstance = 5,
+    kCapability_FragmentStoresAndAtomics = 6,
+    // Vulkan 1.1 features, chained to vkGetPhysicalDeviceFeatures2
+    kCapability_SamplerYcbcrConversion = 7,
+    kCapability_Multiview = 8,
+    kCapability_ShaderDrawParameters = 9,
+    kCapability_StorageBuffer16BitAccess = 10,
+    kCapability_FeatureCount,
+
+    // Device extensions, see GetExtensionCapability
+    kCapability_FirstExtension = 32,
+    kCapability_DynamicRendering = kCapability_FirstExtension,
+    kCapability_Synchronization2,
+    kCapability_DescriptorIndexing,
+    kCapability_TimelineSemaphore,
+    kCapability_BufferDeviceAddress,
+    kCapability_ExtendedDynamicState,
+    kCapability_CreateRenderpass2,
+    kCapability_ShaderFloat16Int8,
+    kCapability_FragmentShadingRate,
+    kCapability_FragmentDensityMap,
+    kCapability_Maintenance4,
+    kCapability_ExternalMemoryAndroidHardwareBuffer,
+    kCapability_ExternalFenceFd,
+    kCapability_MemoryBudget,
+    kCapability_PipelineLibrary,
+    kCapability_GraphicsPipelineLibrary,
+    kCapability_ExtensionEnd
+  };
+
+  static constexpr uint64_t GetBit(const CapabilityBit capability) {
+    return uint64_t{1} << capability;
+  }
+
+  // Set in the capabilities of every probed device. Capabilities of a device
+  // described by vkqGraphicsAPIInfo are unknown, and no rule matches it
+  static constexpr uint64_t kCapability_Probed = uint64_t{1} << 63;
+
+  static constexpr uint64_t kKnownCapabilities =
+      ((uint64_t{1} << kCapability_FeatureCount) - 1) |
+      ((uint64_t{1} << kCapability_ExtensionEnd) - (uint64_t{1} << kCapability_FirstExtension));
+
+  // The capability bit of a VkExtensionProperties::extensionName, 0 if the
+  // extension isn't one of the capabilities
+  static uint64_t GetExtensionCapability(const char *extension_name);
+};
+
+} // namespace vkquality
+
+#endif // VKQUALITY_CAPABILITIES_H_
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vkquality_checksum.h"
+#include <cstring>
+
+#if defined(__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#if defined(__clang__)
+#define VKQ_TARGET_CRC32C __attribute__((target("crc")))
+#else
+#define VKQ_TARGET_CRC32C __attribute__((target("+crc")))
+#endif
+#elif defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define VKQ_TARGET_CRC32C __attribute__((target("sse4.2")))
+#endif
+
+namespace vkquality {
+
+namespace {
+
+struct Crc32cTable {
+  uint32_t entries[256];
+
+  constexpr Crc32cTable() : entries() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78U : 0);
+      }
+      entries[i] = crc;
+    }
+  }
+};
+
+constexpr Crc32cTable kCrc32cTable;
+
+// The update functions take and return the inverted CRC state
+typedef uint32_t (*Crc32cUpdate)(uint32_t crc_state, const uint8_t *bytes, size_t size);
+
+uint32_t Crc32cUpdateTable(uint32_t crc_state, const uint8_t *bytes, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    crc_state = kCrc32cTable.entries[(crc_state ^ bytes[i]) & 0xFF] ^ (crc_state >> 8);
+  }
+  return crc_state;
+}
+
+// The CRC instructions of both architectures implement the same reflected
+// Castagnoli polynomial as the table, 8 bytes at a time
+#if defined(__aarch64__)
+VKQ_TARGET_CRC32C uint32_t Crc32cUpdateHardware(uint32_t crc_state, const uint8_t *bytes,
+                                                size_t size) {
+  for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), bytes += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, bytes, sizeof(word));
+    crc_state = __crc32cd(crc_state, word);
+  }
+  for (; size > 0; --size, ++bytes) {
+    crc_state = __crc32cb(crc_state, *bytes);
+  }
+  return crc_state;
+}
+
+bool CpuHasCrc32c() {
+  return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+#elif defined(__x86_64__) || defined(__i386__)
+VKQ_TARGET_CRC32C uint32_t Crc32cUpdateHardware(uint32_t crc_state, const uint8_t *bytes,
+                                                size_t size) {
+#if defined(__x86_64__)
+  uint64_t wide_state = crc_state;
+  for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), bytes += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, bytes, sizeof(word));
+    wide_state = _mm_crc32_u64(wide_state, word);
+  }
+  crc_state = static_cast<uint32_t>(wide_state);
+#else
+  for (; size >= sizeof(uint32_t); size -= sizeof(uint32_t), bytes += sizeof(uint32_t)) {
+    uint32_t word;
+    memcpy(&word, bytes, sizeof(word));
+    crc_state = _mm_crc32_u32(crc_state, word);
+  }
+#endif
+  for (; size > 0; --size, ++bytes) {
+    crc_state = _mm_crc32_u8(crc_state, *bytes);
+  }
+  return crc_state;
+}
+
+bool CpuHasCrc32c() {
+  return __builtin_cpu_supports("sse4.2");
+}
+#endif
+
+Crc32cUpdate SelectCrc32cUpdate() {
+#if defined(VKQ_TARGET_CRC32C)
+  if (CpuHasCrc32c()) {
+    return Crc32cUpdateHardware;
+  }
+#endif
+  return Crc32cUpdateTable;
+}
+
+} // anonymous namespace
+
+uint32_t VkQualityChecksum::Crc32c(const uint32_t crc, const void *data, const size_t size) {
+  static const Crc32cUpdate crc32c_update = SelectCrc32cUpdate();
+  return ~crc32c_update(~crc, reinterpret_cast<const uint8_t *>(data), size);
+}
+
+uint32_t VkQualityChecksum::Crc32cPortable(const uint32_t crc, const void *data,
+                                           const size_t size) {
+  return ~Crc32cUpdateTable(~crc, reinterpret_cast<const uint8_t *>(data), size);
+}
+
+bool VkQualityChecksum::HasHardwareCrc32c() {
+#if defined(VKQ_TARGET_CRC32C)
+  return CpuHasCrc32c();
+#else
+  return false;
+#endif
+}
+
+} // namespace vkquality
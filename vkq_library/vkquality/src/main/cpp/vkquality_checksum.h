@@ -0,0 +1,40 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VKQUALITY_CHECKSUM_H_
+#define VKQUALITY_CHECKSUM_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vkquality {
+
+class VkQualityChecksum {
+public:
+  // CRC-32C (Castagnoli). Pass the result of the previous call as crc to
+  // continue a checksum over more data, and 0 to start one. Uses the ARMv8 CRC32
+  // or SSE4.2 instructions when the CPU has them.
+  static uint32_t Crc32c(const uint32_t crc, const void *data, const size_t size);
+
+  // The table driven implementation Crc32c falls back to, for comparison
+  static uint32_t Crc32cPortable(const uint32_t crc, const void *data, const size_t size);
+
+  static bool HasHardwareCrc32c();
+};
+
+} // namespace vkquality
+
+#endif // VKQUALITY_CHECKSUM_H_
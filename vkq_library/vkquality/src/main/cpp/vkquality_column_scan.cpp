@@ -0,0 +1,186 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vkquality_column_scan.h"
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace vkquality {
+
+namespace {
+
+// Same thresholds as VkQualityMatching::CheckGpuMatch, which compares the
+// API level as unsigned
+bool PassesGpuFilter(const VkQualityGpuColumns &columns, const uint32_t index,
+                     const DeviceInfo &device_info, const bool deny_list) {
+  const uint32_t api_level = static_cast<uint32_t>(device_info.api_level);
+  const uint32_t min_api = columns.min_api_version[index];
+  const uint32_t min_driver = columns.min_driver_version[index];
+  if (deny_list) {
+    if (min_driver > 0 && device_info.vk_driver_version > min_driver) {
+      return false;
+    }
+    if (min_api > 0 && api_level > min_api) {
+      return false;
+    }
+  } else {
+    if (min_driver > 0 && device_info.vk_driver_version < min_driver) {
+      return false;
+    }
+    if (min_api > 0 && api_level < min_api) {
+      return false;
+    }
+  }
+  // String index 0 is the null string
+  return (columns.device_name_string_index[index] != 0 ||
+          (columns.device_id[index] == device_info.vk_device_id &&
+           columns.vendor_id[index] == device_info.vk_vendor_id));
+}
+
+#if defined(__SSE2__)
+
+// Bit n set if entry index + n is a candidate
+uint32_t ScanGpuColumns4(const VkQualityGpuColumns &columns, const uint32_t index,
+                         const DeviceInfo &device_info, const bool deny_list) {
+  // No unsigned compares in SSE2, flip the sign bits and compare signed
+  const __m128i sign_bits = _mm_set1_epi32(static_cast<int32_t>(0x80000000));
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i api_level = _mm_xor_si128(
+      _mm_set1_epi32(device_info.api_level), sign_bits);
+  const __m128i driver_version = _mm_xor_si128(
+      _mm_set1_epi32(static_cast<int32_t>(device_info.vk_driver_version)), sign_bits);
+
+  const __m128i min_api = _mm_loadu_si128(
+      reinterpret_cast<const __m128i *>(columns.min_api_version + index));
+  const __m128i min_driver = _mm_loadu_si128(
+      reinterpret_cast<const __m128i *>(columns.min_driver_version + index));
+  const __m128i min_api_signed = _mm_xor_si128(min_api, sign_bits);
+  const __m128i min_driver_signed = _mm_xor_si128(min_driver, sign_bits);
+
+  __m128i failed;
+  if (deny_list) {
+    const __m128i api_failed = _mm_andnot_si128(_mm_cmpeq_epi32(min_api, zero),
+                                                _mm_cmpgt_epi32(api_level, min_api_signed));
+    const __m128i driver_failed = _mm_andnot_si128(
+        _mm_cmpeq_epi32(min_driver, zero), _mm_cmpgt_epi32(driver_version, min_driver_signed));
+    failed = _mm_or_si128(api_failed, driver_failed);
+  } else {
+    // A minimum greater than the device value is never 0
+    failed = _mm_or_si128(_mm_cmpgt_epi32(min_api_signed, api_level),
+                          _mm_cmpgt_epi32(min_driver_signed, driver_version));
+  }
+
+  const __m128i name_index = _mm_loadu_si128(
+      reinterpret_cast<const __m128i *>(columns.device_name_string_index + index));
+  const __m128i device_id = _mm_loadu_si128(
+      reinterpret_cast<const __m128i *>(columns.device_id + index));
+  const __m128i vendor_id = _mm_loadu_si128(
+      reinterpret_cast<const __m128i *>(columns.vendor_id + index));
+  const __m128i ids_match = _mm_and_si128(
+      _mm_cmpeq_epi32(device_id, _mm_set1_epi32(static_cast<int32_t>(device_info.vk_device_id))),
+      _mm_cmpeq_epi32(vendor_id, _mm_set1_epi32(static_cast<int32_t>(device_info.vk_vendor_id))));
+  // Entries without a device name need matching ids
+  const __m128i unnamed = _mm_andnot_si128(ids_match, _mm_cmpeq_epi32(name_index, zero));
+  const __m128i rejected = _mm_or_si128(failed, unnamed);
+  return (~static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(rejected)))) & 0xF;
+}
+
+#elif defined(__ARM_NEON)
+
+uint32_t ScanGpuColumns4(const VkQualityGpuColumns &columns, const uint32_t index,
+                         const DeviceInfo &device_info, const bool deny_list) {
+  const uint32x4_t api_level = vdupq_n_u32(static_cast<uint32_t>(device_info.api_level));
+  const uint32x4_t driver_version = vdupq_n_u32(device_info.vk_driver_version);
+  const uint32x4_t min_api = vld1q_u32(columns.min_api_version + index);
+  const uint32x4_t min_driver = vld1q_u32(columns.min_driver_version + index);
+
+  uint32x4_t failed;
+  if (deny_list) {
+    failed = vorrq_u32(vandq_u32(vtstq_u32(min_api, min_api), vcgtq_u32(api_level, min_api)),
+                       vandq_u32(vtstq_u32(min_driver, min_driver),
+                                 vcgtq_u32(driver_version, min_driver)));
+  } else {
+    // A minimum greater than the device value is never 0
+    failed = vorrq_u32(vcgtq_u32(min_api, api_level), vcgtq_u32(min_driver, driver_version));
+  }
+
+  const uint32x4_t name_index = vld1q_u32(columns.device_name_string_index + index);
+  const uint32x4_t ids_match = vandq_u32(
+      vceqq_u32(vld1q_u32(columns.device_id + index), vdupq_n_u32(device_info.vk_device_id)),
+      vceqq_u32(vld1q_u32(columns.vendor_id + index), vdupq_n_u32(device_info.vk_vendor_id)));
+  const uint32x4_t candidates = vbicq_u32(vorrq_u32(vtstq_u32(name_index, name_index), ids_match),
+                                          failed);
+
+  // Lane n to bit n, pairwise adds also work on 32-bit ARM
+  static const uint32_t kLaneBits[4] = {1, 2, 4, 8};
+  const uint32x4_t lane_bits = vandq_u32(candidates, vld1q_u32(kLaneBits));
+  uint32x2_t lane_sum = vpadd_u32(vget_low_u32(lane_bits), vget_high_u32(lane_bits));
+  lane_sum = vpadd_u32(lane_sum, lane_sum);
+  return vget_lane_u32(lane_sum, 0);
+}
+
+#endif
+
+} // anonymous namespace
+
+uint32_t VkQualityColumnScan::FindGpuCandidateScalar(const VkQualityGpuColumns &columns,
+                                                     const DeviceInfo &device_info,
+                                                     const bool deny_list,
+                                                     const uint32_t start_index,
+                                                     const uint32_t end_index) {
+  for (uint32_t i = start_index; i < end_index; ++i) {
+    if (PassesGpuFilter(columns, i, device_info, deny_list)) {
+      return i;
+    }
+  }
+  return columns.count;
+}
+
+uint32_t VkQualityColumnScan::FindGpuCandidate(const VkQualityGpuColumns &columns,
+                                               const DeviceInfo &device_info,
+                                               const bool deny_list,
+                                               const uint32_t start_index) {
+#if defined(__SSE2__) || defined(__ARM_NEON)
+  const uint32_t count = columns.count;
+  if (start_index >= count) {
+    return count;
+  }
+  // Scalar up to a 4 entry boundary, then 4 entries at a time. The last vector
+  // can read into the column padding, lanes at or past count are ignored.
+  const uint32_t vector_start = std::min(count, (start_index + 3) & ~3U);
+  const uint32_t head_index = FindGpuCandidateScalar(columns, device_info, deny_list,
+                                                     start_index, vector_start);
+  if (head_index != count) {
+    return head_index;
+  }
+  for (uint32_t index = vector_start; index < count; index += 4) {
+    const uint32_t lane_mask = ScanGpuColumns4(columns, index, device_info, deny_list);
+    if (lane_mask != 0) {
+      return std::min(count, index + static_cast<uint32_t>(__builtin_ctz(lane_mask)));
+    }
+  }
+  return count;
+#else
+  return FindGpuCandidateScalar(columns, device_info, deny_list, start_index, columns.count);
+#endif
+}
+
+}
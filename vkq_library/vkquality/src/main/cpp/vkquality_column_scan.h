@@ -0,0 +1,56 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VKQUALITY_COLUMN_SCAN_H_
+#define VKQUALITY_COLUMN_SCAN_H_
+
+#include "vkquality_device_info.h"
+#include <cstdint>
+
+namespace vkquality {
+
+// Columns of a GPU predict list column section, see VkQualityGpuColumnsHeader.
+// Each column has room for a multiple of 4 entries so the scans can load
+// whole vectors past count.
+struct VkQualityGpuColumns {
+  const uint32_t *device_name_string_index = nullptr;
+  const uint32_t *min_api_version = nullptr;
+  const uint32_t *device_id = nullptr;
+  const uint32_t *vendor_id = nullptr;
+  const uint32_t *min_driver_version = nullptr;
+  uint32_t count = 0;
+};
+
+class VkQualityColumnScan {
+public:
+  // Returns the index of the first entry at or after start_index that passes the
+  // API level and driver version thresholds and has either a device name or a
+  // matching device/vendor id pair, or columns.count if there is none. Entries
+  // returned still need VkQualityMatching::CheckGpuMatch, entries skipped can't match.
+  static uint32_t FindGpuCandidate(const VkQualityGpuColumns &columns,
+                                   const DeviceInfo &device_info, const bool deny_list,
+                                   const uint32_t start_index);
+
+  // Portable version of FindGpuCandidate, used for the column tails and on
+  // targets without SSE2 or NEON
+  static uint32_t FindGpuCandidateScalar(const VkQualityGpuColumns &columns,
+                                         const DeviceInfo &device_info, const bool deny_list,
+                                         const uint32_t start_index, const uint32_t end_index);
+};
+
+}
+
+#endif // VKQUALITY_COLUMN_SCAN_H_
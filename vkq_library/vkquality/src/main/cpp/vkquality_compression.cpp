@@ -0,0 +1,180 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vkquality_compression.h"
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace vkquality {
+
+static constexpr uint32_t kMinMatchLength = 4;
+static constexpr uint32_t kLengthMask = 15;
+
+// Extended literal and match lengths add bytes until one isn't 255
+static bool ReadLength(const uint8_t *src, const size_t src_size, size_t &src_pos,
+                       size_t &length) {
+  uint8_t length_byte;
+  do {
+    if (src_pos >= src_size) {
+      return false;
+    }
+    length_byte = src[src_pos++];
+    length += length_byte;
+  } while (length_byte == 255);
+  return true;
+}
+
+bool VkQualityCompression::IsCompressed(const void *data, const size_t size) {
+  uint32_t identifier = 0;
+  if (data == nullptr || size < sizeof(identifier)) {
+    return false;
+  }
+  memcpy(&identifier, data, sizeof(identifier));
+  return identifier == kCompressed_File_Identifier;
+}
+
+size_t VkQualityCompression::GetCompressedBound(const size_t uncompressed_size) {
+  return uncompressed_size + (uncompressed_size / 255) + 16;
+}
+
+bool VkQualityCompression::DecompressBlock(const uint8_t *src, const size_t src_size,
+                                           uint8_t *dst_start, const size_t dst_offset,
+                                           const size_t dst_end) {
+  size_t src_pos = 0;
+  size_t dst_pos = dst_offset;
+  while (src_pos < src_size) {
+    const uint8_t token = src[src_pos++];
+
+    size_t literal_length = token >> 4;
+    if (literal_length == kLengthMask &&
+        !ReadLength(src, src_size, src_pos, literal_length)) {
+      return false;
+    }
+    if (literal_length > src_size - src_pos || literal_length > dst_end - dst_pos) {
+      return false;
+    }
+    memcpy(dst_start + dst_pos, src + src_pos, literal_length);
+    src_pos += literal_length;
+    dst_pos += literal_length;
+
+    // The last sequence of a block has only literals
+    if (src_pos == src_size) {
+      break;
+    }
+
+    if (src_size - src_pos < 2) {
+      return false;
+    }
+    const size_t match_offset = src[src_pos] | (src[src_pos + 1] << 8);
+    src_pos += 2;
+    if (match_offset == 0 || match_offset > dst_pos) {
+      return false;
+    }
+    size_t match_length = token & kLengthMask;
+    if (match_length == kLengthMask &&
+        !ReadLength(src, src_size, src_pos, match_length)) {
+      return false;
+    }
+    match_length += kMinMatchLength;
+    if (match_length > dst_end - dst_pos) {
+      return false;
+    }
+
+    const uint8_t *match = dst_start + dst_pos - match_offset;
+    uint8_t *dst = dst_start + dst_pos;
+    if (match_offset >= match_length) {
+      memcpy(dst, match, match_length);
+    } else {
+      // Overlapping matches repeat the bytes just written
+      for (size_t i = 0; i < match_length; ++i) {
+        dst[i] = match[i];
+      }
+    }
+    dst_pos += match_length;
+  }
+  return dst_pos == dst_end;
+}
+
+void *VkQualityCompression::DecompressStream(const VkQualityCompressedFileHeader &header,
+                                             const ReadFunction &read_function,
+                                             size_t &file_size) {
+  if (header.file_identifier != kCompressed_File_Identifier ||
+      header.container_version != kContainer_Version ||
+      header.uncompressed_size < sizeof(VkQualityFileHeader) ||
+      header.uncompressed_size > kMax_Uncompressed_Size ||
+      header.block_size == 0 || header.block_size > kMax_Block_Size) {
+    return nullptr;
+  }
+
+  // One byte past the end, as for uncompressed files
+  uint8_t *file_bytes = reinterpret_cast<uint8_t *>(malloc(header.uncompressed_size + 1));
+  if (file_bytes == nullptr) {
+    return nullptr;
+  }
+  if (!read_function(file_bytes, sizeof(VkQualityFileHeader))) {
+    free(file_bytes);
+    return nullptr;
+  }
+
+  // Only one compressed block is held at a time, it decodes directly into
+  // the file buffer
+  std::vector<uint8_t> block_data;
+  size_t decoded_size = sizeof(VkQualityFileHeader);
+  while (decoded_size < header.uncompressed_size) {
+    VkQualityCompressedBlockHeader block_header;
+    if (!read_function(&block_header, sizeof(block_header)) ||
+        block_header.uncompressed_size == 0 ||
+        block_header.uncompressed_size > header.block_size ||
+        block_header.uncompressed_size > header.uncompressed_size - decoded_size ||
+        block_header.compressed_size > GetCompressedBound(block_header.uncompressed_size)) {
+      free(file_bytes);
+      return nullptr;
+    }
+    block_data.resize(block_header.compressed_size);
+    if (!read_function(block_data.data(), block_data.size()) ||
+        !DecompressBlock(block_data.data(), block_data.size(), file_bytes, decoded_size,
+                         decoded_size + block_header.uncompressed_size)) {
+      free(file_bytes);
+      return nullptr;
+    }
+    decoded_size += block_header.uncompressed_size;
+  }
+  file_bytes[decoded_size] = 0;
+  file_size = decoded_size;
+  return file_bytes;
+}
+
+void *VkQualityCompression::Decompress(const void *data, const size_t size,
+                                       size_t &file_size) {
+  VkQualityCompressedFileHeader header;
+  if (!IsCompressed(data, size) || size < sizeof(header)) {
+    return nullptr;
+  }
+  memcpy(&header, data, sizeof(header));
+  const uint8_t *src = reinterpret_cast<const uint8_t *>(data);
+  size_t src_pos = sizeof(header);
+  return DecompressStream(header, [src, size, &src_pos](void *buffer, size_t read_size) {
+    if (read_size > size - src_pos) {
+      return false;
+    }
+    memcpy(buffer, src + src_pos, read_size);
+    src_pos += read_size;
+    return true;
+  }, file_size);
+}
+
+} // namespace vkquality
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VKQUALITY_COMPRESSION_H_
+#define VKQUALITY_COMPRESSION_H_
+
+#include "vkquality_file_format.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace vkquality {
+
+// Decoder for compressed container files, see VkQualityCompressedFileHeader.
+// The encoder is part of the host tooling, see VkQualityFileWriter::Compress.
+class VkQualityCompression {
+public:
+  static constexpr uint32_t kCompressed_File_Identifier = 0x564b515a; // VKQZ
+  static constexpr uint32_t kContainer_Version = 1;
+  // Limits that keep a corrupt header from requesting a huge allocation
+  static constexpr uint32_t kMax_Block_Size = 1024 * 1024;
+  static constexpr uint32_t kMax_Uncompressed_Size = 64 * 1024 * 1024;
+
+  // Reads exactly size bytes of the container into buffer, false on a short read
+  typedef std::function<bool(void *buffer, size_t size)> ReadFunction;
+
+  static bool IsCompressed(const void *data, const size_t size);
+
+  // Worst case compressed size of a block, blocks larger than this are invalid
+  static size_t GetCompressedBound(const size_t uncompressed_size);
+
+  // Decodes the container one block at a time while reading it, after the
+  // container header was read by the caller, into a buffer allocated with
+  // malloc() that receives the data file. Returns nullptr if the container
+  // is invalid or can't be read.
+  static void *DecompressStream(const VkQualityCompressedFileHeader &header,
+                                const ReadFunction &read_function, size_t &file_size);
+
+  // Decodes a container already in memory
+  static void *Decompress(const void *data, const size_t size, size_t &file_size);
+
+  // Decodes one block of LZ4 sequences to dst_start + dst_offset, ending exactly
+  // at dst_start + dst_end. Matches may refer back to anywhere after dst_start.
+  static bool DecompressBlock(const uint8_t *src, const size_t src_size, uint8_t *dst_start,
+                              const size_t dst_offset, const size_t dst_end);
+};
+
+} // namespace vkquality
+
+#endif // VKQUALITY_COMPRESSION_H_
@@ -0,0 +1,393 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef VKQUALITY_CORE_H_
+#define VKQUALITY_CORE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// Types and functions that do not depend on JNI or other Android
+// APIs. The Android initialization API is declared in vkquality.h
+
+/**
+ * @brief Flag bitfields that cam be passed to ::vkQuality_initializeFlags
+ * in the flags parameter.
+ */
+ enum vkQualityInitFlags : int32_t {
+     /**
+      * @brief Disable the quality check against the SoC/driver fingerprint additional
+      * allow/deny list introduced in version 1.2
+      */
+     kInitFlagSkipFingerprintRecommendationCheck = (1 << 2),
+     /**
+      * @brief Watch the quality data file in the storage directory and
+      * automatically call ::vkQuality_reload when a new version of the file has been
+      * written or moved into place. Only supported on Android/Linux, and
+      * ignored if no storage directory was specified.
+      */
+     kInitFlagWatchStoragePath = (1 << 3),
+     /**
+      * @brief Skip verifying the content checksum of a quality data file loaded
+      * from the app bundle assets, which are already covered by the app signature.
+      * Files in the storage directory are always verified.
+      */
+     kInitFlagSkipAssetChecksum = (1 << 5)
+ };
+
+/**
+ * @brief Result codes returned by ::vkQuality_initialize.
+ */
+enum vkQualityInitResult : int32_t {
+  /**
+   * @brief VKQuality initialization was successful.
+   */
+  kSuccess = 0,
+  /**
+   * @brief VkQuality failed to initialize, unspecified reason
+   */
+  kErrorInitializationFailure = -1,
+  /**
+   * @brief VkQuality failed to initialize, Vulkan was either
+   * not available on the device or couldn't be initialized
+   */
+  kErrorNoVulkan = -2,
+  /**
+   * @brief VkQuality failed to initialize, specified quality
+   * data file was an incompatible version
+   */
+  kErrorInvalidDataVersion = -3,
+  /**
+   * @brief VkQuality failed to initialize, specified quality
+   * data file was invalid
+   */
+  kErrorInvalidDataFile = -4,
+  /**
+   * @brief VkQuality failed to initialize, specified quality
+   * data file could not be found in the app bundle or
+   * in the storage directory
+   */
+  kErrorMissingDataFile = -5
+};
+
+/**
+ * @brief API recommendation returned by ::vkQuality_getRecommendation.
+ */
+enum vkQualityRecommendation : int32_t {
+  /**
+   * @brief A recommendation is not yet ready, call ::vkQuality_getRecommendation
+   * again after a brief interval.
+   */
+  kRecommendationNotReady = -2,
+  /**
+   * @brief VkQuality is not initialized. Either ::vkQuality_initialize was
+   * not called or it returned a failure code.
+   */
+  kRecommendationErrorNotInitialized = -1,
+  /**
+   * @brief Recommend using the Vulkan API. Reason is a device match
+   * was found in the device allow list
+   */
+  kRecommendationVulkanBecauseDeviceMatch = 0,
+  /**
+   * @brief Recommend using the Vulkan API. Reason is a GPU/driver match
+   * was found in the predicted quality allow list
+   */
+  kRecommendationVulkanBecausePredictionMatch,
+  /**
+   * @brief Recommend using the Vulkan API. Reason is device is running
+   * on a higher version of Android beyond what is covered by this
+   * release of VkQuality
+   */
+  kRecommendationVulkanBecauseFutureAndroid,
+  /**
+   * @brief Recommend using the OpenGL ES API. Reason is the device
+   * is running on a version of Android lower than 10, or only
+   * supports Vulkan 1.0.x
+   */
+  kRecommendationGLESBecauseOldDevice,
+  /**
+   * @brief Recommend using the GLES API. Reason is a device match
+   * was found in the device allow list, but its Vulkan driver version
+   * was below a specified minimum version number
+   */
+  kRecommendationGLESBecauseOldDriver,
+  /**
+   * @brief Recommend using the OpenGL ES API. Reason is no matches
+   * were found in the Vulkan device allow list or Vulkan predicted
+   * quality list
+   */
+  kRecommendationGLESBecauseNoDeviceMatch,
+  /**
+   * @brief Recommend using the OpenGL ES API. Reason is a GPU/driver match
+   * was found in the predicted quality deny list
+   */
+  kRecommendationGLESBecausePredictionMatch
+};
+
+/**
+ * @brief Struct used to optionally pass graphics API information to
+ * ::vkQuality_initializeFlagsInfo so the library can use it for
+ * making a recommendation without having to stand up a graphics API
+ * instance to query. Pointers in the struct may be null and are
+ * only expected to be valid until return from ::vkQuality_initializeFlagsInfo
+ */
+typedef struct vkqGraphicsAPIInfo {
+  /**
+   * @brief If non-null, expected to be a pointer containing the contents
+   * of calling glGetString with the GL_VERSION enum. If a string is provided,
+   * the library will not create a GL instance and instead use the string.
+   */
+   const char *gles_version_string;
+
+  /**
+   * @brief If non-null, expected to be a pointer to a valid 
+   * `vkGetPhysicalDeviceProperties` structure. If provided, the library
+   * will use the data in this structure instead of creating a Vulkan
+   * instance to retrieve it.
+   */
+   void *vk_physical_device_properties;
+} vkqGraphicsAPIInfo;
+
+/**
+ * @brief Which list or rule of the quality data file determined a recommendation,
+ * returned as part of a ::vkqEvaluationResult.
+ */
+enum vkQualityMatchType : int32_t {
+  /**
+   * @brief Matched a Build.BRAND/Build.DEVICE entry in the device allow list
+   */
+  kMatchTypeDevice = 0,
+  /**
+   * @brief Matched a device allow list entry, but the device was below the
+   * minimum API level or driver version of the entry
+   */
+  kMatchTypeDeviceOldVersion,
+  /**
+   * @brief Matched a Build.BRAND entry with no Build.DEVICE in the device allow list
+   */
+  kMatchTypeBrandWildcard,
+  /**
+   * @brief Matched a SoC/driver fingerprint pair in the driver allow list
+   */
+  kMatchTypeDriverAllow,
+  /**
+   * @brief Matched a SoC/driver fingerprint pair in the driver deny list
+   */
+  kMatchTypeDriverDeny,
+  /**
+   * @brief Matched an entry in the GPU predict allow list
+   */
+  kMatchTypeGpuAllow,
+  /**
+   * @brief Matched an entry in the GPU predict deny list
+   */
+  kMatchTypeGpuDeny,
+  /**
+   * @brief Matched a SoC/driver version range rule in the driver allow rules
+   */
+  kMatchTypeDriverRuleAllow,
+  /**
+   * @brief Matched a SoC/driver version range rule in the driver deny rules
+   */
+  kMatchTypeDriverRuleDeny,
+  /**
+   * @brief Matched a Vulkan feature and extension rule in the capability allow rules
+   */
+  kMatchTypeCapabilityAllow,
+  /**
+   * @brief Matched a Vulkan feature and extension rule in the capability deny rules
+   */
+  kMatchTypeCapabilityDeny,
+  /**
+   * @brief No list entry matched, or the recommendation did not require
+   * searching the lists
+   */
+  kMatchTypeNone
+};
+
+/**
+ * @brief Description of a device passed to ::vkQuality_evaluateDevice.
+ * String pointers may be null, which is treated as an empty string, and are
+ * only expected to be valid until return from ::vkQuality_evaluateDevice.
+ */
+typedef struct vkqDeviceDescription {
+  /**
+   * @brief The value of android.os.Build.BRAND
+   */
+  const char *brand;
+  /**
+   * @brief The value of android.os.Build.DEVICE
+   */
+  const char *device;
+  /**
+   * @brief The value of android.os.Build.SOC_MODEL, only available
+   * on Android API level 31 and higher
+   */
+  const char *soc;
+  /**
+   * @brief The contents of calling glGetString with the GL_VERSION enum
+   */
+  const char *gles_version;
+  /**
+   * @brief `VkPhysicalDeviceProperties.deviceName`
+   */
+  const char *vk_device_name;
+  /**
+   * @brief The Android API level the device is running
+   */
+  int32_t api_level;
+  /**
+   * @brief `VkPhysicalDeviceProperties.apiVersion`
+   */
+  uint32_t vk_api_version;
+  /**
+   * @brief `VkPhysicalDeviceProperties.driverVersion`
+   */
+  uint32_t vk_driver_version;
+  /**
+   * @brief `VkPhysicalDeviceProperties.deviceID`
+   */
+  uint32_t vk_device_id;
+  /**
+   * @brief `VkPhysicalDeviceProperties.vendorID`
+   */
+  uint32_t vk_vendor_id;
+  /**
+   * @brief Supported Vulkan features and extensions as capability bits, see
+   * vkquality_capabilities.h. Bit 63 marks the capabilities as probed, without
+   * it capability rules don't match. Pass 0 if unknown.
+   */
+  uint64_t vk_capabilities;
+} vkqDeviceDescription;
+
+/**
+ * @brief Recommendation and match details returned by ::vkQuality_evaluateDevice.
+ */
+typedef struct vkqEvaluationResult {
+  /**
+   * @brief The graphics API recommendation for the device
+   */
+  vkQualityRecommendation recommendation;
+  /**
+   * @brief The list that determined the recommendation
+   */
+  vkQualityMatchType match_type;
+  /**
+   * @brief Index of the matching entry in the list identified by `match_type`.
+   * For driver list matches this is the index of the driver fingerprint entry.
+   * Zero if `match_type` is `kMatchTypeNone`.
+   */
+  uint32_t match_index;
+  /**
+   * @brief The `list_version` of the evaluated quality data file, zero if
+   * the recommendation did not require the file
+   */
+  uint32_t list_version;
+} vkqEvaluationResult;
+
+/**
+ * @brief Function called by VkQuality when it no longer needs quality data
+ * file contents that were handed to it in memory.
+ * @param list_data The `list_data` pointer that was passed to VkQuality.
+ * @param user_data The `release_user_data` pointer that was passed to VkQuality.
+ * @see vkQuality_initializeFromMemory
+ */
+typedef void (*vkqListDataRelease)(void *list_data, void *user_data);
+
+/**
+ * @brief Function called by VkQuality to read part of a quality data file
+ * evaluated with ::vkQuality_evaluateDeviceStream.
+ * @param user_data The `user_data` pointer that was passed to VkQuality.
+ * @param offset Offset in bytes from the start of the file.
+ * @param buffer Buffer that receives the file contents.
+ * @param size Number of bytes to read, never past the end of the file.
+ * @return The number of bytes read, anything other than `size` is a read error.
+ */
+typedef size_t (*vkqReadCallback)(void *user_data, uint64_t offset, void *buffer, size_t size);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Evaluate a caller supplied device description against a quality data
+ * file in memory. Does not use JNI, create graphics API instances or perform
+ * any file i/o, and does not require VkQuality to be initialized.
+ * @param device_description Description of the device to evaluate.
+ * @param list_data Pointer to the contents of a quality data file. The
+ * data is only read, and only needs to remain valid until function return.
+ * @param list_size Size of the quality data file in bytes.
+ * @param flags A bit field of ::vkQualityInitFlags enum values specifying
+ * flags to alter default recommendation behavior
+ * @param result Pointer to a ::vkqEvaluationResult that receives the
+ * recommendation and match details.
+ * @return `kSuccess` if successful, `kErrorInvalidDataVersion` or
+ * `kErrorInvalidDataFile` if the quality data file could not be used.
+ */
+vkQualityInitResult vkQuality_evaluateDevice(const vkqDeviceDescription *device_description,
+                                             const void *list_data, size_t list_size,
+                                             int32_t flags, vkqEvaluationResult *result);
+
+/**
+ * @brief Evaluate a caller supplied device description against a quality data
+ * file that is read on demand through a callback, for devices that can't spare
+ * the memory to hold the whole file. The file is read in small pages into a
+ * fixed size cache of a few kilobytes. Gives the same results as
+ * ::vkQuality_evaluateDevice, except that compressed files are not supported
+ * and devices in the sharded device list buckets of a root file don't match.
+ * Does not use JNI and does not require VkQuality to be initialized.
+ * @param device_description Description of the device to evaluate.
+ * @param read_callback Function that reads the quality data file.
+ * @param user_data Pointer passed to each `read_callback` call.
+ * @param list_size Size of the quality data file in bytes.
+ * @param flags A bit field of ::vkQualityInitFlags enum values specifying
+ * flags to alter default recommendation behavior
+ * @param result Pointer to a ::vkqEvaluationResult that receives the
+ * recommendation and match details.
+ * @return `kSuccess` if successful, `kErrorInvalidDataVersion` or
+ * `kErrorInvalidDataFile` if the quality data file could not be used.
+ */
+vkQualityInitResult vkQuality_evaluateDeviceStream(const vkqDeviceDescription *device_description,
+                                                   vkqReadCallback read_callback, void *user_data,
+                                                   uint64_t list_size, int32_t flags,
+                                                   vkqEvaluationResult *result);
+
+/**
+ * @brief Update a downloaded quality data file in the storage path by applying
+ * a list patch. The patch is streamed over the current file into a new file in
+ * the storage path, which replaces the current file only once its size and
+ * checksum match the patch. Does not use JNI and does not require VkQuality to
+ * be initialized, call ::vkQuality_reload afterwards to use the updated file.
+ * @param storage_path Path of the directory holding the quality data file.
+ * @param list_filename Name of the quality data file to update.
+ * @param patch_path Full path of the downloaded patch file.
+ * @return `kSuccess` if the file was updated. `kErrorMissingDataFile` if the
+ * data file or patch couldn't be opened, `kErrorInvalidDataVersion` if the
+ * patch was made for a different version of the data file, `kErrorInvalidDataFile`
+ * if the patch is corrupt and `kErrorInitializationFailure` if the new file
+ * couldn't be written. The current file is unchanged on error.
+ */
+vkQualityInitResult vkQuality_applyListPatch(const char *storage_path,
+                                             const char *list_filename,
+                                             const char *patch_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VKQUALITY_CORE_H_
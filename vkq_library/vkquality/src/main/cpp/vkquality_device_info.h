@@ -35,6 +35,8 @@ struct DeviceInfo {
   uint32_t vk_device_id = kWildcardValue;
   uint32_t vk_driver_version = kWildcardValue;
   uint32_t vk_vendor_id = kWildcardValue;
+  // VkQualityCapabilities bits, 0 if the physical device wasn't probed
+  uint64_t vk_capabilities = 0;
 };
 
 }
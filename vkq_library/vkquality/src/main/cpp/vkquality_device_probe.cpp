@@ -0,0 +1,83 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vkquality_device_probe.h"
+#include <string.h>
+
+namespace vkquality {
+
+bool VkQualityDeviceProbe::Probe(const Loader &loader, VkQualityDeviceCandidates &candidates) {
+  candidates.count = 0;
+  if (loader.enumerate_physical_devices == nullptr ||
+      loader.get_queue_family_flags == nullptr || loader.get_device_properties == nullptr) {
+    return false;
+  }
+
+  // A loader with more devices than fit reports VK_INCOMPLETE, the devices
+  // that fit are still valid
+  void *physical_devices[kMaxPhysicalDevices] = {};
+  uint32_t device_count = kMaxPhysicalDevices;
+  const int32_t result = loader.enumerate_physical_devices(loader.user_data, &device_count,
+                                                           physical_devices);
+  if (result != kResultSuccess && result != kResultIncomplete) {
+    return false;
+  }
+  if (device_count > kMaxPhysicalDevices) {
+    device_count = kMaxPhysicalDevices;
+  }
+
+  uint32_t queue_flags[kMaxQueueFamilies];
+  for (uint32_t i = 0; i < device_count; ++i) {
+    uint32_t family_count = kMaxQueueFamilies;
+    loader.get_queue_family_flags(loader.user_data, physical_devices[i], &family_count,
+                                  queue_flags);
+    bool has_graphics_queue = false;
+    for (uint32_t family = 0; family < family_count && family < kMaxQueueFamilies; ++family) {
+      if ((queue_flags[family] & kQueueGraphicsBit) != 0) {
+        has_graphics_queue = true;
+        break;
+      }
+    }
+    if (!has_graphics_queue) {
+      continue;
+    }
+
+    VkQualityDeviceCandidate &candidate = candidates.candidates[candidates.count++];
+    memset(&candidate, 0, sizeof(candidate));
+    loader.get_device_properties(loader.user_data, physical_devices[i], candidate);
+    candidate.physical_device_index = i;
+    candidate.capabilities = 0;
+    uint64_t capabilities = 0;
+    if (loader.get_capabilities != nullptr &&
+        loader.get_capabilities(loader.user_data, physical_devices[i], &capabilities)) {
+      candidate.capabilities = capabilities | VkQualityCapabilities::kCapability_Probed;
+    }
+    candidate.device_name[sizeof(candidate.device_name) - 1] = '\0';
+  }
+  return candidates.count > 0;
+}
+
+void VkQualityDeviceProbe::CopyCandidate(const VkQualityDeviceCandidate &candidate,
+                                         DeviceInfo &device_info) {
+  device_info.vk_api_version = candidate.api_version;
+  device_info.vk_driver_version = candidate.driver_version;
+  device_info.vk_device_id = candidate.device_id;
+  device_info.vk_vendor_id = candidate.vendor_id;
+  device_info.vk_device_name = candidate.device_name;
+  device_info.vk_capabilities = candidate.capabilities;
+}
+
+} // namespace vkquality
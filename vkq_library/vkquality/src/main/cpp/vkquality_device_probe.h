@@ -0,0 +1,96 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VKQUALITY_DEVICE_PROBE_H_
+#define VKQUALITY_DEVICE_PROBE_H_
+
+#include "vkquality_capabilities.h"
+#include "vkquality_device_info.h"
+#include <cstdint>
+
+namespace vkquality {
+
+// A physical device with a graphics queue, holding the properties the lists
+// match on. Fixed size so probing never allocates
+struct VkQualityDeviceCandidate {
+  // Index of the device in vkEnumeratePhysicalDevices order
+  uint32_t physical_device_index;
+  uint32_t api_version;
+  uint32_t driver_version;
+  uint32_t vendor_id;
+  uint32_t device_id;
+  // VkPhysicalDeviceType
+  int32_t device_type;
+  // VkQualityCapabilities bits, 0 if the loader can't report capabilities
+  uint64_t capabilities;
+  // VK_MAX_PHYSICAL_DEVICE_NAME_SIZE, always null terminated
+  char device_name[256];
+};
+
+struct VkQualityDeviceCandidates {
+  static constexpr uint32_t kMaxCandidates = 8;
+
+  uint32_t count = 0;
+  VkQualityDeviceCandidate candidates[kMaxCandidates];
+};
+
+// Enumerates the physical devices of a Vulkan instance into candidates. The
+// Vulkan entry points are called through a Loader, so the probe builds
+// without the Vulkan headers and can run against a stub loader on the host
+class VkQualityDeviceProbe {
+ public:
+  // Physical devices past this index are never enumerated
+  static constexpr uint32_t kMaxPhysicalDevices = VkQualityDeviceCandidates::kMaxCandidates;
+  // Queue families past this index are not checked for a graphics queue
+  static constexpr uint32_t kMaxQueueFamilies = 16;
+  // VK_QUEUE_GRAPHICS_BIT
+  static constexpr uint32_t kQueueGraphicsBit = 0x1;
+  // VK_SUCCESS and VK_INCOMPLETE
+  static constexpr int32_t kResultSuccess = 0;
+  static constexpr int32_t kResultIncomplete = 5;
+
+  // Entry points with the Vulkan two call convention, handles are passed as
+  // opaque pointers
+  struct Loader {
+    void *user_data = nullptr;
+    // vkEnumeratePhysicalDevices, returns a VkResult
+    int32_t (*enumerate_physical_devices)(void *user_data, uint32_t *device_count,
+                                          void **physical_devices) = nullptr;
+    // vkGetPhysicalDeviceQueueFamilyProperties, reduced to the queueFlags of each family
+    void (*get_queue_family_flags)(void *user_data, void *physical_device,
+                                   uint32_t *family_count, uint32_t *queue_flags) = nullptr;
+    // vkGetPhysicalDeviceProperties, copied into every candidate field but
+    // physical_device_index
+    void (*get_device_properties)(void *user_data, void *physical_device,
+                                  VkQualityDeviceCandidate &candidate) = nullptr;
+    // vkGetPhysicalDeviceFeatures2 and vkEnumerateDeviceExtensionProperties,
+    // reduced to VkQualityCapabilities bits. Returns false if the capabilities
+    // couldn't be fully read, and the device is treated as not probed. Optional
+    bool (*get_capabilities)(void *user_data, void *physical_device,
+                             uint64_t *capabilities) = nullptr;
+  };
+
+  // Adds every physical device with a graphics queue to candidates, in
+  // enumeration order. Returns false if there are none
+  static bool Probe(const Loader &loader, VkQualityDeviceCandidates &candidates);
+
+  // Copies the Vulkan fields of a candidate, the other fields are unchanged
+  static void CopyCandidate(const VkQualityDeviceCandidate &candidate, DeviceInfo &device_info);
+};
+
+} // namespace vkquality
+
+#endif // VKQUALITY_DEVICE_PROBE_H_
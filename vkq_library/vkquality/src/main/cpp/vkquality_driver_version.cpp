@@ -0,0 +1,163 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vkquality_driver_version.h"
+#include <algorithm>
+#include <string.h>
+
+namespace vkquality {
+
+namespace {
+
+bool IsDigit(const char c) {
+  return c >= '0' && c <= '9';
+}
+
+bool IsAlphanumeric(const char c) {
+  return IsDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+// Reads a decimal number that saturates at UINT32_MAX, false without any digits
+bool ParseNumber(const char *&chars, uint32_t &number) {
+  if (!IsDigit(*chars)) {
+    return false;
+  }
+  uint64_t value = 0;
+  while (IsDigit(*chars)) {
+    value = std::min<uint64_t>((value * 10) + (*chars - '0'), UINT32_MAX);
+    ++chars;
+  }
+  number = static_cast<uint32_t>(value);
+  return true;
+}
+
+// V@0615.73, the minor number is optional
+bool ParseQualcomm(const char *gles_version, uint64_t &version) {
+  const char *chars = strstr(gles_version, "V@");
+  if (chars == nullptr) {
+    return false;
+  }
+  chars += 2;
+  uint32_t major = 0;
+  uint32_t minor = 0;
+  if (!ParseNumber(chars, major)) {
+    return false;
+  }
+  if (*chars == '.') {
+    ++chars;
+    ParseNumber(chars, minor);
+  }
+  version = VkQualityDriverVersion::MakeVersion(major, minor, 0);
+  return true;
+}
+
+// r32p1 as its own token, so letters inside a hash don't match
+bool ParseArm(const char *gles_version, uint64_t &version) {
+  for (const char *token = strchr(gles_version, 'r'); token != nullptr;
+       token = strchr(token + 1, 'r')) {
+    if (token != gles_version && IsAlphanumeric(token[-1])) {
+      continue;
+    }
+    const char *chars = token + 1;
+    uint32_t major = 0;
+    uint32_t minor = 0;
+    if (!ParseNumber(chars, major) || *chars != 'p') {
+      continue;
+    }
+    ++chars;
+    if (!ParseNumber(chars, minor)) {
+      continue;
+    }
+    version = VkQualityDriverVersion::MakeVersion(major, minor, 0);
+    return true;
+  }
+  return false;
+}
+
+// build 1.13@5776728
+bool ParseImagination(const char *gles_version, uint64_t &version) {
+  const char *chars = strstr(gles_version, "build ");
+  if (chars == nullptr) {
+    return false;
+  }
+  chars += 6;
+  uint32_t major = 0;
+  uint32_t minor = 0;
+  uint32_t build = 0;
+  if (!ParseNumber(chars, major) || *chars++ != '.' || !ParseNumber(chars, minor) ||
+      *chars++ != '@' || !ParseNumber(chars, build)) {
+    return false;
+  }
+  version = VkQualityDriverVersion::MakeVersion(major, minor, build);
+  return true;
+}
+
+} // anonymous namespace
+
+uint64_t VkQualityDriverVersion::MakeVersion(const uint32_t major, const uint32_t minor,
+                                             const uint32_t build) {
+  return (static_cast<uint64_t>(std::min(major, 0xFFFFU)) << 48) |
+      (static_cast<uint64_t>(std::min(minor, 0xFFFFU)) << 32) | build;
+}
+
+uint64_t VkQualityDriverVersion::DecodeVulkanDriverVersion(const uint32_t vendor_id,
+                                                          const uint32_t driver_version) {
+  const uint32_t major = driver_version >> 22;
+  const uint32_t minor = (driver_version >> 12) & 0x3FF;
+  const uint32_t patch = driver_version & 0xFFF;
+  if (vendor_id == kVendorId_Qualcomm) {
+    return MakeVersion(minor, patch, 0);
+  } else if (vendor_id == kVendorId_Nvidia) {
+    return MakeVersion(major, (driver_version >> 14) & 0xFF, driver_version & 0x3FFF);
+  }
+  return MakeVersion(major, minor, patch);
+}
+
+uint32_t VkQualityDriverVersion::EncodeVulkanDriverVersion(const uint32_t vendor_id,
+                                                          const uint64_t version) {
+  const uint32_t major = static_cast<uint32_t>(version >> 48);
+  const uint32_t minor = static_cast<uint32_t>(version >> 32) & 0xFFFF;
+  const uint32_t build = static_cast<uint32_t>(version);
+  if (vendor_id == kVendorId_Qualcomm) {
+    return 0x80000000U | (std::min(major, 0x3FFU) << 12) | std::min(minor, 0xFFFU);
+  } else if (vendor_id == kVendorId_Nvidia) {
+    return (std::min(major, 0x3FFU) << 22) | (std::min(minor, 0xFFU) << 14) |
+        std::min(build, 0x3FFFU);
+  }
+  return (std::min(major, 0x3FFU) << 22) | (std::min(minor, 0x3FFU) << 12) |
+      std::min(build, 0xFFFU);
+}
+
+bool VkQualityDriverVersion::ParseGlesVersion(const char *gles_version,
+                                              const VersionFormat version_format,
+                                              uint64_t &version) {
+  switch (version_format) {
+    case kVersionFormat_Qualcomm:
+      return ParseQualcomm(gles_version, version);
+    case kVersionFormat_Arm:
+      return ParseArm(gles_version, version);
+    case kVersionFormat_Imagination:
+      return ParseImagination(gles_version, version);
+    // Vulkan driver versions don't come from the GL version string
+    case kVersionFormat_Vulkan:
+    case kVersionFormat_Count:
+    default:
+      break;
+  }
+  return false;
+}
+
+} // namespace vkquality
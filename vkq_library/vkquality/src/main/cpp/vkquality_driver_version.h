@@ -0,0 +1,68 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VKQUALITY_DRIVER_VERSION_H_
+#define VKQUALITY_DRIVER_VERSION_H_
+
+#include <cstdint>
+
+namespace vkquality {
+
+// Extracts the driver version from a glGetString(GL_VERSION) string, or decodes
+// a Vulkan driverVersion, as a number that orders like the vendor's releases, so
+// driver version rules can match a range of builds with integer compares
+class VkQualityDriverVersion {
+public:
+  // PCI vendor ids of the vendors with their own driverVersion layout
+  static constexpr uint32_t kVendorId_Qualcomm = 0x5143;
+  static constexpr uint32_t kVendorId_Nvidia = 0x10DE;
+
+  // Version formats of VkQualityDriverRuleEntry
+  enum VersionFormat : uint32_t {
+    // Qualcomm Adreno, "V@0615.73"
+    kVersionFormat_Qualcomm = 1,
+    // Arm Mali, "v1.r32p1-01eac0"
+    kVersionFormat_Arm = 2,
+    // Imagination PowerVR, "build 1.13@5776728"
+    kVersionFormat_Imagination = 3,
+    // VkPhysicalDeviceProperties::driverVersion, see DecodeVulkanDriverVersion
+    kVersionFormat_Vulkan = 4,
+    kVersionFormat_Count
+  };
+
+  // Major and minor components saturate at 0xFFFF
+  static uint64_t MakeVersion(const uint32_t major, const uint32_t minor, const uint32_t build);
+
+  // Returns false if the string has no version in the format. Qualcomm versions
+  // are V@major.minor, Arm versions are rMAJORpMINOR, both with a zero build.
+  static bool ParseGlesVersion(const char *gles_version, const VersionFormat version_format,
+                               uint64_t &version);
+
+  // Qualcomm sets the top bit of the VK_MAKE_VERSION major and reports the
+  // V@ version as minor.patch, which decodes to the same version as the GL
+  // string. NVIDIA packs 10.8.8.6 bits, the last two decode as the build. Every
+  // other vendor, Arm included (r32p1 is 32.1.0), uses the VK_MAKE_VERSION layout.
+  static uint64_t DecodeVulkanDriverVersion(const uint32_t vendor_id,
+                                            const uint32_t driver_version);
+
+  // The driverVersion that decodes to version, for the raw min_driver_version
+  // fields of the device and GPU lists. Components the layout can't hold saturate.
+  static uint32_t EncodeVulkanDriverVersion(const uint32_t vendor_id, const uint64_t version);
+};
+
+} // namespace vkquality
+
+#endif // VKQUALITY_DRIVER_VERSION_H_
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vkquality_evaluator.h"
+#include "vkquality_compression.h"
+#include "vkquality_paged_file.h"
+#include "vkquality_version.h"
+
+namespace vkquality {
+
+static_assert(static_cast<int32_t>(kMatchTypeNone) ==
+              static_cast<int32_t>(VkQualityPredictionFile::kFileMatch_None),
+              "vkQualityMatchType must mirror FileMatchResult");
+
+bool VkQualityEvaluator::IsOldDevice(const DeviceInfo &device_info) {
+  return (device_info.api_level < kMinimumVulkanApiLevel ||
+          device_info.vk_api_version < kMinimumVulkanVersion);
+}
+
+vkQualityRecommendation VkQualityEvaluator::GetMatchRecommendation(
+    const VkQualityPredictionFile::FileMatchResult match_result,
+    const DeviceInfo &device_info,
+    const int32_t future_android_api_level) {
+  vkQualityRecommendation recommendation;
+  switch (match_result) {
+    case VkQualityPredictionFile::kFileMatch_ExactDevice:
+    case VkQualityPredictionFile::kFileMatch_BrandWildcard:
+      recommendation = kRecommendationVulkanBecauseDeviceMatch;
+      break;
+    case VkQualityPredictionFile::kFileMatch_DeviceOldVersion:
+      recommendation = kRecommendationGLESBecauseOldDriver;
+      break;
+    case VkQualityPredictionFile::kFileMatch_DriverAllow:
+    case VkQualityPredictionFile::kFileMatch_GpuAllow:
+    case VkQualityPredictionFile::kFileMatch_DriverRuleAllow:
+    case VkQualityPredictionFile::kFileMatch_CapabilityAllow:
+      recommendation = kRecommendationVulkanBecausePredictionMatch;
+      break;
+    case VkQualityPredictionFile::kFileMatch_DriverDeny:
+    case VkQualityPredictionFile::kFileMatch_GpuDeny:
+    case VkQualityPredictionFile::kFileMatch_DriverRuleDeny:
+    case VkQualityPredictionFile::kFileMatch_CapabilityDeny:
+      recommendation = kRecommendationGLESBecausePredictionMatch;
+      break;
+    default:
+      recommendation = kRecommendationGLESBecauseNoDeviceMatch;
+  }
+
+  if (recommendation == kRecommendationGLESBecauseNoDeviceMatch &&
+      device_info.api_level >= future_android_api_level) {
+    recommendation = kRecommendationVulkanBecauseFutureAndroid;
+  }
+  return recommendation;
+}
+
+vkQualityRecommendation VkQualityEvaluator::EvaluateCandidates(
+    const VkQualityPredictionFile &prediction_file,
+    const VkQualityDeviceCandidates &candidates, const int32_t flags,
+    DeviceInfo &device_info, uint32_t &candidate_index) {
+  // A list match outranks a recommendation for future Android versions, which
+  // outranks any GLES recommendation
+  auto get_rank = [](const vkQualityRecommendation recommendation) {
+    if (recommendation == kRecommendationVulkanBecauseDeviceMatch ||
+        recommendation == kRecommendationVulkanBecausePredictionMatch) {
+      return 2;
+    }
+    return (recommendation == kRecommendationVulkanBecauseFutureAndroid) ? 1 : 0;
+  };
+
+  vkQualityRecommendation chosen_recommendation = kRecommendationErrorNotInitialized;
+  int chosen_rank = -1;
+  candidate_index = 0;
+  DeviceInfo candidate_info = device_info;
+  for (uint32_t i = 0; i < candidates.count && chosen_rank < 2; ++i) {
+    VkQualityDeviceProbe::CopyCandidate(candidates.candidates[i], candidate_info);
+    vkQualityRecommendation recommendation = kRecommendationGLESBecauseOldDevice;
+    if (candidate_info.vk_api_version >= kMinimumVulkanVersion) {
+      recommendation = GetMatchRecommendation(
+          prediction_file.FindDeviceMatch(candidate_info, flags), candidate_info,
+          prediction_file.GetFutureAndroidAPILevel());
+    }
+    const int rank = get_rank(recommendation);
+    if (rank > chosen_rank) {
+      chosen_recommendation = recommendation;
+      chosen_rank = rank;
+      candidate_index = i;
+    }
+  }
+  if (candidates.count > 0) {
+    VkQualityDeviceProbe::CopyCandidate(candidates.candidates[candidate_index], device_info);
+  }
+  return chosen_recommendation;
+}
+
+vkQualityMatchType VkQualityEvaluator::GetMatchType(
+    const VkQualityPredictionFile::FileMatchResult match_result) {
+  return static_cast<vkQualityMatchType>(match_result);
+}
+
+void VkQualityEvaluator::CopyDeviceDescription(const vkqDeviceDescription &device_description,
+                                               DeviceInfo &device_info) {
+  device_info.brand = (device_description.brand != nullptr) ? device_description.brand : "";
+  device_info.device = (device_description.device != nullptr) ? device_description.device : "";
+  device_info.soc = (device_description.soc != nullptr) ? device_description.soc : "";
+  device_info.gles_version = (device_description.gles_version != nullptr) ?
+      device_description.gles_version : "";
+  device_info.vk_device_name = (device_description.vk_device_name != nullptr) ?
+      device_description.vk_device_name : "";
+  device_info.api_level = device_description.api_level;
+  device_info.vk_api_version = device_description.vk_api_version;
+  device_info.vk_driver_version = device_description.vk_driver_version;
+  device_info.vk_device_id = device_description.vk_device_id;
+  device_info.vk_vendor_id = device_description.vk_vendor_id;
+  device_info.vk_capabilities = device_description.vk_capabilities;
+}
+
+} // namespace vkquality
+
+using namespace vkquality;
+
+extern "C" vkQualityInitResult vkQuality_evaluateDevice(
+    const vkqDeviceDescription *device_description, const void *list_data, size_t list_size,
+    int32_t flags, vkqEvaluationResult *result) {
+  if (device_description == nullptr || result == nullptr) {
+    return kErrorInitializationFailure;
+  }
+  result->recommendation = kRecommendationErrorNotInitialized;
+  result->match_type = kMatchTypeNone;
+  result->match_index = 0;
+  result->list_version = 0;
+
+  DeviceInfo device_info;
+  VkQualityEvaluator::CopyDeviceDescription(*device_description, device_info);
+  if (VkQualityEvaluator::IsOldDevice(device_info)) {
+    result->recommendation = kRecommendationGLESBecauseOldDevice;
+    return kSuccess;
+  }
+
+  if (list_data == nullptr) {
+    return kErrorInvalidDataFile;
+  }
+  // The list data is borrowed, the prediction file only reads from it and
+  // doesn't release it. A compressed container is decoded to a copy the
+  // prediction file releases.
+  void *file_data = const_cast<void *>(list_data);
+  size_t file_size = list_size;
+  VkQualityPredictionFile::FileDataRelease release_function = nullptr;
+  if (VkQualityCompression::IsCompressed(list_data, list_size)) {
+    file_data = VkQualityCompression::Decompress(list_data, list_size, file_size);
+    if (file_data == nullptr) {
+      return kErrorInvalidDataFile;
+    }
+    release_function = VkQualityPredictionFile::FreeFileData;
+  }
+  VkQualityPredictionFile prediction_file;
+  prediction_file.SetValidationMode(VkQualityPredictionFile::kValidation_Lazy);
+  const VkQualityPredictionFile::FileParseResult parse_result =
+      prediction_file.ParseFileData(file_data, file_size, VKQUALITY_PACKED_VERSION,
+                                    release_function);
+  if (parse_result != VkQualityPredictionFile::kFileParseResult_Success &&
+      release_function != nullptr) {
+    release_function(file_data, nullptr);
+  }
+  if (parse_result == VkQualityPredictionFile::kFileParseResult_Error_LibraryTooOldForFile) {
+    return kErrorInvalidDataVersion;
+  } else if (parse_result != VkQualityPredictionFile::kFileParseResult_Success) {
+    return kErrorInvalidDataFile;
+  }
+
+  uint32_t match_index = 0;
+  const VkQualityPredictionFile::FileMatchResult match_result =
+      prediction_file.FindDeviceMatch(device_info, flags, &match_index);
+  result->recommendation = VkQualityEvaluator::GetMatchRecommendation(
+      match_result, device_info, prediction_file.GetFutureAndroidAPILevel());
+  result->match_type = VkQualityEvaluator::GetMatchType(match_result);
+  result->match_index = match_index;
+  result->list_version = prediction_file.GetListVersion();
+  return kSuccess;
+}
+
+extern "C" vkQualityInitResult vkQuality_evaluateDeviceStream(
+    const vkqDeviceDescription *device_description, vkqReadCallback read_callback,
+    void *user_data, uint64_t list_size, int32_t flags, vkqEvaluationResult *result) {
+  if (device_description == nullptr || result == nullptr) {
+    return kErrorInitializationFailure;
+  }
+  result->recommendation = kRecommendationErrorNotInitialized;
+  result->match_type = kMatchTypeNone;
+  result->match_index = 0;
+  result->list_version = 0;
+
+  DeviceInfo device_info;
+  VkQualityEvaluator::CopyDeviceDescription(*device_description, device_info);
+  if (VkQualityEvaluator::IsOldDevice(device_info)) {
+    result->recommendation = kRecommendationGLESBecauseOldDevice;
+    return kSuccess;
+  }
+
+  if (read_callback == nullptr) {
+    return kErrorInvalidDataFile;
+  }
+  VkQualityPagedFile paged_file(
+      [read_callback, user_data](uint64_t offset, void *buffer, size_t size) {
+        return read_callback(user_data, offset, buffer, size);
+      },
+      list_size);
+  const VkQualityPredictionFile::FileParseResult parse_result =
+      paged_file.Open(VKQUALITY_PACKED_VERSION);
+  if (parse_result == VkQualityPredictionFile::kFileParseResult_Error_LibraryTooOldForFile) {
+    return kErrorInvalidDataVersion;
+  } else if (parse_result != VkQualityPredictionFile::kFileParseResult_Success) {
+    return kErrorInvalidDataFile;
+  }
+
+  uint32_t match_index = 0;
+  const VkQualityPredictionFile::FileMatchResult match_result =
+      paged_file.FindDeviceMatch(device_info, flags, &match_index);
+  result->recommendation = VkQualityEvaluator::GetMatchRecommendation(
+      match_result, device_info, paged_file.GetFutureAndroidAPILevel());
+  result->match_type = VkQualityEvaluator::GetMatchType(match_result);
+  result->match_index = match_index;
+  result->list_version = paged_file.GetListVersion();
+  return kSuccess;
+}
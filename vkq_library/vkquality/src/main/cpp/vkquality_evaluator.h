@@ -0,0 +1,59 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VKQUALITY_EVALUATOR_H_
+#define VKQUALITY_EVALUATOR_H_
+
+#include "vkquality_core.h"
+#include "vkquality_device_probe.h"
+#include "vkquality_prediction_file.h"
+
+namespace vkquality {
+
+class VkQualityEvaluator {
+ public:
+  // Android 10, devices running older versions of Android get a GLES recommendation
+  static constexpr int32_t kMinimumVulkanApiLevel = 29;
+  // VK_API_VERSION_1_1, devices limited to Vulkan 1.0.x get a GLES recommendation
+  static constexpr uint32_t kMinimumVulkanVersion = (1U << 22) | (1U << 12);
+
+  static bool IsOldDevice(const DeviceInfo &device_info);
+
+  static vkQualityRecommendation GetMatchRecommendation(
+      const VkQualityPredictionFile::FileMatchResult match_result,
+      const DeviceInfo &device_info,
+      const int32_t future_android_api_level);
+
+  // Evaluates each candidate with the other fields of device_info. Chooses the
+  // first candidate recommended Vulkan by a list match, else the first one
+  // recommended Vulkan, else the first candidate. device_info receives the
+  // Vulkan fields of the chosen candidate, candidate_index its index in candidates.
+  // Candidates must not be empty
+  static vkQualityRecommendation EvaluateCandidates(
+      const VkQualityPredictionFile &prediction_file,
+      const VkQualityDeviceCandidates &candidates, const int32_t flags,
+      DeviceInfo &device_info, uint32_t &candidate_index);
+
+  static vkQualityMatchType GetMatchType(
+      const VkQualityPredictionFile::FileMatchResult match_result);
+
+  static void CopyDeviceDescription(const vkqDeviceDescription &device_description,
+                                    DeviceInfo &device_info);
+};
+
+} // namespace vkquality
+
+#endif // VKQUALITY_EVALUATOR_H_
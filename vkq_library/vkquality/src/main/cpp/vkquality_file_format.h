@@ -109,7 +109,10 @@ typedef struct __attribute__((packed)) VkQualityFileHeader {
   /** @brief Offset in bytes from the beginning of the header to the start of the device list
    * shortcut data. This is a 27 entry array that specifies an index offset A-Z (+1 for
    * everything else) into the device array list for the Device.BRAND strings. This is a shortcut
-   * to reduce the search space to the first letter of a set of brands.
+   * to reduce the search space to the first letter of a set of brands. Entries must not decrease,
+   * each bucket ends at the index of the next entry. An all zero table searches the whole list.
+   * From file format 1.3.0, devices within a bucket are sorted by brand, comparing bytes with
+   * ASCII letters folded to upper case.
    */
   uint32_t device_list_shortcuts_offset;
   /** @brief Offset in bytes from the beginning of the header to the start of the gpu
@@ -161,7 +164,8 @@ typedef struct __attribute__((packed)) VkQualityDeviceAllowListEntry {
    */
   uint32_t min_api_version;
   /** @brief Minimum driver version reported by VkPhysicalDeviceProperties.driverVersion
-   * required to recommend Vulkan on this device. 0 = any driver version
+   * required to recommend Vulkan on this device. 0 = any driver version. Compared as
+   * the raw value, `VkQualityDriverVersion::EncodeVulkanDriverVersion` encodes it
    */
   uint32_t min_driver_version;
 } VkQualityDeviceAllowListEntry;
@@ -201,7 +205,8 @@ typedef struct __attribute__((packed)) VkQualityGpuPredictEntry {
    * If used in a gpu_deny_predict entry, driver numbers BELOW this number match for the
    * deny list.
    * If used in a gpu_allow_predict entry, driver numbers EQUAL OR GREATER this number
-   * match for the allow list
+   * match for the allow list. Compared as the raw value, see
+   * `VkQualityDriverVersion::EncodeVulkanDriverVersion`
    */
   uint32_t min_driver_version;
 } VkQualityGpuPredictEntry;
@@ -236,6 +241,366 @@ typedef struct __attribute__((packed)) VkQualityDriverFingerprintEntry {
   uint32_t driver_version_string_index;
 } VkQualityDriverFingerprintEntry;
 
+/**
+ * @brief A structure that describes the start of the optional section table. From
+ * file format 1.4.0 the section table immediately follows `VkQualityFileHeader`,
+ * earlier libraries skip it since every offset in the header is explicit.
+ * The table header is followed by `section_count` `VkQualityFileSectionEntry`
+ * structures. Sections with an unrecognized `section_id` are ignored. Readers
+ * may defer checking the contents of a section until it is first used, so a
+ * section must not depend on another optional section being valid.
+ */
+typedef struct __attribute__((packed)) VkQualityFileSectionTable {
+  /** @brief Identifier value for the section table, expected to be equal
+   * to the `kVkQuality_Section_Table_Identifier` constant.
+   */
+  uint32_t section_table_identifier;
+  /** @brief The number of section entries following this structure
+   */
+  uint32_t section_count;
+} VkQualityFileSectionTable;
+
+/**
+ * @brief A structure that describes the location of an optional file section
+ */
+typedef struct __attribute__((packed)) VkQualityFileSectionEntry {
+  /** @brief Type of the section, a `VkQualityPredictionFile::FileSectionId` value
+   */
+  uint32_t section_id;
+  /** @brief Offset in bytes from the beginning of the header to the start of the section
+   */
+  uint32_t section_offset;
+  /** @brief Size of the section in bytes
+   */
+  uint32_t section_size;
+  /** @brief Reserved, must be 0
+   */
+  uint32_t section_flags;
+} VkQualityFileSectionEntry;
+
+/**
+ * @brief A structure that describes the start of the brand index section. The brand
+ * index is a directory of the distinct Build.BRAND strings of the device list, with
+ * a range of a secondary device index array for each brand. The header is followed by
+ * `brand_count` `VkQualityBrandIndexEntry` structures sorted by brand string
+ * (byte order, case sensitive), then `device_index_count` 32-bit indices into the
+ * device list. Within the range of a brand, the indices are sorted by Build.DEVICE
+ * string (byte order, case sensitive) and then by device list index.
+ */
+typedef struct __attribute__((packed)) VkQualityBrandIndexHeader {
+  /** @brief The number of brand entries in the brand index
+   */
+  uint32_t brand_count;
+  /** @brief The number of device list indices following the brand entries
+   */
+  uint32_t device_index_count;
+} VkQualityBrandIndexHeader;
+
+/**
+ * @brief A structure that describes the devices of one brand in the brand index
+ */
+typedef struct __attribute__((packed)) VkQualityBrandIndexEntry {
+  /** @brief Index into the string table of the Build.BRAND string of this entry
+   */
+  uint32_t brand_string_index;
+  /** @brief Index into the device index array of the first device of this brand
+   */
+  uint32_t device_index_start;
+  /** @brief Count of the device index array entries for this brand
+   */
+  uint32_t device_index_count;
+} VkQualityBrandIndexEntry;
+
+/**
+ * @brief A structure that describes the start of the brand alias section. From file
+ * format 1.5.0, Build.BRAND strings of the device list and the brand index are brand
+ * keys: ASCII whitespace trimmed from both ends and ASCII letters folded to lower case.
+ * A device brand is converted to a brand key before it is searched, and if the key is
+ * an alias, replaced by the brand of the alias. The header is followed by
+ * `alias_count` `VkQualityBrandAliasEntry` structures sorted by alias string (byte
+ * order). Aliases aren't chained, the brand of an alias is never itself an alias.
+ */
+typedef struct __attribute__((packed)) VkQualityBrandAliasHeader {
+  /** @brief The number of alias entries
+   */
+  uint32_t alias_count;
+  /** @brief Reserved, must be 0
+   */
+  uint32_t reserved;
+} VkQualityBrandAliasHeader;
+
+/**
+ * @brief A structure that maps one OEM variant of a brand to its canonical brand
+ */
+typedef struct __attribute__((packed)) VkQualityBrandAliasEntry {
+  /** @brief Index into the string table of the alias brand key
+   */
+  uint32_t alias_string_index;
+  /** @brief Index into the string table of the brand key the alias is searched as,
+   * must not be the null string
+   */
+  uint32_t brand_string_index;
+} VkQualityBrandAliasEntry;
+
+/**
+ * @brief A structure that describes the start of a driver version rule section. A
+ * rule matches a Build.SOC and a range of driver versions parsed from the
+ * glFullVersion string, so one rule can stand in for the fingerprints of many driver
+ * builds. Rules on the Vulkan driverVersion can match by vendor id alone, as
+ * Build.SOC is only available from Android API level 31. Rules are searched after
+ * the driver fingerprint lists, allow rules before deny rules, and the first matching
+ * rule in section order is used. The header is followed by `rule_count`
+ * `VkQualityDriverRuleEntry` structures.
+ */
+typedef struct __attribute__((packed)) VkQualityDriverRulesHeader {
+  /** @brief The number of rule entries
+   */
+  uint32_t rule_count;
+  /** @brief Reserved, must be 0
+   */
+  uint32_t reserved;
+} VkQualityDriverRulesHeader;
+
+/**
+ * @brief A structure that describes one driver version rule
+ */
+typedef struct __attribute__((packed)) VkQualityDriverRuleEntry {
+  /** @brief Index into the string table of the Build.SOC string of this rule,
+   * compared ignoring case like the SoC lists. May only be the null string for a
+   * `kVersionFormat_Vulkan` rule with a `vendor_id`, which then matches any SoC
+   */
+  uint32_t soc_string_index;
+  /** @brief How the driver version is parsed from glFullVersion, or decoded from
+   * the Vulkan driverVersion by vendor id, a `VkQualityDriverVersion::VersionFormat`
+   * value. Rules with a format the library doesn't know never match
+   */
+  uint32_t version_format;
+  /** @brief Lowest matching driver version, see `VkQualityDriverVersion::MakeVersion`.
+   * 0 = no lower bound
+   */
+  uint64_t min_driver_version;
+  /** @brief Highest matching driver version. 0 = no upper bound
+   */
+  uint64_t max_driver_version;
+  /** @brief `VkPhysicalDeviceProperties.vendorID` the rule is limited to. 0 = any vendor
+   */
+  uint32_t vendor_id;
+  /** @brief Reserved, must be 0
+   */
+  uint32_t reserved;
+} VkQualityDriverRuleEntry;
+
+/**
+ * @brief A structure that describes the start of a capability rule section. A rule
+ * matches the Vulkan features and device extensions of the probed physical device,
+ * as a `VkQualityCapabilities` bit set, so a renderer that depends on a capability
+ * can be steered away from devices without it. Deny rules are searched before any
+ * other list, allow rules after the GPU predict lists, and the first matching rule
+ * in section order is used. Devices whose capabilities weren't probed never match.
+ * The header is followed by `rule_count` `VkQualityCapabilityRuleEntry` structures.
+ */
+typedef struct __attribute__((packed)) VkQualityCapabilityRulesHeader {
+  /** @brief The number of rule entries
+   */
+  uint32_t rule_count;
+  /** @brief Reserved, must be 0
+   */
+  uint32_t reserved;
+} VkQualityCapabilityRulesHeader;
+
+/**
+ * @brief A structure that describes one capability rule
+ */
+typedef struct __attribute__((packed)) VkQualityCapabilityRuleEntry {
+  /** @brief Capability bits the device must have
+   */
+  uint64_t required_capabilities;
+  /** @brief Capability bits the device must not have, disjoint from
+   * `required_capabilities`. Rules with bits the library doesn't know never match
+   */
+  uint64_t forbidden_capabilities;
+  /** @brief `VkPhysicalDeviceProperties.vendorID` of the devices the rule applies
+   * to, 0 = every vendor
+   */
+  uint32_t vendor_id;
+  /** @brief Reserved, must be 0
+   */
+  uint32_t reserved;
+} VkQualityCapabilityRuleEntry;
+
+/**
+ * @brief A structure that describes the start of a GPU predict column section. The
+ * section holds the same entries as the matching `VkQualityGpuPredictEntry` list, as
+ * struct-of-arrays columns so ID and version filters can be scanned as vectors before
+ * any strings are compared. The header is followed by five `column_stride` entry
+ * arrays of 32-bit values, in order: device_name_string_index, min_api_version,
+ * device_id, vendor_id and min_driver_version. The section offset must be a multiple
+ * of 16 bytes, keeping every column 16 byte aligned. Padding entries past
+ * `entry_count` are ignored.
+ */
+typedef struct __attribute__((packed)) VkQualityGpuColumnsHeader {
+  /** @brief The number of entries, equal to the count of the matching GPU predict list
+   */
+  uint32_t entry_count;
+  /** @brief The number of entries in each column, `entry_count` rounded up to a
+   * multiple of 4
+   */
+  uint32_t column_stride;
+  /** @brief Reserved, must be 0. Pads the header to 16 bytes
+   */
+  uint32_t reserved[2];
+} VkQualityGpuColumnsHeader;
+
+/**
+ * @brief A structure that describes the start of the device shard section. A file
+ * with this section is a root file, the device list rows of some brand shortcut
+ * buckets are moved to separate shard files that are only loaded when a device of
+ * that bucket is searched. A shard is a complete data file with the same
+ * `list_version` as the root file, the root file keeps the driver and GPU lists.
+ * The header is followed by `shard_count` `VkQualityDeviceShardEntry` structures
+ * sorted by `shortcut_index`.
+ */
+typedef struct __attribute__((packed)) VkQualityDeviceShardsHeader {
+  /** @brief The number of shard entries
+   */
+  uint32_t shard_count;
+  /** @brief Reserved, must be 0
+   */
+  uint32_t reserved;
+} VkQualityDeviceShardsHeader;
+
+/**
+ * @brief A structure that names the shard file of one brand shortcut bucket
+ */
+typedef struct __attribute__((packed)) VkQualityDeviceShardEntry {
+  /** @brief Brand shortcut bucket of the shard, see `device_list_shortcuts_offset`
+   */
+  uint32_t shortcut_index;
+  /** @brief Index into the string table of the shard file name, relative to the
+   * location of the root file
+   */
+  uint32_t shard_name_string_index;
+} VkQualityDeviceShardEntry;
+
+/**
+ * @brief A structure that holds the content checksum of a data file, the contents
+ * of the `kFileSection_Checksum` section
+ *
+ * The checksum covers every byte of the file, with the `checksum` field itself
+ * read as zero, so it is checked before any other section is trusted. Readers
+ * skip verification for an unrecognized `algorithm`.
+ */
+typedef struct __attribute__((packed)) VkQualityChecksumSection {
+  /** @brief Checksum algorithm, `kChecksum_Crc32c`
+   */
+  uint32_t algorithm;
+  /** @brief Checksum of the file
+   */
+  uint32_t checksum;
+  /** @brief Size in bytes of the file the checksum covers
+   */
+  uint32_t file_size;
+  /** @brief Reserved, must be 0
+   */
+  uint32_t reserved;
+} VkQualityChecksumSection;
+
+/**
+ * @brief A structure that describes the start of a compressed container file. The
+ * container holds a complete data file: this header is followed by the uncompressed
+ * `VkQualityFileHeader` of the data file, so a loader can check the list version and
+ * compatibility without decoding, and then by blocks covering the rest of the data
+ * file in order. Each block is a `VkQualityCompressedBlockHeader` followed by
+ * `compressed_size` bytes of LZ4 block format sequences. A match may refer back into
+ * earlier blocks, up to 65535 bytes before the match.
+ */
+typedef struct __attribute__((packed)) VkQualityCompressedFileHeader {
+  /** @brief Identifier value for the container, expected to be equal
+   * to the `kCompressed_File_Identifier` constant.
+   */
+  uint32_t file_identifier;
+  /** @brief Version of the container layout, currently 1
+   */
+  uint32_t container_version;
+  /** @brief Size in bytes of the decoded data file, including its header
+   */
+  uint32_t uncompressed_size;
+  /** @brief The largest `uncompressed_size` of any block
+   */
+  uint32_t block_size;
+} VkQualityCompressedFileHeader;
+
+/**
+ * @brief A structure that describes one block of a compressed container
+ */
+typedef struct __attribute__((packed)) VkQualityCompressedBlockHeader {
+  /** @brief Size in bytes of the block data following this header
+   */
+  uint32_t compressed_size;
+  /** @brief Size in bytes of the block data once decoded
+   */
+  uint32_t uncompressed_size;
+} VkQualityCompressedBlockHeader;
+
+/**
+ * @brief A structure that describes the header of a list patch file
+ *
+ * A patch rebuilds a target data file from a base data file. The header is
+ * followed by `op_count` operations, each a `VkQualityPatchOp`. Copy operations
+ * append a range of the base file to the target file, insert operations append
+ * the `length` bytes that follow the operation in the patch file. The base
+ * and target are the files as stored, a patch can produce or consume a
+ * compressed container.
+ */
+typedef struct __attribute__((packed)) VkQualityPatchHeader {
+  /** @brief Identifier value for the patch, expected to be equal
+   * to the `kPatch_File_Identifier` constant.
+   */
+  uint32_t patch_identifier;
+  /** @brief Version of the patch layout, currently 1
+   */
+  uint32_t patch_version;
+  /** @brief Number of operations following the header
+   */
+  uint32_t op_count;
+  /** @brief Reserved, must be zero
+   */
+  uint32_t reserved;
+  /** @brief The `list_version` of the file the patch applies to
+   */
+  uint32_t base_list_version;
+  /** @brief Size in bytes of the file the patch applies to
+   */
+  uint32_t base_size;
+  /** @brief CRC-32C of the file the patch applies to
+   */
+  uint32_t base_crc32c;
+  /** @brief The `list_version` of the file the patch produces
+   */
+  uint32_t target_list_version;
+  /** @brief Size in bytes of the file the patch produces
+   */
+  uint32_t target_size;
+  /** @brief CRC-32C of the file the patch produces
+   */
+  uint32_t target_crc32c;
+} VkQualityPatchHeader;
+
+/**
+ * @brief A structure that describes one operation of a list patch file
+ */
+typedef struct __attribute__((packed)) VkQualityPatchOp {
+  /** @brief `kPatchOp_Copy` or `kPatchOp_Insert`
+   */
+  uint32_t op_type;
+  /** @brief Offset in the base file of the copied range, zero for an insert
+   */
+  uint32_t base_offset;
+  /** @brief Size in bytes appended to the target file
+   */
+  uint32_t length;
+} VkQualityPatchOp;
+
 } // namespace vkquality
 
 #endif // VKQUALITY_FILE_FORMAT_H_
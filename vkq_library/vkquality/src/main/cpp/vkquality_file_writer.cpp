@@ -0,0 +1,722 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vkquality_file_writer.h"
+#include "vkquality_checksum.h"
+#include "vkquality_compression.h"
+#include "vkquality_patch.h"
+#include "vkquality_prediction_file.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <strings.h>
+
+namespace vkquality {
+
+namespace {
+
+uint32_t GetBrandShortcutIndex(const std::string &brand) {
+  return VkQualityPredictionFile::GetBrandShortcutIndex(brand.c_str());
+}
+
+// Aliases whose brand is itself an alias are dropped, aliases aren't chained
+std::map<std::string, std::string> GetUnchainedAliases(
+    const std::map<std::string, std::string> &brand_aliases) {
+  std::map<std::string, std::string> unchained_aliases;
+  for (const auto &brand_alias : brand_aliases) {
+    if (brand_aliases.count(brand_alias.second) == 0) {
+      unchained_aliases.insert(brand_alias);
+    }
+  }
+  return unchained_aliases;
+}
+
+// Brand as the reader searches it, see VkQualityPredictionFile::GetKeyedDeviceInfo
+std::string GetSearchedBrand(const std::string &brand,
+                             const std::map<std::string, std::string> &brand_aliases) {
+  const std::string brand_key = VkQualityPredictionFile::GetBrandKey(brand);
+  const auto brand_alias = brand_aliases.find(brand_key);
+  return (brand_alias == brand_aliases.end()) ? brand_key : brand_alias->second;
+}
+
+// Devices with searched brands, without the rows that are repeated once
+// their brands are keyed
+std::vector<VkQualityFileWriter::DeviceEntry> GetKeyedDevices(
+    const std::vector<VkQualityFileWriter::DeviceEntry> &devices,
+    const std::map<std::string, std::string> &brand_aliases) {
+  std::vector<VkQualityFileWriter::DeviceEntry> keyed_devices;
+  std::set<std::tuple<std::string, std::string, uint32_t, uint32_t>> written_rows;
+  keyed_devices.reserve(devices.size());
+  for (const auto &device : devices) {
+    VkQualityFileWriter::DeviceEntry keyed_device = device;
+    keyed_device.brand = GetSearchedBrand(device.brand, brand_aliases);
+    if (written_rows.emplace(keyed_device.brand, keyed_device.device,
+                             keyed_device.min_api_version,
+                             keyed_device.min_driver_version).second) {
+      keyed_devices.push_back(std::move(keyed_device));
+    }
+  }
+  return keyed_devices;
+}
+
+class StringTableBuilder {
+ public:
+  void AddString(const std::string &str) {
+    // Empty strings use the null string at index 0
+    if (!str.empty()) {
+      strings_.emplace(str, 0);
+    }
+  }
+
+  // Strings are stored sorted, indices are assigned once all strings are added
+  void AssignIndices() {
+    uint32_t index = 1;
+    for (auto &string_entry : strings_) {
+      string_entry.second = index++;
+    }
+  }
+
+  uint32_t GetIndex(const std::string &str) const {
+    if (str.empty()) {
+      return 0;
+    }
+    return strings_.at(str);
+  }
+
+  uint32_t GetCount() const { return static_cast<uint32_t>(strings_.size() + 1); }
+
+  void Write(std::vector<uint8_t> &buffer) const {
+    const size_t offset_table_start = buffer.size();
+    buffer.resize(offset_table_start + GetCount() * sizeof(uint32_t));
+    uint32_t offset_index = 0;
+    auto write_string = [&](const std::string &str) {
+      const uint32_t string_offset = static_cast<uint32_t>(buffer.size());
+      memcpy(buffer.data() + offset_table_start + (offset_index++ * sizeof(uint32_t)),
+             &string_offset, sizeof(string_offset));
+      buffer.insert(buffer.end(), str.begin(), str.end());
+      buffer.push_back(0);
+    };
+    write_string(std::string());
+    for (const auto &string_entry : strings_) {
+      write_string(string_entry.first);
+    }
+  }
+
+ private:
+  std::map<std::string, uint32_t> strings_;
+};
+
+struct DriverTable {
+  std::vector<VkQualityDriverSoCEntry> soc_entries;
+  std::vector<VkQualityDriverFingerprintEntry> fingerprint_entries;
+};
+
+template<typename T>
+uint32_t AppendTable(std::vector<uint8_t> &buffer, const std::vector<T> &table) {
+  if (table.empty()) {
+    return 0;
+  }
+  const uint32_t table_offset = static_cast<uint32_t>(buffer.size());
+  const uint8_t *table_bytes = reinterpret_cast<const uint8_t *>(table.data());
+  buffer.insert(buffer.end(), table_bytes, table_bytes + (table.size() * sizeof(T)));
+  return table_offset;
+}
+
+DriverTable BuildDriverTable(const std::vector<VkQualityFileWriter::DriverEntry> &entries,
+                             const StringTableBuilder &string_table) {
+  std::map<std::string, std::vector<std::string>> soc_fingerprints;
+  for (const auto &entry : entries) {
+    soc_fingerprints[entry.soc].push_back(entry.fingerprint);
+  }
+
+  DriverTable driver_table;
+  for (auto &soc_entry : soc_fingerprints) {
+    std::sort(soc_entry.second.begin(), soc_entry.second.end());
+    driver_table.soc_entries.push_back({
+        static_cast<uint32_t>(soc_entry.second.size()),
+        static_cast<uint32_t>(driver_table.fingerprint_entries.size()),
+        string_table.GetIndex(soc_entry.first)});
+    for (const auto &fingerprint : soc_entry.second) {
+      driver_table.fingerprint_entries.push_back({string_table.GetIndex(fingerprint)});
+    }
+  }
+  return driver_table;
+}
+
+std::vector<VkQualityGpuPredictEntry> BuildGpuTable(
+    const std::vector<VkQualityFileWriter::GpuEntry> &entries,
+    const StringTableBuilder &string_table) {
+  std::vector<VkQualityGpuPredictEntry> gpu_table;
+  gpu_table.reserve(entries.size());
+  for (const auto &entry : entries) {
+    gpu_table.push_back({string_table.GetIndex(entry.device_name), entry.min_api_version,
+                         entry.device_id, entry.vendor_id, entry.min_driver_version});
+  }
+  return gpu_table;
+}
+
+// Brands in byte order, and per brand the device list indices in device
+// string byte order, as searched by VkQualityPredictionFile::SearchBrandIndex
+std::vector<uint8_t> BuildBrandIndex(const std::vector<VkQualityFileWriter::DeviceEntry> &devices,
+                                     const StringTableBuilder &string_table) {
+  std::map<std::string, std::vector<uint32_t>> brand_devices;
+  for (uint32_t i = 0; i < devices.size(); ++i) {
+    brand_devices[devices[i].brand].push_back(i);
+  }
+
+  std::vector<VkQualityBrandIndexEntry> brand_entries;
+  std::vector<uint32_t> device_indices;
+  for (auto &brand_entry : brand_devices) {
+    std::stable_sort(brand_entry.second.begin(), brand_entry.second.end(),
+                     [&devices](const uint32_t a, const uint32_t b) {
+      return devices[a].device < devices[b].device;
+    });
+    brand_entries.push_back({string_table.GetIndex(brand_entry.first),
+                             static_cast<uint32_t>(device_indices.size()),
+                             static_cast<uint32_t>(brand_entry.second.size())});
+    device_indices.insert(device_indices.end(), brand_entry.second.begin(),
+                          brand_entry.second.end());
+  }
+
+  std::vector<uint8_t> section;
+  const VkQualityBrandIndexHeader index_header{static_cast<uint32_t>(brand_entries.size()),
+                                               static_cast<uint32_t>(device_indices.size())};
+  const uint8_t *header_bytes = reinterpret_cast<const uint8_t *>(&index_header);
+  section.insert(section.end(), header_bytes, header_bytes + sizeof(index_header));
+  AppendTable(section, brand_entries);
+  AppendTable(section, device_indices);
+  return section;
+}
+
+// Struct-of-arrays copy of a GPU predict table, see VkQualityGpuColumnsHeader
+std::vector<uint8_t> BuildGpuColumns(const std::vector<VkQualityGpuPredictEntry> &gpu_table) {
+  const uint32_t entry_count = static_cast<uint32_t>(gpu_table.size());
+  const uint32_t column_stride = (entry_count + 3) & ~3U;
+  std::vector<uint32_t> columns(column_stride * 5, 0);
+  for (uint32_t i = 0; i < entry_count; ++i) {
+    columns[i] = gpu_table[i].device_name_string_index;
+    columns[column_stride + i] = gpu_table[i].min_api_version;
+    columns[(column_stride * 2) + i] = gpu_table[i].device_id;
+    columns[(column_stride * 3) + i] = gpu_table[i].vendor_id;
+    columns[(column_stride * 4) + i] = gpu_table[i].min_driver_version;
+  }
+
+  std::vector<uint8_t> section;
+  const VkQualityGpuColumnsHeader columns_header{entry_count, column_stride, {0, 0}};
+  const uint8_t *header_bytes = reinterpret_cast<const uint8_t *>(&columns_header);
+  section.insert(section.end(), header_bytes, header_bytes + sizeof(columns_header));
+  AppendTable(section, columns);
+  return section;
+}
+
+// Sorted by alias string in byte order, as searched by
+// VkQualityPredictionFile::ResolveBrandAlias
+std::vector<uint8_t> BuildBrandAliases(const std::map<std::string, std::string> &brand_aliases,
+                                       const StringTableBuilder &string_table) {
+  std::vector<VkQualityBrandAliasEntry> alias_entries;
+  for (const auto &brand_alias : brand_aliases) {
+    alias_entries.push_back({string_table.GetIndex(brand_alias.first),
+                             string_table.GetIndex(brand_alias.second)});
+  }
+
+  std::vector<uint8_t> section;
+  const VkQualityBrandAliasHeader aliases_header{
+      static_cast<uint32_t>(alias_entries.size()), 0};
+  const uint8_t *header_bytes = reinterpret_cast<const uint8_t *>(&aliases_header);
+  section.insert(section.end(), header_bytes, header_bytes + sizeof(aliases_header));
+  AppendTable(section, alias_entries);
+  return section;
+}
+
+std::vector<uint8_t> BuildDriverRules(
+    const std::vector<VkQualityFileWriter::DriverRuleEntry> &driver_rules,
+    const StringTableBuilder &string_table) {
+  std::vector<VkQualityDriverRuleEntry> rule_entries;
+  for (const auto &rule : driver_rules) {
+    rule_entries.push_back({string_table.GetIndex(rule.soc), rule.version_format,
+                            rule.min_driver_version, rule.max_driver_version, rule.vendor_id,
+                            0});
+  }
+
+  std::vector<uint8_t> section;
+  const VkQualityDriverRulesHeader rules_header{static_cast<uint32_t>(rule_entries.size()), 0};
+  const uint8_t *header_bytes = reinterpret_cast<const uint8_t *>(&rules_header);
+  section.insert(section.end(), header_bytes, header_bytes + sizeof(rules_header));
+  AppendTable(section, rule_entries);
+  return section;
+}
+
+std::vector<uint8_t> BuildCapabilityRules(
+    const std::vector<VkQualityFileWriter::CapabilityRuleEntry> &capability_rules) {
+  std::vector<VkQualityCapabilityRuleEntry> rule_entries;
+  for (const auto &rule : capability_rules) {
+    rule_entries.push_back({rule.required_capabilities, rule.forbidden_capabilities,
+                            rule.vendor_id, 0});
+  }
+
+  std::vector<uint8_t> section;
+  const VkQualityCapabilityRulesHeader rules_header{
+      static_cast<uint32_t>(rule_entries.size()), 0};
+  const uint8_t *header_bytes = reinterpret_cast<const uint8_t *>(&rules_header);
+  section.insert(section.end(), header_bytes, header_bytes + sizeof(rules_header));
+  AppendTable(section, rule_entries);
+  return section;
+}
+
+std::vector<uint8_t> BuildDeviceShards(
+    const std::vector<std::pair<uint32_t, std::string>> &device_shards,
+    const StringTableBuilder &string_table) {
+  std::vector<VkQualityDeviceShardEntry> shard_entries;
+  for (const auto &device_shard : device_shards) {
+    shard_entries.push_back({device_shard.first, string_table.GetIndex(device_shard.second)});
+  }
+
+  std::vector<uint8_t> section;
+  const VkQualityDeviceShardsHeader shards_header{
+      static_cast<uint32_t>(shard_entries.size()), 0};
+  const uint8_t *header_bytes = reinterpret_cast<const uint8_t *>(&shards_header);
+  section.insert(section.end(), header_bytes, header_bytes + sizeof(shards_header));
+  AppendTable(section, shard_entries);
+  return section;
+}
+
+// LZ4 block format encoder, greedy matching on a hash of 4 byte sequences
+class BlockEncoder {
+ public:
+  explicit BlockEncoder(const std::vector<uint8_t> &data)
+      : data_(data), hash_table_(kHashTableSize, -1) {
+  }
+
+  // Matches can refer back into earlier blocks, the decoder keeps the whole file
+  void EncodeBlock(const size_t block_start, const size_t block_end,
+                   std::vector<uint8_t> &output) {
+    size_t anchor = block_start;
+    size_t position = block_start;
+    // The format requires the last match to start 12 bytes before the end of
+    // the block and the last 5 bytes to be literals
+    const size_t match_limit = (block_end - block_start > kLastMatchDistance) ?
+        block_end - kLastMatchDistance : block_start;
+    while (position < match_limit) {
+      const uint32_t sequence = Read32(position);
+      const uint32_t hash = (sequence * 2654435761U) >> (32 - kHashBits);
+      const int64_t candidate = hash_table_[hash];
+      hash_table_[hash] = static_cast<int64_t>(position);
+      if (candidate < 0 || position - candidate > kMaxOffset ||
+          Read32(static_cast<size_t>(candidate)) != sequence) {
+        ++position;
+        continue;
+      }
+      size_t match_length = kMinMatch;
+      while (position + match_length < block_end - kLastLiterals &&
+             data_[candidate + match_length] == data_[position + match_length]) {
+        ++match_length;
+      }
+      WriteSequence(anchor, position - anchor, position - candidate, match_length, output);
+      position += match_length;
+      anchor = position;
+    }
+    WriteSequence(anchor, block_end - anchor, 0, 0, output);
+  }
+
+ private:
+  static constexpr uint32_t kHashBits = 16;
+  static constexpr size_t kHashTableSize = 1 << kHashBits;
+  static constexpr size_t kMaxOffset = 65535;
+  static constexpr size_t kMinMatch = 4;
+  static constexpr size_t kLastLiterals = 5;
+  static constexpr size_t kLastMatchDistance = 12;
+
+  uint32_t Read32(const size_t position) const {
+    uint32_t value;
+    memcpy(&value, data_.data() + position, sizeof(value));
+    return value;
+  }
+
+  static void WriteLength(size_t length, std::vector<uint8_t> &output) {
+    while (length >= 255) {
+      output.push_back(255);
+      length -= 255;
+    }
+    output.push_back(static_cast<uint8_t>(length));
+  }
+
+  // A match_length of 0 writes the final literals only sequence
+  void WriteSequence(const size_t literal_start, const size_t literal_length,
+                     const size_t match_offset, const size_t match_length,
+                     std::vector<uint8_t> &output) const {
+    const size_t match_code = (match_length > 0) ? match_length - kMinMatch : 0;
+    output.push_back(static_cast<uint8_t>((std::min<size_t>(literal_length, 15) << 4) |
+                                          std::min<size_t>(match_code, 15)));
+    if (literal_length >= 15) {
+      WriteLength(literal_length - 15, output);
+    }
+    output.insert(output.end(), data_.begin() + literal_start,
+                  data_.begin() + literal_start + literal_length);
+    if (match_length == 0) {
+      return;
+    }
+    output.push_back(static_cast<uint8_t>(match_offset & 0xFF));
+    output.push_back(static_cast<uint8_t>(match_offset >> 8));
+    if (match_code >= 15) {
+      WriteLength(match_code - 15, output);
+    }
+  }
+
+  const std::vector<uint8_t> &data_;
+  std::vector<int64_t> hash_table_;
+};
+
+} // anonymous namespace
+
+VkQualityFileWriter::VkQualityFileWriter(const uint32_t list_version,
+                                         const int32_t min_future_vulkan_recommendation_api)
+    : list_version_(list_version)
+    , min_future_vulkan_recommendation_api_(min_future_vulkan_recommendation_api) {
+}
+
+void VkQualityFileWriter::AddBrandAlias(const std::string &alias, const std::string &brand) {
+  std::string alias_key = VkQualityPredictionFile::GetBrandKey(alias);
+  std::string brand_key = VkQualityPredictionFile::GetBrandKey(brand);
+  if (!alias_key.empty() && !brand_key.empty() && alias_key != brand_key) {
+    brand_aliases_.emplace(std::move(alias_key), std::move(brand_key));
+  }
+}
+
+std::vector<uint8_t> VkQualityFileWriter::Write() const {
+  const std::map<std::string, std::string> brand_aliases = GetUnchainedAliases(brand_aliases_);
+  const std::vector<DeviceEntry> keyed_devices = GetKeyedDevices(devices_, brand_aliases);
+  StringTableBuilder string_table;
+  for (const auto &device : keyed_devices) {
+    string_table.AddString(device.brand);
+    string_table.AddString(device.device);
+  }
+  for (const auto &brand_alias : brand_aliases) {
+    string_table.AddString(brand_alias.first);
+    string_table.AddString(brand_alias.second);
+  }
+  for (const auto *gpu_list : {&gpu_allow_, &gpu_deny_}) {
+    for (const auto &gpu : *gpu_list) {
+      string_table.AddString(gpu.device_name);
+    }
+  }
+  for (const auto *driver_list : {&driver_allow_, &driver_deny_}) {
+    for (const auto &driver : *driver_list) {
+      string_table.AddString(driver.soc);
+      string_table.AddString(driver.fingerprint);
+    }
+  }
+  for (const auto *rule_list : {&driver_allow_rules_, &driver_deny_rules_}) {
+    for (const auto &rule : *rule_list) {
+      string_table.AddString(rule.soc);
+    }
+  }
+  for (const auto &device_shard : device_shards_) {
+    string_table.AddString(device_shard.second);
+  }
+  string_table.AssignIndices();
+
+  // Sort devices by brand shortcut bucket first, so each shortcut table entry
+  // is the start index of its bucket, then in the brand order the device
+  // search uses to stop early
+  std::vector<DeviceEntry> sorted_devices = keyed_devices;
+  std::stable_sort(sorted_devices.begin(), sorted_devices.end(),
+                   [](const DeviceEntry &a, const DeviceEntry &b) {
+    const uint32_t a_shortcut = GetBrandShortcutIndex(a.brand);
+    const uint32_t b_shortcut = GetBrandShortcutIndex(b.brand);
+    if (a_shortcut != b_shortcut) {
+      return a_shortcut < b_shortcut;
+    }
+    const int brand_compare = VkQualityPredictionFile::CompareBrandOrder(a.brand.c_str(),
+                                                                         b.brand.c_str());
+    if (brand_compare != 0) {
+      return brand_compare < 0;
+    }
+    return strcasecmp(a.device.c_str(), b.device.c_str()) < 0;
+  });
+
+  std::vector<VkQualityDeviceAllowListEntry> device_table;
+  std::vector<uint32_t> shortcut_table(VkQualityPredictionFile::kShortcut_Offset_Count, 0);
+  device_table.reserve(sorted_devices.size());
+  uint32_t next_shortcut = 0;
+  for (const auto &device : sorted_devices) {
+    const uint32_t device_shortcut = GetBrandShortcutIndex(device.brand);
+    while (next_shortcut <= device_shortcut) {
+      shortcut_table[next_shortcut++] = static_cast<uint32_t>(device_table.size());
+    }
+    device_table.push_back({string_table.GetIndex(device.brand),
+                            string_table.GetIndex(device.device),
+                            device.min_api_version, device.min_driver_version});
+  }
+  while (next_shortcut < shortcut_table.size()) {
+    shortcut_table[next_shortcut++] = static_cast<uint32_t>(device_table.size());
+  }
+
+  const std::vector<VkQualityGpuPredictEntry> gpu_allow_table =
+      BuildGpuTable(gpu_allow_, string_table);
+  const std::vector<VkQualityGpuPredictEntry> gpu_deny_table =
+      BuildGpuTable(gpu_deny_, string_table);
+  const DriverTable driver_allow_table = BuildDriverTable(driver_allow_, string_table);
+  const DriverTable driver_deny_table = BuildDriverTable(driver_deny_, string_table);
+
+  const std::vector<uint8_t> brand_index = BuildBrandIndex(sorted_devices, string_table);
+
+  // Header tables in the same order as the list editor exporter, the section
+  // table immediately follows the header and the optional sections follow the
+  // device shortcuts
+  std::vector<std::pair<uint32_t, std::vector<uint8_t>>> section_data;
+  section_data.emplace_back(VkQualityPredictionFile::kFileSection_BrandIndex, brand_index);
+  if (!brand_aliases.empty()) {
+    section_data.emplace_back(VkQualityPredictionFile::kFileSection_BrandAliases,
+                              BuildBrandAliases(brand_aliases, string_table));
+  }
+  if (!gpu_allow_table.empty()) {
+    section_data.emplace_back(VkQualityPredictionFile::kFileSection_GpuAllowColumns,
+                              BuildGpuColumns(gpu_allow_table));
+  }
+  if (!gpu_deny_table.empty()) {
+    section_data.emplace_back(VkQualityPredictionFile::kFileSection_GpuDenyColumns,
+                              BuildGpuColumns(gpu_deny_table));
+  }
+  if (!driver_allow_rules_.empty()) {
+    section_data.emplace_back(VkQualityPredictionFile::kFileSection_DriverAllowRules,
+                              BuildDriverRules(driver_allow_rules_, string_table));
+  }
+  if (!driver_deny_rules_.empty()) {
+    section_data.emplace_back(VkQualityPredictionFile::kFileSection_DriverDenyRules,
+                              BuildDriverRules(driver_deny_rules_, string_table));
+  }
+  if (!capability_allow_rules_.empty()) {
+    section_data.emplace_back(VkQualityPredictionFile::kFileSection_CapabilityAllowRules,
+                              BuildCapabilityRules(capability_allow_rules_));
+  }
+  if (!capability_deny_rules_.empty()) {
+    section_data.emplace_back(VkQualityPredictionFile::kFileSection_CapabilityDenyRules,
+                              BuildCapabilityRules(capability_deny_rules_));
+  }
+  if (!device_shards_.empty()) {
+    section_data.emplace_back(VkQualityPredictionFile::kFileSection_DeviceShards,
+                              BuildDeviceShards(device_shards_, string_table));
+  }
+  // Filled in once the rest of the file is laid out
+  section_data.emplace_back(VkQualityPredictionFile::kFileSection_Checksum,
+                            std::vector<uint8_t>(sizeof(VkQualityChecksumSection), 0));
+  std::vector<VkQualityFileSectionEntry> sections;
+  for (const auto &section : section_data) {
+    sections.push_back({section.first, 0, static_cast<uint32_t>(section.second.size()), 0});
+  }
+  const size_t section_table_size = sizeof(VkQualityFileSectionTable) +
+      (sections.size() * sizeof(VkQualityFileSectionEntry));
+  std::vector<uint8_t> buffer(sizeof(VkQualityFileHeader) + section_table_size, 0);
+  VkQualityFileHeader header{};
+  header.file_identifier = VkQualityPredictionFile::kVkQuality_File_Identifier;
+  header.file_format_version = kFileFormatVersion;
+  header.library_minimum_version = kMinimumLibraryVersion;
+  header.list_version = list_version_;
+  header.min_future_vulkan_recommendation_api = min_future_vulkan_recommendation_api_;
+  header.device_list_count = static_cast<uint32_t>(device_table.size());
+  header.driver_allow_count = static_cast<uint32_t>(
+      driver_allow_table.fingerprint_entries.size());
+  header.driver_deny_count = static_cast<uint32_t>(
+      driver_deny_table.fingerprint_entries.size());
+  header.gpu_allow_predict_count = static_cast<uint32_t>(gpu_allow_table.size());
+  header.gpu_deny_predict_count = static_cast<uint32_t>(gpu_deny_table.size());
+  header.soc_allow_count = static_cast<uint32_t>(driver_allow_table.soc_entries.size());
+  header.soc_deny_count = static_cast<uint32_t>(driver_deny_table.soc_entries.size());
+  header.string_table_count = string_table.GetCount();
+
+  header.string_table_offset = static_cast<uint32_t>(buffer.size());
+  string_table.Write(buffer);
+  header.device_list_offset = AppendTable(buffer, device_table);
+  header.device_list_shortcuts_offset = AppendTable(buffer, shortcut_table);
+  for (size_t i = 0; i < section_data.size(); ++i) {
+    // Column sections need 16 byte alignment, keep every section aligned
+    buffer.resize((buffer.size() + 15) & ~static_cast<size_t>(15), 0);
+    sections[i].section_offset = AppendTable(buffer, section_data[i].second);
+  }
+  header.gpu_allow_predict_offset = AppendTable(buffer, gpu_allow_table);
+  header.gpu_deny_predict_offset = AppendTable(buffer, gpu_deny_table);
+  header.soc_allow_offset = AppendTable(buffer, driver_allow_table.soc_entries);
+  header.driver_allow_offset = AppendTable(buffer, driver_allow_table.fingerprint_entries);
+  header.soc_deny_offset = AppendTable(buffer, driver_deny_table.soc_entries);
+  header.driver_deny_offset = AppendTable(buffer, driver_deny_table.fingerprint_entries);
+
+  memcpy(buffer.data(), &header, sizeof(header));
+  const VkQualityFileSectionTable section_table{
+      VkQualityPredictionFile::kVkQuality_Section_Table_Identifier,
+      static_cast<uint32_t>(sections.size())};
+  memcpy(buffer.data() + sizeof(header), &section_table, sizeof(section_table));
+  memcpy(buffer.data() + sizeof(header) + sizeof(section_table), sections.data(),
+         sections.size() * sizeof(VkQualityFileSectionEntry));
+
+  const size_t checksum_offset = sections.back().section_offset;
+  VkQualityChecksumSection checksum_section{VkQualityPredictionFile::kChecksum_Crc32c, 0,
+                                            static_cast<uint32_t>(buffer.size()), 0};
+  memcpy(buffer.data() + checksum_offset, &checksum_section, sizeof(checksum_section));
+  checksum_section.checksum = VkQualityPredictionFile::ComputeFileChecksum(
+      buffer.data(), buffer.size(), checksum_offset);
+  memcpy(buffer.data() + checksum_offset, &checksum_section, sizeof(checksum_section));
+  return buffer;
+}
+
+std::vector<uint8_t> VkQualityFileWriter::WriteSharded(
+    const std::string &shard_prefix, std::vector<ShardFile> &shard_files) const {
+  // Devices are bucketed by the brand the root file searches, the root file
+  // keeps the aliases
+  std::map<uint32_t, VkQualityFileWriter> shard_writers;
+  for (const auto &device : GetKeyedDevices(devices_, GetUnchainedAliases(brand_aliases_))) {
+    const uint32_t shortcut_index = GetBrandShortcutIndex(device.brand);
+    auto shard_writer = shard_writers.find(shortcut_index);
+    if (shard_writer == shard_writers.end()) {
+      shard_writer = shard_writers.emplace(
+          shortcut_index,
+          VkQualityFileWriter(list_version_, min_future_vulkan_recommendation_api_)).first;
+    }
+    shard_writer->second.AddDevice(device);
+  }
+
+  VkQualityFileWriter root_writer = *this;
+  root_writer.devices_.clear();
+  shard_files.clear();
+  for (const auto &shard_writer : shard_writers) {
+    const uint32_t shortcut_index = shard_writer.first;
+    const std::string bucket_name =
+        (shortcut_index + 1 < VkQualityPredictionFile::kShortcut_Offset_Count) ?
+        std::string(1, static_cast<char>('a' + shortcut_index)) : std::string("other");
+    ShardFile shard_file{shard_prefix + "_" + bucket_name + ".vkq",
+                         shard_writer.second.Write()};
+    root_writer.device_shards_.emplace_back(shortcut_index, shard_file.name);
+    shard_files.push_back(std::move(shard_file));
+  }
+  return root_writer.Write();
+}
+
+std::vector<uint8_t> VkQualityFileWriter::Compress(const std::vector<uint8_t> &file_data,
+                                                   const uint32_t block_size) {
+  std::vector<uint8_t> container;
+  if (file_data.size() < sizeof(VkQualityFileHeader)) {
+    return container;
+  }
+  const VkQualityCompressedFileHeader container_header{
+      VkQualityCompression::kCompressed_File_Identifier,
+      VkQualityCompression::kContainer_Version,
+      static_cast<uint32_t>(file_data.size()), block_size};
+  const uint8_t *header_bytes = reinterpret_cast<const uint8_t *>(&container_header);
+  container.insert(container.end(), header_bytes, header_bytes + sizeof(container_header));
+  // The data file header stays uncompressed
+  container.insert(container.end(), file_data.begin(),
+                   file_data.begin() + sizeof(VkQualityFileHeader));
+
+  BlockEncoder encoder(file_data);
+  std::vector<uint8_t> block_data;
+  for (size_t block_start = sizeof(VkQualityFileHeader); block_start < file_data.size();
+       block_start += block_size) {
+    const size_t block_end = std::min<size_t>(block_start + block_size, file_data.size());
+    block_data.clear();
+    encoder.EncodeBlock(block_start, block_end, block_data);
+    const VkQualityCompressedBlockHeader block_header{
+        static_cast<uint32_t>(block_data.size()), static_cast<uint32_t>(block_end - block_start)};
+    const uint8_t *block_header_bytes = reinterpret_cast<const uint8_t *>(&block_header);
+    container.insert(container.end(), block_header_bytes,
+                     block_header_bytes + sizeof(block_header));
+    container.insert(container.end(), block_data.begin(), block_data.end());
+  }
+  return container;
+}
+
+std::vector<uint8_t> VkQualityFileWriter::CreatePatch(const std::vector<uint8_t> &base,
+                                                      const std::vector<uint8_t> &target) {
+  std::vector<uint8_t> patch;
+  uint32_t base_list_version = 0;
+  uint32_t target_list_version = 0;
+  if (!VkQualityPatch::GetStoredListVersion(base.data(), base.size(), base_list_version) ||
+      !VkQualityPatch::GetStoredListVersion(target.data(), target.size(),
+                                            target_list_version)) {
+    return patch;
+  }
+  VkQualityPatchHeader patch_header = {};
+  patch_header.patch_identifier = VkQualityPatch::kPatch_File_Identifier;
+  patch_header.patch_version = VkQualityPatch::kPatch_Version;
+  patch_header.base_list_version = base_list_version;
+  patch_header.base_size = static_cast<uint32_t>(base.size());
+  patch_header.base_crc32c = VkQualityChecksum::Crc32c(0, base.data(), base.size());
+  patch_header.target_list_version = target_list_version;
+  patch_header.target_size = static_cast<uint32_t>(target.size());
+  patch_header.target_crc32c = VkQualityChecksum::Crc32c(0, target.data(), target.size());
+  patch.resize(sizeof(patch_header));
+
+  auto append_op = [&patch, &patch_header](const uint32_t op_type, const uint32_t base_offset,
+                                           const uint8_t *insert_data, const uint32_t length) {
+    const VkQualityPatchOp op{op_type, base_offset, length};
+    const uint8_t *op_bytes = reinterpret_cast<const uint8_t *>(&op);
+    patch.insert(patch.end(), op_bytes, op_bytes + sizeof(op));
+    if (insert_data != nullptr) {
+      patch.insert(patch.end(), insert_data, insert_data + length);
+    }
+    ++patch_header.op_count;
+  };
+
+  // Greedy match against the first base position of each window, a copy
+  // shorter than a window costs more than inserting the bytes
+  constexpr size_t kWindowSize = 16;
+  auto hash_window = [](const uint8_t *window) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < kWindowSize; ++i) {
+      hash = (hash ^ window[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+  };
+  std::unordered_map<uint64_t, uint32_t> base_windows;
+  for (size_t base_pos = 0; base_pos + kWindowSize <= base.size(); ++base_pos) {
+    base_windows.emplace(hash_window(base.data() + base_pos), static_cast<uint32_t>(base_pos));
+  }
+
+  size_t insert_start = 0;
+  size_t target_pos = 0;
+  while (target_pos + kWindowSize <= target.size()) {
+    const auto base_window = base_windows.find(hash_window(target.data() + target_pos));
+    if (base_window == base_windows.end() ||
+        memcmp(base.data() + base_window->second, target.data() + target_pos, kWindowSize) != 0) {
+      ++target_pos;
+      continue;
+    }
+    const size_t base_pos = base_window->second;
+    size_t match_length = kWindowSize;
+    while (base_pos + match_length < base.size() && target_pos + match_length < target.size() &&
+           base[base_pos + match_length] == target[target_pos + match_length]) {
+      ++match_length;
+    }
+    if (target_pos > insert_start) {
+      append_op(VkQualityPatch::kPatchOp_Insert, 0, target.data() + insert_start,
+                static_cast<uint32_t>(target_pos - insert_start));
+    }
+    append_op(VkQualityPatch::kPatchOp_Copy, static_cast<uint32_t>(base_pos), nullptr,
+              static_cast<uint32_t>(match_length));
+    target_pos += match_length;
+    insert_start = target_pos;
+  }
+  if (target.size() > insert_start) {
+    append_op(VkQualityPatch::kPatchOp_Insert, 0, target.data() + insert_start,
+              static_cast<uint32_t>(target.size() - insert_start));
+  }
+  memcpy(patch.data(), &patch_header, sizeof(patch_header));
+  return patch;
+}
+
+} // namespace vkquality
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VKQUALITY_FILE_WRITER_H_
+#define VKQUALITY_FILE_WRITER_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vkquality {
+
+// Writes .vkq quality data files with the same layout as the list editor
+// RuntimeDataExporter. Used by host tools and benchmarks, not part of the
+// Android library.
+class VkQualityFileWriter {
+ public:
+  static constexpr uint32_t kFileFormatVersion = 0x010500;
+  // Files key brands by brand key, which older libraries search as exact brands
+  static constexpr uint32_t kMinimumLibraryVersion = 0x010300;
+  static constexpr uint32_t kCompressedBlockSize = 64 * 1024;
+
+  struct DeviceEntry {
+    std::string brand;
+    std::string device;
+    uint32_t min_api_version = 0;
+    uint32_t min_driver_version = 0;
+  };
+
+  struct GpuEntry {
+    std::string device_name;
+    uint32_t min_api_version = 0;
+    uint32_t device_id = 0;
+    uint32_t vendor_id = 0;
+    uint32_t min_driver_version = 0;
+  };
+
+  struct DriverEntry {
+    std::string soc;
+    std::string fingerprint;
+  };
+
+  // Versions are VkQualityDriverVersion versions of version_format, zero is no bound.
+  // A zero vendor_id is every vendor, kVersionFormat_Vulkan rules with a vendor_id
+  // may leave soc empty
+  struct DriverRuleEntry {
+    std::string soc;
+    uint32_t version_format = 0;
+    uint64_t min_driver_version = 0;
+    uint64_t max_driver_version = 0;
+    uint32_t vendor_id = 0;
+  };
+
+  // Capabilities are VkQualityCapabilities bits, a zero vendor_id is every vendor
+  struct CapabilityRuleEntry {
+    uint64_t required_capabilities = 0;
+    uint64_t forbidden_capabilities = 0;
+    uint32_t vendor_id = 0;
+  };
+
+  VkQualityFileWriter(const uint32_t list_version,
+                      const int32_t min_future_vulkan_recommendation_api);
+
+  void AddDevice(const DeviceEntry &entry) { devices_.push_back(entry); }
+  void AddGpuAllow(const GpuEntry &entry) { gpu_allow_.push_back(entry); }
+  void AddGpuDeny(const GpuEntry &entry) { gpu_deny_.push_back(entry); }
+  void AddDriverAllow(const DriverEntry &entry) { driver_allow_.push_back(entry); }
+  void AddDriverDeny(const DriverEntry &entry) { driver_deny_.push_back(entry); }
+  // Rules are written in the order they are added, which is their priority
+  void AddDriverAllowRule(const DriverRuleEntry &entry) { driver_allow_rules_.push_back(entry); }
+  void AddDriverDenyRule(const DriverRuleEntry &entry) { driver_deny_rules_.push_back(entry); }
+  void AddCapabilityAllowRule(const CapabilityRuleEntry &entry) {
+    capability_allow_rules_.push_back(entry);
+  }
+  void AddCapabilityDenyRule(const CapabilityRuleEntry &entry) {
+    capability_deny_rules_.push_back(entry);
+  }
+  // Devices of the alias brand are searched as devices of brand, the first
+  // alias added for a brand key is used. Aliases of an alias brand are ignored.
+  void AddBrandAlias(const std::string &alias, const std::string &brand);
+
+  struct ShardFile {
+    std::string name;
+    std::vector<uint8_t> data;
+  };
+
+  // Brands are written as brand keys, with aliases resolved, and rows that
+  // are repeated once their brands are keyed are dropped. Devices are sorted
+  // by brand, the brand shortcut table and the brand index section are
+  // populated, driver fingerprints are grouped by SoC
+  std::vector<uint8_t> Write() const;
+
+  // Writes a root file holding the driver and GPU lists, and a shard file per
+  // brand shortcut bucket holding the devices of the bucket. Shards are named
+  // shard_prefix followed by the lower case bucket letter, or _other, and .vkq
+  std::vector<uint8_t> WriteSharded(const std::string &shard_prefix,
+                                    std::vector<ShardFile> &shard_files) const;
+
+  // Packs a data file into a compressed container, see VkQualityCompressedFileHeader
+  static std::vector<uint8_t> Compress(const std::vector<uint8_t> &file_data,
+                                       const uint32_t block_size = kCompressedBlockSize);
+
+  // Creates a patch that rebuilds target from base, see VkQualityPatchHeader.
+  // Either file may be a compressed container. Returns an empty vector if
+  // either file doesn't start with a data file header.
+  static std::vector<uint8_t> CreatePatch(const std::vector<uint8_t> &base,
+                                          const std::vector<uint8_t> &target);
+
+ private:
+  uint32_t list_version_;
+  int32_t min_future_vulkan_recommendation_api_;
+  std::vector<DeviceEntry> devices_;
+  std::vector<GpuEntry> gpu_allow_;
+  std::vector<GpuEntry> gpu_deny_;
+  std::vector<DriverEntry> driver_allow_;
+  std::vector<DriverEntry> driver_deny_;
+  std::vector<DriverRuleEntry> driver_allow_rules_;
+  std::vector<DriverRuleEntry> driver_deny_rules_;
+  std::vector<CapabilityRuleEntry> capability_allow_rules_;
+  std::vector<CapabilityRuleEntry> capability_deny_rules_;
+  // Brand key of each alias, by alias brand key
+  std::map<std::string, std::string> brand_aliases_;
+  // Shortcut index and file name of each shard of a root file
+  std::vector<std::pair<uint32_t, std::string>> device_shards_;
+};
+
+} // namespace vkquality
+
+#endif // VKQUALITY_FILE_WRITER_H_
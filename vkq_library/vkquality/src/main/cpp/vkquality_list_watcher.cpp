@@ -0,0 +1,150 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vkquality_list_watcher.h"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace vkquality {
+
+VkQualityListWatcher::VkQualityListWatcher(const std::string &storage_path,
+                                           const std::string &file_name,
+                                           std::function<void()> on_change)
+    : watch_directory_(storage_path)
+    , watch_file_name_(file_name)
+    , on_change_(std::move(on_change)) {
+  // The data filename can be a partial path, watch the directory that
+  // actually contains the file
+  const size_t separator = file_name.find_last_of('/');
+  if (separator != std::string::npos) {
+    watch_directory_ = storage_path + "/" + file_name.substr(0, separator);
+    watch_file_name_ = file_name.substr(separator + 1);
+  }
+}
+
+VkQualityListWatcher::~VkQualityListWatcher() {
+  Stop();
+}
+
+#if defined(__linux__)
+
+bool VkQualityListWatcher::Start() {
+  if (watch_thread_.joinable()) {
+    return true;
+  }
+  inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd_ < 0) {
+    return false;
+  }
+  // Only react to completed writes and renames, a downloader writing the file
+  // in place will trigger IN_CLOSE_WRITE, one writing to a temp file and
+  // renaming it will trigger IN_MOVED_TO
+  if (inotify_add_watch(inotify_fd_, watch_directory_.c_str(),
+                        IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    close(inotify_fd_);
+    inotify_fd_ = -1;
+    return false;
+  }
+  wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wake_fd_ < 0) {
+    close(inotify_fd_);
+    inotify_fd_ = -1;
+    return false;
+  }
+  watch_thread_ = std::thread(&VkQualityListWatcher::WatchThread, this);
+  return true;
+}
+
+void VkQualityListWatcher::Stop() {
+  if (watch_thread_.joinable()) {
+    const uint64_t wake_value = 1;
+    const ssize_t wake_result = write(wake_fd_, &wake_value, sizeof(wake_value));
+    (void) wake_result;
+    watch_thread_.join();
+  }
+  if (wake_fd_ >= 0) {
+    close(wake_fd_);
+    wake_fd_ = -1;
+  }
+  if (inotify_fd_ >= 0) {
+    close(inotify_fd_);
+    inotify_fd_ = -1;
+  }
+}
+
+void VkQualityListWatcher::WatchThread() {
+  alignas(struct inotify_event) char event_buffer[4096];
+  struct pollfd poll_fds[2] = {
+      {inotify_fd_, POLLIN, 0},
+      {wake_fd_, POLLIN, 0}
+  };
+
+  while (true) {
+    const int poll_result = poll(poll_fds, 2, -1);
+    if (poll_result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if ((poll_fds[1].revents & POLLIN) != 0) {
+      break;
+    }
+    if ((poll_fds[0].revents & POLLIN) == 0) {
+      continue;
+    }
+
+    // Coalesce every event in the read batch into a single change notification
+    bool file_changed = false;
+    ssize_t read_size;
+    while ((read_size = read(inotify_fd_, event_buffer, sizeof(event_buffer))) > 0) {
+      size_t event_offset = 0;
+      while (event_offset < static_cast<size_t>(read_size)) {
+        const struct inotify_event *event =
+            reinterpret_cast<const struct inotify_event *>(event_buffer + event_offset);
+        if (event->len > 0 && watch_file_name_ == event->name) {
+          file_changed = true;
+        }
+        event_offset += sizeof(struct inotify_event) + event->len;
+      }
+    }
+    if (file_changed) {
+      on_change_();
+    }
+  }
+}
+
+#else
+
+bool VkQualityListWatcher::Start() {
+  return false;
+}
+
+void VkQualityListWatcher::Stop() {
+}
+
+void VkQualityListWatcher::WatchThread() {
+}
+
+#endif
+
+} // namespace vkquality
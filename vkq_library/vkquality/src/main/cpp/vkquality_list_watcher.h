@@ -0,0 +1,58 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VKQUALITY_LIST_WATCHER_H_
+#define VKQUALITY_LIST_WATCHER_H_
+
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace vkquality {
+
+/**
+ * @brief Watches a quality data file in the storage directory and calls
+ * a change callback on a background thread whenever a new version of the file
+ * has been completely written or moved into place. Uses inotify, so watching
+ * is only available on Linux and Android, Start will fail elsewhere.
+ */
+class VkQualityListWatcher {
+ public:
+  VkQualityListWatcher(const std::string &storage_path, const std::string &file_name,
+                       std::function<void()> on_change);
+  ~VkQualityListWatcher();
+
+  VkQualityListWatcher(const VkQualityListWatcher &) = delete;
+  VkQualityListWatcher &operator=(const VkQualityListWatcher &) = delete;
+
+  bool Start();
+
+  void Stop();
+
+ private:
+  void WatchThread();
+
+  std::string watch_directory_;
+  std::string watch_file_name_;
+  std::function<void()> on_change_;
+  int inotify_fd_ = -1;
+  int wake_fd_ = -1;
+  std::thread watch_thread_;
+};
+
+} // namespace vkquality
+
+#endif // VKQUALITY_LIST_WATCHER_H_
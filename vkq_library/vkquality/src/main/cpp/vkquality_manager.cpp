@@ -14,9 +14,11 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <iostream>
 #include <jni.h>
 #include <string>
+#include <string.h>
 #include <sys/stat.h>
 #include <vector>
 #include <android/api-level.h>
@@ -25,6 +27,8 @@
 #include <android/log.h>
 
 #include "vkquality_manager.h"
+#include "vkquality_compression.h"
+#include "vkquality_evaluator.h"
 #include "gles_util.h"
 #include "vulkan_util.h"
 
@@ -47,7 +51,7 @@ constexpr const char *kDeviceField = "DEVICE";
 constexpr const char *kSoCField = "SOC_MODEL";
 
 std::mutex VkQualityManager::instance_mutex_;
-std::unique_ptr<VkQualityManager> VkQualityManager::instance_ = nullptr;
+std::shared_ptr<VkQualityManager> VkQualityManager::instance_ = nullptr;
 
 vkQualityInitResult VkQualityManager::Init(JNIEnv *env, AAssetManager *asset_manager,
                                            const char *storage_path,
@@ -60,50 +64,115 @@ vkQualityInitResult VkQualityManager::Init(JNIEnv *env, AAssetManager *asset_man
     return kErrorInitializationFailure;
   }
 
-  instance_ = std::make_unique<VkQualityManager>(env, asset_manager,
-                                                 storage_path, asset_filename,
-                                                 api_info, flags,
-                                                 ConstructorTag{});
+  instance_ = std::make_shared<VkQualityManager>(asset_manager, storage_path,
+                                                 asset_filename, flags);
   if (instance_ == nullptr) {
     return kErrorInitializationFailure;
   }
-  return instance_->StartRecommendation();
+  return instance_->StartRecommendation(env, api_info);
 }
 
-VkQualityManager* VkQualityManager::GetInstance() {
+vkQualityInitResult VkQualityManager::InitFromMemory(JNIEnv *env, void *list_data,
+                                                     size_t list_size,
+                                                     VkQualityPredictionFile::FileDataRelease
+                                                         release_function,
+                                                     void *release_user_data,
+                                                     const char *storage_path,
+                                                     const vkqGraphicsAPIInfo *api_info,
+                                                     int32_t flags) {
   std::lock_guard<std::mutex> lock(instance_mutex_);
-  return instance_.get();
+  if (instance_ != nullptr || list_data == nullptr) {
+    // Already initialized, or nothing to initialize from
+    if (list_data != nullptr && release_function != nullptr) {
+      release_function(list_data, release_user_data);
+    }
+    return kErrorInitializationFailure;
+  }
+
+  // The data file isn't loaded from storage, so watching storage has no purpose
+  instance_ = std::make_shared<VkQualityManager>(nullptr, storage_path, nullptr,
+                                                 flags & ~kInitFlagWatchStoragePath);
+  instance_->SetListData(list_data, list_size, release_function, release_user_data);
+  return instance_->StartRecommendation(env, api_info);
 }
 
-void VkQualityManager::DestroyInstance(JNIEnv */*env*/) {
+std::shared_ptr<VkQualityManager> VkQualityManager::GetInstance() {
   std::lock_guard<std::mutex> lock(instance_mutex_);
-  instance_.reset();
+  return instance_;
+}
+
+// A reload or getter in progress holds its own reference, the manager is freed
+// when the last reference is dropped
+void VkQualityManager::DestroyInstance(JNIEnv */*env*/) {
+  std::shared_ptr<VkQualityManager> instance;
+  {
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    instance = std::move(instance_);
+  }
+}
+
+// instance_mutex_ is only held to copy the instance reference, so readers
+// never wait on a reload in progress
+vkQualityInitResult VkQualityManager::Reload() {
+  const std::shared_ptr<VkQualityManager> mgr = GetInstance();
+  if (mgr == nullptr) {
+    return kErrorInitializationFailure;
+  }
+  return mgr->ReloadRecommendation();
 }
 
 vkQualityRecommendation VkQualityManager::GetQualityRecommendation() {
-  VkQualityManager* mgr = VkQualityManager::GetInstance();
+  const std::shared_ptr<VkQualityManager> mgr = GetInstance();
   if (mgr == nullptr) {
     return kRecommendationErrorNotInitialized;
   }
-  return mgr->quality_recommendation_;
+  return mgr->GetRecommendation();
 }
 
-VkQualityManager::VkQualityManager(JNIEnv *env, AAssetManager *asset_manager,
-                                   const char *storage_path, const char *asset_filename,
-                                   const vkqGraphicsAPIInfo *api_info, int32_t flags,
-                                   ConstructorTag)
+int32_t VkQualityManager::GetQualityRecommendedDeviceIndex() {
+  const std::shared_ptr<VkQualityManager> mgr = GetInstance();
+  if (mgr == nullptr) {
+    return -1;
+  }
+  return mgr->GetRecommendedDeviceIndex();
+}
+
+VkQualityManager::VkQualityManager(AAssetManager *asset_manager, const char *storage_path,
+                                   const char *asset_filename, int32_t flags)
     :asset_manager_(asset_manager)
-    ,env_(env)
-    ,asset_filename_(asset_filename)
+    ,asset_filename_()
     ,storage_path_()
-    ,api_info_(api_info)
     ,flags_(flags) {
   //ALOGE("INIT PATHS %s %s", storage_path, asset_filename);
+  if (asset_filename != nullptr) {
+    asset_filename_ = asset_filename;
+  }
   if (storage_path != nullptr) {
     storage_path_ = storage_path;
   }
 }
 
+VkQualityManager::~VkQualityManager() {
+  // Stop the watcher first so no reload can be running during destruction
+  list_watcher_.reset();
+  if (list_data_ != nullptr && list_release_function_ != nullptr) {
+    list_release_function_(list_data_, list_release_user_data_);
+  }
+}
+
+void VkQualityManager::SetListData(void *list_data, size_t list_size,
+                                   VkQualityPredictionFile::FileDataRelease release_function,
+                                   void *release_user_data) {
+  std::lock_guard<std::mutex> lock(reload_mutex_);
+  if (list_data_ != nullptr && list_release_function_ != nullptr) {
+    list_release_function_(list_data_, list_release_user_data_);
+  }
+  list_data_ = list_data;
+  list_size_ = list_size;
+  list_release_function_ = release_function;
+  list_release_user_data_ = release_user_data;
+}
+
 std::string VkQualityManager::GetStaticStringField(JNIEnv *env, jclass clz,
                                                    const char *name) {
   jfieldID field_id = env->GetStaticFieldID(clz, name, "Ljava/lang/String;");
@@ -128,7 +197,8 @@ std::string VkQualityManager::GetStaticStringField(JNIEnv *env, jclass clz,
 }
 
 vkQualityInitResult VkQualityManager::InitDeviceInfo(JNIEnv *env, DeviceInfo &device_info,
-    const vkqGraphicsAPIInfo *api_info) {
+    VkQualityDeviceCandidates &candidates, const vkqGraphicsAPIInfo *api_info) {
+  candidates.count = 0;
   jclass build_class = env->FindClass(kAndroidBuildClass);
   if (env->ExceptionCheck()) {
     env->ExceptionClear();
@@ -160,10 +230,10 @@ vkQualityInitResult VkQualityManager::InitDeviceInfo(JNIEnv *env, DeviceInfo &de
     return VulkanUtil::CopyDeviceVulkanInfo(device_info,
         api_info->vk_physical_device_properties);
   }
-  return VulkanUtil::GetDeviceVulkanInfo(device_info);
+  return VulkanUtil::GetDeviceVulkanInfo(device_info, candidates);
 }
 
-bool VkQualityManager::LoadCache(const DeviceInfo &device_info) {
+bool VkQualityManager::LoadCache(DeviceInfo &device_info) {
   if (storage_path_.empty()) {
     return false;
   }
@@ -175,10 +245,22 @@ bool VkQualityManager::LoadCache(const DeviceInfo &device_info) {
     if (cache_size == sizeof(CacheFile)) {
       const CacheFile &cache_file = *(reinterpret_cast<CacheFile *>(cache_bytes));
       if (cache_file.schema_version == kCacheSchemaVersion) {
+        for (uint32_t i = 0; i < device_candidates_.count; ++i) {
+          const VkQualityDeviceCandidate &candidate = device_candidates_.candidates[i];
+          if (cache_file.device_id == candidate.device_id &&
+              cache_file.vendor_id == candidate.vendor_id &&
+              cache_file.driver_version == candidate.driver_version) {
+            VkQualityDeviceProbe::CopyCandidate(candidate, device_info);
+            recommended_device_index_ = static_cast<int32_t>(candidate.physical_device_index);
+            break;
+          }
+        }
         if (cache_file.device_id == device_info.vk_device_id &&
             cache_file.vendor_id == device_info.vk_vendor_id &&
             cache_file.driver_version == device_info.vk_driver_version) {
           cache_list_version_ = cache_file.list_version;
+          cache_overlay_version_ = cache_file.overlay_list_version;
+          cache_list_checksum_ = cache_file.list_checksum;
           cache_recommendation_ = static_cast<vkQualityRecommendation>(cache_file.recommendation);
           loaded_cache = true;
         }
@@ -198,7 +280,8 @@ void VkQualityManager::SaveCache(const DeviceInfo &device_info) {
                         device_info.vk_device_id,
                         device_info.vk_vendor_id,
                         device_info.vk_driver_version,
-                        0, 0};
+                        cache_overlay_version_,
+                        cache_list_checksum_};
   SaveFile(storage_path_, kCacheFilename, sizeof(cache_file), &cache_file);
 }
 
@@ -213,20 +296,18 @@ vkQualityInitResult VkQualityManager::LoadFile(AAssetManager *asset_manager,
     if (fp != nullptr) {
       struct stat fileStats{};
       int statResult = fstat(fileno(fp), &fileStats);
+      size_t stored_size = 0;
       if (statResult == 0) {
-        file_size = fileStats.st_size;
+        stored_size = fileStats.st_size;
       }
-      if (file_size == 0) {
-        fclose(fp);
-        return kErrorInvalidDataFile;
-      }
-      *file_bytes = malloc(file_size + 1);
-      if (*file_bytes == nullptr) {
-        fclose(fp);
-        return kErrorInitializationFailure;
-      }
-      fread((*file_bytes), file_size, 1, fp);
+      const vkQualityInitResult result = ReadFileData(
+          [fp](void *buffer, size_t size) {
+            return fread(buffer, size, 1, fp) == 1;
+          }, stored_size, file_size, file_bytes);
       fclose(fp);
+      if (result != kSuccess) {
+        return result;
+      }
     }
   }
 
@@ -234,18 +315,14 @@ vkQualityInitResult VkQualityManager::LoadFile(AAssetManager *asset_manager,
   if (*file_bytes == nullptr && asset_manager != nullptr) {
     AAsset *json_asset = AAssetManager_open(asset_manager, file_name.c_str(), AASSET_MODE_STREAMING);
     if (json_asset != nullptr) {
-      file_size = AAsset_getLength(json_asset);
-      if (file_size == 0) {
-        AAsset_close(json_asset);
-        return kErrorInvalidDataFile;
-      }
-      *file_bytes = malloc(file_size + 1);
-      if ((*file_bytes) == nullptr) {
-        AAsset_close(json_asset);
-        return kErrorInitializationFailure;
-      }
-      AAsset_read(json_asset, (*file_bytes), file_size);
+      const vkQualityInitResult result = ReadFileData(
+          [json_asset](void *buffer, size_t size) {
+            return AAsset_read(json_asset, buffer, size) == static_cast<int>(size);
+          }, AAsset_getLength(json_asset), file_size, file_bytes);
       AAsset_close(json_asset);
+      if (result != kSuccess) {
+        return result;
+      }
     }
   }
 
@@ -256,6 +333,109 @@ vkQualityInitResult VkQualityManager::LoadFile(AAssetManager *asset_manager,
   return kSuccess;
 }
 
+vkQualityInitResult VkQualityManager::ReadFileData(
+    const VkQualityCompression::ReadFunction &read_function, const size_t stored_size,
+    size_t &file_size, void **file_bytes) {
+  if (stored_size == 0) {
+    return kErrorInvalidDataFile;
+  }
+
+  // Compressed containers are decoded while they are read, without holding
+  // the compressed file in memory
+  VkQualityCompressedFileHeader compressed_header{};
+  size_t header_size = 0;
+  if (stored_size >= sizeof(compressed_header)) {
+    if (!read_function(&compressed_header, sizeof(compressed_header))) {
+      return kErrorInvalidDataFile;
+    }
+    header_size = sizeof(compressed_header);
+    if (VkQualityCompression::IsCompressed(&compressed_header, header_size)) {
+      *file_bytes = VkQualityCompression::DecompressStream(compressed_header, read_function,
+                                                           file_size);
+      return (*file_bytes != nullptr) ? kSuccess : kErrorInvalidDataFile;
+    }
+  }
+
+  uint8_t *stored_bytes = reinterpret_cast<uint8_t *>(malloc(stored_size + 1));
+  if (stored_bytes == nullptr) {
+    return kErrorInitializationFailure;
+  }
+  memcpy(stored_bytes, &compressed_header, header_size);
+  if (stored_size > header_size &&
+      !read_function(stored_bytes + header_size, stored_size - header_size)) {
+    free(stored_bytes);
+    return kErrorInvalidDataFile;
+  }
+  file_size = stored_size;
+  *file_bytes = stored_bytes;
+  return kSuccess;
+}
+
+bool VkQualityManager::ReadListHeader(AAssetManager *asset_manager,
+                                      const std::string &storage_path,
+                                      const std::string &file_name,
+                                      const ListSource source,
+                                      VkQualityFileHeader &header) {
+  // A compressed container stores the data file header uncompressed after its
+  // own header
+  auto read_list_header = [&header](const VkQualityCompression::ReadFunction &read_function) {
+    VkQualityCompressedFileHeader compressed_header{};
+    if (!read_function(&compressed_header, sizeof(compressed_header))) {
+      return false;
+    }
+    if (VkQualityCompression::IsCompressed(&compressed_header, sizeof(compressed_header))) {
+      return read_function(&header, sizeof(header));
+    }
+    memcpy(&header, &compressed_header, sizeof(compressed_header));
+    return read_function(reinterpret_cast<uint8_t *>(&header) + sizeof(compressed_header),
+                         sizeof(header) - sizeof(compressed_header));
+  };
+
+  bool read_header = false;
+  if (source == kListSource_Storage && !storage_path.empty()) {
+    std::string full_path = storage_path + "/" + file_name;
+    FILE *fp = fopen(full_path.c_str(), "rb");
+    if (fp != nullptr) {
+      read_header = read_list_header([fp](void *buffer, size_t size) {
+        return fread(buffer, size, 1, fp) == 1;
+      });
+      fclose(fp);
+    }
+  } else if (source == kListSource_Asset && asset_manager != nullptr) {
+    AAsset *vkq_asset = AAssetManager_open(asset_manager, file_name.c_str(),
+                                           AASSET_MODE_STREAMING);
+    if (vkq_asset != nullptr) {
+      read_header = read_list_header([vkq_asset](void *buffer, size_t size) {
+        return AAsset_read(vkq_asset, buffer, size) == static_cast<int>(size);
+      });
+      AAsset_close(vkq_asset);
+    }
+  }
+  return read_header;
+}
+
+VkQualityManager::ListSource VkQualityManager::SelectListSource(AAssetManager *asset_manager,
+                                                                const std::string &storage_path,
+                                                                const std::string &file_name) {
+  // Compare only the headers of the candidates so a stale downloaded file
+  // doesn't shadow a newer file bundled in an updated app, ties go to storage
+  ListSource selected_source = kListSource_None;
+  uint32_t selected_version = 0;
+  const ListSource candidates[] = {kListSource_Storage, kListSource_Asset};
+  for (const ListSource candidate : candidates) {
+    VkQualityFileHeader header{};
+    if (!ReadListHeader(asset_manager, storage_path, file_name, candidate, header) ||
+        !VkQualityPredictionFile::IsHeaderCompatible(header, VkQuality_getVersion())) {
+      continue;
+    }
+    if (selected_source == kListSource_None || header.list_version > selected_version) {
+      selected_source = candidate;
+      selected_version = header.list_version;
+    }
+  }
+  return selected_source;
+}
+
 bool VkQualityManager::SaveFile(const std::string &storage_path,
                                 const std::string &file_name,
                                 const size_t file_size, const void *file_bytes) {
@@ -275,87 +455,238 @@ bool VkQualityManager::SaveFile(const std::string &storage_path,
   return ((count_written * file_size) == file_size);
 }
 
-vkQualityInitResult VkQualityManager::StartRecommendation() {
+vkQualityInitResult VkQualityManager::StartRecommendation(JNIEnv *env,
+                                                          const vkqGraphicsAPIInfo *api_info) {
   if (android_get_device_api_level() < __ANDROID_API_Q__) {
     // GLES recommendation when running on pre-Android 10
     quality_recommendation_ = kRecommendationGLESBecauseOldDevice;
     return kSuccess;
   }
 
-  DeviceInfo device_info;
-  vkQualityInitResult result = InitDeviceInfo(env_, device_info, api_info_);
+  vkQualityInitResult result = InitDeviceInfo(env, device_info_, device_candidates_, api_info);
   if (result != kSuccess) {
     return result;
   }
+  if (device_candidates_.count > 0) {
+    recommended_device_index_ =
+        static_cast<int32_t>(device_candidates_.candidates[0].physical_device_index);
+  }
 
-  if (device_info.vk_api_version < VulkanUtil::GetMinimumRecommendedVulkanVersion()) {
+  // Any probed device may be the recommended one
+  uint32_t vk_api_version = device_info_.vk_api_version;
+  for (uint32_t i = 0; i < device_candidates_.count; ++i) {
+    vk_api_version = std::max(vk_api_version, device_candidates_.candidates[i].api_version);
+  }
+  if (vk_api_version < VkQualityEvaluator::kMinimumVulkanVersion) {
     // GLES recommendation on devices limited to Vulkan 1.0.x
     quality_recommendation_ = kRecommendationGLESBecauseOldDevice;
     return kSuccess;
   }
+  device_info_valid_ = true;
 
   // Load cache after obtaining device info, we invalidate the cache if
   // the device info doesn't match the cached versions, in case the cache file
   // somehow got copied to a different device
-  bool loaded_cache = LoadCache(device_info);
-
-  if (asset_filename_.find(".vkq") != std::string::npos) {
-    size_t vkq_size = 0;
-    void *vkq_bytes = nullptr;
-    result = LoadFile(asset_manager_, storage_path_, asset_filename_, vkq_size, &vkq_bytes);
-    if (result == kSuccess) {
-      const VkQualityPredictionFile::FileParseResult parse_result =
-          prediction_file_.ParseFileData(vkq_bytes, vkq_size, VkQuality_getVersion());
-      if (parse_result != VkQualityPredictionFile::kFileParseResult_Success) {
-        ALOGE("Parsing VkQuality data file failed for reason: %s",
-              prediction_file_.GetParseErrorString().c_str());
-        free(vkq_bytes);
-        if (parse_result == VkQualityPredictionFile::kFileParseResult_Error_LibraryTooOldForFile) {
-          return kErrorInvalidDataVersion;
-        }
+  bool loaded_cache = LoadCache(device_info_);
+
+  {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    result = LoadRecommendation(loaded_cache);
+  }
+
+  if ((flags_ & kInitFlagWatchStoragePath) != 0) {
+    StartListWatcher();
+  }
+  return result;
+}
+
+std::string VkQualityManager::GetHotfixFilename(const std::string &file_name) {
+  const size_t extension_offset = file_name.rfind(".vkq");
+  if (extension_offset == std::string::npos) {
+    return std::string();
+  }
+  return file_name.substr(0, extension_offset) + "_hotfix" + file_name.substr(extension_offset);
+}
+
+void VkQualityManager::LoadHotfix(VkQualityPredictionFile &prediction_file) const {
+  const std::string hotfix_filename = GetHotfixFilename(asset_filename_);
+  if (storage_path_.empty() || hotfix_filename.empty()) {
+    return;
+  }
+  size_t hotfix_size = 0;
+  void *hotfix_bytes = nullptr;
+  if (LoadFile(nullptr, storage_path_, hotfix_filename, hotfix_size, &hotfix_bytes) != kSuccess) {
+    return;
+  }
+  auto hotfix_file = std::make_unique<VkQualityPredictionFile>();
+  hotfix_file->SetValidationMode(VkQualityPredictionFile::kValidation_Lazy);
+  // The overlay owns the hotfix data from a successful parse onward
+  if (hotfix_file->ParseFileData(hotfix_bytes, hotfix_size, VkQuality_getVersion(),
+                                 VkQualityPredictionFile::FreeFileData) !=
+      VkQualityPredictionFile::kFileParseResult_Success) {
+    ALOGE("Parsing VkQuality hotfix file failed for reason: %s",
+          hotfix_file->GetParseErrorString().c_str());
+    free(hotfix_bytes);
+    return;
+  }
+  // Rejected overlays are stale, left behind by an older list, or sharded. A rejected
+  // overlay is destroyed here and releases its data.
+  prediction_file.AddOverlay(std::move(hotfix_file));
+}
+
+vkQualityInitResult VkQualityManager::LoadRecommendation(const bool use_cache) {
+  size_t vkq_size = 0;
+  void *vkq_bytes = nullptr;
+  VkQualityPredictionFile::FileDataRelease release_function =
+      VkQualityPredictionFile::FreeFileData;
+  void *release_user_data = nullptr;
+  // Shards of a root file are loaded from the same place as the root file,
+  // in-memory file data has no shards
+  AAssetManager *shard_asset_manager = nullptr;
+  std::string shard_storage_path;
+  bool list_from_asset = false;
+
+  if (list_data_ != nullptr) {
+    // In-memory file data, ownership passes to the prediction file
+    vkq_size = list_size_;
+    vkq_bytes = list_data_;
+    release_function = list_release_function_;
+    release_user_data = list_release_user_data_;
+    list_data_ = nullptr;
+    if (VkQualityCompression::IsCompressed(vkq_bytes, vkq_size)) {
+      // The decoded copy replaces the container, which is released right away
+      size_t decoded_size = 0;
+      void *decoded_bytes = VkQualityCompression::Decompress(vkq_bytes, vkq_size, decoded_size);
+      if (release_function != nullptr) {
+        release_function(vkq_bytes, release_user_data);
+      }
+      if (decoded_bytes == nullptr) {
         return kErrorInvalidDataFile;
-      } else {
-        if (loaded_cache && cache_list_version_ == prediction_file_.GetListVersion()) {
-          quality_recommendation_ = cache_recommendation_;
-        } else {
-          VkQualityPredictionFile::FileMatchResult match_result =
-              prediction_file_.FindDeviceMatch(device_info, flags_);
-
-          switch (match_result) {
-            case VkQualityPredictionFile::kFileMatch_ExactDevice:
-            case VkQualityPredictionFile::kFileMatch_BrandWildcard:
-              quality_recommendation_ = kRecommendationVulkanBecauseDeviceMatch;
-              break;
-            case VkQualityPredictionFile::kFileMatch_DeviceOldVersion:
-              quality_recommendation_ = kRecommendationGLESBecauseOldDriver;
-              break;
-            case VkQualityPredictionFile::kFileMatch_DriverAllow:
-            case VkQualityPredictionFile::kFileMatch_GpuAllow:
-              quality_recommendation_ = kRecommendationVulkanBecausePredictionMatch;
-              break;
-            case VkQualityPredictionFile::kFileMatch_DriverDeny:
-            case VkQualityPredictionFile::kFileMatch_GpuDeny:
-              quality_recommendation_ = kRecommendationGLESBecausePredictionMatch;
-              break;
-            default:
-              quality_recommendation_ = kRecommendationGLESBecauseNoDeviceMatch;
-          }
+      }
+      vkq_size = decoded_size;
+      vkq_bytes = decoded_bytes;
+      release_function = VkQualityPredictionFile::FreeFileData;
+      release_user_data = nullptr;
+    }
+  } else {
+    if (asset_filename_.find(".vkq") == std::string::npos) {
+      return kSuccess;
+    }
+    // Only the selected file is loaded. If no candidate looks usable, fall back
+    // to the storage then asset search order so the load reports why
+    const ListSource list_source = SelectListSource(asset_manager_, storage_path_,
+                                                    asset_filename_);
+    shard_asset_manager = (list_source == kListSource_Storage) ? nullptr : asset_manager_;
+    list_from_asset = (list_source == kListSource_Asset);
+    shard_storage_path = (list_source == kListSource_Asset) ? std::string() : storage_path_;
+    vkQualityInitResult result = LoadFile(shard_asset_manager, shard_storage_path,
+                                          asset_filename_, vkq_size, &vkq_bytes);
+    if (result != kSuccess) {
+      return result;
+    }
+  }
 
-          if (quality_recommendation_ == kRecommendationGLESBecauseNoDeviceMatch &&
-              device_info.api_level >= prediction_file_.GetFutureAndroidAPILevel()) {
-            quality_recommendation_ = kRecommendationVulkanBecauseFutureAndroid;
-          }
-          cache_list_version_ = prediction_file_.GetListVersion();
-          SaveCache(device_info);
-        }
+  std::unique_ptr<VkQualityPredictionFile> prediction_file =
+      std::make_unique<VkQualityPredictionFile>();
+  // A cached recommendation never searches the file, so only check the
+  // sections a search actually uses
+  prediction_file->SetValidationMode(VkQualityPredictionFile::kValidation_Lazy);
+  if (list_from_asset && (flags_ & kInitFlagSkipAssetChecksum) != 0) {
+    prediction_file->SetVerifyChecksum(false);
+  }
+  if (shard_asset_manager != nullptr || !shard_storage_path.empty()) {
+    prediction_file->SetShardLoader([shard_asset_manager, shard_storage_path](
+        const char *shard_name, size_t &shard_size) -> void * {
+      void *shard_bytes = nullptr;
+      shard_size = 0;
+      if (LoadFile(shard_asset_manager, shard_storage_path, shard_name, shard_size,
+                   &shard_bytes) != kSuccess) {
+        return nullptr;
       }
+      return shard_bytes;
+    });
+  }
+  const VkQualityPredictionFile::FileParseResult parse_result =
+      prediction_file->ParseFileData(vkq_bytes, vkq_size, VkQuality_getVersion(),
+                                     release_function, release_user_data);
+  if (parse_result != VkQualityPredictionFile::kFileParseResult_Success) {
+    ALOGE("Parsing VkQuality data file failed for reason: %s",
+          prediction_file->GetParseErrorString().c_str());
+    if (release_function != nullptr) {
+      release_function(vkq_bytes, release_user_data);
+    }
+    if (parse_result == VkQualityPredictionFile::kFileParseResult_Error_LibraryTooOldForFile) {
+      return kErrorInvalidDataVersion;
     }
+    return kErrorInvalidDataFile;
   }
 
-  return result;
+  LoadHotfix(*prediction_file);
+
+  const int32_t list_version = static_cast<int32_t>(prediction_file->GetListVersion());
+  const int32_t overlay_version =
+      static_cast<int32_t>(prediction_file->GetOverlayListVersion());
+  const uint32_t list_checksum = prediction_file->GetContentChecksum();
+  vkQualityRecommendation recommendation;
+  if (use_cache && cache_list_version_ == list_version &&
+      cache_overlay_version_ == overlay_version && cache_list_checksum_ == list_checksum) {
+    recommendation = cache_recommendation_;
+  } else if (device_candidates_.count > 1) {
+    uint32_t candidate_index = 0;
+    recommendation = VkQualityEvaluator::EvaluateCandidates(*prediction_file, device_candidates_,
+                                                            flags_, device_info_,
+                                                            candidate_index);
+    recommended_device_index_ = static_cast<int32_t>(
+        device_candidates_.candidates[candidate_index].physical_device_index);
+  } else {
+    const VkQualityPredictionFile::FileMatchResult match_result =
+        prediction_file->FindDeviceMatch(device_info_, flags_);
+    recommendation = VkQualityEvaluator::GetMatchRecommendation(
+        match_result, device_info_, prediction_file->GetFutureAndroidAPILevel());
+  }
+
+  // The file is released here, only the recommendation and the device info for
+  // reloads are kept
+  prediction_file.reset();
+  quality_recommendation_ = recommendation;
+
+  if (cache_list_version_ != list_version || cache_overlay_version_ != overlay_version ||
+      cache_list_checksum_ != list_checksum) {
+    cache_list_version_ = list_version;
+    cache_overlay_version_ = overlay_version;
+    cache_list_checksum_ = list_checksum;
+    SaveCache(device_info_);
+  }
+  return kSuccess;
 }
 
+vkQualityInitResult VkQualityManager::ReloadRecommendation() {
+  std::lock_guard<std::mutex> lock(reload_mutex_);
+  if (!device_info_valid_) {
+    // Old devices get a GLES recommendation regardless of list contents
+    return (quality_recommendation_ == kRecommendationGLESBecauseOldDevice) ?
+        kSuccess : kErrorInitializationFailure;
+  }
+  const vkQualityInitResult result = LoadRecommendation(false);
+  if (result != kSuccess) {
+    ALOGE("Reloading VkQuality data file failed, keeping previous recommendation");
+  }
+  return result;
+}
 
+void VkQualityManager::StartListWatcher() {
+  if (storage_path_.empty() || asset_filename_.empty()) {
+    return;
+  }
+  list_watcher_ = std::make_unique<VkQualityListWatcher>(storage_path_, asset_filename_,
+                                                         [this]() {
+    ReloadRecommendation();
+  });
+  if (!list_watcher_->Start()) {
+    ALOGE("Unable to watch %s for data file changes", storage_path_.c_str());
+    list_watcher_.reset();
+  }
+}
 
 } // namespace vkquality
 
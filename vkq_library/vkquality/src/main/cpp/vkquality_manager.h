@@ -18,7 +18,11 @@
 #define VKQUALITY_UTIL_H_
 
 #include "vkquality.h"
+#include "vkquality_list_watcher.h"
+#include "vkquality_compression.h"
+#include "vkquality_device_probe.h"
 #include "vkquality_prediction_file.h"
+#include <atomic>
 #include <jni.h>
 #include <memory>
 #include <mutex>
@@ -28,12 +32,16 @@ namespace vkquality {
 
 static constexpr uint32_t kCacheSchemaVersion = 2;
 
+// A VkQualityManager is an independent recommendation context. Contexts can be
+// created directly through the vkQualityContext handle API, the vkQuality_*
+// functions operate on a single process-wide default context
 class VkQualityManager {
  private:
-  // Allows construction with std::unique_ptr from a static method, but
-  // disallows construction outside of the class since no one else can
-  // construct a ConstructorTag
-  struct ConstructorTag {};
+  enum ListSource : int32_t {
+    kListSource_None = 0,
+    kListSource_Storage,
+    kListSource_Asset
+  };
 
   struct CacheFile {
     int32_t schema_version;
@@ -42,39 +50,76 @@ class VkQualityManager {
     uint32_t device_id;
     uint32_t vendor_id;
     uint32_t driver_version;
-    int32_t reserved;
-    int32_t reserved2;
+    // Zero when no hotfix overlay was applied
+    int32_t overlay_list_version;
+    // Content checksum of the data file, zero if it has none
+    uint32_t list_checksum;
   };
 
  public:
-  VkQualityManager(JNIEnv *env, AAssetManager *asset_manager,
-                   const char *storage_path, const char *asset_filename, 
-                   const vkqGraphicsAPIInfo *api_info, int32_t flags,
-                   ConstructorTag);
+  VkQualityManager(AAssetManager *asset_manager, const char *storage_path,
+                   const char *asset_filename, int32_t flags);
+
+  ~VkQualityManager();
+
+  VkQualityManager(const VkQualityManager &) = delete;
+  VkQualityManager &operator=(const VkQualityManager &) = delete;
+
+  // Use quality data file contents in memory instead of loading the data file,
+  // the data is consumed by the next StartRecommendation call. Data that is never
+  // consumed is released when the manager is destroyed
+  void SetListData(void *list_data, size_t list_size,
+                   VkQualityPredictionFile::FileDataRelease release_function,
+                   void *release_user_data);
+
+  vkQualityInitResult StartRecommendation(JNIEnv *env, const vkqGraphicsAPIInfo *api_info);
 
-  ~VkQualityManager() = default;
+  vkQualityInitResult ReloadRecommendation();
 
+  vkQualityRecommendation GetRecommendation() const { return quality_recommendation_; }
+
+  // Index in vkEnumeratePhysicalDevices order of the device the recommendation
+  // is for, -1 if no physical devices were probed
+  int32_t GetRecommendedDeviceIndex() const { return recommended_device_index_; }
+
+  // Default context functions
   static vkQualityInitResult Init(JNIEnv *env, AAssetManager *asset_manager,
                                   const char *storage_path,
                                   const char *asset_filename,
                                   const vkqGraphicsAPIInfo *api_info,
                                   int32_t flags);
 
+  static vkQualityInitResult InitFromMemory(JNIEnv *env, void *list_data, size_t list_size,
+                                            VkQualityPredictionFile::FileDataRelease
+                                                release_function,
+                                            void *release_user_data,
+                                            const char *storage_path,
+                                            const vkqGraphicsAPIInfo *api_info,
+                                            int32_t flags);
+
   static void DestroyInstance(JNIEnv *env);
 
+  static vkQualityInitResult Reload();
+
   static vkQualityRecommendation GetQualityRecommendation();
 
+  static int32_t GetQualityRecommendedDeviceIndex();
+
  private:
 
-  static VkQualityManager* GetInstance();
+  static std::shared_ptr<VkQualityManager> GetInstance();
 
   static std::string GetStaticStringField(JNIEnv *env, jclass clz,
                                           const char *name);
 
+  // candidates is empty when the Vulkan fields come from api_info
   static vkQualityInitResult InitDeviceInfo(JNIEnv *env, DeviceInfo &device_info,
+                                            VkQualityDeviceCandidates &candidates,
                                             const vkqGraphicsAPIInfo *api_info);
 
-  bool LoadCache(const DeviceInfo &device_info);
+  // With several probed devices, the cache may be for any of them, device_info
+  // receives the Vulkan fields of the cached device
+  bool LoadCache(DeviceInfo &device_info);
 
   void SaveCache(const DeviceInfo &device_info);
 
@@ -83,28 +128,70 @@ class VkQualityManager {
                                       const std::string &file_name,
                                       size_t &file_size, void **file_bytes);
 
+  // Reads a whole data file of stored_size bytes, decoding compressed containers
+  static vkQualityInitResult ReadFileData(const VkQualityCompression::ReadFunction &read_function,
+                                          const size_t stored_size, size_t &file_size,
+                                          void **file_bytes);
+
+  static bool ReadListHeader(AAssetManager *asset_manager,
+                             const std::string &storage_path,
+                             const std::string &file_name,
+                             const ListSource source,
+                             VkQualityFileHeader &header);
+
+  static ListSource SelectListSource(AAssetManager *asset_manager,
+                                     const std::string &storage_path,
+                                     const std::string &file_name);
+
   static bool SaveFile(const std::string &storage_path,
                        const std::string &file_name,
                        const size_t file_size, const void *file_bytes);
 
-  vkQualityInitResult StartRecommendation();
+  // A hotfix list in the storage directory named after the data file, with
+  // _hotfix before the .vkq extension
+  static std::string GetHotfixFilename(const std::string &file_name);
+
+  // Stacks the hotfix list on the prediction file if one is present and usable
+  void LoadHotfix(VkQualityPredictionFile &prediction_file) const;
+
+  vkQualityInitResult LoadRecommendation(const bool use_cache) REQUIRES(reload_mutex_);
+
+  void StartListWatcher();
 
   AAssetManager *asset_manager_ = nullptr;
-  JNIEnv *env_ = nullptr;
   std::string asset_filename_;
   std::string storage_path_;
-  const vkqGraphicsAPIInfo *api_info_ = nullptr;
+
+  // Pending in-memory file data set by SetListData
+  void *list_data_ = nullptr;
+  size_t list_size_ = 0;
+  VkQualityPredictionFile::FileDataRelease list_release_function_ = nullptr;
+  void *list_release_user_data_ = nullptr;
 
   int32_t cache_list_version_ = -1;
+  int32_t cache_overlay_version_ = 0;
+  uint32_t cache_list_checksum_ = 0;
   int32_t flags_ = 0;
 
-  VkQualityPredictionFile prediction_file_;
+  // Device info is retained after a successful probe so list reloads can be
+  // re-evaluated without standing up graphics APIs or calling into JNI again
+  DeviceInfo device_info_;
+  bool device_info_valid_ = false;
+  // Every probed physical device with a graphics queue, each is evaluated
+  // when there is more than one
+  VkQualityDeviceCandidates device_candidates_;
+  std::atomic<int32_t> recommended_device_index_{-1};
+
 
   vkQualityRecommendation cache_recommendation_ = kRecommendationErrorNotInitialized;
-  vkQualityRecommendation quality_recommendation_ = kRecommendationErrorNotInitialized;
+  std::atomic<vkQualityRecommendation> quality_recommendation_{
+      kRecommendationErrorNotInitialized};
+
+  std::mutex reload_mutex_;
+  std::unique_ptr<VkQualityListWatcher> list_watcher_;
 
   static std::mutex instance_mutex_;
-  static std::unique_ptr<VkQualityManager> instance_ GUARDED_BY(instance_mutex_);
+  static std::shared_ptr<VkQualityManager> instance_ GUARDED_BY(instance_mutex_);
 };
 
 } // namespace vkquality
@@ -202,4 +202,45 @@ VkQualityPredictionFile::FileMatchResult VkQualityMatching::CheckGpuMatch(
   return VkQualityPredictionFile::kFileMatch_None;
 }
 
+bool VkQualityMatching::CheckDriverRuleMatch(const DeviceInfo &device_info,
+                                             const VkQualityDriverRuleEntry &rule,
+                                             DriverVersionCache &version_cache) {
+  const uint32_t version_format = rule.version_format;
+  if (version_format == 0 || version_format >= VkQualityDriverVersion::kVersionFormat_Count ||
+      (rule.vendor_id != 0 && rule.vendor_id != device_info.vk_vendor_id)) {
+    return false;
+  }
+  if (!version_cache.parsed[version_format]) {
+    version_cache.parsed[version_format] = true;
+    if (version_format == VkQualityDriverVersion::kVersionFormat_Vulkan) {
+      version_cache.valid[version_format] = (device_info.vk_driver_version != 0);
+      version_cache.versions[version_format] = VkQualityDriverVersion::DecodeVulkanDriverVersion(
+          device_info.vk_vendor_id, device_info.vk_driver_version);
+    } else {
+      version_cache.valid[version_format] = VkQualityDriverVersion::ParseGlesVersion(
+          device_info.gles_version.c_str(),
+          static_cast<VkQualityDriverVersion::VersionFormat>(version_format),
+          version_cache.versions[version_format]);
+    }
+  }
+  const uint64_t version = version_cache.versions[version_format];
+  return version_cache.valid[version_format] &&
+      (rule.min_driver_version == 0 || version >= rule.min_driver_version) &&
+      (rule.max_driver_version == 0 || version <= rule.max_driver_version);
+}
+
+bool VkQualityMatching::CheckCapabilityRuleMatch(const DeviceInfo &device_info,
+                                                 const VkQualityCapabilityRuleEntry &rule) {
+  // A bit the library doesn't probe can't be told apart from a missing capability
+  const uint64_t rule_capabilities = rule.required_capabilities | rule.forbidden_capabilities;
+  if ((rule_capabilities & ~VkQualityCapabilities::kKnownCapabilities) != 0 ||
+      (rule.vendor_id != 0 && rule.vendor_id != device_info.vk_vendor_id)) {
+    return false;
+  }
+  // Every required and forbidden bit, and that the device was probed, in one compare
+  return (device_info.vk_capabilities &
+          (rule_capabilities | VkQualityCapabilities::kCapability_Probed)) ==
+      (rule.required_capabilities | VkQualityCapabilities::kCapability_Probed);
+}
+
 }
\ No newline at end of file
@@ -17,6 +17,8 @@
 #ifndef VKQUALITY_MATCHING_H_
 #define VKQUALITY_MATCHING_H_
 
+#include "vkquality_capabilities.h"
+#include "vkquality_driver_version.h"
 #include "vkquality_prediction_file.h"
 #include <string_view>
 
@@ -55,6 +57,23 @@ public:
       const uint32_t min_api,
       const uint32_t min_driver,
       const VkQualityPredictionFile::FileMatchResult match_result);
+
+  // Driver versions of a device, parsed from its GL version string or decoded
+  // from its Vulkan driver version the first time a rule of the format is checked
+  struct DriverVersionCache {
+    uint64_t versions[VkQualityDriverVersion::kVersionFormat_Count] = {};
+    bool parsed[VkQualityDriverVersion::kVersionFormat_Count] = {};
+    bool valid[VkQualityDriverVersion::kVersionFormat_Count] = {};
+  };
+
+  // Checks the vendor and version range of a driver rule, the caller matches the SoC
+  static bool CheckDriverRuleMatch(const DeviceInfo &device_info,
+                                   const VkQualityDriverRuleEntry &rule,
+                                   DriverVersionCache &version_cache);
+
+  // Checks the vendor and capability bits of a capability rule
+  static bool CheckCapabilityRuleMatch(const DeviceInfo &device_info,
+                                       const VkQualityCapabilityRuleEntry &rule);
 };
 
 }
@@ -0,0 +1,762 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vkquality_paged_file.h"
+#include "vkquality_checksum.h"
+#include "vkquality_compression.h"
+#include "vkquality_core.h"
+#include "vkquality_matching.h"
+#include <algorithm>
+#include <string.h>
+#include <strings.h>
+
+namespace vkquality {
+
+VkQualityPagedFile::VkQualityPagedFile(ReadFunction read_function, const uint64_t file_size,
+                                       const uint32_t page_size, const uint32_t page_count) :
+    read_function_(std::move(read_function)),
+    file_size_(file_size),
+    page_size_(std::max(page_size, 16U)),
+    page_data_(static_cast<size_t>(page_size_) * std::max(page_count, 1U)),
+    pages_(std::max(page_count, 1U)) {
+  file_parse_error_ = "No error";
+}
+
+const uint8_t *VkQualityPagedFile::GetPage(const uint64_t page_index, size_t &valid_size) {
+  // Least recently used page is replaced, the cache is only a few pages so a
+  // scan is cheaper than keeping a list
+  size_t replace_slot = 0;
+  for (size_t i = 0; i < pages_.size(); ++i) {
+    if (pages_[i].page_index == page_index) {
+      pages_[i].last_use = ++page_use_counter_;
+      valid_size = pages_[i].valid_size;
+      return page_data_.data() + (i * page_size_);
+    }
+    if (pages_[i].last_use < pages_[replace_slot].last_use) {
+      replace_slot = i;
+    }
+  }
+
+  CachePage &page = pages_[replace_slot];
+  uint8_t *page_start = page_data_.data() + (replace_slot * page_size_);
+  const uint64_t page_offset = page_index * page_size_;
+  const size_t read_size = static_cast<size_t>(
+      std::min<uint64_t>(page_size_, file_size_ - page_offset));
+  ++page_read_count_;
+  if (read_function_(page_offset, page_start, read_size) != read_size) {
+    page.page_index = UINT64_MAX;
+    page.last_use = 0;
+    return nullptr;
+  }
+  page.page_index = page_index;
+  page.valid_size = read_size;
+  page.last_use = ++page_use_counter_;
+  valid_size = read_size;
+  return page_start;
+}
+
+bool VkQualityPagedFile::Read(const uint64_t offset, void *buffer, const size_t size) {
+  if (offset > file_size_ || size > file_size_ - offset) {
+    return false;
+  }
+  uint8_t *destination = reinterpret_cast<uint8_t *>(buffer);
+  uint64_t read_offset = offset;
+  size_t remaining = size;
+  while (remaining > 0) {
+    size_t valid_size = 0;
+    const uint8_t *page = GetPage(read_offset / page_size_, valid_size);
+    const size_t page_offset = static_cast<size_t>(read_offset % page_size_);
+    if (page == nullptr || page_offset >= valid_size) {
+      return false;
+    }
+    const size_t copy_size = std::min(remaining, valid_size - page_offset);
+    memcpy(destination, page + page_offset, copy_size);
+    destination += copy_size;
+    read_offset += copy_size;
+    remaining -= copy_size;
+  }
+  return true;
+}
+
+const char *VkQualityPagedFile::ReadString(const uint32_t string_index,
+                                           std::string &string_buffer) {
+  // Same bounds rules as VkQualityPredictionFile::GetString, a string without a
+  // terminator before the end of the file is the null string
+  string_buffer.clear();
+  uint32_t string_offset = 0;
+  if (!ReadEntry(string_offsets_, string_index, string_offset)) {
+    return string_buffer.c_str();
+  }
+  uint64_t read_offset = string_offset;
+  while (read_offset < file_size_ && string_buffer.size() < kMax_String_Length) {
+    size_t valid_size = 0;
+    const uint8_t *page = GetPage(read_offset / page_size_, valid_size);
+    const size_t page_offset = static_cast<size_t>(read_offset % page_size_);
+    if (page == nullptr || page_offset >= valid_size) {
+      break;
+    }
+    const char *chars = reinterpret_cast<const char *>(page + page_offset);
+    const size_t chars_size = valid_size - page_offset;
+    const size_t string_length = strnlen(chars, chars_size);
+    string_buffer.append(chars, string_length);
+    if (string_length < chars_size) {
+      return string_buffer.c_str();
+    }
+    read_offset += chars_size;
+  }
+  string_buffer.clear();
+  return string_buffer.c_str();
+}
+
+bool VkQualityPagedFile::CheckTable(const FileTable &table, const size_t entry_size,
+                                    const char *name) {
+  if (table.offset + (static_cast<uint64_t>(table.count) * entry_size) > file_size_) {
+    file_parse_error_ = std::string("Invalid file: ") + name + " overflows end of file";
+    return false;
+  }
+  return true;
+}
+
+VkQualityPredictionFile::FileParseResult VkQualityPagedFile::Open(
+    const uint32_t library_version) {
+  if (opened_) {
+    return VkQualityPredictionFile::kFileParseResult_Success;
+  }
+  if (file_size_ < sizeof(VkQualityFileHeader) ||
+      !Read(0, &file_header_, sizeof(VkQualityFileHeader))) {
+    file_parse_error_ = "File smaller than header size";
+    return VkQualityPredictionFile::kFileParseResult_Error_TooSmall;
+  }
+  if (file_header_.file_identifier != VkQualityPredictionFile::kVkQuality_File_Identifier) {
+    // Including compressed containers, which would need decoding as a whole
+    file_parse_error_ = VkQualityCompression::IsCompressed(&file_header_, sizeof(file_header_)) ?
+        "Compressed files can't be read in pages" : "File identifier invalid";
+    return VkQualityPredictionFile::kFileParseResult_Error_InvalidIdentifier;
+  }
+  if (file_header_.library_minimum_version > library_version) {
+    file_parse_error_ = "File minimum library version is newer than the library";
+    return VkQualityPredictionFile::kFileParseResult_Error_LibraryTooOldForFile;
+  }
+
+  // Same order and results as VkQualityPredictionFile::ValidateFile
+  device_table_ = {file_header_.device_list_offset, file_header_.device_list_count};
+  driver_allow_table_ = {file_header_.driver_allow_offset, file_header_.driver_allow_count};
+  driver_deny_table_ = {file_header_.driver_deny_offset, file_header_.driver_deny_count};
+  gpu_allow_table_ = {file_header_.gpu_allow_predict_offset,
+                      file_header_.gpu_allow_predict_count};
+  gpu_deny_table_ = {file_header_.gpu_deny_predict_offset, file_header_.gpu_deny_predict_count};
+  soc_allow_table_ = {file_header_.soc_allow_offset, file_header_.soc_allow_count};
+  soc_deny_table_ = {file_header_.soc_deny_offset, file_header_.soc_deny_count};
+  string_offsets_ = {file_header_.string_table_offset, file_header_.string_table_count};
+  device_shortcuts_ = {file_header_.device_list_shortcuts_offset,
+                       VkQualityPredictionFile::kShortcut_Offset_Count};
+  if (!CheckTable(device_table_, sizeof(VkQualityDeviceAllowListEntry), "Device list")) {
+    return VkQualityPredictionFile::kFileParseResult_Error_DeviceListOverflow;
+  }
+  if (!CheckTable(driver_allow_table_, sizeof(VkQualityDriverFingerprintEntry),
+                  "driver allow list")) {
+    return VkQualityPredictionFile::kFileParseResult_Error_DriverAllowOverflow;
+  }
+  if (!CheckTable(driver_deny_table_, sizeof(VkQualityDriverFingerprintEntry),
+                  "driver deny list")) {
+    return VkQualityPredictionFile::kFileParseResult_Error_DriverDenyOverflow;
+  }
+  if (!CheckTable(gpu_allow_table_, sizeof(VkQualityGpuPredictEntry), "GPU allow list")) {
+    return VkQualityPredictionFile::kFileParseResult_Error_GpuAllowOverflow;
+  }
+  if (!CheckTable(gpu_deny_table_, sizeof(VkQualityGpuPredictEntry), "GPU deny list")) {
+    return VkQualityPredictionFile::kFileParseResult_Error_GpuDenyOverflow;
+  }
+  if (!CheckTable(soc_allow_table_, sizeof(VkQualityDriverSoCEntry), "SoC allow list")) {
+    return VkQualityPredictionFile::kFileParseResult_Error_SoCAllowOverflow;
+  }
+  if (!CheckTable(soc_deny_table_, sizeof(VkQualityDriverSoCEntry), "soc deny list")) {
+    return VkQualityPredictionFile::kFileParseResult_Error_SoCDenyOverflow;
+  }
+  if (!CheckTable(string_offsets_, sizeof(uint32_t), "string table offset list")) {
+    return VkQualityPredictionFile::kFileParseResult_Error_StringOffsetOverflow;
+  }
+  if (!CheckTable(device_shortcuts_, sizeof(uint32_t), "shortcut offset list")) {
+    return VkQualityPredictionFile::kFileParseResult_Error_ShortcutOverflow;
+  }
+
+  // A shortcut table that is out of order is treated like an unpopulated one,
+  // as in a lazily validated prediction file. String offsets are checked as
+  // each string is read.
+  uint32_t shortcuts[VkQualityPredictionFile::kShortcut_Offset_Count];
+  if (!Read(device_shortcuts_.offset, shortcuts, sizeof(shortcuts))) {
+    return VkQualityPredictionFile::kFileParseResult_Error_ShortcutOverflow;
+  }
+  uint32_t previous_shortcut = 0;
+  bool shortcuts_populated = false;
+  for (const uint32_t shortcut : shortcuts) {
+    if (shortcut < previous_shortcut || shortcut > file_header_.device_list_count) {
+      shortcuts_populated = false;
+      break;
+    }
+    shortcuts_populated |= (shortcut != 0);
+    previous_shortcut = shortcut;
+  }
+  if (!shortcuts_populated) {
+    device_shortcuts_.count = 0;
+  }
+
+  const VkQualityPredictionFile::FileParseResult result = ReadSectionTable();
+  if (result == VkQualityPredictionFile::kFileParseResult_Success) {
+    opened_ = true;
+  }
+  return result;
+}
+
+VkQualityPredictionFile::FileParseResult VkQualityPagedFile::ReadSectionTable() {
+  if (file_header_.file_format_version < VkQualityPredictionFile::kSectionTable_File_Format_Version) {
+    return VkQualityPredictionFile::kFileParseResult_Success;
+  }
+  VkQualityFileSectionTable section_table;
+  if (!Read(sizeof(VkQualityFileHeader), &section_table, sizeof(section_table))) {
+    file_parse_error_ = "Invalid file: section table overflows end of file";
+    return VkQualityPredictionFile::kFileParseResult_Error_SectionTableOverflow;
+  }
+  if (section_table.section_table_identifier !=
+      VkQualityPredictionFile::kVkQuality_Section_Table_Identifier) {
+    file_parse_error_ = "Section table identifier invalid";
+    return VkQualityPredictionFile::kFileParseResult_Error_InvalidIdentifier;
+  }
+  const uint64_t entries_offset = sizeof(VkQualityFileHeader) + sizeof(section_table);
+  if (entries_offset + (static_cast<uint64_t>(section_table.section_count) *
+                        sizeof(VkQualityFileSectionEntry)) > file_size_) {
+    file_parse_error_ = "Invalid file: section table entries overflow end of file";
+    return VkQualityPredictionFile::kFileParseResult_Error_SectionTableOverflow;
+  }
+
+  // Only the brand index, brand aliases, rules and checksum are used,
+  // the first of a repeated section wins
+  const VkQualityFileSectionEntry *brand_index_entry = nullptr;
+  const VkQualityFileSectionEntry *brand_aliases_entry = nullptr;
+  const VkQualityFileSectionEntry *driver_allow_rules_entry = nullptr;
+  const VkQualityFileSectionEntry *driver_deny_rules_entry = nullptr;
+  const VkQualityFileSectionEntry *capability_allow_rules_entry = nullptr;
+  const VkQualityFileSectionEntry *capability_deny_rules_entry = nullptr;
+  const VkQualityFileSectionEntry *checksum_entry = nullptr;
+  VkQualityFileSectionEntry brand_index_section = {};
+  VkQualityFileSectionEntry brand_aliases_section = {};
+  VkQualityFileSectionEntry driver_allow_rules_section = {};
+  VkQualityFileSectionEntry driver_deny_rules_section = {};
+  VkQualityFileSectionEntry capability_allow_rules_section = {};
+  VkQualityFileSectionEntry capability_deny_rules_section = {};
+  VkQualityFileSectionEntry checksum_section = {};
+  for (uint32_t i = 0; i < section_table.section_count; ++i) {
+    VkQualityFileSectionEntry entry;
+    if (!Read(entries_offset + (static_cast<uint64_t>(i) * sizeof(entry)), &entry,
+              sizeof(entry))) {
+      return VkQualityPredictionFile::kFileParseResult_Error_SectionTableOverflow;
+    }
+    if (static_cast<uint64_t>(entry.section_offset) + entry.section_size > file_size_) {
+      file_parse_error_ = "Invalid file: section overflows end of file";
+      return VkQualityPredictionFile::kFileParseResult_Error_SectionOverflow;
+    }
+    if (entry.section_id == VkQualityPredictionFile::kFileSection_BrandIndex &&
+        brand_index_entry == nullptr) {
+      brand_index_section = entry;
+      brand_index_entry = &brand_index_section;
+    } else if (entry.section_id == VkQualityPredictionFile::kFileSection_BrandAliases &&
+               brand_aliases_entry == nullptr) {
+      brand_aliases_section = entry;
+      brand_aliases_entry = &brand_aliases_section;
+    } else if (entry.section_id == VkQualityPredictionFile::kFileSection_DriverAllowRules &&
+               driver_allow_rules_entry == nullptr) {
+      driver_allow_rules_section = entry;
+      driver_allow_rules_entry = &driver_allow_rules_section;
+    } else if (entry.section_id == VkQualityPredictionFile::kFileSection_DriverDenyRules &&
+               driver_deny_rules_entry == nullptr) {
+      driver_deny_rules_section = entry;
+      driver_deny_rules_entry = &driver_deny_rules_section;
+    } else if (entry.section_id == VkQualityPredictionFile::kFileSection_CapabilityAllowRules &&
+               capability_allow_rules_entry == nullptr) {
+      capability_allow_rules_section = entry;
+      capability_allow_rules_entry = &capability_allow_rules_section;
+    } else if (entry.section_id == VkQualityPredictionFile::kFileSection_CapabilityDenyRules &&
+               capability_deny_rules_entry == nullptr) {
+      capability_deny_rules_section = entry;
+      capability_deny_rules_entry = &capability_deny_rules_section;
+    } else if (entry.section_id == VkQualityPredictionFile::kFileSection_Checksum &&
+               checksum_entry == nullptr) {
+      checksum_section = entry;
+      checksum_entry = &checksum_section;
+    }
+  }
+
+  if (checksum_entry != nullptr) {
+    const VkQualityPredictionFile::FileParseResult result =
+        VerifyChecksum(checksum_entry->section_offset, checksum_entry->section_size);
+    if (result != VkQualityPredictionFile::kFileParseResult_Success) {
+      return result;
+    }
+  }
+
+  // Entry ranges and device indices of the brand index are checked as they are read
+  VkQualityBrandIndexHeader index_header;
+  if (brand_index_entry != nullptr &&
+      brand_index_entry->section_size >= sizeof(index_header) &&
+      Read(brand_index_entry->section_offset, &index_header, sizeof(index_header))) {
+    const uint64_t index_size = sizeof(VkQualityBrandIndexHeader) +
+        (static_cast<uint64_t>(index_header.brand_count) * sizeof(VkQualityBrandIndexEntry)) +
+        (static_cast<uint64_t>(index_header.device_index_count) * sizeof(uint32_t));
+    if (index_size <= brand_index_entry->section_size) {
+      brand_index_entries_ = {brand_index_entry->section_offset + sizeof(index_header),
+                              index_header.brand_count};
+      brand_device_index_ = {brand_index_entries_.offset +
+                                 (static_cast<uint64_t>(index_header.brand_count) *
+                                  sizeof(VkQualityBrandIndexEntry)),
+                             index_header.device_index_count};
+    }
+  }
+
+  // Alias string indices are checked as they are read
+  VkQualityBrandAliasHeader aliases_header;
+  if (brand_aliases_entry != nullptr &&
+      brand_aliases_entry->section_size >= sizeof(aliases_header) &&
+      Read(brand_aliases_entry->section_offset, &aliases_header, sizeof(aliases_header))) {
+    const uint64_t aliases_size = sizeof(VkQualityBrandAliasHeader) +
+        (static_cast<uint64_t>(aliases_header.alias_count) * sizeof(VkQualityBrandAliasEntry));
+    if (aliases_size <= brand_aliases_entry->section_size) {
+      brand_aliases_ = {brand_aliases_entry->section_offset + sizeof(aliases_header),
+                        aliases_header.alias_count};
+    }
+  }
+
+  // Rule SoC string indices are checked as they are read
+  if (driver_allow_rules_entry != nullptr) {
+    ReadRules<VkQualityDriverRulesHeader, VkQualityDriverRuleEntry>(*driver_allow_rules_entry,
+                                                                    driver_allow_rules_);
+  }
+  if (driver_deny_rules_entry != nullptr) {
+    ReadRules<VkQualityDriverRulesHeader, VkQualityDriverRuleEntry>(*driver_deny_rules_entry,
+                                                                    driver_deny_rules_);
+  }
+  // A rule with overlapping capability masks never matches
+  if (capability_allow_rules_entry != nullptr) {
+    ReadRules<VkQualityCapabilityRulesHeader, VkQualityCapabilityRuleEntry>(
+        *capability_allow_rules_entry, capability_allow_rules_);
+  }
+  if (capability_deny_rules_entry != nullptr) {
+    ReadRules<VkQualityCapabilityRulesHeader, VkQualityCapabilityRuleEntry>(
+        *capability_deny_rules_entry, capability_deny_rules_);
+  }
+  return VkQualityPredictionFile::kFileParseResult_Success;
+}
+
+template<typename RulesHeader, typename RuleEntry>
+void VkQualityPagedFile::ReadRules(const VkQualityFileSectionEntry &section,
+                                   FileTable &rule_table) {
+  RulesHeader rules_header;
+  if (section.section_size >= sizeof(rules_header) &&
+      Read(section.section_offset, &rules_header, sizeof(rules_header))) {
+    const uint64_t rules_size = sizeof(RulesHeader) +
+        (static_cast<uint64_t>(rules_header.rule_count) * sizeof(RuleEntry));
+    if (rules_size <= section.section_size) {
+      rule_table = {section.section_offset + sizeof(rules_header), rules_header.rule_count};
+    }
+  }
+}
+
+VkQualityPredictionFile::FileParseResult VkQualityPagedFile::VerifyChecksum(
+    const uint64_t checksum_offset, const uint32_t checksum_size) {
+  VkQualityChecksumSection checksum_section;
+  if (checksum_size != sizeof(checksum_section) ||
+      !Read(checksum_offset, &checksum_section, sizeof(checksum_section))) {
+    file_parse_error_ = "Invalid file: checksum section size mismatch";
+    return VkQualityPredictionFile::kFileParseResult_Error_ChecksumInvalid;
+  }
+  if (!verify_checksum_ ||
+      checksum_section.algorithm != VkQualityPredictionFile::kChecksum_Crc32c) {
+    return VkQualityPredictionFile::kFileParseResult_Success;
+  }
+  if (checksum_section.file_size != file_size_) {
+    file_parse_error_ = "Invalid file: checksum mismatch, file size differs";
+    return VkQualityPredictionFile::kFileParseResult_Error_ChecksumMismatch;
+  }
+
+  // Streamed through the first cache page, which is invalidated afterwards. The
+  // checksum field is hashed as zero, see ComputeFileChecksum.
+  const uint64_t field_offset = checksum_offset + offsetof(VkQualityChecksumSection, checksum);
+  uint8_t *chunk = page_data_.data();
+  uint32_t checksum = 0;
+  bool read_failed = false;
+  for (uint64_t offset = 0; offset < file_size_; offset += page_size_) {
+    const size_t chunk_size = static_cast<size_t>(std::min<uint64_t>(page_size_,
+                                                                     file_size_ - offset));
+    ++page_read_count_;
+    if (read_function_(offset, chunk, chunk_size) != chunk_size) {
+      read_failed = true;
+      break;
+    }
+    for (uint64_t i = std::max(offset, field_offset);
+         i < std::min(offset + chunk_size, field_offset + sizeof(uint32_t)); ++i) {
+      chunk[i - offset] = 0;
+    }
+    checksum = VkQualityChecksum::Crc32c(checksum, chunk, chunk_size);
+  }
+  pages_[0].page_index = UINT64_MAX;
+  pages_[0].last_use = 0;
+  if (read_failed || checksum != checksum_section.checksum) {
+    file_parse_error_ = "Invalid file: checksum mismatch";
+    return VkQualityPredictionFile::kFileParseResult_Error_ChecksumMismatch;
+  }
+  return VkQualityPredictionFile::kFileParseResult_Success;
+}
+
+VkQualityPredictionFile::FileMatchResult VkQualityPagedFile::FindDeviceMatch(
+    const DeviceInfo &device_info, const int32_t flags, uint32_t *match_index) {
+  uint32_t found_index = 0;
+  VkQualityPredictionFile::FileMatchResult result = VkQualityPredictionFile::kFileMatch_None;
+  if (!opened_) {
+    if (match_index != nullptr) {
+      *match_index = 0;
+    }
+    return result;
+  }
+
+  // Same priority order as VkQualityPredictionFile::FindDeviceMatch
+  result = SearchCapabilityRules(device_info, VkQualityPredictionFile::kFileMatch_CapabilityDeny,
+                                 found_index);
+  if (result == VkQualityPredictionFile::kFileMatch_None &&
+      (flags & kInitFlagSkipFingerprintRecommendationCheck) == 0) {
+    result = SearchDriverList(device_info, VkQualityPredictionFile::kFileMatch_DriverAllow,
+                              found_index);
+    if (result == VkQualityPredictionFile::kFileMatch_None) {
+      result = SearchDriverList(device_info, VkQualityPredictionFile::kFileMatch_DriverDeny,
+                                found_index);
+    }
+    if (result == VkQualityPredictionFile::kFileMatch_None) {
+      result = SearchDriverRules(device_info, VkQualityPredictionFile::kFileMatch_DriverRuleAllow,
+                                 found_index);
+    }
+    if (result == VkQualityPredictionFile::kFileMatch_None) {
+      result = SearchDriverRules(device_info, VkQualityPredictionFile::kFileMatch_DriverRuleDeny,
+                                 found_index);
+    }
+  }
+  if (result == VkQualityPredictionFile::kFileMatch_None) {
+    DeviceInfo keyed_info;
+    result = SearchDeviceList(GetKeyedDeviceInfo(device_info, keyed_info), found_index);
+  }
+  if (result == VkQualityPredictionFile::kFileMatch_None) {
+    result = SearchGpuList(device_info, VkQualityPredictionFile::kFileMatch_GpuAllow,
+                           found_index);
+  }
+  if (result == VkQualityPredictionFile::kFileMatch_None) {
+    result = SearchGpuList(device_info, VkQualityPredictionFile::kFileMatch_GpuDeny,
+                           found_index);
+  }
+  if (result == VkQualityPredictionFile::kFileMatch_None) {
+    result = SearchCapabilityRules(device_info,
+                                   VkQualityPredictionFile::kFileMatch_CapabilityAllow,
+                                   found_index);
+  }
+
+  if (match_index != nullptr) {
+    *match_index = (result == VkQualityPredictionFile::kFileMatch_None) ? 0 : found_index;
+  }
+  return result;
+}
+
+VkQualityPredictionFile::FileMatchResult VkQualityPagedFile::SearchDriverList(
+    const DeviceInfo &device_info, const VkQualityPredictionFile::FileMatchResult match_result,
+    uint32_t &match_index) {
+  if (device_info.soc.empty()) {
+    return VkQualityPredictionFile::kFileMatch_None;
+  }
+  const bool allow_list = (match_result == VkQualityPredictionFile::kFileMatch_DriverAllow);
+  const FileTable &soc_table = allow_list ? soc_allow_table_ : soc_deny_table_;
+  const FileTable &driver_table = allow_list ? driver_allow_table_ : driver_deny_table_;
+
+  for (uint32_t soc_index = 0; soc_index < soc_table.count; ++soc_index) {
+    VkQualityDriverSoCEntry soc_entry;
+    if (!ReadEntry(soc_table, soc_index, soc_entry)) {
+      return VkQualityPredictionFile::kFileMatch_None;
+    }
+    if (strcasecmp(ReadString(soc_entry.soc_string_index, string_buffer_),
+                   device_info.soc.c_str()) != 0) {
+      continue;
+    }
+    const uint64_t fingerprint_end = static_cast<uint64_t>(soc_entry.soc_fingerprint_offset) +
+        soc_entry.soc_fingerprint_count;
+    for (uint64_t driver_index = soc_entry.soc_fingerprint_offset;
+         driver_index < fingerprint_end; ++driver_index) {
+      // An entry past the end of the driver table ends the search
+      VkQualityDriverFingerprintEntry driver_entry;
+      if (!ReadEntry(driver_table, static_cast<uint32_t>(driver_index), driver_entry)) {
+        break;
+      }
+      if (strcmp(ReadString(driver_entry.driver_version_string_index, string_buffer_),
+                 device_info.gles_version.c_str()) == 0) {
+        match_index = static_cast<uint32_t>(driver_index);
+        return match_result;
+      }
+    }
+    return VkQualityPredictionFile::kFileMatch_None;
+  }
+  return VkQualityPredictionFile::kFileMatch_None;
+}
+
+VkQualityPredictionFile::FileMatchResult VkQualityPagedFile::SearchDriverRules(
+    const DeviceInfo &device_info, const VkQualityPredictionFile::FileMatchResult match_result,
+    uint32_t &match_index) {
+  const FileTable &rule_table =
+      (match_result == VkQualityPredictionFile::kFileMatch_DriverRuleAllow) ?
+      driver_allow_rules_ : driver_deny_rules_;
+
+  VkQualityMatching::DriverVersionCache version_cache;
+  for (uint32_t i = 0; i < rule_table.count; ++i) {
+    VkQualityDriverRuleEntry rule;
+    if (!ReadEntry(rule_table, i, rule)) {
+      return VkQualityPredictionFile::kFileMatch_None;
+    }
+    // Same SoC rules as VkQualityPredictionFile::SearchDriverRules
+    if ((rule.soc_string_index == 0 ||
+         (!device_info.soc.empty() &&
+          strcasecmp(ReadString(rule.soc_string_index, string_buffer_),
+                     device_info.soc.c_str()) == 0)) &&
+        VkQualityMatching::CheckDriverRuleMatch(device_info, rule, version_cache)) {
+      match_index = i;
+      return match_result;
+    }
+  }
+  return VkQualityPredictionFile::kFileMatch_None;
+}
+
+VkQualityPredictionFile::FileMatchResult VkQualityPagedFile::SearchCapabilityRules(
+    const DeviceInfo &device_info, const VkQualityPredictionFile::FileMatchResult match_result,
+    uint32_t &match_index) {
+  if (device_info.vk_capabilities == 0) {
+    return VkQualityPredictionFile::kFileMatch_None;
+  }
+  const FileTable &rule_table =
+      (match_result == VkQualityPredictionFile::kFileMatch_CapabilityAllow) ?
+      capability_allow_rules_ : capability_deny_rules_;
+
+  for (uint32_t i = 0; i < rule_table.count; ++i) {
+    VkQualityCapabilityRuleEntry rule;
+    if (!ReadEntry(rule_table, i, rule)) {
+      return VkQualityPredictionFile::kFileMatch_None;
+    }
+    if (VkQualityMatching::CheckCapabilityRuleMatch(device_info, rule)) {
+      match_index = i;
+      return match_result;
+    }
+  }
+  return VkQualityPredictionFile::kFileMatch_None;
+}
+
+VkQualityPredictionFile::FileMatchResult VkQualityPagedFile::CheckDeviceEntry(
+    const DeviceInfo &device_info, const uint32_t device_index) {
+  VkQualityDeviceAllowListEntry entry;
+  if (!ReadEntry(device_table_, device_index, entry)) {
+    return VkQualityPredictionFile::kFileMatch_None;
+  }
+  const char *brand_string = ReadString(entry.brand_string_index, string_buffer_);
+  const char *device_string = ReadString(entry.device_string_index, compare_buffer_);
+  return VkQualityMatching::CheckDeviceMatch(device_info, brand_string, device_string,
+                                             entry.min_api_version, entry.min_driver_version);
+}
+
+const DeviceInfo &VkQualityPagedFile::GetKeyedDeviceInfo(const DeviceInfo &device_info,
+                                                         DeviceInfo &keyed_info) {
+  if (file_header_.file_format_version <
+      VkQualityPredictionFile::kBrandKey_File_Format_Version) {
+    return device_info;
+  }
+  std::string brand_key = VkQualityPredictionFile::GetBrandKey(device_info.brand);
+  auto alias_string = [this](const uint32_t index) {
+    VkQualityBrandAliasEntry alias_entry = {};
+    ReadEntry(brand_aliases_, index, alias_entry);
+    return ReadString(alias_entry.alias_string_index, string_buffer_);
+  };
+  uint32_t alias_low = 0;
+  uint32_t alias_high = brand_aliases_.count;
+  while (!brand_key.empty() && alias_low < alias_high) {
+    const uint32_t alias_mid = alias_low + ((alias_high - alias_low) / 2);
+    if (strcmp(alias_string(alias_mid), brand_key.c_str()) < 0) {
+      alias_low = alias_mid + 1;
+    } else {
+      alias_high = alias_mid;
+    }
+  }
+  // As in VkQualityPredictionFile::ResolveBrandAlias, an alias to the null
+  // string leaves the key unchanged
+  VkQualityBrandAliasEntry alias_entry;
+  if (!brand_key.empty() && ReadEntry(brand_aliases_, alias_low, alias_entry) &&
+      strcmp(ReadString(alias_entry.alias_string_index, string_buffer_),
+             brand_key.c_str()) == 0 &&
+      ReadString(alias_entry.brand_string_index, string_buffer_)[0] != '\0') {
+    brand_key = string_buffer_;
+  }
+  if (brand_key == device_info.brand) {
+    return device_info;
+  }
+  keyed_info = device_info;
+  keyed_info.brand = std::move(brand_key);
+  return keyed_info;
+}
+
+VkQualityPredictionFile::FileMatchResult VkQualityPagedFile::SearchDeviceList(
+    const DeviceInfo &device_info, uint32_t &match_index) {
+  if (brand_index_entries_.count > 0) {
+    return SearchBrandIndex(device_info, match_index);
+  }
+
+  const char *device_brand = device_info.brand.c_str();
+  const uint32_t letter_index = VkQualityPredictionFile::GetBrandShortcutIndex(device_brand);
+  uint32_t start_index = 0;
+  uint32_t end_index = device_table_.count;
+  const bool shortcuts_populated = (device_shortcuts_.count > 0);
+  if (shortcuts_populated) {
+    if (!ReadEntry(device_shortcuts_, letter_index, start_index) ||
+        (letter_index + 1 < device_shortcuts_.count &&
+         !ReadEntry(device_shortcuts_, letter_index + 1, end_index))) {
+      return VkQualityPredictionFile::kFileMatch_None;
+    }
+  }
+  const bool brand_sorted = shortcuts_populated &&
+      file_header_.file_format_version >= VkQualityPredictionFile::kBrandSorted_File_Format_Version;
+
+  for (uint32_t i = start_index; i < end_index; ++i) {
+    VkQualityDeviceAllowListEntry entry;
+    if (!ReadEntry(device_table_, i, entry)) {
+      break;
+    }
+    const char *brand_string = ReadString(entry.brand_string_index, string_buffer_);
+    if (brand_sorted && VkQualityPredictionFile::CompareBrandOrder(brand_string,
+                                                                   device_brand) > 0) {
+      break;
+    }
+    const char *device_string = ReadString(entry.device_string_index, compare_buffer_);
+    const VkQualityPredictionFile::FileMatchResult result =
+        VkQualityMatching::CheckDeviceMatch(device_info, brand_string, device_string,
+                                            entry.min_api_version, entry.min_driver_version);
+    if (result != VkQualityPredictionFile::kFileMatch_None) {
+      match_index = i;
+      return result;
+    }
+  }
+  return VkQualityPredictionFile::kFileMatch_None;
+}
+
+VkQualityPredictionFile::FileMatchResult VkQualityPagedFile::SearchBrandIndex(
+    const DeviceInfo &device_info, uint32_t &match_index) {
+  const char *device_brand = device_info.brand.c_str();
+  auto brand_string = [this](const uint32_t index) {
+    VkQualityBrandIndexEntry brand_entry = {};
+    ReadEntry(brand_index_entries_, index, brand_entry);
+    return ReadString(brand_entry.brand_string_index, string_buffer_);
+  };
+  uint32_t brand_low = 0;
+  uint32_t brand_high = brand_index_entries_.count;
+  while (brand_low < brand_high) {
+    const uint32_t brand_mid = brand_low + ((brand_high - brand_low) / 2);
+    if (strcmp(brand_string(brand_mid), device_brand) < 0) {
+      brand_low = brand_mid + 1;
+    } else {
+      brand_high = brand_mid;
+    }
+  }
+  VkQualityBrandIndexEntry brand_entry;
+  if (!ReadEntry(brand_index_entries_, brand_low, brand_entry) ||
+      strcmp(ReadString(brand_entry.brand_string_index, string_buffer_), device_brand) != 0) {
+    return VkQualityPredictionFile::kFileMatch_None;
+  }
+  const uint64_t range_end = static_cast<uint64_t>(brand_entry.device_index_start) +
+      brand_entry.device_index_count;
+  if (range_end > brand_device_index_.count) {
+    return VkQualityPredictionFile::kFileMatch_None;
+  }
+  const uint32_t range_start = brand_entry.device_index_start;
+
+  // A device index past the end of the device list reads as UINT32_MAX, which
+  // has the null device string and never matches
+  auto device_table_index = [this](const uint32_t index) {
+    uint32_t device_index = UINT32_MAX;
+    ReadEntry(brand_device_index_, index, device_index);
+    return device_index;
+  };
+  auto device_string = [this, &device_table_index](const uint32_t index) {
+    VkQualityDeviceAllowListEntry entry = {};
+    ReadEntry(device_table_, device_table_index(index), entry);
+    return ReadString(entry.device_string_index, compare_buffer_);
+  };
+
+  // First match in device list order, as in VkQualityPredictionFile::SearchBrandIndex
+  VkQualityPredictionFile::FileMatchResult result = VkQualityPredictionFile::kFileMatch_None;
+  auto check_device = [&](const uint32_t index) {
+    const uint32_t device_index = device_table_index(index);
+    if (result != VkQualityPredictionFile::kFileMatch_None && device_index >= match_index) {
+      return;
+    }
+    const VkQualityPredictionFile::FileMatchResult device_result =
+        CheckDeviceEntry(device_info, device_index);
+    if (device_result != VkQualityPredictionFile::kFileMatch_None) {
+      result = device_result;
+      match_index = device_index;
+    }
+  };
+
+  for (uint32_t i = range_start; i < range_end && device_string(i)[0] == '\0'; ++i) {
+    check_device(i);
+  }
+  if (!device_info.device.empty()) {
+    const char *device_name = device_info.device.c_str();
+    uint32_t device_low = range_start;
+    uint32_t device_high = static_cast<uint32_t>(range_end);
+    while (device_low < device_high) {
+      const uint32_t device_mid = device_low + ((device_high - device_low) / 2);
+      if (strcmp(device_string(device_mid), device_name) < 0) {
+        device_low = device_mid + 1;
+      } else {
+        device_high = device_mid;
+      }
+    }
+    for (uint32_t i = device_low; i < range_end && strcmp(device_string(i), device_name) == 0;
+         ++i) {
+      check_device(i);
+    }
+  }
+  return result;
+}
+
+VkQualityPredictionFile::FileMatchResult VkQualityPagedFile::SearchGpuList(
+    const DeviceInfo &device_info, const VkQualityPredictionFile::FileMatchResult match_result,
+    uint32_t &match_index) {
+  const FileTable &gpu_table = (match_result == VkQualityPredictionFile::kFileMatch_GpuAllow) ?
+      gpu_allow_table_ : gpu_deny_table_;
+  for (uint32_t i = 0; i < gpu_table.count; ++i) {
+    VkQualityGpuPredictEntry entry;
+    if (!ReadEntry(gpu_table, i, entry)) {
+      break;
+    }
+    const VkQualityPredictionFile::FileMatchResult result = VkQualityMatching::CheckGpuMatch(
+        device_info, ReadString(entry.device_name_string_index, string_buffer_),
+        entry.device_id, entry.vendor_id, entry.min_api_version, entry.min_driver_version,
+        match_result);
+    if (result == match_result) {
+      match_index = i;
+      return result;
+    }
+  }
+  return VkQualityPredictionFile::kFileMatch_None;
+}
+
+} // namespace vkquality
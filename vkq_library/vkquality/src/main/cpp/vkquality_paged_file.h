@@ -0,0 +1,190 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VKQUALITY_PAGED_FILE_H_
+#define VKQUALITY_PAGED_FILE_H_
+
+#include "vkquality_device_info.h"
+#include "vkquality_file_format.h"
+#include "vkquality_prediction_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace vkquality {
+
+// Searches a data file that is never held in memory as a whole. The file is read
+// through a callback, a page at a time, into a fixed size page cache, so the working
+// set is the page cache and a few strings regardless of the size of the file.
+// Searches give the same results as VkQualityPredictionFile::FindDeviceMatch, using
+// the row tables, the brand index and brand aliases. Column sections aren't used, and devices of a
+// sharded root file don't match. Compressed containers aren't supported.
+// Not thread safe, searches update the page cache.
+class VkQualityPagedFile {
+public:
+  static constexpr uint32_t kDefault_Page_Size = 1024;
+  static constexpr uint32_t kDefault_Page_Count = 4;
+  // Longer strings read as the null string, no list string comes close
+  static constexpr uint32_t kMax_String_Length = 1024;
+
+  // Reads up to size bytes at offset into buffer, returns the count of bytes read
+  typedef std::function<size_t(uint64_t offset, void *buffer, size_t size)> ReadFunction;
+
+  VkQualityPagedFile(ReadFunction read_function, const uint64_t file_size,
+                     const uint32_t page_size = kDefault_Page_Size,
+                     const uint32_t page_count = kDefault_Page_Count);
+
+  VkQualityPagedFile(const VkQualityPagedFile &) = delete;
+  VkQualityPagedFile &operator=(const VkQualityPagedFile &) = delete;
+
+  // Applies to the next Open call, see VkQualityPredictionFile::SetVerifyChecksum.
+  // Verifying reads the whole file once, through a single page.
+  void SetVerifyChecksum(const bool verify_checksum) { verify_checksum_ = verify_checksum; }
+
+  // Reads and checks the header and section table, and the checksum if present
+  VkQualityPredictionFile::FileParseResult Open(const uint32_t library_version);
+
+  VkQualityPredictionFile::FileMatchResult FindDeviceMatch(const DeviceInfo &device_info,
+                                                           const int32_t flags,
+                                                           uint32_t *match_index = nullptr);
+
+  uint32_t GetListVersion() const { return file_header_.list_version; }
+
+  int32_t GetFutureAndroidAPILevel() const {
+    return file_header_.min_future_vulkan_recommendation_api;
+  }
+
+  const std::string &GetParseErrorString() const { return file_parse_error_; }
+
+  // Count of pages read through the callback since the file was opened
+  uint64_t GetPageReadCount() const { return page_read_count_; }
+
+  // Bytes held by the page cache
+  size_t GetPageCacheSize() const { return page_data_.size(); }
+
+private:
+  struct CachePage {
+    uint64_t page_index = UINT64_MAX;
+    size_t valid_size = 0;
+    uint64_t last_use = 0;
+  };
+
+  // A table of fixed size entries in the file
+  struct FileTable {
+    uint64_t offset = 0;
+    uint32_t count = 0;
+  };
+
+  // Copies size bytes at offset through the page cache, false if any of them
+  // are past the end of the file or can't be read
+  bool Read(const uint64_t offset, void *buffer, const size_t size);
+
+  template<typename T>
+  bool ReadEntry(const FileTable &table, const uint32_t index, T &entry) {
+    return index < table.count && Read(table.offset + (uint64_t(index) * sizeof(T)), &entry,
+                                       sizeof(T));
+  }
+
+  // Reads a string table string into string_buffer, the null string if the
+  // string is out of bounds
+  const char *ReadString(const uint32_t string_index, std::string &string_buffer);
+
+  const uint8_t *GetPage(const uint64_t page_index, size_t &valid_size);
+
+  bool CheckTable(const FileTable &table, const size_t entry_size, const char *name);
+
+  VkQualityPredictionFile::FileParseResult ReadSectionTable();
+
+  // Sets rule_table to the rules of a driver or capability rules section, left
+  // empty if the section is too small for its rule count
+  template<typename RulesHeader, typename RuleEntry>
+  void ReadRules(const VkQualityFileSectionEntry &section, FileTable &rule_table);
+
+  VkQualityPredictionFile::FileParseResult VerifyChecksum(const uint64_t checksum_offset,
+                                                          const uint32_t checksum_size);
+
+  VkQualityPredictionFile::FileMatchResult SearchDriverList(
+      const DeviceInfo &device_info, const VkQualityPredictionFile::FileMatchResult match_result,
+      uint32_t &match_index);
+
+  VkQualityPredictionFile::FileMatchResult SearchDriverRules(
+      const DeviceInfo &device_info, const VkQualityPredictionFile::FileMatchResult match_result,
+      uint32_t &match_index);
+
+  VkQualityPredictionFile::FileMatchResult SearchCapabilityRules(
+      const DeviceInfo &device_info, const VkQualityPredictionFile::FileMatchResult match_result,
+      uint32_t &match_index);
+
+  // See VkQualityPredictionFile::GetKeyedDeviceInfo
+  const DeviceInfo &GetKeyedDeviceInfo(const DeviceInfo &device_info, DeviceInfo &keyed_info);
+
+  VkQualityPredictionFile::FileMatchResult SearchDeviceList(const DeviceInfo &device_info,
+                                                            uint32_t &match_index);
+
+  VkQualityPredictionFile::FileMatchResult SearchBrandIndex(const DeviceInfo &device_info,
+                                                            uint32_t &match_index);
+
+  VkQualityPredictionFile::FileMatchResult CheckDeviceEntry(const DeviceInfo &device_info,
+                                                            const uint32_t device_index);
+
+  VkQualityPredictionFile::FileMatchResult SearchGpuList(
+      const DeviceInfo &device_info, const VkQualityPredictionFile::FileMatchResult match_result,
+      uint32_t &match_index);
+
+  ReadFunction read_function_;
+  uint64_t file_size_;
+  uint32_t page_size_;
+  std::vector<uint8_t> page_data_;
+  std::vector<CachePage> pages_;
+  uint64_t page_use_counter_ = 0;
+  uint64_t page_read_count_ = 0;
+  bool verify_checksum_ = true;
+  bool opened_ = false;
+
+  VkQualityFileHeader file_header_ = {};
+  FileTable string_offsets_;
+  FileTable device_table_;
+  FileTable driver_allow_table_;
+  FileTable driver_deny_table_;
+  FileTable gpu_allow_table_;
+  FileTable gpu_deny_table_;
+  FileTable soc_allow_table_;
+  FileTable soc_deny_table_;
+  FileTable device_shortcuts_;
+  // Brand entries and the device index of the brand index section, empty
+  // if the file has none or it failed its check
+  FileTable brand_index_entries_;
+  FileTable brand_device_index_;
+  // Entries of the brand alias section, empty if the file has none
+  FileTable brand_aliases_;
+  // Rules of the driver rules sections, empty if the file has none
+  FileTable driver_allow_rules_;
+  FileTable driver_deny_rules_;
+  // Rules of the capability rules sections, empty if the file has none
+  FileTable capability_allow_rules_;
+  FileTable capability_deny_rules_;
+
+  // Reused so searches don't allocate once the strings have grown
+  std::string string_buffer_;
+  std::string compare_buffer_;
+  std::string file_parse_error_;
+};
+
+} // namespace vkquality
+
+#endif // VKQUALITY_PAGED_FILE_H_
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vkquality_patch.h"
+#include "vkquality_checksum.h"
+#include "vkquality_compression.h"
+#include "vkquality_core.h"
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+namespace vkquality {
+
+namespace {
+
+constexpr size_t kCopyBufferSize = 64 * 1024;
+// Larger than any list a device downloads, keeps a corrupt patch from
+// filling the storage directory
+constexpr uint32_t kMax_Target_Size = 256 * 1024 * 1024;
+
+// Closes the files of an apply on every return path, and removes the
+// partially written target unless it was committed
+class PatchFiles {
+public:
+  explicit PatchFiles(const std::string &temp_path) : temp_path_(temp_path) {}
+  ~PatchFiles() {
+    if (base_ != nullptr) fclose(base_);
+    if (patch_ != nullptr) fclose(patch_);
+    if (temp_ != nullptr) fclose(temp_);
+    if (temp_created_) unlink(temp_path_.c_str());
+  }
+
+  bool CreateTemp() {
+    temp_ = fopen(temp_path_.c_str(), "wb");
+    temp_created_ = (temp_ != nullptr);
+    return temp_created_;
+  }
+
+  // Flushes the target to storage before it replaces target_path, so a
+  // power loss can't leave a renamed but incomplete file
+  bool Commit(const std::string &target_path) {
+    const bool flushed = (fflush(temp_) == 0) && (fsync(fileno(temp_)) == 0);
+    const bool closed = (fclose(temp_) == 0);
+    temp_ = nullptr;
+    if (!flushed || !closed || rename(temp_path_.c_str(), target_path.c_str()) != 0) {
+      return false;
+    }
+    temp_created_ = false;
+    return true;
+  }
+
+  FILE *base_ = nullptr;
+  FILE *patch_ = nullptr;
+  FILE *temp_ = nullptr;
+
+private:
+  std::string temp_path_;
+  bool temp_created_ = false;
+};
+
+bool ReadExact(FILE *fp, void *buffer, const size_t size) {
+  return fread(buffer, 1, size, fp) == size;
+}
+
+} // anonymous namespace
+
+bool VkQualityPatch::GetStoredListVersion(const void *data, const size_t size,
+                                          uint32_t &list_version) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+  size_t header_offset = 0;
+  if (VkQualityCompression::IsCompressed(data, size)) {
+    header_offset = sizeof(VkQualityCompressedFileHeader);
+  }
+  if (size < header_offset + sizeof(VkQualityFileHeader)) {
+    return false;
+  }
+  VkQualityFileHeader header;
+  memcpy(&header, bytes + header_offset, sizeof(VkQualityFileHeader));
+  list_version = header.list_version;
+  return true;
+}
+
+VkQualityPatch::PatchResult VkQualityPatch::ApplyPatch(const std::string &base_path,
+                                                       const std::string &patch_path,
+                                                       const std::string &target_path) {
+  PatchFiles files(target_path + ".patching");
+
+  files.patch_ = fopen(patch_path.c_str(), "rb");
+  files.base_ = fopen(base_path.c_str(), "rb");
+  if (files.patch_ == nullptr || files.base_ == nullptr) {
+    return kPatchResult_Error_MissingFile;
+  }
+
+  VkQualityPatchHeader patch_header;
+  if (!ReadExact(files.patch_, &patch_header, sizeof(patch_header)) ||
+      patch_header.patch_identifier != kPatch_File_Identifier ||
+      patch_header.patch_version != kPatch_Version ||
+      patch_header.target_size > kMax_Target_Size) {
+    return kPatchResult_Error_InvalidPatch;
+  }
+
+  // Check the base is exactly the file the patch was made against before
+  // writing anything
+  uint8_t copy_buffer[kCopyBufferSize];
+  uint32_t base_crc = 0;
+  uint64_t base_size = 0;
+  uint32_t base_list_version = 0;
+  size_t read_size;
+  while ((read_size = fread(copy_buffer, 1, sizeof(copy_buffer), files.base_)) > 0) {
+    if (base_size == 0 && !GetStoredListVersion(copy_buffer, read_size, base_list_version)) {
+      return kPatchResult_Error_BaseMismatch;
+    }
+    base_crc = VkQualityChecksum::Crc32c(base_crc, copy_buffer, read_size);
+    base_size += read_size;
+  }
+  if (ferror(files.base_) != 0) {
+    return kPatchResult_Error_MissingFile;
+  }
+  if (base_size != patch_header.base_size || base_crc != patch_header.base_crc32c ||
+      base_list_version != patch_header.base_list_version) {
+    return kPatchResult_Error_BaseMismatch;
+  }
+
+  if (!files.CreateTemp()) {
+    return kPatchResult_Error_WriteFailed;
+  }
+
+  uint32_t target_crc = 0;
+  uint64_t target_size = 0;
+  for (uint32_t op_index = 0; op_index < patch_header.op_count; ++op_index) {
+    VkQualityPatchOp op;
+    if (!ReadExact(files.patch_, &op, sizeof(op))) {
+      return kPatchResult_Error_InvalidPatch;
+    }
+    target_size += op.length;
+    if (target_size > patch_header.target_size) {
+      return kPatchResult_Error_InvalidPatch;
+    }
+    FILE *source = nullptr;
+    if (op.op_type == kPatchOp_Copy) {
+      if (static_cast<uint64_t>(op.base_offset) + op.length > base_size ||
+          fseek(files.base_, op.base_offset, SEEK_SET) != 0) {
+        return kPatchResult_Error_InvalidPatch;
+      }
+      source = files.base_;
+    } else if (op.op_type == kPatchOp_Insert) {
+      source = files.patch_;
+    } else {
+      return kPatchResult_Error_InvalidPatch;
+    }
+    uint32_t remaining = op.length;
+    while (remaining > 0) {
+      const size_t chunk_size = (remaining < kCopyBufferSize) ? remaining : kCopyBufferSize;
+      if (!ReadExact(source, copy_buffer, chunk_size)) {
+        return kPatchResult_Error_InvalidPatch;
+      }
+      if (fwrite(copy_buffer, chunk_size, 1, files.temp_) != 1) {
+        return kPatchResult_Error_WriteFailed;
+      }
+      target_crc = VkQualityChecksum::Crc32c(target_crc, copy_buffer, chunk_size);
+      remaining -= static_cast<uint32_t>(chunk_size);
+    }
+  }
+  // Trailing data means the patch isn't the one described by its header
+  if (fgetc(files.patch_) != EOF) {
+    return kPatchResult_Error_InvalidPatch;
+  }
+  if (target_size != patch_header.target_size || target_crc != patch_header.target_crc32c) {
+    return kPatchResult_Error_TargetMismatch;
+  }
+
+  if (!files.Commit(target_path)) {
+    return kPatchResult_Error_WriteFailed;
+  }
+  return kPatchResult_Success;
+}
+
+} // namespace vkquality
+
+using namespace vkquality;
+
+extern "C" vkQualityInitResult vkQuality_applyListPatch(const char *storage_path,
+                                                        const char *list_filename,
+                                                        const char *patch_path) {
+  if (storage_path == nullptr || list_filename == nullptr || patch_path == nullptr) {
+    return kErrorInitializationFailure;
+  }
+  const std::string list_path = std::string(storage_path) + "/" + list_filename;
+  switch (VkQualityPatch::ApplyPatch(list_path, patch_path, list_path)) {
+    case VkQualityPatch::kPatchResult_Success:
+      return kSuccess;
+    case VkQualityPatch::kPatchResult_Error_MissingFile:
+      return kErrorMissingDataFile;
+    case VkQualityPatch::kPatchResult_Error_BaseMismatch:
+      return kErrorInvalidDataVersion;
+    case VkQualityPatch::kPatchResult_Error_InvalidPatch:
+    case VkQualityPatch::kPatchResult_Error_TargetMismatch:
+      return kErrorInvalidDataFile;
+    case VkQualityPatch::kPatchResult_Error_WriteFailed:
+      break;
+  }
+  return kErrorInitializationFailure;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VKQUALITY_PATCH_H_
+#define VKQUALITY_PATCH_H_
+
+#include "vkquality_file_format.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vkquality {
+
+// Applies list patch files, see VkQualityPatchHeader. Patches are created by
+// the host tooling, see VkQualityFileWriter::CreatePatch.
+class VkQualityPatch {
+public:
+  static constexpr uint32_t kPatch_File_Identifier = 0x564b5150; // VKQP
+  static constexpr uint32_t kPatch_Version = 1;
+
+  enum PatchOpType : uint32_t {
+    kPatchOp_Copy = 1,
+    kPatchOp_Insert = 2
+  };
+
+  enum PatchResult : int32_t {
+    kPatchResult_Success = 0,
+    kPatchResult_Error_MissingFile,
+    kPatchResult_Error_InvalidPatch,
+    kPatchResult_Error_BaseMismatch,
+    kPatchResult_Error_TargetMismatch,
+    kPatchResult_Error_WriteFailed
+  };
+
+  // list_version of a data file as stored, looking inside a compressed
+  // container header. Returns false if the data doesn't start with a header.
+  static bool GetStoredListVersion(const void *data, const size_t size, uint32_t &list_version);
+
+  // Rebuilds the target of a patch from the base file, streaming both files.
+  // The target is written next to target_path and only renamed over it once its
+  // size and checksum are verified, so target_path can be the base file, which is
+  // either left unchanged or replaced in one step.
+  static PatchResult ApplyPatch(const std::string &base_path, const std::string &patch_path,
+                                const std::string &target_path);
+};
+
+} // namespace vkquality
+
+#endif // VKQUALITY_PATCH_H_
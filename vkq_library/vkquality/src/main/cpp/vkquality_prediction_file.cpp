@@ -14,11 +14,17 @@
  * limitations under the License.
  */
 
-#include "vkquality.h"
+#include "vkquality_checksum.h"
+#include "vkquality_core.h"
 #include "vkquality_prediction_file.h"
 #include "vkquality_matching.h"
+#include <algorithm>
+#include <cstddef>
 #include <ctype.h>
+#include <stdarg.h>
 #include <malloc.h>
+#include <string.h>
+#include <strings.h>
 #include <vector>
 
 namespace vkquality {
@@ -50,18 +56,102 @@ static bool CheckOffsetListValidity(const uint32_t *offset_list, const uint32_t
   return true;
 }
 
+// Shard names are file names relative to the root file, they can't reach other directories
+static bool IsShardNameSafe(const char *shard_name, const size_t shard_name_length) {
+  return (shard_name_length > 0 && memchr(shard_name, '/', shard_name_length) == nullptr &&
+          strstr(shard_name, "..") == nullptr);
+}
+
+// FNV-1a, for the string table hash index
+static uint32_t HashString(const char *string, const bool fold_case) {
+  uint32_t hash = 0x811c9dc5U;
+  for (const unsigned char *chars = reinterpret_cast<const unsigned char *>(string);
+       *chars != '\0'; ++chars) {
+    const uint8_t hash_byte = fold_case ? static_cast<uint8_t>(tolower(*chars)) : *chars;
+    hash = (hash ^ hash_byte) * 0x01000193U;
+  }
+  return hash;
+}
+
+// A power of two, at most half full
+static size_t GetHashSlotCount(const uint32_t entry_count) {
+  size_t slot_count = 16;
+  while (slot_count < static_cast<size_t>(entry_count) * 2) {
+    slot_count *= 2;
+  }
+  return slot_count;
+}
+
+static void SetError(std::string *error_string, const std::string &error) {
+  if (error_string != nullptr) {
+    *error_string = error;
+  }
+}
+
 VkQualityPredictionFile::VkQualityPredictionFile() {
   file_parse_error_ = "No error";
 }
 
 VkQualityPredictionFile::~VkQualityPredictionFile() {
-  if (file_header_ != nullptr) {
-    free(const_cast<VkQualityFileHeader *>(file_header_));
+  if (file_header_ != nullptr && release_function_ != nullptr) {
+    release_function_(const_cast<VkQualityFileHeader *>(file_header_), release_user_data_);
+  }
+}
+
+void VkQualityPredictionFile::FreeFileData(void *file_data, void */*user_data*/) {
+  free(file_data);
+}
+
+bool VkQualityPredictionFile::IsHeaderCompatible(const VkQualityFileHeader &header,
+                                                 const uint32_t library_version) {
+  return (header.file_identifier == kVkQuality_File_Identifier &&
+          header.library_minimum_version <= library_version);
+}
+
+uint32_t VkQualityPredictionFile::GetBrandShortcutIndex(const char *brand) {
+  const int brand_first_letter = toupper(static_cast<unsigned char>(brand[0]));
+  if (brand_first_letter >= 'A' && brand_first_letter <= 'Z') {
+    return brand_first_letter - 'A';
   }
+  return kShortcut_Offset_Count - 1;
+}
+
+int VkQualityPredictionFile::CompareBrandOrder(const char *a, const char *b) {
+  // Not strcasecmp, it folds to lower case which orders '_' and friends
+  // differently than the exporter
+  const unsigned char *a_chars = reinterpret_cast<const unsigned char *>(a);
+  const unsigned char *b_chars = reinterpret_cast<const unsigned char *>(b);
+  while (true) {
+    const int a_char = (*a_chars >= 'a' && *a_chars <= 'z') ? *a_chars - ('a' - 'A') : *a_chars;
+    const int b_char = (*b_chars >= 'a' && *b_chars <= 'z') ? *b_chars - ('a' - 'A') : *b_chars;
+    if (a_char != b_char || a_char == 0) {
+      return a_char - b_char;
+    }
+    ++a_chars;
+    ++b_chars;
+  }
+}
+
+std::string VkQualityPredictionFile::GetBrandKey(const std::string_view &brand) {
+  const char *whitespace = " \t\n\v\f\r";
+  const size_t key_start = brand.find_first_not_of(whitespace);
+  if (key_start == std::string_view::npos) {
+    return std::string();
+  }
+  const size_t key_end = brand.find_last_not_of(whitespace) + 1;
+  std::string brand_key(brand.substr(key_start, key_end - key_start));
+  // Not tolower, it depends on the locale
+  for (char &key_char : brand_key) {
+    if (key_char >= 'A' && key_char <= 'Z') {
+      key_char = static_cast<char>(key_char + ('a' - 'A'));
+    }
+  }
+  return brand_key;
 }
 
 VkQualityPredictionFile::FileParseResult VkQualityPredictionFile::ValidateFile(
-    void *file_data, const size_t file_size, const uint32_t library_version) {
+    void *file_data, const size_t file_size, const uint32_t library_version,
+    FileSection *sections) {
   const VkQualityFileHeader *header = reinterpret_cast<const VkQualityFileHeader *>(file_data);
 
   // File must be at least the size of the header
@@ -80,104 +170,593 @@ VkQualityPredictionFile::FileParseResult VkQualityPredictionFile::ValidateFile(
     return kFileParseResult_Error_LibraryTooOldForFile;
   }
 
-  const size_t device_list_size = header->device_list_count * sizeof(VkQualityDeviceAllowListEntry);
-  const size_t device_list_end = header->device_list_offset + device_list_size;
-  if (device_list_end > file_size) {
-    file_parse_error_ = "Invalid file: Device list overflows end of file";
-    return kFileParseResult_Error_DeviceListOverflow;
+  // The sections located by header fields, in the order they are checked.
+  // 64-bit sums, offset + size of a section can overflow a 32-bit size_t
+  struct HeaderSection {
+    SectionSlot slot;
+    uint32_t offset;
+    uint64_t size;
+    FileParseResult overflow_result;
+    const char *name;
+  };
+  const HeaderSection header_sections[] = {
+      {kSectionSlot_DeviceList, header->device_list_offset,
+       static_cast<uint64_t>(header->device_list_count) * sizeof(VkQualityDeviceAllowListEntry),
+       kFileParseResult_Error_DeviceListOverflow, "Device list"},
+      {kSectionSlot_DriverAllow, header->driver_allow_offset,
+       static_cast<uint64_t>(header->driver_allow_count) * sizeof(VkQualityDriverFingerprintEntry),
+       kFileParseResult_Error_DriverAllowOverflow, "driver allow list"},
+      {kSectionSlot_DriverDeny, header->driver_deny_offset,
+       static_cast<uint64_t>(header->driver_deny_count) * sizeof(VkQualityDriverFingerprintEntry),
+       kFileParseResult_Error_DriverDenyOverflow, "driver deny list"},
+      {kSectionSlot_GpuAllow, header->gpu_allow_predict_offset,
+       static_cast<uint64_t>(header->gpu_allow_predict_count) * sizeof(VkQualityGpuPredictEntry),
+       kFileParseResult_Error_GpuAllowOverflow, "GPU allow list"},
+      {kSectionSlot_GpuDeny, header->gpu_deny_predict_offset,
+       static_cast<uint64_t>(header->gpu_deny_predict_count) * sizeof(VkQualityGpuPredictEntry),
+       kFileParseResult_Error_GpuDenyOverflow, "GPU deny list"},
+      {kSectionSlot_SoCAllow, header->soc_allow_offset,
+       static_cast<uint64_t>(header->soc_allow_count) * sizeof(VkQualityDriverSoCEntry),
+       kFileParseResult_Error_SoCAllowOverflow, "SoC allow list"},
+      {kSectionSlot_SoCDeny, header->soc_deny_offset,
+       static_cast<uint64_t>(header->soc_deny_count) * sizeof(VkQualityDriverSoCEntry),
+       kFileParseResult_Error_SoCDenyOverflow, "soc deny list"},
+      {kSectionSlot_StringTable, header->string_table_offset,
+       static_cast<uint64_t>(header->string_table_count) * sizeof(uint32_t),
+       kFileParseResult_Error_StringOffsetOverflow, "string table offset list"},
+      {kSectionSlot_DeviceShortcuts, header->device_list_shortcuts_offset,
+       static_cast<uint64_t>(kShortcut_Offset_Count) * sizeof(uint32_t),
+       kFileParseResult_Error_ShortcutOverflow, "shortcut offset list"}
+  };
+  for (const HeaderSection &header_section : header_sections) {
+    if (header_section.offset + header_section.size > file_size) {
+      file_parse_error_ = str_fmt("Invalid file: %s overflows end of file", header_section.name);
+      return header_section.overflow_result;
+    }
+    FileSection &section = sections[header_section.slot];
+    section.offset = header_section.offset;
+    section.size = header_section.size;
+    section.present = true;
+  }
+
+  return ValidateSectionTable(file_data, file_size, sections);
+}
+
+VkQualityPredictionFile::FileParseResult VkQualityPredictionFile::ValidateSectionTable(
+    const void *file_data, const size_t file_size, FileSection *sections) {
+  const VkQualityFileHeader *header = reinterpret_cast<const VkQualityFileHeader *>(file_data);
+  if (header->file_format_version < kSectionTable_File_Format_Version) {
+    return kFileParseResult_Success;
+  }
+
+  const uint8_t *file_start = reinterpret_cast<const uint8_t *>(file_data);
+  const uint64_t section_table_end = sizeof(VkQualityFileHeader) +
+      sizeof(VkQualityFileSectionTable);
+  if (section_table_end > file_size) {
+    file_parse_error_ = "Invalid file: section table overflows end of file";
+    return kFileParseResult_Error_SectionTableOverflow;
+  }
+  const VkQualityFileSectionTable *section_table =
+      reinterpret_cast<const VkQualityFileSectionTable *>(file_start + sizeof(VkQualityFileHeader));
+  if (section_table->section_table_identifier != kVkQuality_Section_Table_Identifier) {
+    file_parse_error_ = "Section table identifier invalid";
+    return kFileParseResult_Error_InvalidIdentifier;
+  }
+  const uint64_t section_entries_end = section_table_end +
+      (static_cast<uint64_t>(section_table->section_count) * sizeof(VkQualityFileSectionEntry));
+  if (section_entries_end > file_size) {
+    file_parse_error_ = "Invalid file: section table entries overflow end of file";
+    return kFileParseResult_Error_SectionTableOverflow;
+  }
+
+  // Only the bounds of each section are checked here, see CheckSection.
+  // Sections this library doesn't know are skipped, the first of a repeated
+  // section is used.
+  const VkQualityFileSectionEntry *entries =
+      reinterpret_cast<const VkQualityFileSectionEntry *>(section_table + 1);
+  for (uint32_t i = 0; i < section_table->section_count; ++i) {
+    const uint64_t section_end = static_cast<uint64_t>(entries[i].section_offset) +
+        entries[i].section_size;
+    if (section_end > file_size) {
+      file_parse_error_ = str_fmt("Invalid file: section %u overflows end of file", i);
+      return kFileParseResult_Error_SectionOverflow;
+    }
+    SectionSlot slot;
+    if (entries[i].section_id == kFileSection_BrandIndex) {
+      slot = kSectionSlot_BrandIndex;
+    } else if (entries[i].section_id == kFileSection_GpuAllowColumns) {
+      slot = kSectionSlot_GpuAllowColumns;
+    } else if (entries[i].section_id == kFileSection_GpuDenyColumns) {
+      slot = kSectionSlot_GpuDenyColumns;
+    } else if (entries[i].section_id == kFileSection_DeviceShards) {
+      slot = kSectionSlot_DeviceShards;
+    } else if (entries[i].section_id == kFileSection_Checksum) {
+      slot = kSectionSlot_Checksum;
+    } else if (entries[i].section_id == kFileSection_BrandAliases) {
+      slot = kSectionSlot_BrandAliases;
+    } else if (entries[i].section_id == kFileSection_DriverAllowRules) {
+      slot = kSectionSlot_DriverAllowRules;
+    } else if (entries[i].section_id == kFileSection_DriverDenyRules) {
+      slot = kSectionSlot_DriverDenyRules;
+    } else if (entries[i].section_id == kFileSection_CapabilityAllowRules) {
+      slot = kSectionSlot_CapabilityAllowRules;
+    } else if (entries[i].section_id == kFileSection_CapabilityDenyRules) {
+      slot = kSectionSlot_CapabilityDenyRules;
+    } else {
+      continue;
+    }
+    if (!sections[slot].present) {
+      sections[slot].offset = entries[i].section_offset;
+      sections[slot].size = entries[i].section_size;
+      sections[slot].present = true;
+    }
   }
+  return kFileParseResult_Success;
+}
 
-  const size_t driver_allow_list_size = header->driver_allow_count *
-      sizeof(VkQualityDriverFingerprintEntry);
-  const size_t driver_allow_list_end = header->driver_allow_offset + driver_allow_list_size;
-  if (driver_allow_list_end > file_size) {
-    file_parse_error_ = "Invalid file: driver allow list overflows end of file";
-    return kFileParseResult_Error_DriverAllowOverflow;
+VkQualityPredictionFile::FileParseResult VkQualityPredictionFile::CheckSection(
+    const VkQualityFileHeader *header, const size_t file_size, const FileSection *sections,
+    const SectionSlot slot, std::string *error_string) {
+  const FileSection &section = sections[slot];
+  if (!section.present) {
+    return kFileParseResult_Success;
+  }
+  const uint8_t *file_start = reinterpret_cast<const uint8_t *>(header);
+  if (slot == kSectionSlot_StringTable) {
+    // Individual string bounds checks are made at string retrieval time, only
+    // the string offsets are checked here
+    const uint32_t *string_offsets = reinterpret_cast<const uint32_t *>(
+        file_start + section.offset);
+    if (!CheckOffsetListValidity(string_offsets, header->string_table_count, file_size)) {
+      SetError(error_string, "Invalid file: String offset table entry overflows end of file");
+      return kFileParseResult_Error_StringOffsetOverflow;
+    }
+  } else if (slot == kSectionSlot_DeviceShortcuts) {
+    // Each shortcut is the start index of its bucket, and the next shortcut is the end
+    const uint32_t *shortcut_offsets = reinterpret_cast<const uint32_t *>(
+        file_start + section.offset);
+    uint32_t previous_shortcut = 0;
+    for (uint32_t i = 0; i < kShortcut_Offset_Count; ++i) {
+      if (shortcut_offsets[i] < previous_shortcut ||
+          shortcut_offsets[i] > header->device_list_count) {
+        SetError(error_string, str_fmt("Invalid file: shortcut %u out of order", i));
+        return kFileParseResult_Error_ShortcutOrder;
+      }
+      previous_shortcut = shortcut_offsets[i];
+    }
+  } else if (slot == kSectionSlot_BrandIndex) {
+    return CheckBrandIndex(header, section, error_string);
+  } else if (slot == kSectionSlot_GpuAllowColumns) {
+    return CheckGpuColumns(header, section, header->gpu_allow_predict_count, error_string);
+  } else if (slot == kSectionSlot_GpuDenyColumns) {
+    return CheckGpuColumns(header, section, header->gpu_deny_predict_count, error_string);
+  } else if (slot == kSectionSlot_DeviceShards) {
+    return CheckDeviceShards(header, file_size, section, error_string);
+  } else if (slot == kSectionSlot_BrandAliases) {
+    return CheckBrandAliases(header, section, error_string);
+  } else if (slot == kSectionSlot_DriverAllowRules || slot == kSectionSlot_DriverDenyRules) {
+    return CheckDriverRules(header, section, error_string);
+  } else if (slot == kSectionSlot_CapabilityAllowRules ||
+             slot == kSectionSlot_CapabilityDenyRules) {
+    return CheckCapabilityRules(header, section, error_string);
+  } else if (slot == kSectionSlot_Checksum) {
+    if (section.size != sizeof(VkQualityChecksumSection)) {
+      SetError(error_string, "Invalid file: checksum section size mismatch");
+      return kFileParseResult_Error_ChecksumInvalid;
+    }
   }
+  return kFileParseResult_Success;
+}
 
-  const size_t driver_deny_list_size = header->driver_deny_count *
-      sizeof(VkQualityDriverFingerprintEntry);
-  const size_t driver_deny_list_end = header->driver_deny_offset + driver_deny_list_size;
-  if (driver_deny_list_end > file_size) {
-    file_parse_error_ = "Invalid file: driver deny list overflows end of file";
-    return kFileParseResult_Error_DriverDenyOverflow;
+uint32_t VkQualityPredictionFile::ComputeFileChecksum(const void *file_data,
+                                                      const size_t file_size,
+                                                      const size_t checksum_section_offset) {
+  const uint8_t *file_start = reinterpret_cast<const uint8_t *>(file_data);
+  const size_t checksum_offset = checksum_section_offset +
+      offsetof(VkQualityChecksumSection, checksum);
+  const uint32_t zero_checksum = 0;
+  uint32_t checksum = VkQualityChecksum::Crc32c(0, file_start, checksum_offset);
+  checksum = VkQualityChecksum::Crc32c(checksum, &zero_checksum, sizeof(zero_checksum));
+  const size_t remaining_offset = checksum_offset + sizeof(zero_checksum);
+  return VkQualityChecksum::Crc32c(checksum, file_start + remaining_offset,
+                                   file_size - remaining_offset);
+}
+
+VkQualityPredictionFile::FileParseResult VkQualityPredictionFile::VerifyChecksum(
+    const void *file_data, const size_t file_size, const FileSection &section) {
+  if (!section.present) {
+    return kFileParseResult_Success;
+  }
+  if (section.size != sizeof(VkQualityChecksumSection)) {
+    file_parse_error_ = "Invalid file: checksum section size mismatch";
+    return kFileParseResult_Error_ChecksumInvalid;
   }
+  VkQualityChecksumSection checksum_section;
+  memcpy(&checksum_section, reinterpret_cast<const uint8_t *>(file_data) + section.offset,
+         sizeof(checksum_section));
+  if (!verify_checksum_ || checksum_section.algorithm != kChecksum_Crc32c) {
+    content_checksum_ = checksum_section.checksum;
+    return kFileParseResult_Success;
+  }
+  // A size mismatch catches a truncated or extended file without hashing it
+  if (checksum_section.file_size != file_size ||
+      ComputeFileChecksum(file_data, file_size, section.offset) != checksum_section.checksum) {
+    file_parse_error_ = str_fmt("Invalid file: checksum mismatch, file size %zu expected %u",
+                                file_size, checksum_section.file_size);
+    return kFileParseResult_Error_ChecksumMismatch;
+  }
+  content_checksum_ = checksum_section.checksum;
+  return kFileParseResult_Success;
+}
 
-  const size_t gpu_allow_list_size = header->gpu_allow_predict_count *
-                                     sizeof(VkQualityGpuPredictEntry);
-  const size_t gpu_allow_list_end = header->gpu_allow_predict_offset + gpu_allow_list_size;
-  if (gpu_allow_list_end > file_size) {
-    file_parse_error_ = "Invalid file: GPU allow list overflows end of file";
-    return kFileParseResult_Error_GpuAllowOverflow;
+VkQualityPredictionFile::FileParseResult VkQualityPredictionFile::CheckBrandIndex(
+    const VkQualityFileHeader *header, const FileSection &section, std::string *error_string) {
+  if (section.size < sizeof(VkQualityBrandIndexHeader)) {
+    SetError(error_string, "Invalid file: brand index smaller than its header");
+    return kFileParseResult_Error_BrandIndexInvalid;
+  }
+  const VkQualityBrandIndexHeader *index_header =
+      reinterpret_cast<const VkQualityBrandIndexHeader *>(
+          reinterpret_cast<const uint8_t *>(header) + section.offset);
+  const uint64_t index_size = sizeof(VkQualityBrandIndexHeader) +
+      (static_cast<uint64_t>(index_header->brand_count) * sizeof(VkQualityBrandIndexEntry)) +
+      (static_cast<uint64_t>(index_header->device_index_count) * sizeof(uint32_t));
+  if (index_size > section.size) {
+    SetError(error_string, "Invalid file: brand index overflows its section");
+    return kFileParseResult_Error_BrandIndexInvalid;
   }
 
-  const size_t gpu_deny_list_size = header->gpu_deny_predict_count *
-                                    sizeof(VkQualityGpuPredictEntry);
-  const size_t gpu_deny_list_end = header->gpu_deny_predict_offset + gpu_deny_list_size;
-  if (gpu_deny_list_end > file_size) {
-    file_parse_error_ = "Invalid file: GPU deny list overflows end of file";
-    return kFileParseResult_Error_GpuDenyOverflow;
+  const VkQualityBrandIndexEntry *brand_entries =
+      reinterpret_cast<const VkQualityBrandIndexEntry *>(index_header + 1);
+  for (uint32_t i = 0; i < index_header->brand_count; ++i) {
+    const uint64_t range_end = static_cast<uint64_t>(brand_entries[i].device_index_start) +
+        brand_entries[i].device_index_count;
+    if (range_end > index_header->device_index_count) {
+      SetError(error_string, str_fmt("Invalid file: brand index entry %u out of range", i));
+      return kFileParseResult_Error_BrandIndexInvalid;
+    }
+  }
+  const uint32_t *device_indices =
+      reinterpret_cast<const uint32_t *>(brand_entries + index_header->brand_count);
+  for (uint32_t i = 0; i < index_header->device_index_count; ++i) {
+    if (device_indices[i] >= header->device_list_count) {
+      SetError(error_string, str_fmt("Invalid file: brand index device %u out of range", i));
+      return kFileParseResult_Error_BrandIndexInvalid;
+    }
   }
+  return kFileParseResult_Success;
+}
 
-  const size_t soc_allow_list_size = header->soc_allow_count *
-      sizeof(VkQualityDriverSoCEntry);
-  const size_t soc_allow_list_end = header->soc_allow_offset + soc_allow_list_size;
-  if (soc_allow_list_end > file_size) {
-    file_parse_error_ = "Invalid file: SoC allow list overflows end of file";
-    return kFileParseResult_Error_SoCAllowOverflow;
+VkQualityPredictionFile::FileParseResult VkQualityPredictionFile::CheckGpuColumns(
+    const VkQualityFileHeader *header, const FileSection &section, const uint32_t list_count,
+    std::string *error_string) {
+  if ((section.offset % 16) != 0 || section.size < sizeof(VkQualityGpuColumnsHeader)) {
+    SetError(error_string, "Invalid file: GPU column section misaligned or too small");
+    return kFileParseResult_Error_GpuColumnsInvalid;
   }
+  const VkQualityGpuColumnsHeader *columns_header =
+      reinterpret_cast<const VkQualityGpuColumnsHeader *>(
+          reinterpret_cast<const uint8_t *>(header) + section.offset);
+  const uint64_t columns_size = sizeof(VkQualityGpuColumnsHeader) +
+      (static_cast<uint64_t>(columns_header->column_stride) * 5 * sizeof(uint32_t));
+  // The scans load 4 entries at a time, so the stride must cover whole vectors
+  if (columns_header->entry_count != list_count ||
+      columns_header->column_stride < list_count ||
+      (columns_header->column_stride % 4) != 0 ||
+      columns_size > section.size) {
+    SetError(error_string, "Invalid file: GPU column section doesn't match its list");
+    return kFileParseResult_Error_GpuColumnsInvalid;
+  }
+  return kFileParseResult_Success;
+}
 
-  const size_t soc_deny_list_size = header->soc_deny_count *
-      sizeof(VkQualityDriverSoCEntry);
-  const size_t soc_deny_list_end = header->soc_deny_offset + soc_deny_list_size;
-  if (soc_deny_list_end > file_size) {
-    file_parse_error_ = "Invalid file: soc deny list overflows end of file";
-    return kFileParseResult_Error_SoCDenyOverflow;
+VkQualityPredictionFile::FileParseResult VkQualityPredictionFile::CheckDeviceShards(
+    const VkQualityFileHeader *header, const size_t file_size, const FileSection &section,
+    std::string *error_string) {
+  if (section.size < sizeof(VkQualityDeviceShardsHeader)) {
+    SetError(error_string, "Invalid file: device shards smaller than their header");
+    return kFileParseResult_Error_DeviceShardsInvalid;
+  }
+  const VkQualityDeviceShardsHeader *shards_header =
+      reinterpret_cast<const VkQualityDeviceShardsHeader *>(
+          reinterpret_cast<const uint8_t *>(header) + section.offset);
+  const uint64_t shards_size = sizeof(VkQualityDeviceShardsHeader) +
+      (static_cast<uint64_t>(shards_header->shard_count) * sizeof(VkQualityDeviceShardEntry));
+  if (shards_size > section.size) {
+    SetError(error_string, "Invalid file: device shards overflow their section");
+    return kFileParseResult_Error_DeviceShardsInvalid;
   }
 
-  // Individual string offset bounds checks are made at string retrieval time, we just make
-  // sure the actual string offset list is within the file bounds here.
-  const size_t string_offset_list_size = header->string_table_count * sizeof(uint32_t);
-  const size_t string_offset_list_end = header->string_table_offset + string_offset_list_size;
-  if (string_offset_list_end > file_size) {
-    file_parse_error_ = "Invalid file: string table offset list overflows end of file";
-    return kFileParseResult_Error_StringOffsetOverflow;
+  // One shard per bucket, in bucket order, each with a name
+  const VkQualityDeviceShardEntry *shard_entries =
+      reinterpret_cast<const VkQualityDeviceShardEntry *>(shards_header + 1);
+  for (uint32_t i = 0; i < shards_header->shard_count; ++i) {
+    if (shard_entries[i].shortcut_index >= kShortcut_Offset_Count ||
+        (i > 0 && shard_entries[i].shortcut_index <= shard_entries[i - 1].shortcut_index) ||
+        shard_entries[i].shard_name_string_index == 0 ||
+        shard_entries[i].shard_name_string_index >= header->string_table_count) {
+      SetError(error_string, str_fmt("Invalid file: device shard %u invalid", i));
+      return kFileParseResult_Error_DeviceShardsInvalid;
+    }
   }
-  const uint8_t *file_start = reinterpret_cast<const uint8_t *>(file_data);
+
+  // The names are passed to the shard loader, which opens them as files
+  const uint8_t *file_start = reinterpret_cast<const uint8_t *>(header);
   const uint32_t *string_offsets = reinterpret_cast<const uint32_t *>(
-      (file_start + header->string_table_offset));
-  if (!CheckOffsetListValidity(string_offsets, header->device_list_count, file_size)) {
-    file_parse_error_ = "Invalid file: String offset table entry overflows end of file";
-    return kFileParseResult_Error_StringOffsetOverflow;
+      file_start + header->string_table_offset);
+  for (uint32_t i = 0; i < shards_header->shard_count; ++i) {
+    const uint32_t name_offset = string_offsets[shard_entries[i].shard_name_string_index];
+    if (name_offset >= file_size) {
+      SetError(error_string, str_fmt("Invalid file: device shard %u name overflows", i));
+      return kFileParseResult_Error_DeviceShardsInvalid;
+    }
+    const char *shard_name = reinterpret_cast<const char *>(file_start + name_offset);
+    const size_t shard_name_length = strnlen(shard_name, file_size - name_offset);
+    if (shard_name_length == file_size - name_offset ||
+        !IsShardNameSafe(shard_name, shard_name_length)) {
+      SetError(error_string, str_fmt("Invalid file: device shard %u name unsafe", i));
+      return kFileParseResult_Error_DeviceShardsInvalid;
+    }
   }
+  return kFileParseResult_Success;
+}
+
+VkQualityPredictionFile::FileParseResult VkQualityPredictionFile::CheckBrandAliases(
+    const VkQualityFileHeader *header, const FileSection &section, std::string *error_string) {
+  if (section.size < sizeof(VkQualityBrandAliasHeader)) {
+    SetError(error_string, "Invalid file: brand aliases smaller than their header");
+    return kFileParseResult_Error_BrandAliasesInvalid;
+  }
+  const VkQualityBrandAliasHeader *aliases_header =
+      reinterpret_cast<const VkQualityBrandAliasHeader *>(
+          reinterpret_cast<const uint8_t *>(header) + section.offset);
+  const uint64_t aliases_size = sizeof(VkQualityBrandAliasHeader) +
+      (static_cast<uint64_t>(aliases_header->alias_count) * sizeof(VkQualityBrandAliasEntry));
+  if (aliases_size > section.size) {
+    SetError(error_string, "Invalid file: brand aliases overflow their section");
+    return kFileParseResult_Error_BrandAliasesInvalid;
+  }
+
+  // An alias to the null string would stop every device of the brand matching
+  const VkQualityBrandAliasEntry *alias_entries =
+      reinterpret_cast<const VkQualityBrandAliasEntry *>(aliases_header + 1);
+  for (uint32_t i = 0; i < aliases_header->alias_count; ++i) {
+    if (alias_entries[i].alias_string_index >= header->string_table_count ||
+        alias_entries[i].brand_string_index == 0 ||
+        alias_entries[i].brand_string_index >= header->string_table_count) {
+      SetError(error_string, str_fmt("Invalid file: brand alias %u invalid", i));
+      return kFileParseResult_Error_BrandAliasesInvalid;
+    }
+  }
+  return kFileParseResult_Success;
+}
 
-  const size_t shortcut_offset_list_size = VkQualityPredictionFile::kShortcut_Offset_Count * sizeof(uint32_t);
-  const size_t shortcut_offset_list_end = header->device_list_shortcuts_offset + shortcut_offset_list_size;
-  if (shortcut_offset_list_end > file_size) {
-    file_parse_error_ = "Invalid file: shortcut offset list overflows end of file";
-    return kFileParseResult_Error_ShortcutOverflow;
+VkQualityPredictionFile::FileParseResult VkQualityPredictionFile::CheckDriverRules(
+    const VkQualityFileHeader *header, const FileSection &section, std::string *error_string) {
+  if (section.size < sizeof(VkQualityDriverRulesHeader)) {
+    SetError(error_string, "Invalid file: driver rules smaller than their header");
+    return kFileParseResult_Error_DriverRulesInvalid;
+  }
+  const VkQualityDriverRulesHeader *rules_header =
+      reinterpret_cast<const VkQualityDriverRulesHeader *>(
+          reinterpret_cast<const uint8_t *>(header) + section.offset);
+  const uint64_t rules_size = sizeof(VkQualityDriverRulesHeader) +
+      (static_cast<uint64_t>(rules_header->rule_count) * sizeof(VkQualityDriverRuleEntry));
+  if (rules_size > section.size) {
+    SetError(error_string, "Invalid file: driver rules overflow their section");
+    return kFileParseResult_Error_DriverRulesInvalid;
   }
 
+  // A rule needs a SoC or, for the Vulkan driver version decoded by vendor, a
+  // vendor id, otherwise it would match every device
+  const VkQualityDriverRuleEntry *rule_entries =
+      reinterpret_cast<const VkQualityDriverRuleEntry *>(rules_header + 1);
+  for (uint32_t i = 0; i < rules_header->rule_count; ++i) {
+    const bool vendor_keyed =
+        (rule_entries[i].version_format == VkQualityDriverVersion::kVersionFormat_Vulkan &&
+         rule_entries[i].vendor_id != 0);
+    if ((rule_entries[i].soc_string_index == 0 && !vendor_keyed) ||
+        rule_entries[i].soc_string_index >= header->string_table_count) {
+      SetError(error_string, str_fmt("Invalid file: driver rule %u invalid", i));
+      return kFileParseResult_Error_DriverRulesInvalid;
+    }
+  }
   return kFileParseResult_Success;
 }
 
+VkQualityPredictionFile::FileParseResult VkQualityPredictionFile::CheckCapabilityRules(
+    const VkQualityFileHeader *header, const FileSection &section, std::string *error_string) {
+  if (section.size < sizeof(VkQualityCapabilityRulesHeader)) {
+    SetError(error_string, "Invalid file: capability rules smaller than their header");
+    return kFileParseResult_Error_CapabilityRulesInvalid;
+  }
+  const VkQualityCapabilityRulesHeader *rules_header =
+      reinterpret_cast<const VkQualityCapabilityRulesHeader *>(
+          reinterpret_cast<const uint8_t *>(header) + section.offset);
+  const uint64_t rules_size = sizeof(VkQualityCapabilityRulesHeader) +
+      (static_cast<uint64_t>(rules_header->rule_count) * sizeof(VkQualityCapabilityRuleEntry));
+  if (rules_size > section.size) {
+    SetError(error_string, "Invalid file: capability rules overflow their section");
+    return kFileParseResult_Error_CapabilityRulesInvalid;
+  }
+
+  // A bit that is both required and forbidden is a rule that can never match
+  const VkQualityCapabilityRuleEntry *rule_entries =
+      reinterpret_cast<const VkQualityCapabilityRuleEntry *>(rules_header + 1);
+  for (uint32_t i = 0; i < rules_header->rule_count; ++i) {
+    if ((rule_entries[i].required_capabilities & rule_entries[i].forbidden_capabilities) != 0) {
+      SetError(error_string, str_fmt("Invalid file: capability rule %u invalid", i));
+      return kFileParseResult_Error_CapabilityRulesInvalid;
+    }
+  }
+  return kFileParseResult_Success;
+}
+
+VkQualityGpuColumns VkQualityPredictionFile::MapGpuColumns(const uint8_t *section_start) {
+  const VkQualityGpuColumnsHeader *columns_header =
+      reinterpret_cast<const VkQualityGpuColumnsHeader *>(section_start);
+  const uint32_t *column_start = reinterpret_cast<const uint32_t *>(columns_header + 1);
+  const uint32_t stride = columns_header->column_stride;
+  VkQualityGpuColumns columns;
+  columns.device_name_string_index = column_start;
+  columns.min_api_version = column_start + stride;
+  columns.device_id = column_start + (stride * 2);
+  columns.vendor_id = column_start + (stride * 3);
+  columns.min_driver_version = column_start + (stride * 4);
+  columns.count = columns_header->entry_count;
+  return columns;
+}
+
+bool VkQualityPredictionFile::AcquireSection(const SectionSlot slot) const {
+  if (file_header_ == nullptr) {
+    return false;
+  }
+  std::call_once(section_once_[slot], [this, slot]() {
+    section_valid_[slot] = sections_[slot].present &&
+        (sections_checked_ ||
+         CheckSection(file_header_, total_file_size_, sections_, slot, nullptr) ==
+             kFileParseResult_Success);
+    if (section_valid_[slot]) {
+      MapSection(slot);
+    }
+  });
+  return section_valid_[slot];
+}
+
+void VkQualityPredictionFile::MapSection(const SectionSlot slot) const {
+  const uint8_t *section_start = reinterpret_cast<const uint8_t *>(file_header_) +
+      sections_[slot].offset;
+  if (slot == kSectionSlot_DeviceShortcuts) {
+    device_shortcut_table_ = reinterpret_cast<const uint32_t *>(section_start);
+    for (uint32_t i = 0; i < kShortcut_Offset_Count; ++i) {
+      if (device_shortcut_table_[i] != 0) {
+        device_shortcuts_populated_ = true;
+        break;
+      }
+    }
+  } else if (slot == kSectionSlot_BrandIndex) {
+    brand_index_header_ = reinterpret_cast<const VkQualityBrandIndexHeader *>(section_start);
+    brand_index_table_ = reinterpret_cast<const VkQualityBrandIndexEntry *>(
+        brand_index_header_ + 1);
+    brand_device_index_ = reinterpret_cast<const uint32_t *>(
+        brand_index_table_ + brand_index_header_->brand_count);
+  } else if (slot == kSectionSlot_GpuAllowColumns) {
+    gpu_allow_columns_ = MapGpuColumns(section_start);
+  } else if (slot == kSectionSlot_GpuDenyColumns) {
+    gpu_deny_columns_ = MapGpuColumns(section_start);
+  } else if (slot == kSectionSlot_DeviceShards) {
+    device_shards_header_ = reinterpret_cast<const VkQualityDeviceShardsHeader *>(section_start);
+    device_shard_table_ = reinterpret_cast<const VkQualityDeviceShardEntry *>(
+        device_shards_header_ + 1);
+  } else if (slot == kSectionSlot_DriverAllowRules) {
+    driver_allow_rules_header_ =
+        reinterpret_cast<const VkQualityDriverRulesHeader *>(section_start);
+    driver_allow_rule_table_ = reinterpret_cast<const VkQualityDriverRuleEntry *>(
+        driver_allow_rules_header_ + 1);
+  } else if (slot == kSectionSlot_DriverDenyRules) {
+    driver_deny_rules_header_ =
+        reinterpret_cast<const VkQualityDriverRulesHeader *>(section_start);
+    driver_deny_rule_table_ = reinterpret_cast<const VkQualityDriverRuleEntry *>(
+        driver_deny_rules_header_ + 1);
+  } else if (slot == kSectionSlot_CapabilityAllowRules) {
+    capability_allow_rules_header_ =
+        reinterpret_cast<const VkQualityCapabilityRulesHeader *>(section_start);
+    capability_allow_rule_table_ = reinterpret_cast<const VkQualityCapabilityRuleEntry *>(
+        capability_allow_rules_header_ + 1);
+  } else if (slot == kSectionSlot_CapabilityDenyRules) {
+    capability_deny_rules_header_ =
+        reinterpret_cast<const VkQualityCapabilityRulesHeader *>(section_start);
+    capability_deny_rule_table_ = reinterpret_cast<const VkQualityCapabilityRuleEntry *>(
+        capability_deny_rules_header_ + 1);
+  } else if (slot == kSectionSlot_BrandAliases) {
+    brand_aliases_header_ = reinterpret_cast<const VkQualityBrandAliasHeader *>(section_start);
+    brand_alias_table_ = reinterpret_cast<const VkQualityBrandAliasEntry *>(
+        brand_aliases_header_ + 1);
+  }
+}
+
+const VkQualityPredictionFile *VkQualityPredictionFile::AcquireDeviceShard(
+    const uint32_t shortcut_index) const {
+  if (!AcquireSection(kSectionSlot_DeviceShards)) {
+    return nullptr;
+  }
+  std::call_once(shard_once_[shortcut_index], [this, shortcut_index]() {
+    const VkQualityDeviceShardEntry *shard_entry = nullptr;
+    for (uint32_t i = 0; i < device_shards_header_->shard_count; ++i) {
+      if (device_shard_table_[i].shortcut_index == shortcut_index) {
+        shard_entry = &device_shard_table_[i];
+        break;
+      }
+    }
+    if (shard_entry == nullptr || !shard_loader_) {
+      return;
+    }
+    size_t shard_size = 0;
+    void *shard_data = shard_loader_(GetString(shard_entry->shard_name_string_index),
+                                     shard_size);
+    if (shard_data == nullptr) {
+      return;
+    }
+    auto shard = std::make_unique<VkQualityPredictionFile>();
+    shard->SetValidationMode(validation_mode_);
+    shard->SetVerifyChecksum(verify_checksum_);
+    shard->SetStringIndex(string_index_);
+    if (shard->ParseFileData(shard_data, shard_size, library_version_) !=
+        kFileParseResult_Success) {
+      FreeFileData(shard_data, nullptr);
+      return;
+    }
+    // A shard left behind by a different list would give stale matches
+    if (shard->GetListVersion() == file_header_->list_version) {
+      device_shards_[shortcut_index] = std::move(shard);
+    }
+  });
+  return device_shards_[shortcut_index].get();
+}
+
 VkQualityPredictionFile::FileParseResult VkQualityPredictionFile::ParseFileData(
-    void *file_data, const size_t file_size, const uint32_t library_version) {
+    void *file_data, const size_t file_size, const uint32_t library_version,
+    FileDataRelease release_function, void *release_user_data) {
+  // Searches and overlays may already point into the parsed file data
+  if (file_header_ != nullptr) {
+    file_parse_error_ = "File data already parsed";
+    return kFileParseResult_Error_AlreadyParsed;
+  }
+  FileSection sections[kSectionSlot_Count];
   VkQualityPredictionFile::FileParseResult result =
-      ValidateFile(file_data, file_size, library_version);
-
+      ValidateFile(file_data, file_size, library_version, sections);
   if (result != kFileParseResult_Success) {
     return result;
   }
+  result = VerifyChecksum(file_data, file_size, sections[kSectionSlot_Checksum]);
+  if (result != kFileParseResult_Success) {
+    return result;
+  }
+  const VkQualityFileHeader *header = reinterpret_cast<const VkQualityFileHeader *>(file_data);
+  if (validation_mode_ == kValidation_Full) {
+    for (uint32_t slot = 0; slot < kSectionSlot_Count; ++slot) {
+      result = CheckSection(header, file_size, sections, static_cast<SectionSlot>(slot),
+                            &file_parse_error_);
+      if (result != kFileParseResult_Success) {
+        return result;
+      }
+    }
+  }
 
+  release_function_ = release_function;
+  release_user_data_ = release_user_data;
   total_file_size_ = file_size;
-  file_header_ = reinterpret_cast<const VkQualityFileHeader *>(file_data);
+  file_header_ = header;
+  library_version_ = library_version;
+  sections_checked_ = (validation_mode_ == kValidation_Full);
+  for (uint32_t slot = 0; slot < kSectionSlot_Count; ++slot) {
+    sections_[slot] = sections[slot];
+  }
   const uint8_t *file_start = reinterpret_cast<const uint8_t *>(file_data);
 
+  // The legacy lists have nothing to check beyond their bounds
   string_offset_table_ = reinterpret_cast<const uint32_t *>(
       (file_start + file_header_->string_table_offset));
-  device_shortcut_table_ = reinterpret_cast<const uint32_t *>(
-      (file_start + file_header_->device_list_shortcuts_offset));
   device_table_ = reinterpret_cast<const VkQualityDeviceAllowListEntry *>(
       (file_start + file_header_->device_list_offset));
   driver_allow_table_ = reinterpret_cast<const VkQualityDriverFingerprintEntry *>(
@@ -196,41 +775,334 @@ VkQualityPredictionFile::FileParseResult VkQualityPredictionFile::ParseFileData(
   return result;
 }
 
-VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::FindDeviceMatch(
-    const DeviceInfo &device_info, const int32_t flags) {
+uint64_t VkQualityPredictionFile::GetOverlayKey(const SearchStage stage, const char *data,
+                                               const size_t size, const bool fold_case) {
+  uint64_t key = 0xcbf29ce484222325ULL ^ stage;
+  for (size_t i = 0; i < size; ++i) {
+    uint8_t key_byte = static_cast<uint8_t>(data[i]);
+    // ASCII only like GetBrandKey, tolower depends on the locale
+    if (fold_case && key_byte >= 'A' && key_byte <= 'Z') {
+      key_byte = static_cast<uint8_t>(key_byte + ('a' - 'A'));
+    }
+    key = (key ^ key_byte) * 0x100000001b3ULL;
+  }
+  return key;
+}
 
-  // Search for a prediction from the SoC/fingerprint list
-  FileMatchResult result = kFileMatch_None;
-  if ((flags & kInitFlagSkipFingerprintRecommendationCheck) == 0) {
-      result = SearchDriverLists(device_info);
+bool VkQualityPredictionFile::AddOverlay(std::unique_ptr<VkQualityPredictionFile> overlay) {
+  if (file_header_ == nullptr || overlay == nullptr || overlay->file_header_ == nullptr ||
+      overlays_.size() >= kMax_Overlay_Count) {
+    return false;
+  }
+  // Overlays are searched in full, the shards of a sharded overlay would never be loaded
+  if (overlay->AcquireSection(kSectionSlot_DeviceShards)) {
+    return false;
+  }
+  const uint32_t below_version = overlays_.empty() ? GetListVersion() : GetOverlayListVersion();
+  if (overlay->GetListVersion() <= below_version) {
+    return false;
+  }
+  IndexOverlay(static_cast<uint32_t>(overlays_.size()), *overlay);
+  overlays_.push_back(std::move(overlay));
+  return true;
+}
+
+void VkQualityPredictionFile::IndexOverlay(const uint32_t overlay_index,
+                                           const VkQualityPredictionFile &overlay) {
+  const uint32_t overlay_bit = 1U << overlay_index;
+  auto add_key = [this, overlay_bit](const SearchStage stage, const char *data,
+                                     const size_t size, const bool fold_case) {
+    overlay_index_.push_back({GetOverlayKey(stage, data, size, fold_case), overlay_bit});
+  };
+  const VkQualityFileHeader &header = *overlay.file_header_;
+
+  // SoC names compare ignoring case
+  for (uint32_t i = 0; i < header.soc_allow_count; ++i) {
+    const char *soc = overlay.GetString(overlay.soc_allow_table_[i].soc_string_index);
+    add_key(kSearchStage_Driver, soc, strlen(soc), true);
+  }
+  for (uint32_t i = 0; i < header.soc_deny_count; ++i) {
+    const char *soc = overlay.GetString(overlay.soc_deny_table_[i].soc_string_index);
+    add_key(kSearchStage_Driver, soc, strlen(soc), true);
+  }
+  // Driver rules without a SoC are keyed by vendor id
+  auto add_rule_key = [&overlay, &add_key](const VkQualityDriverRuleEntry &rule) {
+    if (rule.soc_string_index == 0) {
+      add_key(kSearchStage_Driver, reinterpret_cast<const char *>(&rule.vendor_id),
+              sizeof(rule.vendor_id), false);
+    } else {
+      const char *soc = overlay.GetString(rule.soc_string_index);
+      add_key(kSearchStage_Driver, soc, strlen(soc), true);
+    }
+  };
+  if (overlay.AcquireSection(kSectionSlot_DriverAllowRules)) {
+    for (uint32_t i = 0; i < overlay.driver_allow_rules_header_->rule_count; ++i) {
+      add_rule_key(overlay.driver_allow_rule_table_[i]);
+    }
+  }
+  if (overlay.AcquireSection(kSectionSlot_DriverDenyRules)) {
+    for (uint32_t i = 0; i < overlay.driver_deny_rules_header_->rule_count; ++i) {
+      add_rule_key(overlay.driver_deny_rule_table_[i]);
+    }
+  }
+
+  // Capability rules match any device, there is no key to index them by
+  if (overlay.AcquireSection(kSectionSlot_CapabilityAllowRules)) {
+    overlay_unkeyed_mask_[kSearchStage_CapabilityAllow] |= overlay_bit;
+  }
+  if (overlay.AcquireSection(kSectionSlot_CapabilityDenyRules)) {
+    overlay_unkeyed_mask_[kSearchStage_CapabilityDeny] |= overlay_bit;
+  }
+
+  // Device rows are keyed by the brand key
+  for (uint32_t i = 0; i < header.device_list_count; ++i) {
+    const std::string brand_key =
+        GetBrandKey(overlay.GetString(overlay.device_table_[i].brand_string_index));
+    add_key(kSearchStage_Device, brand_key.data(), brand_key.size(), false);
+  }
+  // A device with an alias brand key searches the rows of the alias brand
+  if (overlay.AcquireSection(kSectionSlot_BrandAliases)) {
+    for (uint32_t i = 0; i < overlay.brand_aliases_header_->alias_count; ++i) {
+      const char *alias = overlay.GetString(overlay.brand_alias_table_[i].alias_string_index);
+      add_key(kSearchStage_Device, alias, strlen(alias), false);
+    }
+  }
+
+  // GPU entries match by ID pair or by name, a name pattern can't be keyed
+  for (const bool deny_list : {false, true}) {
+    const VkQualityGpuPredictEntry *gpu_table = deny_list ? overlay.gpu_deny_table_ :
+        overlay.gpu_allow_table_;
+    const uint32_t gpu_count = deny_list ? header.gpu_deny_predict_count :
+        header.gpu_allow_predict_count;
+    for (uint32_t i = 0; i < gpu_count; ++i) {
+      const uint32_t gpu_ids[2] = {gpu_table[i].device_id, gpu_table[i].vendor_id};
+      add_key(kSearchStage_Gpu, reinterpret_cast<const char *>(gpu_ids), sizeof(gpu_ids),
+              false);
+      const char *device_name = overlay.GetString(gpu_table[i].device_name_string_index);
+      if (device_name[0] == '^' || strchr(device_name, '*') != nullptr) {
+        overlay_unkeyed_mask_[kSearchStage_Gpu] |= overlay_bit;
+      } else if (device_name[0] != '\0') {
+        add_key(kSearchStage_Gpu, device_name, strlen(device_name), false);
+      }
+    }
+  }
+
+  std::sort(overlay_index_.begin(), overlay_index_.end(),
+            [](const OverlayKey &a, const OverlayKey &b) { return a.key < b.key; });
+  size_t merged_count = 0;
+  for (const OverlayKey &overlay_key : overlay_index_) {
+    if (merged_count > 0 && overlay_index_[merged_count - 1].key == overlay_key.key) {
+      overlay_index_[merged_count - 1].overlay_mask |= overlay_key.overlay_mask;
+    } else {
+      overlay_index_[merged_count++] = overlay_key;
+    }
+  }
+  overlay_index_.resize(merged_count);
+}
+
+uint32_t VkQualityPredictionFile::GetOverlayMask(const SearchStage stage,
+                                                 const DeviceInfo &device_info) const {
+  uint32_t overlay_mask = overlay_unkeyed_mask_[stage];
+  auto find_key = [this, &overlay_mask](const uint64_t key) {
+    const auto found = std::lower_bound(
+        overlay_index_.begin(), overlay_index_.end(), key,
+        [](const OverlayKey &overlay_key, const uint64_t find) { return overlay_key.key < find; });
+    if (found != overlay_index_.end() && found->key == key) {
+      overlay_mask |= found->overlay_mask;
+    }
+  };
+  if (stage == kSearchStage_Driver) {
+    find_key(GetOverlayKey(stage, device_info.soc.data(), device_info.soc.size(), true));
+    find_key(GetOverlayKey(stage, reinterpret_cast<const char *>(&device_info.vk_vendor_id),
+                           sizeof(device_info.vk_vendor_id), false));
+  } else if (stage == kSearchStage_Device) {
+    const std::string brand_key = GetBrandKey(device_info.brand);
+    find_key(GetOverlayKey(stage, brand_key.data(), brand_key.size(), false));
+  } else if (stage == kSearchStage_Gpu) {
+    const uint32_t gpu_ids[2] = {device_info.vk_device_id, device_info.vk_vendor_id};
+    find_key(GetOverlayKey(stage, reinterpret_cast<const char *>(gpu_ids), sizeof(gpu_ids),
+                           false));
+    find_key(GetOverlayKey(stage, device_info.vk_device_name.data(),
+                           device_info.vk_device_name.size(), false));
+  }
+  return overlay_mask;
+}
+
+VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchLayers(
+    const SearchStage stage, const DeviceInfo &device_info, uint32_t &match_index) const {
+  const uint32_t overlay_mask = overlays_.empty() ? 0 : GetOverlayMask(stage, device_info);
+  for (size_t i = overlays_.size(); i > 0 && overlay_mask != 0; --i) {
+    if ((overlay_mask & (1U << (i - 1))) != 0) {
+      const FileMatchResult result = overlays_[i - 1]->SearchOwnLists(stage, device_info,
+                                                                      match_index);
       if (result != kFileMatch_None) {
-          return result;
+        return result;
       }
+    }
+  }
+  return SearchOwnLists(stage, device_info, match_index);
+}
+
+VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchOwnLists(
+    const SearchStage stage, const DeviceInfo &device_info, uint32_t &match_index) const {
+  if (stage == kSearchStage_Driver) {
+    return SearchDriverLists(device_info, match_index);
+  } else if (stage == kSearchStage_Device) {
+    return SearchDeviceList(device_info, match_index);
+  } else if (stage == kSearchStage_CapabilityDeny) {
+    return SearchCapabilityRules(device_info, kFileMatch_CapabilityDeny, match_index);
+  } else if (stage == kSearchStage_CapabilityAllow) {
+    return SearchCapabilityRules(device_info, kFileMatch_CapabilityAllow, match_index);
+  }
+  return SearchGpuLists(device_info, match_index);
+}
+
+VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::FindDeviceMatch(
+    const DeviceInfo &device_info, const int32_t flags, uint32_t *match_index) const {
+  uint32_t found_index = 0;
+
+  // A device without a capability the renderer depends on can't run it well,
+  // whatever the other lists predict
+  FileMatchResult result = SearchLayers(kSearchStage_CapabilityDeny, device_info, found_index);
+
+  // Search for a prediction from the SoC/fingerprint list
+  if (result == kFileMatch_None && (flags & kInitFlagSkipFingerprintRecommendationCheck) == 0) {
+      result = SearchLayers(kSearchStage_Driver, device_info, found_index);
+  }
+  if (result == kFileMatch_None) {
+    // Next search for an explicit device match in the device list
+    result = SearchLayers(kSearchStage_Device, device_info, found_index);
   }
-  // Next search for an explicit device match in the device list
-  result = SearchDeviceList(device_info);
   if (result == kFileMatch_None) {
     // If there was no device match, look for a GPU allow or deny prediction match
-    result = SearchGpuLists(device_info);
+    result = SearchLayers(kSearchStage_Gpu, device_info, found_index);
+  }
+  if (result == kFileMatch_None) {
+    result = SearchLayers(kSearchStage_CapabilityAllow, device_info, found_index);
   }
 
+  if (match_index != nullptr) {
+    *match_index = (result == kFileMatch_None) ? 0 : found_index;
+  }
   return result;
 }
 
+const DeviceInfo &VkQualityPredictionFile::GetKeyedDeviceInfo(const DeviceInfo &device_info,
+                                                              DeviceInfo &keyed_info) const {
+  if (file_header_->file_format_version < kBrandKey_File_Format_Version) {
+    return device_info;
+  }
+  std::string brand_key = GetBrandKey(device_info.brand);
+  ResolveBrandAlias(brand_key);
+  // Most devices report a brand that is already its own key
+  if (brand_key == device_info.brand) {
+    return device_info;
+  }
+  keyed_info = device_info;
+  keyed_info.brand = std::move(brand_key);
+  return keyed_info;
+}
+
+void VkQualityPredictionFile::ResolveBrandAlias(std::string &brand_key) const {
+  if (brand_key.empty() || !AcquireSection(kSectionSlot_BrandAliases)) {
+    return;
+  }
+  const uint32_t alias_count = brand_aliases_header_->alias_count;
+  uint32_t alias_low = 0;
+  uint32_t alias_high = alias_count;
+  while (alias_low < alias_high) {
+    const uint32_t alias_mid = alias_low + ((alias_high - alias_low) / 2);
+    if (strcmp(GetString(brand_alias_table_[alias_mid].alias_string_index),
+               brand_key.c_str()) < 0) {
+      alias_low = alias_mid + 1;
+    } else {
+      alias_high = alias_mid;
+    }
+  }
+  // A brand string that fails its bounds check leaves the key unchanged
+  if (alias_low < alias_count &&
+      strcmp(GetString(brand_alias_table_[alias_low].alias_string_index),
+             brand_key.c_str()) == 0) {
+    const char *alias_brand = GetString(brand_alias_table_[alias_low].brand_string_index);
+    if (alias_brand[0] != '\0') {
+      brand_key = alias_brand;
+    }
+  }
+}
+
 VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchDeviceList(
-    const DeviceInfo &device_info) {
+    const DeviceInfo &device_info, uint32_t &match_index) const {
+  DeviceInfo keyed_info;
+  return SearchDeviceRows(GetKeyedDeviceInfo(device_info, keyed_info), match_index);
+}
 
-  // Shortcut offset table is sorted Device.BRAND from A-Z and then everything else, default to
-  // the 'everything else' entry after the alphabet
-  uint32_t letter_index = 26;
-  const char brand_first_letter = toupper(device_info.brand.c_str()[0]);
-  if (brand_first_letter >= 'A' && brand_first_letter <= 'Z') {
-    letter_index = brand_first_letter - 'A';
+VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchDeviceRows(
+    const DeviceInfo &device_info, uint32_t &match_index) const {
+  // Shortcut offset table is sorted Device.BRAND from A-Z and then everything else, a
+  // bucket ends where the next one starts
+  const char *device_brand = device_info.brand.c_str();
+  const uint32_t letter_index = GetBrandShortcutIndex(device_brand);
+
+  // The rows of a sharded bucket are only in its shard file, match_index is an
+  // index into the device list of the shard
+  if (AcquireSection(kSectionSlot_DeviceShards)) {
+    const VkQualityPredictionFile *device_shard = AcquireDeviceShard(letter_index);
+    if (device_shard != nullptr) {
+      return device_shard->SearchDeviceList(device_info, match_index);
+    }
+  }
+
+  if (AcquireSection(kSectionSlot_BrandIndex)) {
+    return SearchBrandRows(device_info, match_index);
+  }
+  uint32_t start_device_table_index = 0;
+  uint32_t end_device_table_index = file_header_->device_list_count;
+  // A shortcut table that fails its check is treated like an unpopulated one
+  AcquireSection(kSectionSlot_DeviceShortcuts);
+  if (device_shortcuts_populated_) {
+    start_device_table_index = device_shortcut_table_[letter_index];
+    if (letter_index + 1 < kShortcut_Offset_Count) {
+      end_device_table_index = device_shortcut_table_[letter_index + 1];
+    }
+  }
+  // Once past the brand in a sorted bucket, the rest of the bucket can't match
+  const bool brand_sorted = device_shortcuts_populated_ &&
+      file_header_->file_format_version >= kBrandSorted_File_Format_Version;
+
+  if (AcquireStringIndex()) {
+    // Only rows with the brand's string index can match, a brand that isn't
+    // in the string table can't match any row
+    const uint32_t brand_id = FindStringId(device_brand);
+    if (brand_id >= kEmpty_String_Id) {
+      return kFileMatch_None;
+    }
+    const uint32_t device_id = FindStringId(device_info.device.c_str());
+    uint32_t previous_brand_index = kAbsent_String_Id;
+    for (uint32_t i = start_device_table_index; i < end_device_table_index; ++i) {
+      // Rows with the same brand index have the same brand, the sort order only
+      // needs checking where a run of rows of one brand starts
+      const uint32_t brand_index = device_table_[i].brand_string_index;
+      if (brand_sorted && brand_index != previous_brand_index) {
+        if (CompareBrandOrder(GetString(brand_index), device_brand) > 0) {
+          break;
+        }
+        previous_brand_index = brand_index;
+      }
+      const FileMatchResult result = CheckInternedDevice(device_info, device_table_[i],
+                                                         brand_id, device_id);
+      if (result != kFileMatch_None) {
+        match_index = i;
+        return result;
+      }
+    }
+    return kFileMatch_None;
   }
-  const uint32_t start_device_table_index = device_shortcut_table_[letter_index];
 
-  for (uint32_t i = start_device_table_index; i < file_header_->device_list_count; ++i) {
+  for (uint32_t i = start_device_table_index; i < end_device_table_index; ++i) {
     const char *brand_string = GetString(device_table_[i].brand_string_index);
+    if (brand_sorted && CompareBrandOrder(brand_string, device_brand) > 0) {
+      break;
+    }
     const char *device_string = GetString(device_table_[i].device_string_index);
     std::string_view brand_view(brand_string);
     std::string_view device_view(device_string);
@@ -240,33 +1112,192 @@ VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchDeviceLi
                                                                  device_table_[i].min_api_version,
                                                                  device_table_[i].min_driver_version);
     if (result != kFileMatch_None) {
+      match_index = i;
       return result;
     }
   }
   return kFileMatch_None;
 }
 
+VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchBrandIndex(
+    const DeviceInfo &device_info, uint32_t &match_index) const {
+  if (!AcquireSection(kSectionSlot_BrandIndex)) {
+    return kFileMatch_None;
+  }
+  DeviceInfo keyed_info;
+  return SearchBrandRows(GetKeyedDeviceInfo(device_info, keyed_info), match_index);
+}
+
+VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchBrandRows(
+    const DeviceInfo &device_info, uint32_t &match_index) const {
+  const char *device_brand = device_info.brand.c_str();
+  const bool interned = AcquireStringIndex();
+  uint32_t brand_id = kAbsent_String_Id;
+  uint32_t device_id = kAbsent_String_Id;
+  if (interned) {
+    brand_id = FindStringId(device_brand);
+    if (brand_id >= kEmpty_String_Id) {
+      return kFileMatch_None;
+    }
+    device_id = FindStringId(device_info.device.c_str());
+  }
+  const uint32_t brand_count = brand_index_header_->brand_count;
+  uint32_t brand_low = 0;
+  uint32_t brand_high = brand_count;
+  while (brand_low < brand_high) {
+    const uint32_t brand_mid = brand_low + ((brand_high - brand_low) / 2);
+    if (strcmp(GetString(brand_index_table_[brand_mid].brand_string_index), device_brand) < 0) {
+      brand_low = brand_mid + 1;
+    } else {
+      brand_high = brand_mid;
+    }
+  }
+  if (brand_low == brand_count ||
+      strcmp(GetString(brand_index_table_[brand_low].brand_string_index), device_brand) != 0) {
+    return kFileMatch_None;
+  }
+
+  const uint32_t range_start = brand_index_table_[brand_low].device_index_start;
+  const uint32_t range_end = range_start + brand_index_table_[brand_low].device_index_count;
+  auto device_string = [this](const uint32_t index) {
+    return GetString(device_table_[brand_device_index_[index]].device_string_index);
+  };
+
+  // Only brand wildcard entries and entries for this exact device can match. The
+  // device list scan returns the first match in list order, so do the same here.
+  FileMatchResult result = kFileMatch_None;
+  auto check_device = [&](const uint32_t index) {
+    const uint32_t device_table_index = brand_device_index_[index];
+    if (result != kFileMatch_None && device_table_index >= match_index) {
+      return;
+    }
+    const VkQualityDeviceAllowListEntry &entry = device_table_[device_table_index];
+    const FileMatchResult device_result = interned ?
+        CheckInternedDevice(device_info, entry, brand_id, device_id) :
+        VkQualityMatching::CheckDeviceMatch(device_info, GetString(entry.brand_string_index),
+                                            GetString(entry.device_string_index),
+                                            entry.min_api_version, entry.min_driver_version);
+    if (device_result != kFileMatch_None) {
+      result = device_result;
+      match_index = device_table_index;
+    }
+  };
+
+  // Empty device strings sort to the start of the brand range
+  for (uint32_t i = range_start; i < range_end && device_string(i)[0] == '\0'; ++i) {
+    check_device(i);
+  }
+  // A device that isn't in the string table can only match brand wildcards
+  if (!device_info.device.empty() && !(interned && device_id == kAbsent_String_Id)) {
+    const char *device_name = device_info.device.c_str();
+    uint32_t device_low = range_start;
+    uint32_t device_high = range_end;
+    while (device_low < device_high) {
+      const uint32_t device_mid = device_low + ((device_high - device_low) / 2);
+      if (strcmp(device_string(device_mid), device_name) < 0) {
+        device_low = device_mid + 1;
+      } else {
+        device_high = device_mid;
+      }
+    }
+    for (uint32_t i = device_low; i < range_end && strcmp(device_string(i), device_name) == 0;
+         ++i) {
+      check_device(i);
+    }
+  }
+  return result;
+}
+
 VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchDriverLists(
-    const DeviceInfo &device_info) {
-  FileMatchResult result = SearchDriverList(device_info, kFileMatch_DriverAllow);
+    const DeviceInfo &device_info, uint32_t &match_index) const {
+  FileMatchResult result = SearchDriverList(device_info, kFileMatch_DriverAllow, match_index);
+  if (result == kFileMatch_None) {
+    result = SearchDriverList(device_info, kFileMatch_DriverDeny, match_index);
+  }
+  // An exact fingerprint is more specific than a version range
+  if (result == kFileMatch_None) {
+    result = SearchDriverRules(device_info, kFileMatch_DriverRuleAllow, match_index);
+  }
   if (result == kFileMatch_None) {
-    result = SearchDriverList(device_info, kFileMatch_DriverDeny);
+    result = SearchDriverRules(device_info, kFileMatch_DriverRuleDeny, match_index);
   }
   return result;
 }
 
+VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchDriverRules(
+    const DeviceInfo &device_info, const FileMatchResult match_result,
+    uint32_t &match_index) const {
+  const VkQualityDriverRulesHeader *rules_header;
+  const VkQualityDriverRuleEntry *rule_table;
+  if (match_result == kFileMatch_DriverRuleAllow &&
+      AcquireSection(kSectionSlot_DriverAllowRules)) {
+    rules_header = driver_allow_rules_header_;
+    rule_table = driver_allow_rule_table_;
+  } else if (match_result == kFileMatch_DriverRuleDeny &&
+             AcquireSection(kSectionSlot_DriverDenyRules)) {
+    rules_header = driver_deny_rules_header_;
+    rule_table = driver_deny_rule_table_;
+  } else {
+    return kFileMatch_None;
+  }
+
+  // Rules are in priority order, the first SoC and version range match wins. Rules
+  // without a SoC are keyed by vendor, and also match devices without a SoC.
+  VkQualityMatching::DriverVersionCache version_cache;
+  for (uint32_t i = 0; i < rules_header->rule_count; ++i) {
+    const VkQualityDriverRuleEntry &rule = rule_table[i];
+    if ((rule.soc_string_index == 0 ||
+         (!device_info.soc.empty() &&
+          strcasecmp(GetString(rule.soc_string_index), device_info.soc.c_str()) == 0)) &&
+        VkQualityMatching::CheckDriverRuleMatch(device_info, rule, version_cache)) {
+      match_index = i;
+      return match_result;
+    }
+  }
+  return kFileMatch_None;
+}
+
+VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchCapabilityRules(
+    const DeviceInfo &device_info, const FileMatchResult match_result,
+    uint32_t &match_index) const {
+  if (device_info.vk_capabilities == 0) {
+    return kFileMatch_None;
+  }
+  const VkQualityCapabilityRulesHeader *rules_header;
+  const VkQualityCapabilityRuleEntry *rule_table;
+  if (match_result == kFileMatch_CapabilityAllow &&
+      AcquireSection(kSectionSlot_CapabilityAllowRules)) {
+    rules_header = capability_allow_rules_header_;
+    rule_table = capability_allow_rule_table_;
+  } else if (match_result == kFileMatch_CapabilityDeny &&
+             AcquireSection(kSectionSlot_CapabilityDenyRules)) {
+    rules_header = capability_deny_rules_header_;
+    rule_table = capability_deny_rule_table_;
+  } else {
+    return kFileMatch_None;
+  }
+
+  // Rules are in priority order, the first match wins
+  for (uint32_t i = 0; i < rules_header->rule_count; ++i) {
+    if (VkQualityMatching::CheckCapabilityRuleMatch(device_info, rule_table[i])) {
+      match_index = i;
+      return match_result;
+    }
+  }
+  return kFileMatch_None;
+}
+
 VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchDriverList(
-    const DeviceInfo &device_info, const FileMatchResult match_result) {
+    const DeviceInfo &device_info, const FileMatchResult match_result,
+    uint32_t &match_index) const {
   if (device_info.soc.empty()) {
     // SoC check requires Android API >= 31, string will be empty on
     // earlier versions of Android
     return kFileMatch_None;
   }
 
-  // Linear search at the moment for simplicity and small list sizes, the
-  // data for SoC strings and driver fingerprint strings should be alphabetically
-  // sorted in a manner compatible with performing a binary search for a future
-  // optimization
+  // The SoC row and fingerprint are looked up in the string hash index, files
+  // with repeated strings fall back to a linear search comparing strings
   uint32_t driver_count;
   uint32_t soc_count;
   const VkQualityDriverFingerprintEntry *driver_table;
@@ -285,6 +1316,24 @@ VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchDriverLi
     return kFileMatch_None;
   }
 
+  if (AcquireStringIndex()) {
+    const uint32_t soc_index = FindSoCRow(match_result, device_info.soc.c_str());
+    const uint32_t fingerprint_id = FindStringId(device_info.gles_version.c_str());
+    if (soc_index == kAbsent_String_Id || fingerprint_id == kAbsent_String_Id) {
+      return kFileMatch_None;
+    }
+    const uint32_t fingerprint_offset = soc_table[soc_index].soc_fingerprint_offset;
+    const uint32_t fingerprint_count = soc_table[soc_index].soc_fingerprint_count;
+    for (uint32_t driver_index = fingerprint_offset;
+        driver_index < (fingerprint_offset + fingerprint_count); ++driver_index) {
+      if (IsStringId(driver_table[driver_index].driver_version_string_index, fingerprint_id)) {
+        match_index = driver_index;
+        return match_result;
+      }
+    }
+    return kFileMatch_None;
+  }
+
   for (uint32_t soc_index = 0; soc_index < soc_count; ++soc_index) {
     const char *soc_string = GetString(soc_table[soc_index].soc_string_index);
     if (strcasecmp(soc_string, device_info.soc.c_str()) == 0) {
@@ -295,6 +1344,7 @@ VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchDriverLi
         const char *fingerprint_string =
             GetString(driver_table[driver_index].driver_version_string_index);
         if (strcmp(fingerprint_string, device_info.gles_version.c_str()) == 0) {
+          match_index = driver_index;
           return match_result;
         }
       }
@@ -306,30 +1356,56 @@ VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchDriverLi
 }
 
 VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchGpuLists(
-    const DeviceInfo &device_info) {
+    const DeviceInfo &device_info, uint32_t &match_index) const {
 
-  FileMatchResult result = SearchGpuList(device_info, kFileMatch_GpuAllow);
+  FileMatchResult result = SearchGpuList(device_info, kFileMatch_GpuAllow, match_index);
   if (result == kFileMatch_None) {
-    result = SearchGpuList(device_info, kFileMatch_GpuDeny);
+    result = SearchGpuList(device_info, kFileMatch_GpuDeny, match_index);
   }
   return result;
 }
 
 VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchGpuList(
-    const DeviceInfo &device_info, const FileMatchResult match_result) {
+    const DeviceInfo &device_info, const FileMatchResult match_result,
+    uint32_t &match_index) const {
 
   const VkQualityGpuPredictEntry *gpu_table;
+  const VkQualityGpuColumns *gpu_columns;
   uint32_t table_count;
+  SectionSlot columns_slot;
   if (match_result == kFileMatch_GpuAllow) {
     gpu_table = gpu_allow_table_;
+    gpu_columns = &gpu_allow_columns_;
+    columns_slot = kSectionSlot_GpuAllowColumns;
     table_count = file_header_->gpu_allow_predict_count;
   } else if (match_result == kFileMatch_GpuDeny) {
     gpu_table = gpu_deny_table_;
+    gpu_columns = &gpu_deny_columns_;
+    columns_slot = kSectionSlot_GpuDenyColumns;
     table_count = file_header_->gpu_deny_predict_count;
   } else {
     return kFileMatch_None;
   }
 
+  if (AcquireSection(columns_slot)) {
+    // Vector scan of the ID and version columns, only candidates compare strings
+    const bool deny_list = (match_result == kFileMatch_GpuDeny);
+    for (uint32_t i = VkQualityColumnScan::FindGpuCandidate(*gpu_columns, device_info,
+                                                            deny_list, 0);
+         i < gpu_columns->count;
+         i = VkQualityColumnScan::FindGpuCandidate(*gpu_columns, device_info, deny_list, i + 1)) {
+      FileMatchResult result = VkQualityMatching::CheckGpuMatch(
+          device_info, GetString(gpu_columns->device_name_string_index[i]),
+          gpu_columns->device_id[i], gpu_columns->vendor_id[i],
+          gpu_columns->min_api_version[i], gpu_columns->min_driver_version[i], match_result);
+      if (result == match_result) {
+        match_index = i;
+        return result;
+      }
+    }
+    return kFileMatch_None;
+  }
+
   for (uint32_t i = 0; i < table_count; ++i) {
     const char *device_string = GetString(gpu_table[i].device_name_string_index);
     std::string_view device_view(device_string);
@@ -341,6 +1417,7 @@ VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchGpuList(
                                                               gpu_table[i].min_driver_version,
                                                               match_result);
     if (result == match_result) {
+      match_index = i;
       return result;
     }
   }
@@ -348,7 +1425,137 @@ VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::SearchGpuList(
   return kFileMatch_None;
 }
 
-const char *VkQualityPredictionFile::GetString(const uint32_t string_index) {
+bool VkQualityPredictionFile::AcquireStringIndex() const {
+  if (file_header_ == nullptr || !string_index_) {
+    return false;
+  }
+  std::call_once(string_index_once_, [this]() { BuildStringIndex(); });
+  return string_index_valid_;
+}
+
+static uint64_t MakeHashSlot(const uint32_t hash, const uint32_t index) {
+  return (static_cast<uint64_t>(hash) << 32) | (index + 1);
+}
+
+void VkQualityPredictionFile::BuildStringIndex() const {
+  const uint32_t string_count = file_header_->string_table_count;
+  std::vector<uint64_t> string_slots(GetHashSlotCount(string_count), 0);
+  const size_t string_mask = string_slots.size() - 1;
+  for (uint32_t i = 0; i < string_count; ++i) {
+    const char *string = GetString(i);
+    const uint32_t hash = HashString(string, false);
+    size_t slot = hash & string_mask;
+    while (string_slots[slot] != 0) {
+      // A repeated string has more than one index, so indices can't be
+      // compared. Strings that fail their bounds check read as empty strings.
+      if ((string_slots[slot] >> 32) == hash &&
+          strcmp(GetString(static_cast<uint32_t>(string_slots[slot]) - 1), string) == 0) {
+        return;
+      }
+      slot = (slot + 1) & string_mask;
+    }
+    string_slots[slot] = MakeHashSlot(hash, i);
+    if (string[0] == '\0') {
+      empty_string_index_ = i;
+    }
+  }
+
+  // SoC names compare ignoring case, the first row of a SoC is the one a
+  // row scan would find
+  auto build_soc_slots = [this](const VkQualityDriverSoCEntry *soc_table,
+                                const uint32_t soc_count, std::vector<uint64_t> &soc_slots) {
+    soc_slots.assign(GetHashSlotCount(soc_count), 0);
+    const size_t soc_mask = soc_slots.size() - 1;
+    for (uint32_t row = 0; row < soc_count; ++row) {
+      const char *soc = GetString(soc_table[row].soc_string_index);
+      const uint32_t hash = HashString(soc, true);
+      size_t slot = hash & soc_mask;
+      while (soc_slots[slot] != 0 &&
+             ((soc_slots[slot] >> 32) != hash ||
+              strcasecmp(GetString(soc_table[static_cast<uint32_t>(soc_slots[slot]) - 1]
+                                       .soc_string_index), soc) != 0)) {
+        slot = (slot + 1) & soc_mask;
+      }
+      if (soc_slots[slot] == 0) {
+        soc_slots[slot] = MakeHashSlot(hash, row);
+      }
+    }
+  };
+  build_soc_slots(soc_allow_table_, file_header_->soc_allow_count, soc_allow_slots_);
+  build_soc_slots(soc_deny_table_, file_header_->soc_deny_count, soc_deny_slots_);
+  string_slots_ = std::move(string_slots);
+  string_index_valid_ = true;
+}
+
+uint32_t VkQualityPredictionFile::FindStringId(const char *string) const {
+  if (string[0] == '\0') {
+    return kEmpty_String_Id;
+  }
+  if (!AcquireStringIndex()) {
+    return kAbsent_String_Id;
+  }
+  const uint32_t hash = HashString(string, false);
+  const size_t string_mask = string_slots_.size() - 1;
+  for (size_t slot = hash & string_mask; string_slots_[slot] != 0;
+       slot = (slot + 1) & string_mask) {
+    const uint32_t string_index = static_cast<uint32_t>(string_slots_[slot]) - 1;
+    if ((string_slots_[slot] >> 32) == hash && strcmp(GetString(string_index), string) == 0) {
+      return string_index;
+    }
+  }
+  return kAbsent_String_Id;
+}
+
+uint32_t VkQualityPredictionFile::FindSoCRow(const FileMatchResult match_result,
+                                             const char *soc) const {
+  const bool allow_list = (match_result == kFileMatch_DriverAllow);
+  const std::vector<uint64_t> &soc_slots = allow_list ? soc_allow_slots_ : soc_deny_slots_;
+  const VkQualityDriverSoCEntry *soc_table = allow_list ? soc_allow_table_ : soc_deny_table_;
+  const uint32_t hash = HashString(soc, true);
+  const size_t soc_mask = soc_slots.size() - 1;
+  for (size_t slot = hash & soc_mask; soc_slots[slot] != 0; slot = (slot + 1) & soc_mask) {
+    const uint32_t row = static_cast<uint32_t>(soc_slots[slot]) - 1;
+    if ((soc_slots[slot] >> 32) == hash &&
+        strcasecmp(GetString(soc_table[row].soc_string_index), soc) == 0) {
+      return row;
+    }
+  }
+  return kAbsent_String_Id;
+}
+
+bool VkQualityPredictionFile::IsStringId(const uint32_t string_index,
+                                         const uint32_t string_id) const {
+  // Indices out of bounds read as the empty string
+  if (string_id == kEmpty_String_Id) {
+    return string_index >= file_header_->string_table_count ||
+        string_index == empty_string_index_;
+  }
+  return string_index == string_id;
+}
+
+VkQualityPredictionFile::FileMatchResult VkQualityPredictionFile::CheckInternedDevice(
+    const DeviceInfo &device_info, const VkQualityDeviceAllowListEntry &entry,
+    const uint32_t brand_id, const uint32_t device_id) const {
+  // Same rules as VkQualityMatching::CheckDeviceMatch, brand_id is never empty
+  if (entry.brand_string_index != brand_id) {
+    return kFileMatch_None;
+  }
+  // A negative API level compares as a large unsigned value in CheckDeviceMatch,
+  // so it is never too old
+  const bool version_too_old =
+      (entry.min_api_version > 0 && device_info.api_level >= 0 &&
+       static_cast<uint32_t>(device_info.api_level) < entry.min_api_version) ||
+      (entry.min_driver_version > 0 && device_info.vk_driver_version < entry.min_driver_version);
+  if (IsStringId(entry.device_string_index, kEmpty_String_Id)) {
+    return version_too_old ? kFileMatch_None : kFileMatch_BrandWildcard;
+  }
+  if (device_id >= kEmpty_String_Id || entry.device_string_index != device_id) {
+    return kFileMatch_None;
+  }
+  return version_too_old ? kFileMatch_DeviceOldVersion : kFileMatch_ExactDevice;
+}
+
+const char *VkQualityPredictionFile::GetString(const uint32_t string_index) const {
   // Bounds check both the string index and the actual string data, return
   // a placeholder null string if either end up out of bounds
   if (string_index >= file_header_->string_table_count) {
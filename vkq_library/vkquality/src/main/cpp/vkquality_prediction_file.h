@@ -17,8 +17,15 @@
 #ifndef VKQUALITY_PREDICTION_FILE_H_
 #define VKQUALITY_PREDICTION_FILE_H_
 
+#include "vkquality_column_scan.h"
 #include "vkquality_device_info.h"
 #include "vkquality_file_format.h"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace vkquality {
 
@@ -27,6 +34,35 @@ public:
   static constexpr uint32_t kVkQuality_File_Identifier = 0x564b5141; // VKQA
   // A-Z and 'everything else'
   static constexpr uint32_t kShortcut_Offset_Count = 27;
+  // Device lists in files of this format version or later are sorted by
+  // CompareBrandOrder within each shortcut bucket
+  static constexpr uint32_t kBrandSorted_File_Format_Version = 0x010300;
+  // Files of this format version or later have a section table after the header
+  static constexpr uint32_t kSectionTable_File_Format_Version = 0x010400;
+  static constexpr uint32_t kVkQuality_Section_Table_Identifier = 0x564b5153; // VKQS
+  // Brands in files of this format version or later are brand keys, see GetBrandKey
+  static constexpr uint32_t kBrandKey_File_Format_Version = 0x010500;
+  // Overlays are tracked in a bit mask per merged index key
+  static constexpr uint32_t kMax_Overlay_Count = 8;
+  // Interned string ids of query strings that aren't in the string table
+  static constexpr uint32_t kAbsent_String_Id = UINT32_MAX;
+  static constexpr uint32_t kEmpty_String_Id = UINT32_MAX - 1;
+
+  enum FileSectionId : uint32_t {
+    kFileSection_BrandIndex = 1,
+    kFileSection_GpuAllowColumns = 2,
+    kFileSection_GpuDenyColumns = 3,
+    kFileSection_DeviceShards = 4,
+    kFileSection_Checksum = 5,
+    kFileSection_BrandAliases = 6,
+    kFileSection_DriverAllowRules = 7,
+    kFileSection_DriverDenyRules = 8,
+    kFileSection_CapabilityAllowRules = 9,
+    kFileSection_CapabilityDenyRules = 10
+  };
+
+  // VkQualityChecksumSection algorithms
+  static constexpr uint32_t kChecksum_Crc32c = 1;
 
   enum FileParseResult : int32_t {
     kFileParseResult_Success = 0,
@@ -41,7 +77,19 @@ public:
     kFileParseResult_Error_SoCAllowOverflow,
     kFileParseResult_Error_SoCDenyOverflow,
     kFileParseResult_Error_StringOffsetOverflow,
-    kFileParseResult_Error_ShortcutOverflow
+    kFileParseResult_Error_ShortcutOverflow,
+    kFileParseResult_Error_ShortcutOrder,
+    kFileParseResult_Error_SectionTableOverflow,
+    kFileParseResult_Error_SectionOverflow,
+    kFileParseResult_Error_BrandIndexInvalid,
+    kFileParseResult_Error_GpuColumnsInvalid,
+    kFileParseResult_Error_DeviceShardsInvalid,
+    kFileParseResult_Error_ChecksumInvalid,
+    kFileParseResult_Error_ChecksumMismatch,
+    kFileParseResult_Error_BrandAliasesInvalid,
+    kFileParseResult_Error_DriverRulesInvalid,
+    kFileParseResult_Error_CapabilityRulesInvalid,
+    kFileParseResult_Error_AlreadyParsed
   };
 
   enum FileMatchResult : int32_t {
@@ -52,42 +100,329 @@ public:
     kFileMatch_DriverDeny,
     kFileMatch_GpuAllow,
     kFileMatch_GpuDeny,
+    kFileMatch_DriverRuleAllow,
+    kFileMatch_DriverRuleDeny,
+    kFileMatch_CapabilityAllow,
+    kFileMatch_CapabilityDeny,
     kFileMatch_None
   };
 
+  // Full checks every section when the file is parsed. Lazy only checks that
+  // sections lie within the file, the contents of a section are checked the
+  // first time a search uses it. A section that fails its check is ignored,
+  // and the search falls back to the legacy lists.
+  enum ValidationMode : int32_t {
+    kValidation_Full = 0,
+    kValidation_Lazy
+  };
+
+  // Called with the file data when the file is destroyed, if ParseFileData
+  // succeeded. The default releases file data allocated with malloc()
+  typedef void (*FileDataRelease)(void *file_data, void *user_data);
+
+  // Loads the shard file with the name from a root file, returns the shard data
+  // allocated with malloc() and its size, or nullptr if it can't be loaded
+  typedef std::function<void *(const char *shard_name, size_t &shard_size)> ShardLoader;
+
   VkQualityPredictionFile();
   ~VkQualityPredictionFile();
 
+  VkQualityPredictionFile(const VkQualityPredictionFile &) = delete;
+  VkQualityPredictionFile &operator=(const VkQualityPredictionFile &) = delete;
+
+  static void FreeFileData(void *file_data, void *user_data);
+
+  // Check only the header of a file, without needing the rest of the file
+  // contents, to see if it could be used by the library
+  static bool IsHeaderCompatible(const VkQualityFileHeader &header,
+                                 const uint32_t library_version);
+
+  // Shortcut table index for a Build.BRAND string, A-Z by first letter
+  // ignoring case, then everything else
+  static uint32_t GetBrandShortcutIndex(const char *brand);
+
+  // Device list brand sort order, compares bytes with ASCII letters folded
+  // to upper case. The list editor exporter sorts with the same rule.
+  static int CompareBrandOrder(const char *a, const char *b);
+
+  // Build.BRAND with ASCII whitespace trimmed and ASCII letters folded to lower
+  // case, so OEM builds that differ only in case or padding share device rows
+  static std::string GetBrandKey(const std::string_view &brand);
+
+  // Applies to the next ParseFileData call
+  void SetValidationMode(const ValidationMode validation_mode) {
+    validation_mode_ = validation_mode;
+  }
+
+  // Applies to the next ParseFileData call. The checksum section of a file is
+  // verified by default, trusted files such as app bundle assets can skip it.
+  void SetVerifyChecksum(const bool verify_checksum) { verify_checksum_ = verify_checksum; }
+
+  // Checksum of a file with the contents of its checksum section zeroed, see
+  // VkQualityChecksumSection
+  static uint32_t ComputeFileChecksum(const void *file_data, const size_t file_size,
+                                      const size_t checksum_section_offset);
+
+  // Call before any search. With a string index, device and
+  // driver searches look up the strings of the device in a hash index over the
+  // string table, then compare string table indices instead of strings. The
+  // index is built on first use by hashing every string, which only pays off
+  // for a file that is searched many times.
+  void SetStringIndex(const bool string_index) { string_index_ = string_index; }
+
+  // Shards of a root file are loaded on the first search of their brand bucket.
+  // Without a loader, devices in sharded buckets don't match the device list.
+  void SetShardLoader(ShardLoader shard_loader) { shard_loader_ = std::move(shard_loader); }
+
+  // Stacks a parsed file, such as a downloaded hotfix, on top of this file and any
+  // earlier overlays. For each search stage of FindDeviceMatch, a match in a higher
+  // layer takes precedence over the layers below it. The overlay list_version must
+  // be newer than the layer below it, an overlay older than an updated base file is
+  // stale. Overlays with device shards are rejected, shards are only loaded for the
+  // base file. Call before any search, returns false if the overlay is rejected.
+  // A rejected overlay is destroyed and releases its file data.
+  bool AddOverlay(std::unique_ptr<VkQualityPredictionFile> overlay);
+
+  uint32_t GetOverlayCount() const { return static_cast<uint32_t>(overlays_.size()); }
+
+  // Pass a nullptr release function for file data that remains owned by the caller.
+  // Can succeed only once per file object, later calls fail with
+  // kFileParseResult_Error_AlreadyParsed.
   FileParseResult ParseFileData(void *file_data, const size_t file_size,
-                                const uint32_t library_version);
+                                const uint32_t library_version,
+                                FileDataRelease release_function = FreeFileData,
+                                void *release_user_data = nullptr);
 
-  FileMatchResult FindDeviceMatch(const DeviceInfo &device_info, const int32_t flags);
+  // If match_index is not null, it receives the index of the matching entry in the
+  // table of the returned match result, in the layer that matched
+  FileMatchResult FindDeviceMatch(const DeviceInfo &device_info, const int32_t flags,
+                                  uint32_t *match_index = nullptr) const;
 
   uint32_t GetListVersion() const { return file_header_->list_version; }
 
+  // Checksum stored in the checksum section, whether or not it was verified. A
+  // cheap identity for the file contents, 0 if the file has no checksum section
+  uint32_t GetContentChecksum() const { return content_checksum_; }
+
+  // list_version of the top overlay, 0 without overlays
+  uint32_t GetOverlayListVersion() const {
+    return overlays_.empty() ? 0 : overlays_.back()->GetListVersion();
+  }
+
   int32_t GetFutureAndroidAPILevel() const {
     return file_header_->min_future_vulkan_recommendation_api;
   }
 
   const std::string &GetParseErrorString() const { return file_parse_error_; }
 
+  // Individual list searches, FindDeviceMatch applies them in priority order.
+  // Public so each list can be benchmarked on its own. In files with brand keys,
+  // the device searches look up the brand key of the device and its alias.
+  FileMatchResult SearchDeviceList(const DeviceInfo &device_info, uint32_t &match_index) const;
+  // Binary search of the brand index section, the device list scan is used
+  // when the file has no brand index
+  FileMatchResult SearchBrandIndex(const DeviceInfo &device_info, uint32_t &match_index) const;
+  bool HasBrandIndex() const { return AcquireSection(kSectionSlot_BrandIndex); }
+  bool HasBrandAliases() const { return AcquireSection(kSectionSlot_BrandAliases); }
+  // True if the string index is enabled and the string table has no repeated
+  // strings, see SetStringIndex. Builds the index the first time it is called.
+  bool HasInternedStrings() const { return AcquireStringIndex(); }
+  // String table index of a string, kEmpty_String_Id for an empty string and
+  // kAbsent_String_Id if the string isn't in the table or the table can't be
+  // interned
+  uint32_t FindStringId(const char *string) const;
+  bool HasDeviceShards() const { return AcquireSection(kSectionSlot_DeviceShards); }
+  bool HasGpuColumns() const {
+    return AcquireSection(kSectionSlot_GpuAllowColumns) ||
+        AcquireSection(kSectionSlot_GpuDenyColumns);
+  }
+  FileMatchResult SearchDriverLists(const DeviceInfo &device_info, uint32_t &match_index) const;
+  FileMatchResult SearchDriverList(const DeviceInfo &device_info,
+                                   const FileMatchResult match_result,
+                                   uint32_t &match_index) const;
+  // match_result is kFileMatch_DriverRuleAllow or kFileMatch_DriverRuleDeny,
+  // match_index receives the index of the rule in its section
+  FileMatchResult SearchDriverRules(const DeviceInfo &device_info,
+                                    const FileMatchResult match_result,
+                                    uint32_t &match_index) const;
+  bool HasDriverRules() const {
+    return AcquireSection(kSectionSlot_DriverAllowRules) ||
+        AcquireSection(kSectionSlot_DriverDenyRules);
+  }
+  // match_result is kFileMatch_CapabilityAllow or kFileMatch_CapabilityDeny,
+  // match_index receives the index of the rule in its section
+  FileMatchResult SearchCapabilityRules(const DeviceInfo &device_info,
+                                        const FileMatchResult match_result,
+                                        uint32_t &match_index) const;
+  bool HasCapabilityRules() const {
+    return AcquireSection(kSectionSlot_CapabilityAllowRules) ||
+        AcquireSection(kSectionSlot_CapabilityDenyRules);
+  }
+  FileMatchResult SearchGpuLists(const DeviceInfo &device_info, uint32_t &match_index) const;
+  FileMatchResult SearchGpuList(const DeviceInfo &device_info,
+                                const FileMatchResult match_result,
+                                uint32_t &match_index) const;
+
 private:
-  const char *GetString(const uint32_t string_index);
+  // Every section of the file, whether located by the header fields or by the
+  // section table, has a slot in the section directory
+  enum SectionSlot : uint32_t {
+    kSectionSlot_DeviceList = 0,
+    kSectionSlot_DriverAllow,
+    kSectionSlot_DriverDeny,
+    kSectionSlot_GpuAllow,
+    kSectionSlot_GpuDeny,
+    kSectionSlot_SoCAllow,
+    kSectionSlot_SoCDeny,
+    kSectionSlot_StringTable,
+    kSectionSlot_DeviceShortcuts,
+    kSectionSlot_BrandIndex,
+    kSectionSlot_GpuAllowColumns,
+    kSectionSlot_GpuDenyColumns,
+    kSectionSlot_DeviceShards,
+    kSectionSlot_Checksum,
+    kSectionSlot_BrandAliases,
+    kSectionSlot_DriverAllowRules,
+    kSectionSlot_DriverDenyRules,
+    kSectionSlot_CapabilityAllowRules,
+    kSectionSlot_CapabilityDenyRules,
+    kSectionSlot_Count
+  };
+
+  struct FileSection {
+    uint32_t offset = 0;
+    uint64_t size = 0;
+    bool present = false;
+  };
+
+  // FindDeviceMatch searches the layers one stage at a time
+  enum SearchStage : uint32_t {
+    kSearchStage_Driver = 0,
+    kSearchStage_Device,
+    kSearchStage_Gpu,
+    kSearchStage_CapabilityDeny,
+    kSearchStage_CapabilityAllow,
+    kSearchStage_Count
+  };
+
+  // Merged index entry, overlay_mask has a bit set for each overlay holding an
+  // entry that a device with the key could match
+  struct OverlayKey {
+    uint64_t key;
+    uint32_t overlay_mask;
+  };
+
+  static uint64_t GetOverlayKey(const SearchStage stage, const char *data, const size_t size,
+                                const bool fold_case);
+
+  // Adds the merged index entries of an overlay
+  void IndexOverlay(const uint32_t overlay_index, const VkQualityPredictionFile &overlay);
+
+  // Overlays that could match the device in a search stage
+  uint32_t GetOverlayMask(const SearchStage stage, const DeviceInfo &device_info) const;
+
+  // Searches the overlays from the top down, then this file
+  FileMatchResult SearchLayers(const SearchStage stage, const DeviceInfo &device_info,
+                               uint32_t &match_index) const;
+
+  // Searches the lists of a stage in this file only
+  FileMatchResult SearchOwnLists(const SearchStage stage, const DeviceInfo &device_info,
+                                 uint32_t &match_index) const;
+
+  const char *GetString(const uint32_t string_index) const;
+
+  // Returns device_info, or keyed_info holding a copy of device_info with the
+  // brand replaced by its brand key or alias, if this file uses brand keys
+  const DeviceInfo &GetKeyedDeviceInfo(const DeviceInfo &device_info,
+                                       DeviceInfo &keyed_info) const;
+
+  // Replaces a brand key with the brand of its alias, if it has one
+  void ResolveBrandAlias(std::string &brand_key) const;
+
+  // The device searches, for a device_info with a keyed brand
+  FileMatchResult SearchDeviceRows(const DeviceInfo &device_info, uint32_t &match_index) const;
+  FileMatchResult SearchBrandRows(const DeviceInfo &device_info, uint32_t &match_index) const;
+
+  // Builds the string table hash index the first time it is used, returns false
+  // if the index isn't enabled or the string table has repeated strings. Safe to
+  // call from multiple threads.
+  bool AcquireStringIndex() const;
+
+  void BuildStringIndex() const;
+
+  // Index of the first SoC list row with the SoC, ignoring case, kAbsent_String_Id
+  // if there is none
+  uint32_t FindSoCRow(const FileMatchResult match_result, const char *soc) const;
+
+  // Whether the string at a string table index equals the string with an
+  // interned id, needs the string index
+  bool IsStringId(const uint32_t string_index, const uint32_t string_id) const;
+
+  FileMatchResult CheckInternedDevice(const DeviceInfo &device_info,
+                                      const VkQualityDeviceAllowListEntry &entry,
+                                      const uint32_t brand_id, const uint32_t device_id) const;
 
   FileParseResult ValidateFile(void *file_data, const size_t file_size,
-                               const uint32_t library_version);
+                               const uint32_t library_version, FileSection *sections);
 
-  FileMatchResult SearchDeviceList(const DeviceInfo &device_info);
-  FileMatchResult SearchDriverLists(const DeviceInfo &device_info);
-  FileMatchResult SearchDriverList(const DeviceInfo &device_info,
-                                   const FileMatchResult match_result);
-  FileMatchResult SearchGpuLists(const DeviceInfo &device_info);
-  FileMatchResult SearchGpuList(const DeviceInfo &device_info, const FileMatchResult match_result);
+  FileParseResult ValidateSectionTable(const void *file_data, const size_t file_size,
+                                       FileSection *sections);
+
+  // Checks the contents of a section, error_string can be nullptr
+  static FileParseResult CheckSection(const VkQualityFileHeader *header, const size_t file_size,
+                                      const FileSection *sections, const SectionSlot slot,
+                                      std::string *error_string);
+
+  static FileParseResult CheckBrandIndex(const VkQualityFileHeader *header,
+                                         const FileSection &section, std::string *error_string);
+
+  static FileParseResult CheckGpuColumns(const VkQualityFileHeader *header,
+                                         const FileSection &section, const uint32_t list_count,
+                                         std::string *error_string);
+
+  static FileParseResult CheckDeviceShards(const VkQualityFileHeader *header,
+                                           const size_t file_size, const FileSection &section,
+                                           std::string *error_string);
+
+  static FileParseResult CheckBrandAliases(const VkQualityFileHeader *header,
+                                           const FileSection &section,
+                                           std::string *error_string);
+
+  static FileParseResult CheckCapabilityRules(const VkQualityFileHeader *header,
+                                              const FileSection &section,
+                                              std::string *error_string);
+
+  static FileParseResult CheckDriverRules(const VkQualityFileHeader *header,
+                                          const FileSection &section,
+                                          std::string *error_string);
+
+  // Called by ParseFileData in every validation mode, the rest of the file
+  // can't be trusted until the checksum matches
+  FileParseResult VerifyChecksum(const void *file_data, const size_t file_size,
+                                 const FileSection &section);
+
+  // Shard file of a shortcut bucket, nullptr if the bucket isn't sharded or
+  // its shard couldn't be loaded
+  const VkQualityPredictionFile *AcquireDeviceShard(const uint32_t shortcut_index) const;
+
+  static VkQualityGpuColumns MapGpuColumns(const uint8_t *section_start);
+
+  // Checks and maps a section the first time it is used, returns false if the
+  // section is absent or failed its check. Safe to call from multiple threads.
+  bool AcquireSection(const SectionSlot slot) const;
+
+  void MapSection(const SectionSlot slot) const;
 
+  ValidationMode validation_mode_ = kValidation_Full;
+  bool verify_checksum_ = true;
+  uint32_t content_checksum_ = 0;
+  uint32_t library_version_ = 0;
+  ShardLoader shard_loader_;
+  FileDataRelease release_function_ = nullptr;
+  void *release_user_data_ = nullptr;
   size_t total_file_size_ = 0;
   const VkQualityFileHeader *file_header_ = nullptr;
   const uint32_t *string_offset_table_ = nullptr;
-  const uint32_t *device_shortcut_table_ = nullptr;
   const VkQualityDeviceAllowListEntry *device_table_ = nullptr;
   const VkQualityDriverFingerprintEntry *driver_allow_table_ = nullptr;
   const VkQualityDriverFingerprintEntry *driver_deny_table_ = nullptr;
@@ -95,6 +430,51 @@ private:
   const VkQualityGpuPredictEntry *gpu_deny_table_ = nullptr;
   const VkQualityDriverSoCEntry *soc_allow_table_ = nullptr;
   const VkQualityDriverSoCEntry *soc_deny_table_ = nullptr;
+  FileSection sections_[kSectionSlot_Count];
+  // ParseFileData checked the contents of every section
+  bool sections_checked_ = false;
+  // Set once per slot by AcquireSection, under the slot's once flag
+  mutable std::once_flag section_once_[kSectionSlot_Count];
+  mutable bool section_valid_[kSectionSlot_Count] = {};
+  mutable const uint32_t *device_shortcut_table_ = nullptr;
+  // Older exporters wrote an all zero shortcut table, which means search
+  // the whole device list
+  mutable bool device_shortcuts_populated_ = false;
+  mutable const VkQualityBrandIndexHeader *brand_index_header_ = nullptr;
+  mutable const VkQualityBrandIndexEntry *brand_index_table_ = nullptr;
+  mutable const uint32_t *brand_device_index_ = nullptr;
+  mutable VkQualityGpuColumns gpu_allow_columns_;
+  mutable VkQualityGpuColumns gpu_deny_columns_;
+  mutable const VkQualityDeviceShardsHeader *device_shards_header_ = nullptr;
+  mutable const VkQualityDeviceShardEntry *device_shard_table_ = nullptr;
+  mutable const VkQualityBrandAliasHeader *brand_aliases_header_ = nullptr;
+  mutable const VkQualityBrandAliasEntry *brand_alias_table_ = nullptr;
+  mutable const VkQualityDriverRulesHeader *driver_allow_rules_header_ = nullptr;
+  mutable const VkQualityDriverRuleEntry *driver_allow_rule_table_ = nullptr;
+  mutable const VkQualityDriverRulesHeader *driver_deny_rules_header_ = nullptr;
+  mutable const VkQualityDriverRuleEntry *driver_deny_rule_table_ = nullptr;
+  mutable const VkQualityCapabilityRulesHeader *capability_allow_rules_header_ = nullptr;
+  mutable const VkQualityCapabilityRuleEntry *capability_allow_rule_table_ = nullptr;
+  mutable const VkQualityCapabilityRulesHeader *capability_deny_rules_header_ = nullptr;
+  mutable const VkQualityCapabilityRuleEntry *capability_deny_rule_table_ = nullptr;
+  mutable std::once_flag shard_once_[kShortcut_Offset_Count];
+  mutable std::unique_ptr<VkQualityPredictionFile> device_shards_[kShortcut_Offset_Count];
+  bool string_index_ = false;
+  // Open addressing hash tables, each slot holds the string hash in the upper
+  // 32 bits and a string table index (or SoC list row) + 1 in the lower 32 bits,
+  // 0 for an empty slot
+  mutable std::once_flag string_index_once_;
+  mutable bool string_index_valid_ = false;
+  mutable std::vector<uint64_t> string_slots_;
+  mutable std::vector<uint64_t> soc_allow_slots_;
+  mutable std::vector<uint64_t> soc_deny_slots_;
+  mutable uint32_t empty_string_index_ = kAbsent_String_Id;
+  std::vector<std::unique_ptr<VkQualityPredictionFile>> overlays_;
+  // Sorted by key
+  std::vector<OverlayKey> overlay_index_;
+  // Overlays with entries the merged index can't key, such as wildcard GPU
+  // names, are searched in every query of the stage
+  uint32_t overlay_unkeyed_mask_[kSearchStage_Count] = {};
   std::string file_parse_error_;
 };
 
@@ -14,8 +14,23 @@
  * limitations under the License.
  */
 #include "gtest/gtest.h"
-#include "vkquality_manager.h"
+#include "vkquality_capabilities.h"
+#include "vkquality_checksum.h"
+#include "vkquality_compression.h"
+#include "vkquality_core.h"
+#include "vkquality_device_probe.h"
+#include "vkquality_driver_version.h"
+#include "vkquality_evaluator.h"
+#include "vkquality_list_watcher.h"
+#include "vkquality_prediction_file.h"
 #include "vkquality_matching.h"
+#include "vkquality_paged_file.h"
+#include "vkquality_patch.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
 
 // From Vulkan.h, so we don't have to pull in the whole header
 #define VK_MAKE_API_VERSION(variant, major, minor, patch) \
@@ -389,10 +404,20 @@ TEST(VkQualityFileParseHeaderVersionCheck, Validity)
   EXPECT_EQ(result, VkQualityPredictionFile::kFileParseResult_Error_LibraryTooOldForFile);
 }
 
+TEST(VkQualityFileHeaderCompatible, Validity)
+{
+  VkQualityFileHeader header = kGoodHeaderTemplate;
+  EXPECT_TRUE(VkQualityPredictionFile::IsHeaderCompatible(header, kValidVersion));
+  EXPECT_FALSE(VkQualityPredictionFile::IsHeaderCompatible(header, kOldVersion));
+  header.file_identifier = 0;
+  EXPECT_FALSE(VkQualityPredictionFile::IsHeaderCompatible(header, kValidVersion));
+}
+
 //int debug_counter = 0;
 //void *debug_ptr = nullptr;
 
-static void ConstructValidFile(MemoryBuffer &memory_buffer) {
+// section_count reserves a zeroed section table after the header for the test to fill in
+static void ConstructValidFile(MemoryBuffer &memory_buffer, const uint32_t section_count = 0) {
   EXPECT_EQ(memory_buffer.GetTotalSize(), MemoryBuffer::kDefaultBufferSize);
   void *zero_buffer = malloc(1024*1024);
   memset(zero_buffer, 0, 1024*1024);
@@ -401,6 +426,13 @@ static void ConstructValidFile(MemoryBuffer &memory_buffer) {
   EXPECT_EQ(memory_buffer.GetUsedSize(), sizeof(VkQualityFileHeader));
   uint8_t *base = reinterpret_cast<uint8_t *>(memory_buffer.GetPtr());
   VkQualityFileHeader *header = reinterpret_cast<VkQualityFileHeader*>(base);
+  if (section_count > 0) {
+    header->file_format_version = VkQualityPredictionFile::kSectionTable_File_Format_Version;
+    const VkQualityFileSectionTable section_table{
+        VkQualityPredictionFile::kVkQuality_Section_Table_Identifier, section_count};
+    memory_buffer.Push((void*)&section_table, sizeof(section_table));
+    PUSH_ZERO(section_count * sizeof(VkQualityFileSectionEntry));
+  }
   header->device_list_count = kDefaultDeviceListCount;
   header->driver_allow_count = kDefaultFingerprintAllowListCount;
   header->driver_deny_count = kDefaultFingerprintDenyListCount;
@@ -490,6 +522,42 @@ TEST(VkQualityFileParseHeaderValid, Validity)
   //    "0x" << std::uppercase << std::setfill('0') << std::setw(8) << std::hex <<((uint64_t)debug_ptr);
 }
 
+static void CountFileDataRelease(void */*file_data*/, void *user_data) {
+  ++(*reinterpret_cast<int *>(user_data));
+}
+
+// Verify in-memory file data is released once, and only after a successful parse
+TEST(VkQualityFileParseRelease, Validity)
+{
+  MemoryBuffer memory_buffer(MemoryBuffer::kDefaultBufferSize, true);
+  ConstructValidFile(memory_buffer);
+
+  int release_count = 0;
+  {
+    VkQualityPredictionFile file;
+    const auto result = file.ParseFileData(memory_buffer.GetPtr(), sizeof(kTooSmallBuffer),
+                                           kValidVersion, CountFileDataRelease,
+                                           &release_count);
+    EXPECT_NE(result, VkQualityPredictionFile::kFileParseResult_Success);
+  }
+  EXPECT_EQ(release_count, 0);
+
+  {
+    VkQualityPredictionFile file;
+    const auto result = file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                           kValidVersion, CountFileDataRelease,
+                                           &release_count);
+    EXPECT_EQ(result, VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_EQ(release_count, 0);
+    // The file data of a parsed object can't be replaced
+    EXPECT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                 kValidVersion, CountFileDataRelease, &release_count),
+              VkQualityPredictionFile::kFileParseResult_Error_AlreadyParsed);
+    EXPECT_EQ(release_count, 0);
+  }
+  EXPECT_EQ(release_count, 1);
+}
+
 // Verify bounds-check of offset table counts
 TEST(VkQualityFileParseHeaderOffsetCounts, Validity)
 {
@@ -584,6 +652,684 @@ TEST(VkQualityFileParseHeaderOffsetTables, Validity)
   *string_offsets = old_offset;
 }
 
+// Verify the shortcut table must not decrease or point past the device list
+TEST(VkQualityFileParseShortcutOrder, Validity)
+{
+  MemoryBuffer memory_buffer;
+  ConstructValidFile(memory_buffer);
+
+  uint8_t *base = reinterpret_cast<uint8_t *>(memory_buffer.GetPtr());
+  VkQualityFileHeader *header = reinterpret_cast<VkQualityFileHeader*>(base);
+  uint32_t *shortcuts = reinterpret_cast<uint32_t *>(base + header->device_list_shortcuts_offset);
+
+  VkQualityPredictionFile file;
+  shortcuts[6] = 2;
+  auto result = file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                   kValidVersion);
+  EXPECT_EQ(result, VkQualityPredictionFile::kFileParseResult_Error_ShortcutOrder);
+
+  for (uint32_t i = 6; i < VkQualityPredictionFile::kShortcut_Offset_Count; ++i) {
+    shortcuts[i] = kDefaultDeviceListCount + 1;
+  }
+  result = file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                              kValidVersion);
+  EXPECT_EQ(result, VkQualityPredictionFile::kFileParseResult_Error_ShortcutOrder);
+}
+
+TEST(VkQualityBrandOrder, Validity)
+{
+  EXPECT_EQ(VkQualityPredictionFile::GetBrandShortcutIndex("google"), 6U);
+  EXPECT_EQ(VkQualityPredictionFile::GetBrandShortcutIndex("Google"), 6U);
+  EXPECT_EQ(VkQualityPredictionFile::GetBrandShortcutIndex("9dfx"), 26U);
+  EXPECT_EQ(VkQualityPredictionFile::GetBrandShortcutIndex(""), 26U);
+
+  EXPECT_EQ(VkQualityPredictionFile::CompareBrandOrder("google", "GOOGLE"), 0);
+  EXPECT_LT(VkQualityPredictionFile::CompareBrandOrder("google", "superfone"), 0);
+  EXPECT_LT(VkQualityPredictionFile::CompareBrandOrder("goo", "google"), 0);
+  // Upper case folding puts '_' after the letters
+  EXPECT_GT(VkQualityPredictionFile::CompareBrandOrder("g_", "ga"), 0);
+}
+
+// Device list searches stop at the end of the brand bucket, and for sorted
+// files once past the brand
+TEST(VkQualityDeviceListShortcuts, Validity)
+{
+  DeviceInfo device_info {
+      "superfone",
+      "superfone 9000",
+      "genericsoc",
+      "gGPU",
+      "genericfingerprint",
+      kDefaultMinAndroidApi,
+      VK_API_VERSION_1_3,
+      0x111,
+      kFakeGpuVendor_9dfx_MinDriverVersion,
+      kFakeGpuVendorId_Google
+  };
+
+  MemoryBuffer memory_buffer(MemoryBuffer::kDefaultBufferSize, true);
+  ConstructValidFile(memory_buffer);
+  uint8_t *base = reinterpret_cast<uint8_t *>(memory_buffer.GetPtr());
+  VkQualityFileHeader *header = reinterpret_cast<VkQualityFileHeader*>(base);
+  uint32_t *shortcuts = reinterpret_cast<uint32_t *>(base + header->device_list_shortcuts_offset);
+
+  // All zero table, whole list is searched
+  uint32_t match_index = 0;
+  {
+    VkQualityPredictionFile file;
+    ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                 kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_ExactDevice);
+    EXPECT_EQ(match_index, 3U);
+  }
+
+  // 'G' bucket is [0, 3), 'S' bucket is [3, 4)
+  for (uint32_t i = 0; i < VkQualityPredictionFile::kShortcut_Offset_Count; ++i) {
+    shortcuts[i] = (i <= 6) ? 0 : ((i <= 18) ? 3 : 4);
+  }
+  {
+    VkQualityPredictionFile file;
+    ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                 kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_ExactDevice);
+    EXPECT_EQ(match_index, 3U);
+  }
+
+  // Superfone outside of its bucket isn't found
+  for (uint32_t i = 18; i < VkQualityPredictionFile::kShortcut_Offset_Count; ++i) {
+    shortcuts[i] = 4;
+  }
+  {
+    VkQualityPredictionFile file;
+    ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                 kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_None);
+  }
+
+  // Superfone ahead of google in a 'G' bucket spanning the whole list, only found
+  // when the file doesn't claim to be sorted
+  static constexpr VkQualityDeviceAllowListEntry kUnsortedDeviceList[2] = {
+      {
+          kTestString_BrandSuperfone, kTestString_DeviceSuperfone9000,
+          kDefaultMinAndroidApi, kFakeGpuVendor_9dfx_MinDriverVersion
+      },
+      {
+          kTestString_BrandGoogle, kTestString_DevicePixel7,
+          kDefaultMinAndroidApi, kFakeGpuVendor_9dfx_MinDriverVersion
+      }
+  };
+  memcpy(base + header->device_list_offset, kUnsortedDeviceList, sizeof(kUnsortedDeviceList));
+  header->device_list_count = 2;
+  for (uint32_t i = 0; i < VkQualityPredictionFile::kShortcut_Offset_Count; ++i) {
+    shortcuts[i] = (i <= 6) ? 0 : 2;
+  }
+  device_info.brand = "google";
+  device_info.device = "pixel7";
+  {
+    VkQualityPredictionFile file;
+    ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                 kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_ExactDevice);
+    EXPECT_EQ(match_index, 1U);
+  }
+  header->file_format_version = VkQualityPredictionFile::kBrandSorted_File_Format_Version;
+  {
+    VkQualityPredictionFile file;
+    ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                 kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_None);
+  }
+}
+
+// Brand index over kDefaultDeviceList: google (pixel3.14, pixel7, brand wildcard)
+// and superfone (superfone 9000)
+static constexpr VkQualityBrandIndexHeader kDefaultBrandIndexHeader = {2, 4};
+static constexpr VkQualityBrandIndexEntry kDefaultBrandIndex[2] = {
+    {kTestString_BrandGoogle, 0, 3},
+    {kTestString_BrandSuperfone, 3, 1}
+};
+static constexpr uint32_t kDefaultBrandDeviceIndex[4] = {2, 0, 1, 3};
+
+static void ConstructBrandIndexFile(MemoryBuffer &memory_buffer) {
+  ConstructValidFile(memory_buffer, 1);
+  uint8_t *base = reinterpret_cast<uint8_t *>(memory_buffer.GetPtr());
+  VkQualityFileSectionEntry *section = reinterpret_cast<VkQualityFileSectionEntry *>(
+      base + sizeof(VkQualityFileHeader) + sizeof(VkQualityFileSectionTable));
+  section->section_id = VkQualityPredictionFile::kFileSection_BrandIndex;
+  section->section_offset = static_cast<uint32_t>(
+      memory_buffer.Push((void*)&kDefaultBrandIndexHeader, sizeof(kDefaultBrandIndexHeader)));
+  PUSH_BUFFER(kDefaultBrandIndex);
+  PUSH_BUFFER(kDefaultBrandDeviceIndex);
+  section->section_size = static_cast<uint32_t>(memory_buffer.GetUsedSize() -
+      section->section_offset);
+}
+
+TEST(VkQualityBrandIndexParse, Validity)
+{
+  MemoryBuffer memory_buffer(MemoryBuffer::kDefaultBufferSize, true);
+  ConstructBrandIndexFile(memory_buffer);
+  uint8_t *base = reinterpret_cast<uint8_t *>(memory_buffer.GetPtr());
+  VkQualityFileSectionTable *section_table = reinterpret_cast<VkQualityFileSectionTable *>(
+      base + sizeof(VkQualityFileHeader));
+  VkQualityFileSectionEntry *section =
+      reinterpret_cast<VkQualityFileSectionEntry *>(section_table + 1);
+  VkQualityBrandIndexEntry *brand_entries = reinterpret_cast<VkQualityBrandIndexEntry *>(
+      base + section->section_offset + sizeof(VkQualityBrandIndexHeader));
+  uint32_t *device_indices = reinterpret_cast<uint32_t *>(brand_entries + 2);
+
+  {
+    VkQualityPredictionFile file;
+    EXPECT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                 kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_TRUE(file.HasBrandIndex());
+  }
+
+  VkQualityPredictionFile file;
+  device_indices[3] = kDefaultDeviceListCount;
+  auto result = file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                   kValidVersion);
+  EXPECT_EQ(result, VkQualityPredictionFile::kFileParseResult_Error_BrandIndexInvalid);
+  device_indices[3] = 3;
+
+  brand_entries[1].device_index_count = 2;
+  result = file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                              kValidVersion);
+  EXPECT_EQ(result, VkQualityPredictionFile::kFileParseResult_Error_BrandIndexInvalid);
+  brand_entries[1].device_index_count = 1;
+
+  section->section_size += 4;
+  result = file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                              kValidVersion);
+  EXPECT_EQ(result, VkQualityPredictionFile::kFileParseResult_Error_SectionOverflow);
+  section->section_size -= 4;
+
+  section_table->section_count = 0x7FFFFFFF;
+  result = file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                              kValidVersion);
+  EXPECT_EQ(result, VkQualityPredictionFile::kFileParseResult_Error_SectionTableOverflow);
+  section_table->section_count = 1;
+
+  section_table->section_table_identifier = 0;
+  result = file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                              kValidVersion);
+  EXPECT_EQ(result, VkQualityPredictionFile::kFileParseResult_Error_InvalidIdentifier);
+  section_table->section_table_identifier =
+      VkQualityPredictionFile::kVkQuality_Section_Table_Identifier;
+
+  // Unknown sections are skipped
+  section->section_id = 0x7FFFFFFF;
+  result = file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                              kValidVersion, nullptr);
+  EXPECT_EQ(result, VkQualityPredictionFile::kFileParseResult_Success);
+  EXPECT_FALSE(file.HasBrandIndex());
+}
+
+// Lazy validation defers section content checks to first use, a section that
+// fails its check is ignored and the search falls back to the device list
+TEST(VkQualityLazySectionValidation, Validity)
+{
+  MemoryBuffer memory_buffer;
+  ConstructBrandIndexFile(memory_buffer);
+  uint8_t *base = reinterpret_cast<uint8_t *>(memory_buffer.GetPtr());
+  VkQualityFileHeader *header = reinterpret_cast<VkQualityFileHeader *>(base);
+  VkQualityFileSectionEntry *section = reinterpret_cast<VkQualityFileSectionEntry *>(
+      base + sizeof(VkQualityFileHeader) + sizeof(VkQualityFileSectionTable));
+  uint32_t *device_indices = reinterpret_cast<uint32_t *>(
+      base + section->section_offset + sizeof(VkQualityBrandIndexHeader) +
+      sizeof(kDefaultBrandIndex));
+  uint32_t *shortcuts = reinterpret_cast<uint32_t *>(base + header->device_list_shortcuts_offset);
+  device_indices[3] = kDefaultDeviceListCount;
+  shortcuts[6] = kDefaultDeviceListCount + 1;
+
+  const DeviceInfo device_info {
+      "superfone",
+      "superfone 9000",
+      "genericsoc",
+      "gGPU",
+      "genericfingerprint",
+      kDefaultMinAndroidApi,
+      VK_API_VERSION_1_3,
+      0x111,
+      kFakeGpuVendor_9dfx_MinDriverVersion,
+      kFakeGpuVendorId_Google
+  };
+  uint32_t match_index = 0;
+  {
+    VkQualityPredictionFile file;
+    EXPECT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                 kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Error_ShortcutOrder);
+  }
+  {
+    VkQualityPredictionFile file;
+    file.SetValidationMode(VkQualityPredictionFile::kValidation_Lazy);
+    ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                 kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_FALSE(file.HasBrandIndex());
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_ExactDevice);
+    EXPECT_EQ(match_index, 3U);
+  }
+
+  // Bounds are still checked when the file is parsed
+  section->section_size += 4;
+  {
+    VkQualityPredictionFile file;
+    file.SetValidationMode(VkQualityPredictionFile::kValidation_Lazy);
+    EXPECT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                 kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Error_SectionOverflow);
+  }
+  section->section_size -= 4;
+
+  device_indices[3] = 3;
+  shortcuts[6] = 0;
+  {
+    VkQualityPredictionFile file;
+    file.SetValidationMode(VkQualityPredictionFile::kValidation_Lazy);
+    ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                 kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_TRUE(file.HasBrandIndex());
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_ExactDevice);
+    EXPECT_EQ(match_index, 3U);
+  }
+}
+
+// Brand index lookups return the same match as the device list scan
+TEST(VkQualityBrandIndexSearch, Validity)
+{
+  MemoryBuffer memory_buffer;
+  ConstructBrandIndexFile(memory_buffer);
+  VkQualityPredictionFile file;
+  ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                               kValidVersion),
+            VkQualityPredictionFile::kFileParseResult_Success);
+
+  DeviceInfo device_info {
+      "google",
+      "pixel7",
+      "genericsoc",
+      "gGPU",
+      "genericfingerprint",
+      kDefaultMinAndroidApi,
+      VK_API_VERSION_1_3,
+      0x111,
+      kFakeGpuVendor_Google_MinDriverVersion,
+      kFakeGpuVendorId_Google
+  };
+
+  // The exact device entry is ahead of the brand wildcard in the device list
+  uint32_t match_index = 0;
+  EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+            VkQualityPredictionFile::kFileMatch_ExactDevice);
+  EXPECT_EQ(match_index, 1U);
+
+  device_info.vk_driver_version -= 1;
+  EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+            VkQualityPredictionFile::kFileMatch_DeviceOldVersion);
+  EXPECT_EQ(match_index, 1U);
+  device_info.vk_driver_version += 1;
+
+  device_info.device = "pixel8";
+  EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+            VkQualityPredictionFile::kFileMatch_BrandWildcard);
+  EXPECT_EQ(match_index, 2U);
+
+  device_info.brand = "superfone";
+  device_info.device = "superfone 9000";
+  device_info.vk_driver_version = kFakeGpuVendor_9dfx_MinDriverVersion;
+  EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+            VkQualityPredictionFile::kFileMatch_ExactDevice);
+  EXPECT_EQ(match_index, 3U);
+
+  device_info.device = "superfone 9001";
+  EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+            VkQualityPredictionFile::kFileMatch_None);
+
+  device_info.brand = "Superfone";
+  device_info.device = "superfone 9000";
+  EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+            VkQualityPredictionFile::kFileMatch_None);
+
+  device_info.brand = "zzzfone";
+  EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+            VkQualityPredictionFile::kFileMatch_None);
+}
+
+static size_t PushGpuColumns(MemoryBuffer &memory_buffer, const VkQualityGpuPredictEntry *gpu_list,
+                             const uint32_t gpu_count) {
+  PUSH_ZERO((16 - (memory_buffer.GetUsedSize() % 16)) % 16);
+  const uint32_t stride = (gpu_count + 3) & ~3U;
+  const VkQualityGpuColumnsHeader columns_header{gpu_count, stride, {0, 0}};
+  const size_t section_offset = memory_buffer.Push((void*)&columns_header, sizeof(columns_header));
+  std::vector<uint32_t> columns(stride * 5, 0);
+  for (uint32_t i = 0; i < gpu_count; ++i) {
+    columns[i] = gpu_list[i].device_name_string_index;
+    columns[stride + i] = gpu_list[i].min_api_version;
+    columns[(stride * 2) + i] = gpu_list[i].device_id;
+    columns[(stride * 3) + i] = gpu_list[i].vendor_id;
+    columns[(stride * 4) + i] = gpu_list[i].min_driver_version;
+  }
+  memory_buffer.Push(columns.data(), columns.size() * sizeof(uint32_t));
+  return section_offset;
+}
+
+static void ConstructGpuColumnsFile(MemoryBuffer &memory_buffer) {
+  ConstructValidFile(memory_buffer, 2);
+  uint8_t *base = reinterpret_cast<uint8_t *>(memory_buffer.GetPtr());
+  VkQualityFileSectionEntry *sections = reinterpret_cast<VkQualityFileSectionEntry *>(
+      base + sizeof(VkQualityFileHeader) + sizeof(VkQualityFileSectionTable));
+  sections[0].section_id = VkQualityPredictionFile::kFileSection_GpuAllowColumns;
+  sections[0].section_offset = static_cast<uint32_t>(
+      PushGpuColumns(memory_buffer, kDefaultGpuAllowList, kDefaultGpuAllowCount));
+  sections[0].section_size = static_cast<uint32_t>(memory_buffer.GetUsedSize() -
+      sections[0].section_offset);
+  sections[1].section_id = VkQualityPredictionFile::kFileSection_GpuDenyColumns;
+  sections[1].section_offset = static_cast<uint32_t>(
+      PushGpuColumns(memory_buffer, kDefaultGpuDenyList, kDefaultGpuDenyCount));
+  sections[1].section_size = static_cast<uint32_t>(memory_buffer.GetUsedSize() -
+      sections[1].section_offset);
+}
+
+// Vector scans find the same candidates as the scalar scan, from every start index
+TEST(VkQualityGpuColumnScan, Validity)
+{
+  static constexpr uint32_t kEntryCount = 61;
+  static constexpr uint32_t kStride = 64;
+  std::vector<uint32_t> column_data(kStride * 5, 0);
+  VkQualityGpuColumns columns;
+  columns.device_name_string_index = column_data.data();
+  columns.min_api_version = column_data.data() + kStride;
+  columns.device_id = column_data.data() + (kStride * 2);
+  columns.vendor_id = column_data.data() + (kStride * 3);
+  columns.min_driver_version = column_data.data() + (kStride * 4);
+  columns.count = kEntryCount;
+
+  uint32_t random_state = 0x1234567;
+  auto next_random = [&random_state](const uint32_t range) {
+    random_state = (random_state * 1103515245U) + 12345U;
+    return (random_state >> 16) % range;
+  };
+  for (uint32_t i = 0; i < kEntryCount; ++i) {
+    column_data[i] = (next_random(4) == 0) ? 1 : 0;
+    column_data[kStride + i] = (next_random(2) == 0) ? 0 : 30 + next_random(8);
+    column_data[(kStride * 2) + i] = 0x100 + next_random(2);
+    column_data[(kStride * 3) + i] = 0x5143;
+    column_data[(kStride * 4) + i] = (next_random(2) == 0) ? 0 : 0x80000000U + next_random(4);
+  }
+
+  DeviceInfo device_info;
+  device_info.vk_vendor_id = 0x5143;
+  for (const int32_t api_level : {29, 33, 40}) {
+    for (const uint32_t driver_version : {0U, 0x80000001U, 0xFFFFFFFFU}) {
+      device_info.api_level = api_level;
+      device_info.vk_driver_version = driver_version;
+      device_info.vk_device_id = 0x100 + (driver_version & 1);
+      for (const bool deny_list : {false, true}) {
+        for (uint32_t start = 0; start <= kEntryCount; ++start) {
+          EXPECT_EQ(VkQualityColumnScan::FindGpuCandidate(columns, device_info, deny_list, start),
+                    VkQualityColumnScan::FindGpuCandidateScalar(columns, device_info, deny_list,
+                                                                start, kEntryCount));
+        }
+      }
+    }
+  }
+}
+
+// GPU column sections give the same matches as the GPU predict lists
+TEST(VkQualityGpuColumnSearch, Validity)
+{
+  MemoryBuffer legacy_buffer;
+  MemoryBuffer columns_buffer;
+  ConstructValidFile(legacy_buffer);
+  ConstructGpuColumnsFile(columns_buffer);
+  VkQualityPredictionFile legacy_file;
+  VkQualityPredictionFile columns_file;
+  ASSERT_EQ(legacy_file.ParseFileData(legacy_buffer.GetPtr(), legacy_buffer.GetUsedSize(),
+                                      kValidVersion),
+            VkQualityPredictionFile::kFileParseResult_Success);
+  ASSERT_EQ(columns_file.ParseFileData(columns_buffer.GetPtr(), columns_buffer.GetUsedSize(),
+                                       kValidVersion),
+            VkQualityPredictionFile::kFileParseResult_Success);
+  EXPECT_FALSE(legacy_file.HasGpuColumns());
+  EXPECT_TRUE(columns_file.HasGpuColumns());
+
+  DeviceInfo device_info {
+      "fakebrand",
+      "fakefone",
+      "genericsoc",
+      "",
+      "genericfingerprint",
+      kDefaultMinAndroidApi,
+      VK_API_VERSION_1_3,
+      0,
+      0,
+      0
+  };
+  for (const char *gpu_name : {"gGPU a250", "gGPU a290", "9dfx doovoo 500", "zmistake XL",
+                               "unknown"}) {
+    for (const uint32_t device_id : {0U, 0xc0250U, 0x333U}) {
+      for (const uint32_t vendor_id : {kFakeGpuVendorId_Google, kFakeGpuVendorId_ZMistake}) {
+        for (const uint32_t driver_version : {kFakeGpuVendor_9dfx_MinDriverVersion - 1,
+                                              kFakeGpuVendor_Google_MinDriverVersion,
+                                              kFakeGpuVendor_ZMistake_MinDriverVersion + 1}) {
+          for (const int32_t api_level : {kDefaultMinAndroidApi - 1, kDefaultMinAndroidApi,
+                                          kDefaultMinAndroidApi + 1}) {
+            device_info.vk_device_name = gpu_name;
+            device_info.vk_device_id = device_id;
+            device_info.vk_vendor_id = vendor_id;
+            device_info.vk_driver_version = driver_version;
+            device_info.api_level = api_level;
+            uint32_t legacy_index = 0;
+            uint32_t columns_index = 0;
+            const auto legacy_result = legacy_file.SearchGpuLists(device_info, legacy_index);
+            EXPECT_EQ(columns_file.SearchGpuLists(device_info, columns_index), legacy_result);
+            if (legacy_result != VkQualityPredictionFile::kFileMatch_None) {
+              EXPECT_EQ(columns_index, legacy_index);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Column count must match the list count
+  VkQualityFileHeader *header = reinterpret_cast<VkQualityFileHeader *>(columns_buffer.GetPtr());
+  header->gpu_deny_predict_count = 0;
+  VkQualityPredictionFile invalid_file;
+  EXPECT_EQ(invalid_file.ParseFileData(columns_buffer.GetPtr(), columns_buffer.GetUsedSize(),
+                                       kValidVersion),
+            VkQualityPredictionFile::kFileParseResult_Error_GpuColumnsInvalid);
+}
+
+// LZ4 block decoding, including matches that overlap their output and
+// matches into data decoded by an earlier block
+TEST(VkQualityCompressionBlocks, Validity)
+{
+  uint8_t decoded[16] = {};
+  // 2 literals "ab", match offset 2 length 6, then 2 final literals "cd"
+  static constexpr uint8_t kOverlapBlock[] = {0x22, 'a', 'b', 0x02, 0x00, 0x20, 'c', 'd'};
+  EXPECT_TRUE(VkQualityCompression::DecompressBlock(kOverlapBlock, sizeof(kOverlapBlock),
+                                                    decoded, 0, 10));
+  EXPECT_EQ(memcmp(decoded, "ababababcd", 10), 0);
+  // Output size must match exactly
+  EXPECT_FALSE(VkQualityCompression::DecompressBlock(kOverlapBlock, sizeof(kOverlapBlock),
+                                                     decoded, 0, 11));
+  EXPECT_FALSE(VkQualityCompression::DecompressBlock(kOverlapBlock, sizeof(kOverlapBlock),
+                                                     decoded, 0, 9));
+  EXPECT_FALSE(VkQualityCompression::DecompressBlock(kOverlapBlock, sizeof(kOverlapBlock) - 4,
+                                                     decoded, 0, 10));
+
+  // A block starting at offset 10 copying the first 4 bytes of the previous block
+  static constexpr uint8_t kLinkedBlock[] = {0x00, 0x0A, 0x00, 0x10, 'z'};
+  EXPECT_TRUE(VkQualityCompression::DecompressBlock(kLinkedBlock, sizeof(kLinkedBlock),
+                                                    decoded, 10, 15));
+  EXPECT_EQ(memcmp(decoded + 10, "ababz", 5), 0);
+  // The same match from the start of the output reaches before it
+  EXPECT_FALSE(VkQualityCompression::DecompressBlock(kLinkedBlock, sizeof(kLinkedBlock),
+                                                     decoded, 0, 5));
+
+  // 15 + 3 extended literal length
+  uint8_t extended_block[20] = {0xF0, 0x03};
+  memset(extended_block + 2, 'x', 18);
+  EXPECT_FALSE(VkQualityCompression::DecompressBlock(extended_block, sizeof(extended_block),
+                                                     decoded, 0, 16));
+  uint8_t extended_decoded[18];
+  EXPECT_TRUE(VkQualityCompression::DecompressBlock(extended_block, sizeof(extended_block),
+                                                    extended_decoded, 0, 18));
+
+  VkQualityCompressedFileHeader header = {
+      VkQualityCompression::kCompressed_File_Identifier,
+      VkQualityCompression::kContainer_Version,
+      VkQualityCompression::kMax_Uncompressed_Size + 1,
+      64 * 1024};
+  size_t file_size = 0;
+  EXPECT_TRUE(VkQualityCompression::IsCompressed(&header, sizeof(header)));
+  EXPECT_EQ(VkQualityCompression::Decompress(&header, sizeof(header), file_size), nullptr);
+  header.uncompressed_size = sizeof(VkQualityFileHeader) + 1;
+  EXPECT_EQ(VkQualityCompression::Decompress(&header, sizeof(header), file_size), nullptr);
+}
+
+TEST(VkQualityChecksum, Crc32c)
+{
+  static constexpr char kCheckString[] = "123456789";
+  EXPECT_EQ(VkQualityChecksum::Crc32c(0, kCheckString, 9), 0xE3069283U);
+  // Continuing a checksum matches a single pass
+  const uint32_t partial_crc = VkQualityChecksum::Crc32c(0, kCheckString, 4);
+  EXPECT_EQ(VkQualityChecksum::Crc32c(partial_crc, kCheckString + 4, 5), 0xE3069283U);
+  EXPECT_EQ(VkQualityChecksum::Crc32c(0, nullptr, 0), 0U);
+
+  // The hardware path agrees with the table at every length and alignment
+  uint8_t buffer[80];
+  for (size_t i = 0; i < sizeof(buffer); ++i) {
+    buffer[i] = static_cast<uint8_t>((i * 167) + 13);
+  }
+  for (size_t start = 0; start < 8; ++start) {
+    for (size_t size = 0; start + size <= sizeof(buffer); ++size) {
+      EXPECT_EQ(VkQualityChecksum::Crc32c(0x1234, buffer + start, size),
+                VkQualityChecksum::Crc32cPortable(0x1234, buffer + start, size));
+    }
+  }
+}
+
+namespace {
+
+bool WriteTestFile(const std::string &path, const void *data, const size_t size) {
+  FILE *fp = fopen(path.c_str(), "wb");
+  if (fp == nullptr) {
+    return false;
+  }
+  const bool wrote = fwrite(data, size, 1, fp) == 1;
+  fclose(fp);
+  return wrote;
+}
+
+bool ReadTestFile(const std::string &path, std::vector<uint8_t> &data) {
+  FILE *fp = fopen(path.c_str(), "rb");
+  if (fp == nullptr) {
+    return false;
+  }
+  uint8_t read_buffer[256];
+  size_t read_size;
+  data.clear();
+  while ((read_size = fread(read_buffer, 1, sizeof(read_buffer), fp)) > 0) {
+    data.insert(data.end(), read_buffer, read_buffer + read_size);
+  }
+  fclose(fp);
+  return true;
+}
+
+} // anonymous namespace
+
+TEST(VkQualityListPatch, Apply)
+{
+  char patch_directory[] = "/data/local/tmp/vkqpatchXXXXXX";
+  if (mkdtemp(patch_directory) == nullptr) {
+    strcpy(patch_directory, "/tmp/vkqpatchXXXXXX");
+    if (mkdtemp(patch_directory) == nullptr) {
+      GTEST_SKIP() << "No writable temp directory";
+    }
+  }
+  const std::string directory_string(patch_directory);
+  const std::string list_path = directory_string + "/patched.vkq";
+  const std::string patch_path = directory_string + "/patched.vkqp";
+
+  // Only the header and checksums are checked, the body doesn't need to be a valid list
+  std::vector<uint8_t> base(sizeof(VkQualityFileHeader) + 8, 0);
+  VkQualityFileHeader file_header = {};
+  file_header.list_version = 7;
+  memcpy(base.data(), &file_header, sizeof(file_header));
+  memcpy(base.data() + sizeof(file_header), "basetail", 8);
+  std::vector<uint8_t> target(base.begin(), base.begin() + sizeof(file_header));
+  target[offsetof(VkQualityFileHeader, list_version)] = 8;
+  target.insert(target.end(), {'n', 'e', 'w', 't', 'a', 'i', 'l'});
+
+  // Insert the new header, copy "tail" from the base, then insert the rest
+  std::vector<uint8_t> patch(sizeof(VkQualityPatchHeader));
+  auto append_op = [&patch](const uint32_t op_type, const uint32_t base_offset,
+                            const void *insert_data, const uint32_t length) {
+    const VkQualityPatchOp op{op_type, base_offset, length};
+    const uint8_t *op_bytes = reinterpret_cast<const uint8_t *>(&op);
+    patch.insert(patch.end(), op_bytes, op_bytes + sizeof(op));
+    if (insert_data != nullptr) {
+      const uint8_t *insert_bytes = reinterpret_cast<const uint8_t *>(insert_data);
+      patch.insert(patch.end(), insert_bytes, insert_bytes + length);
+    }
+  };
+  append_op(VkQualityPatch::kPatchOp_Insert, 0, target.data(), sizeof(file_header));
+  append_op(VkQualityPatch::kPatchOp_Insert, 0, "new", 3);
+  append_op(VkQualityPatch::kPatchOp_Copy, sizeof(file_header) + 4, nullptr, 4);
+  const VkQualityPatchHeader patch_header{
+      VkQualityPatch::kPatch_File_Identifier, VkQualityPatch::kPatch_Version, 3, 0,
+      7, static_cast<uint32_t>(base.size()), VkQualityChecksum::Crc32c(0, base.data(), base.size()),
+      8, static_cast<uint32_t>(target.size()),
+      VkQualityChecksum::Crc32c(0, target.data(), target.size())};
+  memcpy(patch.data(), &patch_header, sizeof(patch_header));
+
+  std::vector<uint8_t> list_data;
+  EXPECT_EQ(vkQuality_applyListPatch(patch_directory, "patched.vkq", patch_path.c_str()),
+            kErrorMissingDataFile);
+
+  // A corrupt patch leaves the current file in place
+  ASSERT_TRUE(WriteTestFile(list_path, base.data(), base.size()));
+  ASSERT_TRUE(WriteTestFile(patch_path, patch.data(), patch.size() - 1));
+  EXPECT_EQ(vkQuality_applyListPatch(patch_directory, "patched.vkq", patch_path.c_str()),
+            kErrorInvalidDataFile);
+  ASSERT_TRUE(ReadTestFile(list_path, list_data));
+  EXPECT_EQ(list_data, base);
+  EXPECT_NE(access((list_path + ".patching").c_str(), F_OK), 0);
+
+  ASSERT_TRUE(WriteTestFile(patch_path, patch.data(), patch.size()));
+  EXPECT_EQ(vkQuality_applyListPatch(patch_directory, "patched.vkq", patch_path.c_str()),
+            kSuccess);
+  ASSERT_TRUE(ReadTestFile(list_path, list_data));
+  EXPECT_EQ(list_data, target);
+
+  // The patch no longer matches the updated file
+  EXPECT_EQ(vkQuality_applyListPatch(patch_directory, "patched.vkq", patch_path.c_str()),
+            kErrorInvalidDataVersion);
+  ASSERT_TRUE(ReadTestFile(list_path, list_data));
+  EXPECT_EQ(list_data, target);
+
+  remove(patch_path.c_str());
+  remove(list_path.c_str());
+  rmdir(patch_directory);
+}
+
 TEST(VkQualityStringComparison, Validity)
 {
   std::string start = "Match Me A";
@@ -983,4 +1729,1022 @@ TEST(VkQualityFingerprintTests, Validity) {
   recommendation = file.FindDeviceMatch(fingerprint_deny,0);
   EXPECT_EQ(recommendation, VkQualityPredictionFile::kFileMatch_DriverDeny);
 
-}
\ No newline at end of file
+}
+
+TEST(VkQualityInternedStrings, Validity) {
+  MemoryBuffer memory_buffer(MemoryBuffer::kDefaultBufferSize, true);
+  ConstructValidFile(memory_buffer);
+  DeviceInfo device_info {
+      "google",
+      "pixel7",
+      "ZZSOC456",
+      "gGPU",
+      "zzzFingerprintCGood",
+      kDefaultMinAndroidApi,
+      VK_API_VERSION_1_3,
+      0x111,
+      kFakeGpuVendor_Google_MinDriverVersion,
+      kFakeGpuVendorId_Google
+  };
+
+  // The string index is opt in
+  uint32_t match_index = 0;
+  {
+    VkQualityPredictionFile file;
+    ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                 kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_FALSE(file.HasInternedStrings());
+  }
+
+  // Every test string is unique, so searches compare string table indices
+  {
+    VkQualityPredictionFile file;
+    file.SetStringIndex(true);
+    ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                 kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_TRUE(file.HasInternedStrings());
+    EXPECT_EQ(file.FindStringId("google"), kTestString_BrandGoogle);
+    EXPECT_EQ(file.FindStringId("zzzFingerprintCGood"), kTestString_FingerprintCGood);
+    EXPECT_EQ(file.FindStringId(""), VkQualityPredictionFile::kEmpty_String_Id);
+    EXPECT_EQ(file.FindStringId("Google"), VkQualityPredictionFile::kAbsent_String_Id);
+
+    EXPECT_EQ(file.FindDeviceMatch(device_info, 0, &match_index),
+              VkQualityPredictionFile::kFileMatch_DriverAllow);
+    EXPECT_EQ(match_index, 3U);
+    EXPECT_EQ(file.FindDeviceMatch(device_info, kInitFlagSkipFingerprintRecommendationCheck,
+                                   &match_index),
+              VkQualityPredictionFile::kFileMatch_ExactDevice);
+    EXPECT_EQ(match_index, 1U);
+    device_info.device = "pixel99";
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_BrandWildcard);
+    EXPECT_EQ(match_index, 2U);
+    device_info.brand = "notabrand";
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_None);
+    device_info.gles_version = "notafingerprint";
+    EXPECT_EQ(file.SearchDriverLists(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_None);
+  }
+
+  // A repeated string has two indices, searches fall back to comparing strings
+  uint8_t *base = reinterpret_cast<uint8_t *>(memory_buffer.GetPtr());
+  const VkQualityFileHeader *header = reinterpret_cast<const VkQualityFileHeader *>(base);
+  uint32_t *string_offsets = reinterpret_cast<uint32_t *>(base + header->string_table_offset);
+  string_offsets[kTestString_GpuFakeGoogle290] = string_offsets[kTestString_BrandGoogle];
+  device_info.brand = "google";
+  device_info.device = "pixel7";
+  device_info.gles_version = "zzzFingerprintCGood";
+  {
+    VkQualityPredictionFile file;
+    file.SetStringIndex(true);
+    ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                 kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_FALSE(file.HasInternedStrings());
+    EXPECT_EQ(file.FindStringId("google"), VkQualityPredictionFile::kAbsent_String_Id);
+    EXPECT_EQ(file.FindDeviceMatch(device_info, 0, &match_index),
+              VkQualityPredictionFile::kFileMatch_DriverAllow);
+    EXPECT_EQ(match_index, 3U);
+    EXPECT_EQ(file.FindDeviceMatch(device_info, kInitFlagSkipFingerprintRecommendationCheck,
+                                   &match_index),
+              VkQualityPredictionFile::kFileMatch_ExactDevice);
+    EXPECT_EQ(match_index, 1U);
+  }
+}
+TEST(VkQualityEvaluateDeviceTests, Validity) {
+  MemoryBuffer memory_buffer(MemoryBuffer::kDefaultBufferSize, true);
+  ConstructValidFile(memory_buffer);
+
+  vkqDeviceDescription device_description {
+      "google",
+      "pixel3.14",
+      nullptr,
+      nullptr,
+      "gGPU",
+      kDefaultMinAndroidApi,
+      VK_API_VERSION_1_3,
+      kFakeGpuVendor_Google_MinDriverVersion,
+      0x111,
+      kFakeGpuVendorId_Google
+  };
+
+  vkqEvaluationResult result{};
+  auto init_result = vkQuality_evaluateDevice(&device_description, memory_buffer.GetPtr(),
+                                              memory_buffer.GetUsedSize(), 0, &result);
+  EXPECT_EQ(init_result, kSuccess);
+  EXPECT_EQ(result.recommendation, kRecommendationVulkanBecauseDeviceMatch);
+  EXPECT_EQ(result.match_type, kMatchTypeDevice);
+  EXPECT_EQ(result.match_index, 0);
+  EXPECT_EQ(result.list_version, kGoodHeaderTemplate.list_version);
+
+  // GPU deny list match, reporting the matching entry
+  device_description.brand = "notrealbrand";
+  device_description.vk_device_name = "zmistake XL";
+  device_description.vk_vendor_id = kFakeGpuVendorId_ZMistake;
+  device_description.vk_driver_version = kFakeGpuVendor_ZMistake_MinDriverVersion;
+  init_result = vkQuality_evaluateDevice(&device_description, memory_buffer.GetPtr(),
+                                         memory_buffer.GetUsedSize(), 0, &result);
+  EXPECT_EQ(init_result, kSuccess);
+  EXPECT_EQ(result.recommendation, kRecommendationGLESBecausePredictionMatch);
+  EXPECT_EQ(result.match_type, kMatchTypeGpuDeny);
+  EXPECT_EQ(result.match_index, 0);
+
+  // No match, but new enough to be recommended Vulkan
+  device_description.vk_device_name = "unknown gpu";
+  device_description.api_level = kGoodHeaderTemplate.min_future_vulkan_recommendation_api;
+  init_result = vkQuality_evaluateDevice(&device_description, memory_buffer.GetPtr(),
+                                         memory_buffer.GetUsedSize(), 0, &result);
+  EXPECT_EQ(init_result, kSuccess);
+  EXPECT_EQ(result.recommendation, kRecommendationVulkanBecauseFutureAndroid);
+  EXPECT_EQ(result.match_type, kMatchTypeNone);
+
+  // Old devices don't need list data
+  device_description.vk_api_version = VK_API_VERSION_1_0;
+  init_result = vkQuality_evaluateDevice(&device_description, nullptr, 0, 0, &result);
+  EXPECT_EQ(init_result, kSuccess);
+  EXPECT_EQ(result.recommendation, kRecommendationGLESBecauseOldDevice);
+
+  device_description.vk_api_version = VK_API_VERSION_1_3;
+  init_result = vkQuality_evaluateDevice(&device_description, kTooSmallBuffer,
+                                         sizeof(kTooSmallBuffer), 0, &result);
+  EXPECT_EQ(init_result, kErrorInvalidDataFile);
+}
+
+static size_t ReadMemoryBuffer(void *user_data, uint64_t offset, void *buffer, size_t size) {
+  MemoryBuffer *memory_buffer = reinterpret_cast<MemoryBuffer *>(user_data);
+  memcpy(buffer, reinterpret_cast<const uint8_t *>(memory_buffer->GetPtr()) + offset, size);
+  return size;
+}
+
+static size_t ReadFailure(void */*user_data*/, uint64_t /*offset*/, void */*buffer*/,
+                          size_t /*size*/) {
+  return 0;
+}
+
+TEST(VkQualityPagedFileTests, Validity) {
+  MemoryBuffer memory_buffer;
+  ConstructValidFile(memory_buffer);
+
+  VkQualityPredictionFile file;
+  EXPECT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                               kValidVersion, nullptr),
+            VkQualityPredictionFile::kFileParseResult_Success);
+
+  // Pages smaller than a device entry, so reads and strings cross pages
+  VkQualityPagedFile paged_file(
+      [&memory_buffer](uint64_t offset, void *buffer, size_t size) {
+        return ReadMemoryBuffer(&memory_buffer, offset, buffer, size);
+      },
+      memory_buffer.GetUsedSize(), 16, 2);
+  EXPECT_EQ(paged_file.Open(kValidVersion), VkQualityPredictionFile::kFileParseResult_Success);
+  EXPECT_EQ(paged_file.GetListVersion(), file.GetListVersion());
+  EXPECT_EQ(paged_file.GetPageCacheSize(), 32);
+
+  const DeviceInfo device_infos[] = {
+      {"google", "pixel3.14", "genericsoc", "gGPU", "genericfingerprint",
+       kDefaultMinAndroidApi, VK_API_VERSION_1_3, 0x111,
+       kFakeGpuVendor_Google_MinDriverVersion, kFakeGpuVendorId_Google},
+      {"google", "", "genericsoc", "gGPU", "genericfingerprint",
+       kDefaultMinAndroidApi + 1, VK_API_VERSION_1_3, 0x111,
+       kFakeGpuVendor_Google_MinDriverVersion, kFakeGpuVendorId_Google},
+      {"fakebrand", "fakefone", "genericsoc", "9dfx doovoo 500", "genericfingerprint",
+       kDefaultMinAndroidApi, VK_API_VERSION_1_3, 0x333,
+       kFakeGpuVendor_9dfx_MinDriverVersion, kFakeGpuVendorId_9dfx},
+      {"notrealbrand", "notrealfone", "genericsoc", "zmistake XL", "genericfingerprint",
+       kDefaultMinAndroidApi, VK_API_VERSION_1_3, 0x222,
+       kFakeGpuVendor_ZMistake_MinDriverVersion, kFakeGpuVendorId_ZMistake},
+      {"google", "pixel3.14", "zzSoC456", "gGPU", "zzzFingerprintCGood",
+       kDefaultMinAndroidApi, VK_API_VERSION_1_3, 0x111,
+       kFakeGpuVendor_Google_MinDriverVersion, kFakeGpuVendorId_Google},
+      {"google", "pixel3.14", "zzSoC123", "gGPU", "zzzFingerprintABad",
+       kDefaultMinAndroidApi, VK_API_VERSION_1_3, 0x111,
+       kFakeGpuVendor_Google_MinDriverVersion, kFakeGpuVendorId_Google},
+      {"nobrand", "nodevice", "nosoc", "nogpu", "nofingerprint",
+       kDefaultMinAndroidApi, VK_API_VERSION_1_3, 0x999, 1, 0x999}
+  };
+  for (const DeviceInfo &device_info : device_infos) {
+    for (const int32_t flags : {0, static_cast<int32_t>(kInitFlagSkipFingerprintRecommendationCheck)}) {
+      uint32_t match_index = UINT32_MAX;
+      uint32_t paged_match_index = UINT32_MAX;
+      EXPECT_EQ(paged_file.FindDeviceMatch(device_info, flags, &paged_match_index),
+                file.FindDeviceMatch(device_info, flags, &match_index)) << device_info.brand;
+      EXPECT_EQ(paged_match_index, match_index);
+    }
+  }
+
+  // Stream evaluation gives the same results as in memory evaluation
+  vkqDeviceDescription device_description {
+      "notrealbrand",
+      "notrealfone",
+      nullptr,
+      nullptr,
+      "zmistake XL",
+      kDefaultMinAndroidApi,
+      VK_API_VERSION_1_3,
+      kFakeGpuVendor_ZMistake_MinDriverVersion,
+      0x222,
+      kFakeGpuVendorId_ZMistake
+  };
+  vkqEvaluationResult result{};
+  vkqEvaluationResult stream_result{};
+  EXPECT_EQ(vkQuality_evaluateDevice(&device_description, memory_buffer.GetPtr(),
+                                     memory_buffer.GetUsedSize(), 0, &result), kSuccess);
+  EXPECT_EQ(vkQuality_evaluateDeviceStream(&device_description, ReadMemoryBuffer, &memory_buffer,
+                                           memory_buffer.GetUsedSize(), 0, &stream_result),
+            kSuccess);
+  EXPECT_EQ(stream_result.recommendation, kRecommendationGLESBecausePredictionMatch);
+  EXPECT_EQ(stream_result.recommendation, result.recommendation);
+  EXPECT_EQ(stream_result.match_type, result.match_type);
+  EXPECT_EQ(stream_result.match_index, result.match_index);
+  EXPECT_EQ(stream_result.list_version, result.list_version);
+
+  // Read errors and truncated files fail to open
+  EXPECT_EQ(vkQuality_evaluateDeviceStream(&device_description, ReadFailure, nullptr,
+                                           memory_buffer.GetUsedSize(), 0, &stream_result),
+            kErrorInvalidDataFile);
+  EXPECT_EQ(vkQuality_evaluateDeviceStream(&device_description, ReadMemoryBuffer, &memory_buffer,
+                                           sizeof(VkQualityFileHeader) - 1, 0, &stream_result),
+            kErrorInvalidDataFile);
+  VkQualityPagedFile truncated_file(
+      [&memory_buffer](uint64_t offset, void *buffer, size_t size) {
+        return ReadMemoryBuffer(&memory_buffer, offset, buffer, size);
+      },
+      reinterpret_cast<const VkQualityFileHeader *>(memory_buffer.GetPtr())->string_table_offset);
+  EXPECT_EQ(truncated_file.Open(kValidVersion),
+            VkQualityPredictionFile::kFileParseResult_Error_StringOffsetOverflow);
+}
+
+// "pixel7" is an alias of "superfone", in a file with the brand index
+static constexpr VkQualityBrandAliasHeader kDefaultBrandAliasHeader = {1, 0};
+static constexpr VkQualityBrandAliasEntry kDefaultBrandAliases[1] = {
+    {kTestString_DevicePixel7, kTestString_BrandSuperfone}
+};
+
+static void ConstructBrandKeyFile(MemoryBuffer &memory_buffer) {
+  ConstructValidFile(memory_buffer, 2);
+  uint8_t *base = reinterpret_cast<uint8_t *>(memory_buffer.GetPtr());
+  reinterpret_cast<VkQualityFileHeader *>(base)->file_format_version =
+      VkQualityPredictionFile::kBrandKey_File_Format_Version;
+  VkQualityFileSectionEntry *sections = reinterpret_cast<VkQualityFileSectionEntry *>(
+      base + sizeof(VkQualityFileHeader) + sizeof(VkQualityFileSectionTable));
+  sections[0].section_id = VkQualityPredictionFile::kFileSection_BrandIndex;
+  sections[0].section_offset = static_cast<uint32_t>(
+      memory_buffer.Push((void*)&kDefaultBrandIndexHeader, sizeof(kDefaultBrandIndexHeader)));
+  PUSH_BUFFER(kDefaultBrandIndex);
+  PUSH_BUFFER(kDefaultBrandDeviceIndex);
+  sections[0].section_size = static_cast<uint32_t>(memory_buffer.GetUsedSize() -
+      sections[0].section_offset);
+  sections[1].section_id = VkQualityPredictionFile::kFileSection_BrandAliases;
+  sections[1].section_offset = static_cast<uint32_t>(
+      memory_buffer.Push((void*)&kDefaultBrandAliasHeader, sizeof(kDefaultBrandAliasHeader)));
+  PUSH_BUFFER(kDefaultBrandAliases);
+  sections[1].section_size = static_cast<uint32_t>(memory_buffer.GetUsedSize() -
+      sections[1].section_offset);
+}
+
+TEST(VkQualityBrandKeys, Validity) {
+  EXPECT_EQ(VkQualityPredictionFile::GetBrandKey("samsung"), "samsung");
+  EXPECT_EQ(VkQualityPredictionFile::GetBrandKey(" SamSung\t"), "samsung");
+  EXPECT_EQ(VkQualityPredictionFile::GetBrandKey("Sony Ericsson"), "sony ericsson");
+  EXPECT_EQ(VkQualityPredictionFile::GetBrandKey(" \r\n"), "");
+  EXPECT_EQ(VkQualityPredictionFile::GetBrandKey(""), "");
+  // Only ASCII letters fold
+  EXPECT_EQ(VkQualityPredictionFile::GetBrandKey("\xC3\x89" "CLAIR_X"), "\xC3\x89" "clair_x");
+
+  MemoryBuffer memory_buffer(MemoryBuffer::kDefaultBufferSize, true);
+  ConstructBrandKeyFile(memory_buffer);
+  VkQualityPredictionFile file;
+  ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                               kValidVersion, nullptr),
+            VkQualityPredictionFile::kFileParseResult_Success);
+  EXPECT_TRUE(file.HasBrandAliases());
+  VkQualityPagedFile paged_file(
+      [&memory_buffer](uint64_t offset, void *buffer, size_t size) {
+        return ReadMemoryBuffer(&memory_buffer, offset, buffer, size);
+      },
+      memory_buffer.GetUsedSize(), 16, 2);
+  ASSERT_EQ(paged_file.Open(kValidVersion), VkQualityPredictionFile::kFileParseResult_Success);
+
+  DeviceInfo device_info {
+      "superfone",
+      "superfone 9000",
+      "genericsoc",
+      "gGPU",
+      "genericfingerprint",
+      kDefaultMinAndroidApi,
+      VK_API_VERSION_1_3,
+      0x111,
+      kFakeGpuVendor_9dfx_MinDriverVersion,
+      0
+  };
+  const struct {
+    const char *brand;
+    VkQualityPredictionFile::FileMatchResult match_result;
+  } brand_matches[] = {
+      {"superfone", VkQualityPredictionFile::kFileMatch_ExactDevice},
+      {"Superfone", VkQualityPredictionFile::kFileMatch_ExactDevice},
+      {" SUPERFONE ", VkQualityPredictionFile::kFileMatch_ExactDevice},
+      {"pixel7", VkQualityPredictionFile::kFileMatch_ExactDevice},
+      {"Pixel7", VkQualityPredictionFile::kFileMatch_ExactDevice},
+      {"super fone", VkQualityPredictionFile::kFileMatch_None},
+      {"", VkQualityPredictionFile::kFileMatch_None}
+  };
+  for (const auto &brand_match : brand_matches) {
+    device_info.brand = brand_match.brand;
+    uint32_t match_index = 0;
+    EXPECT_EQ(file.SearchDeviceList(device_info, match_index), brand_match.match_result)
+        << brand_match.brand;
+    EXPECT_EQ(file.SearchBrandIndex(device_info, match_index), brand_match.match_result)
+        << brand_match.brand;
+    EXPECT_EQ(paged_file.FindDeviceMatch(device_info, kInitFlagSkipFingerprintRecommendationCheck),
+              file.FindDeviceMatch(device_info, kInitFlagSkipFingerprintRecommendationCheck))
+        << brand_match.brand;
+    if (brand_match.match_result == VkQualityPredictionFile::kFileMatch_ExactDevice) {
+      EXPECT_EQ(match_index, 3U);
+    }
+  }
+  // The device list scan gives the same results without the brand index
+  uint8_t *base = reinterpret_cast<uint8_t *>(memory_buffer.GetPtr());
+  VkQualityFileSectionEntry *sections = reinterpret_cast<VkQualityFileSectionEntry *>(
+      base + sizeof(VkQualityFileHeader) + sizeof(VkQualityFileSectionTable));
+  {
+    sections[0].section_id = 0x7FFFFFFF;
+    VkQualityPredictionFile scan_file;
+    ASSERT_EQ(scan_file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                      kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_FALSE(scan_file.HasBrandIndex());
+    uint32_t match_index = 0;
+    device_info.brand = "PIXEL7";
+    EXPECT_EQ(scan_file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_ExactDevice);
+    EXPECT_EQ(match_index, 3U);
+    sections[0].section_id = VkQualityPredictionFile::kFileSection_BrandIndex;
+  }
+
+  // Files from before brand keys match brands exactly, and ignore aliases
+  VkQualityFileHeader *header = reinterpret_cast<VkQualityFileHeader *>(base);
+  header->file_format_version = VkQualityPredictionFile::kSectionTable_File_Format_Version;
+  for (const char *brand : {"Superfone", "pixel7"}) {
+    VkQualityPredictionFile old_file;
+    ASSERT_EQ(old_file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                     kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    device_info.brand = brand;
+    uint32_t match_index = 0;
+    EXPECT_EQ(old_file.SearchDeviceList(device_info, match_index),
+              VkQualityPredictionFile::kFileMatch_None) << brand;
+  }
+  header->file_format_version = VkQualityPredictionFile::kBrandKey_File_Format_Version;
+
+  // An alias to the null string is invalid, and ignored with lazy validation
+  VkQualityBrandAliasEntry *alias_entries = reinterpret_cast<VkQualityBrandAliasEntry *>(
+      base + sections[1].section_offset + sizeof(VkQualityBrandAliasHeader));
+  alias_entries[0].brand_string_index = 0;
+  {
+    VkQualityPredictionFile invalid_file;
+    EXPECT_EQ(invalid_file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                         kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Error_BrandAliasesInvalid);
+  }
+  VkQualityPredictionFile lazy_file;
+  lazy_file.SetValidationMode(VkQualityPredictionFile::kValidation_Lazy);
+  ASSERT_EQ(lazy_file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                    kValidVersion, nullptr),
+            VkQualityPredictionFile::kFileParseResult_Success);
+  EXPECT_FALSE(lazy_file.HasBrandAliases());
+  device_info.brand = "Superfone";
+  uint32_t match_index = 0;
+  EXPECT_EQ(lazy_file.SearchDeviceList(device_info, match_index),
+            VkQualityPredictionFile::kFileMatch_ExactDevice);
+}
+
+TEST(VkQualityDriverVersion, Parse) {
+  const struct {
+    const char *gles_version;
+    VkQualityDriverVersion::VersionFormat version_format;
+    bool valid;
+    uint64_t version;
+  } parse_tests[] = {
+      {"OpenGL ES 3.2 V@0615.73 (GIT@8f5499ec14, I2ed56ad6a5, 1693304458) (Date:08/29/23)",
+       VkQualityDriverVersion::kVersionFormat_Qualcomm, true,
+       VkQualityDriverVersion::MakeVersion(615, 73, 0)},
+      {"OpenGL ES 3.2 V@415.0", VkQualityDriverVersion::kVersionFormat_Qualcomm, true,
+       VkQualityDriverVersion::MakeVersion(415, 0, 0)},
+      {"OpenGL ES 3.2 V@502", VkQualityDriverVersion::kVersionFormat_Qualcomm, true,
+       VkQualityDriverVersion::MakeVersion(502, 0, 0)},
+      {"OpenGL ES 3.2 V@", VkQualityDriverVersion::kVersionFormat_Qualcomm, false, 0},
+      {"OpenGL ES 3.2 v1.r32p1-01eac0.2819f9d4dbe0b5a2f89c835d8484f9cd",
+       VkQualityDriverVersion::kVersionFormat_Arm, true,
+       VkQualityDriverVersion::MakeVersion(32, 1, 0)},
+      {"OpenGL ES 3.2 v1.g2p0-01eac0.0fd2effaec483a5f4c440d2ffa25eb7a",
+       VkQualityDriverVersion::kVersionFormat_Arm, false, 0},
+      // "r" inside a hash is not a version
+      {"OpenGL ES 3.2 v1.g2p0-01eac0.ar9p3", VkQualityDriverVersion::kVersionFormat_Arm, false, 0},
+      {"OpenGL ES 3.2 build 1.13@5776728", VkQualityDriverVersion::kVersionFormat_Imagination,
+       true, VkQualityDriverVersion::MakeVersion(1, 13, 5776728)},
+      {"OpenGL ES 3.2 build 1.13", VkQualityDriverVersion::kVersionFormat_Imagination, false, 0},
+      // Formats don't parse other vendors' strings
+      {"OpenGL ES 3.2 V@0615.73", VkQualityDriverVersion::kVersionFormat_Arm, false, 0},
+      {"OpenGL ES 3.2 v1.r32p1-01eac0", VkQualityDriverVersion::kVersionFormat_Qualcomm, false, 0},
+      {"", VkQualityDriverVersion::kVersionFormat_Imagination, false, 0},
+      {"OpenGL ES 3.2 V@0615.73", static_cast<VkQualityDriverVersion::VersionFormat>(0), false, 0}
+  };
+  for (const auto &parse_test : parse_tests) {
+    uint64_t version = 0;
+    EXPECT_EQ(VkQualityDriverVersion::ParseGlesVersion(parse_test.gles_version,
+                                                       parse_test.version_format, version),
+              parse_test.valid) << parse_test.gles_version;
+    if (parse_test.valid) {
+      EXPECT_EQ(version, parse_test.version) << parse_test.gles_version;
+    }
+  }
+
+  // Versions order by major, then minor, then build, and saturate
+  EXPECT_LT(VkQualityDriverVersion::MakeVersion(614, 999, 0),
+            VkQualityDriverVersion::MakeVersion(615, 0, 0));
+  EXPECT_LT(VkQualityDriverVersion::MakeVersion(1, 13, 5776728),
+            VkQualityDriverVersion::MakeVersion(1, 14, 0));
+  EXPECT_EQ(VkQualityDriverVersion::MakeVersion(0x20000, 0, 0),
+            VkQualityDriverVersion::MakeVersion(0xFFFF, 0, 0));
+  uint64_t version = 0;
+  EXPECT_TRUE(VkQualityDriverVersion::ParseGlesVersion(
+      "V@99999999999.1", VkQualityDriverVersion::kVersionFormat_Qualcomm, version));
+  EXPECT_EQ(version, VkQualityDriverVersion::MakeVersion(0xFFFF, 1, 0));
+}
+
+TEST(VkQualityDriverVersion, VulkanDecode) {
+  const struct {
+    uint32_t vendor_id;
+    uint32_t driver_version;
+    uint64_t version;
+  } decode_tests[] = {
+      // Adreno 512.676.0, V@0676
+      {VkQualityDriverVersion::kVendorId_Qualcomm, 2150252544U,
+       VkQualityDriverVersion::MakeVersion(676, 0, 0)},
+      {VkQualityDriverVersion::kVendorId_Qualcomm, 0x80267049U,
+       VkQualityDriverVersion::MakeVersion(615, 73, 0)},
+      // Mali r32p1
+      {0x13B5, (32U << 22) | (1U << 12), VkQualityDriverVersion::MakeVersion(32, 1, 0)},
+      // NVIDIA 535.98.3.1
+      {VkQualityDriverVersion::kVendorId_Nvidia, (535U << 22) | (98U << 14) | (3U << 6) | 1U,
+       VkQualityDriverVersion::MakeVersion(535, 98, (3U << 6) | 1U)},
+      // PowerVR 1.386.1368
+      {0x1010, (1U << 22) | (386U << 12) | 1368U, VkQualityDriverVersion::MakeVersion(1, 386, 1368)}
+  };
+  for (const auto &decode_test : decode_tests) {
+    EXPECT_EQ(VkQualityDriverVersion::DecodeVulkanDriverVersion(decode_test.vendor_id,
+                                                                decode_test.driver_version),
+              decode_test.version) << decode_test.driver_version;
+    EXPECT_EQ(VkQualityDriverVersion::EncodeVulkanDriverVersion(decode_test.vendor_id,
+                                                                decode_test.version),
+              decode_test.driver_version) << decode_test.driver_version;
+  }
+
+  // A Qualcomm driver decodes to the version parsed from its GL string
+  uint64_t gles_version = 0;
+  ASSERT_TRUE(VkQualityDriverVersion::ParseGlesVersion(
+      "OpenGL ES 3.2 V@0615.73 (GIT@8f5499ec14)", VkQualityDriverVersion::kVersionFormat_Qualcomm,
+      gles_version));
+  EXPECT_EQ(VkQualityDriverVersion::DecodeVulkanDriverVersion(
+      VkQualityDriverVersion::kVendorId_Qualcomm, 0x80267049U), gles_version);
+
+  // Raw values of a vendor order the same as their decoded versions
+  EXPECT_LT(VkQualityDriverVersion::EncodeVulkanDriverVersion(
+                VkQualityDriverVersion::kVendorId_Qualcomm,
+                VkQualityDriverVersion::MakeVersion(615, 999, 0)),
+            VkQualityDriverVersion::EncodeVulkanDriverVersion(
+                VkQualityDriverVersion::kVendorId_Qualcomm,
+                VkQualityDriverVersion::MakeVersion(676, 0, 0)));
+  // Components the layout can't hold saturate
+  EXPECT_EQ(VkQualityDriverVersion::EncodeVulkanDriverVersion(
+                0x13B5, VkQualityDriverVersion::MakeVersion(0x400, 0x400, 0x1000)),
+            UINT32_MAX);
+}
+
+// zzSoC123 Qualcomm drivers from 600 up to 700 are allowed, except for
+// 615.73 which is denied, and all zzSoC456 Arm drivers before r40p0 are denied
+static constexpr VkQualityDriverRulesHeader kDefaultDriverAllowRulesHeader = {1, 0};
+static constexpr VkQualityDriverRuleEntry kDefaultDriverAllowRules[1] = {
+    {kTestString_SoC123, VkQualityDriverVersion::kVersionFormat_Qualcomm,
+     0x0258000000000000ULL, 0x02BC000000000000ULL}
+};
+static constexpr VkQualityDriverRulesHeader kDefaultDriverDenyRulesHeader = {2, 0};
+static constexpr VkQualityDriverRuleEntry kDefaultDriverDenyRules[2] = {
+    {kTestString_SoC456, VkQualityDriverVersion::kVersionFormat_Arm, 0, 0x0027FFFFFFFFFFFFULL},
+    {kTestString_SoC123, VkQualityDriverVersion::kVersionFormat_Qualcomm, 0, 0}
+};
+
+static void ConstructDriverRulesFile(MemoryBuffer &memory_buffer) {
+  ConstructValidFile(memory_buffer, 2);
+  uint8_t *base = reinterpret_cast<uint8_t *>(memory_buffer.GetPtr());
+  VkQualityFileSectionEntry *sections = reinterpret_cast<VkQualityFileSectionEntry *>(
+      base + sizeof(VkQualityFileHeader) + sizeof(VkQualityFileSectionTable));
+  sections[0].section_id = VkQualityPredictionFile::kFileSection_DriverAllowRules;
+  sections[0].section_offset = static_cast<uint32_t>(memory_buffer.Push(
+      (void*)&kDefaultDriverAllowRulesHeader, sizeof(kDefaultDriverAllowRulesHeader)));
+  PUSH_BUFFER(kDefaultDriverAllowRules);
+  sections[0].section_size = static_cast<uint32_t>(memory_buffer.GetUsedSize() -
+      sections[0].section_offset);
+  sections[1].section_id = VkQualityPredictionFile::kFileSection_DriverDenyRules;
+  sections[1].section_offset = static_cast<uint32_t>(memory_buffer.Push(
+      (void*)&kDefaultDriverDenyRulesHeader, sizeof(kDefaultDriverDenyRulesHeader)));
+  PUSH_BUFFER(kDefaultDriverDenyRules);
+  sections[1].section_size = static_cast<uint32_t>(memory_buffer.GetUsedSize() -
+      sections[1].section_offset);
+}
+
+TEST(VkQualityDriverRules, Validity) {
+  EXPECT_EQ(kDefaultDriverAllowRules[0].min_driver_version,
+            VkQualityDriverVersion::MakeVersion(600, 0, 0));
+  EXPECT_EQ(kDefaultDriverAllowRules[0].max_driver_version,
+            VkQualityDriverVersion::MakeVersion(700, 0, 0));
+
+  MemoryBuffer memory_buffer(MemoryBuffer::kDefaultBufferSize, true);
+  ConstructDriverRulesFile(memory_buffer);
+  VkQualityPredictionFile file;
+  ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                               kValidVersion, nullptr),
+            VkQualityPredictionFile::kFileParseResult_Success);
+  EXPECT_TRUE(file.HasDriverRules());
+  VkQualityPagedFile paged_file(
+      [&memory_buffer](uint64_t offset, void *buffer, size_t size) {
+        return ReadMemoryBuffer(&memory_buffer, offset, buffer, size);
+      },
+      memory_buffer.GetUsedSize(), 16, 2);
+  ASSERT_EQ(paged_file.Open(kValidVersion), VkQualityPredictionFile::kFileParseResult_Success);
+
+  DeviceInfo device_info {
+      "nobrand",
+      "nodevice",
+      "zzSoC123",
+      "gGPU",
+      "",
+      kDefaultMinAndroidApi,
+      VK_API_VERSION_1_3,
+      0x111,
+      kFakeGpuVendor_9dfx_MinDriverVersion,
+      0
+  };
+  const struct {
+    const char *soc;
+    const char *gles_version;
+    VkQualityPredictionFile::FileMatchResult match_result;
+    uint32_t match_index;
+  } rule_matches[] = {
+      {"zzSoC123", "OpenGL ES 3.2 V@0615.73 (GIT@8f5499ec14)",
+       VkQualityPredictionFile::kFileMatch_DriverRuleAllow, 0},
+      {"ZZSOC123", "OpenGL ES 3.2 V@600", VkQualityPredictionFile::kFileMatch_DriverRuleAllow, 0},
+      {"zzSoC123", "OpenGL ES 3.2 V@700.0", VkQualityPredictionFile::kFileMatch_DriverRuleAllow, 0},
+      {"zzSoC123", "OpenGL ES 3.2 V@700.1", VkQualityPredictionFile::kFileMatch_DriverRuleDeny, 1},
+      {"zzSoC123", "OpenGL ES 3.2 V@0512.0", VkQualityPredictionFile::kFileMatch_DriverRuleDeny, 1},
+      // The unbounded deny rule still needs a version it can parse
+      {"zzSoC123", "OpenGL ES 3.2 v1.r32p1", VkQualityPredictionFile::kFileMatch_None, 0},
+      {"zzSoC456", "OpenGL ES 3.2 v1.r32p1-01eac0",
+       VkQualityPredictionFile::kFileMatch_DriverRuleDeny, 0},
+      {"zzSoC456", "OpenGL ES 3.2 v1.r40p0-01eac0", VkQualityPredictionFile::kFileMatch_None, 0},
+      {"zzSoC789", "OpenGL ES 3.2 V@0615.73", VkQualityPredictionFile::kFileMatch_None, 0},
+      {"", "OpenGL ES 3.2 V@0615.73", VkQualityPredictionFile::kFileMatch_None, 0}
+  };
+  for (const auto &rule_match : rule_matches) {
+    device_info.soc = rule_match.soc;
+    device_info.gles_version = rule_match.gles_version;
+    uint32_t match_index = 0;
+    EXPECT_EQ(file.FindDeviceMatch(device_info, 0, &match_index), rule_match.match_result)
+        << rule_match.soc << " " << rule_match.gles_version;
+    EXPECT_EQ(match_index, rule_match.match_index) << rule_match.gles_version;
+    uint32_t paged_match_index = 0;
+    EXPECT_EQ(paged_file.FindDeviceMatch(device_info, 0, &paged_match_index),
+              rule_match.match_result) << rule_match.gles_version;
+    EXPECT_EQ(paged_match_index, rule_match.match_index) << rule_match.gles_version;
+    // Rules are part of the fingerprint check
+    EXPECT_EQ(file.FindDeviceMatch(device_info, kInitFlagSkipFingerprintRecommendationCheck),
+              VkQualityPredictionFile::kFileMatch_None);
+  }
+
+  // An exact fingerprint wins over a rule
+  device_info.soc = "zzSoC123";
+  device_info.gles_version = "zzzFingerprintAGood";
+  EXPECT_EQ(file.FindDeviceMatch(device_info, 0),
+            VkQualityPredictionFile::kFileMatch_DriverAllow);
+
+  // A rule with the null SoC string is invalid, and ignored with lazy validation
+  uint8_t *base = reinterpret_cast<uint8_t *>(memory_buffer.GetPtr());
+  VkQualityFileSectionEntry *sections = reinterpret_cast<VkQualityFileSectionEntry *>(
+      base + sizeof(VkQualityFileHeader) + sizeof(VkQualityFileSectionTable));
+  VkQualityDriverRuleEntry *rule_entries = reinterpret_cast<VkQualityDriverRuleEntry *>(
+      base + sections[0].section_offset + sizeof(VkQualityDriverRulesHeader));
+  rule_entries[0].soc_string_index = 0;
+  {
+    VkQualityPredictionFile invalid_file;
+    EXPECT_EQ(invalid_file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                         kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Error_DriverRulesInvalid);
+  }
+
+  // unless it is a Vulkan driver version rule keyed by vendor id
+  rule_entries[0].version_format = VkQualityDriverVersion::kVersionFormat_Vulkan;
+  {
+    VkQualityPredictionFile invalid_file;
+    EXPECT_EQ(invalid_file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                         kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Error_DriverRulesInvalid);
+  }
+  rule_entries[0].vendor_id = VkQualityDriverVersion::kVendorId_Qualcomm;
+  {
+    VkQualityPredictionFile vendor_file;
+    EXPECT_EQ(vendor_file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                        kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+  }
+  rule_entries[0].version_format = VkQualityDriverVersion::kVersionFormat_Qualcomm;
+  rule_entries[0].vendor_id = 0;
+  rule_entries[0].soc_string_index = kTestStringTableCount;
+  VkQualityPredictionFile lazy_file;
+  lazy_file.SetValidationMode(VkQualityPredictionFile::kValidation_Lazy);
+  ASSERT_EQ(lazy_file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                    kValidVersion, nullptr),
+            VkQualityPredictionFile::kFileParseResult_Success);
+  device_info.gles_version = "OpenGL ES 3.2 V@0615.73";
+  EXPECT_EQ(lazy_file.FindDeviceMatch(device_info, 0),
+            VkQualityPredictionFile::kFileMatch_DriverRuleDeny);
+
+  // A rule count past the end of the section fails the size check
+  reinterpret_cast<VkQualityDriverRulesHeader *>(base + sections[1].section_offset)->rule_count = 3;
+  {
+    VkQualityPredictionFile invalid_file;
+    EXPECT_EQ(invalid_file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                         kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Error_DriverRulesInvalid);
+  }
+}
+
+static constexpr uint64_t kCapabilityDynamicRendering =
+    VkQualityCapabilities::GetBit(VkQualityCapabilities::kCapability_DynamicRendering);
+static constexpr uint64_t kCapabilitySynchronization2 =
+    VkQualityCapabilities::GetBit(VkQualityCapabilities::kCapability_Synchronization2);
+static constexpr uint64_t kCapabilityShaderInt16 =
+    VkQualityCapabilities::GetBit(VkQualityCapabilities::kCapability_ShaderInt16);
+static constexpr uint64_t kCapabilityShaderFloat16Int8 =
+    VkQualityCapabilities::GetBit(VkQualityCapabilities::kCapability_ShaderFloat16Int8);
+
+// Devices with dynamic rendering and synchronization2 are allowed. zmistake
+// devices without dynamic rendering, and devices with 16 bit integers in
+// shaders but not float16_int8, are denied
+static constexpr VkQualityCapabilityRulesHeader kDefaultCapabilityAllowRulesHeader = {1, 0};
+static constexpr VkQualityCapabilityRuleEntry kDefaultCapabilityAllowRules[1] = {
+    {kCapabilityDynamicRendering | kCapabilitySynchronization2, 0, 0, 0}
+};
+static constexpr VkQualityCapabilityRulesHeader kDefaultCapabilityDenyRulesHeader = {2, 0};
+static constexpr VkQualityCapabilityRuleEntry kDefaultCapabilityDenyRules[2] = {
+    {0, kCapabilityDynamicRendering, kFakeGpuVendorId_ZMistake, 0},
+    {kCapabilityShaderInt16, kCapabilityShaderFloat16Int8, 0, 0}
+};
+
+static void ConstructCapabilityRulesFile(MemoryBuffer &memory_buffer) {
+  ConstructValidFile(memory_buffer, 2);
+  uint8_t *base = reinterpret_cast<uint8_t *>(memory_buffer.GetPtr());
+  VkQualityFileSectionEntry *sections = reinterpret_cast<VkQualityFileSectionEntry *>(
+      base + sizeof(VkQualityFileHeader) + sizeof(VkQualityFileSectionTable));
+  sections[0].section_id = VkQualityPredictionFile::kFileSection_CapabilityAllowRules;
+  sections[0].section_offset = static_cast<uint32_t>(memory_buffer.Push(
+      (void*)&kDefaultCapabilityAllowRulesHeader, sizeof(kDefaultCapabilityAllowRulesHeader)));
+  PUSH_BUFFER(kDefaultCapabilityAllowRules);
+  sections[0].section_size = static_cast<uint32_t>(memory_buffer.GetUsedSize() -
+      sections[0].section_offset);
+  sections[1].section_id = VkQualityPredictionFile::kFileSection_CapabilityDenyRules;
+  sections[1].section_offset = static_cast<uint32_t>(memory_buffer.Push(
+      (void*)&kDefaultCapabilityDenyRulesHeader, sizeof(kDefaultCapabilityDenyRulesHeader)));
+  PUSH_BUFFER(kDefaultCapabilityDenyRules);
+  sections[1].section_size = static_cast<uint32_t>(memory_buffer.GetUsedSize() -
+      sections[1].section_offset);
+}
+
+TEST(VkQualityCapabilityRules, Validity) {
+  EXPECT_EQ(VkQualityCapabilities::GetExtensionCapability("VK_KHR_dynamic_rendering"),
+            kCapabilityDynamicRendering);
+  EXPECT_EQ(VkQualityCapabilities::GetExtensionCapability("VK_KHR_swapchain"), 0U);
+  EXPECT_EQ(VkQualityCapabilities::kKnownCapabilities & VkQualityCapabilities::kCapability_Probed,
+            0U);
+
+  MemoryBuffer memory_buffer(MemoryBuffer::kDefaultBufferSize, true);
+  ConstructCapabilityRulesFile(memory_buffer);
+  VkQualityPredictionFile file;
+  ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                               kValidVersion, nullptr),
+            VkQualityPredictionFile::kFileParseResult_Success);
+  EXPECT_TRUE(file.HasCapabilityRules());
+  VkQualityPagedFile paged_file(
+      [&memory_buffer](uint64_t offset, void *buffer, size_t size) {
+        return ReadMemoryBuffer(&memory_buffer, offset, buffer, size);
+      },
+      memory_buffer.GetUsedSize(), 16, 2);
+  ASSERT_EQ(paged_file.Open(kValidVersion), VkQualityPredictionFile::kFileParseResult_Success);
+
+  constexpr uint64_t kProbed = VkQualityCapabilities::kCapability_Probed;
+  const struct {
+    const char *brand;
+    uint32_t vendor_id;
+    uint64_t capabilities;
+    VkQualityPredictionFile::FileMatchResult match_result;
+    uint32_t match_index;
+  } rule_matches[] = {
+      {"notrealbrand", 0, kProbed | kCapabilityDynamicRendering | kCapabilitySynchronization2,
+       VkQualityPredictionFile::kFileMatch_CapabilityAllow, 0},
+      {"notrealbrand", 0, kProbed | kCapabilityDynamicRendering,
+       VkQualityPredictionFile::kFileMatch_None, 0},
+      // Capabilities of a device that wasn't probed are unknown
+      {"notrealbrand", 0, kCapabilityDynamicRendering | kCapabilitySynchronization2,
+       VkQualityPredictionFile::kFileMatch_None, 0},
+      {"notrealbrand", 0, kProbed | kCapabilityShaderInt16 | kCapabilityDynamicRendering |
+           kCapabilitySynchronization2, VkQualityPredictionFile::kFileMatch_CapabilityDeny, 1},
+      {"notrealbrand", 0, kProbed | kCapabilityShaderInt16 | kCapabilityShaderFloat16Int8,
+       VkQualityPredictionFile::kFileMatch_None, 0},
+      {"notrealbrand", kFakeGpuVendorId_ZMistake, kProbed | kCapabilitySynchronization2,
+       VkQualityPredictionFile::kFileMatch_CapabilityDeny, 0},
+      // Deny rules are searched before the device list, allow rules after it
+      {"google", 0, kProbed | kCapabilityShaderInt16,
+       VkQualityPredictionFile::kFileMatch_CapabilityDeny, 1},
+      {"google", 0, kProbed | kCapabilityDynamicRendering | kCapabilitySynchronization2,
+       VkQualityPredictionFile::kFileMatch_ExactDevice, 0},
+  };
+  DeviceInfo device_info {
+      "",
+      "pixel3.14",
+      "",
+      "unknown gpu",
+      "",
+      kDefaultMinAndroidApi,
+      VK_API_VERSION_1_3,
+      0x111,
+      kFakeGpuVendor_Google_MinDriverVersion,
+      0
+  };
+  for (const auto &rule_match : rule_matches) {
+    device_info.brand = rule_match.brand;
+    device_info.vk_vendor_id = rule_match.vendor_id;
+    device_info.vk_capabilities = rule_match.capabilities;
+    uint32_t match_index = 0;
+    EXPECT_EQ(file.FindDeviceMatch(device_info, 0, &match_index), rule_match.match_result)
+        << rule_match.capabilities;
+    EXPECT_EQ(match_index, rule_match.match_index) << rule_match.capabilities;
+    uint32_t paged_match_index = 0;
+    EXPECT_EQ(paged_file.FindDeviceMatch(device_info, 0, &paged_match_index),
+              rule_match.match_result) << rule_match.capabilities;
+    EXPECT_EQ(paged_match_index, rule_match.match_index) << rule_match.capabilities;
+  }
+
+  // Capabilities passed through the device description match the same rules
+  vkqDeviceDescription device_description{};
+  device_description.brand = "notrealbrand";
+  device_description.device = "pixel3.14";
+  device_description.api_level = kDefaultMinAndroidApi;
+  device_description.vk_api_version = VK_API_VERSION_1_3;
+  device_description.vk_capabilities = kProbed | kCapabilityDynamicRendering |
+      kCapabilitySynchronization2;
+  vkqEvaluationResult result{};
+  EXPECT_EQ(vkQuality_evaluateDevice(&device_description, memory_buffer.GetPtr(),
+                                     memory_buffer.GetUsedSize(), 0, &result), kSuccess);
+  EXPECT_EQ(result.recommendation, kRecommendationVulkanBecausePredictionMatch);
+  EXPECT_EQ(result.match_type, kMatchTypeCapabilityAllow);
+  device_description.vk_capabilities |= kCapabilityShaderInt16;
+  EXPECT_EQ(vkQuality_evaluateDevice(&device_description, memory_buffer.GetPtr(),
+                                     memory_buffer.GetUsedSize(), 0, &result), kSuccess);
+  EXPECT_EQ(result.recommendation, kRecommendationGLESBecausePredictionMatch);
+  EXPECT_EQ(result.match_type, kMatchTypeCapabilityDeny);
+  EXPECT_EQ(result.match_index, 1);
+
+  // A bit the library doesn't know never matches, it may be one a newer library probes
+  uint8_t *base = reinterpret_cast<uint8_t *>(memory_buffer.GetPtr());
+  VkQualityFileSectionEntry *sections = reinterpret_cast<VkQualityFileSectionEntry *>(
+      base + sizeof(VkQualityFileHeader) + sizeof(VkQualityFileSectionTable));
+  VkQualityCapabilityRuleEntry *rule_entries = reinterpret_cast<VkQualityCapabilityRuleEntry *>(
+      base + sections[0].section_offset + sizeof(VkQualityCapabilityRulesHeader));
+  rule_entries[0].forbidden_capabilities = uint64_t{1} << 62;
+  device_info.brand = "notrealbrand";
+  device_info.vk_vendor_id = 0;
+  device_info.vk_capabilities = kProbed | kCapabilityDynamicRendering |
+      kCapabilitySynchronization2;
+  {
+    VkQualityPredictionFile unknown_file;
+    ASSERT_EQ(unknown_file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                         kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Success);
+    EXPECT_EQ(unknown_file.FindDeviceMatch(device_info, 0),
+              VkQualityPredictionFile::kFileMatch_None);
+  }
+
+  // A bit both required and forbidden is invalid
+  rule_entries[0].forbidden_capabilities = kCapabilitySynchronization2;
+  {
+    VkQualityPredictionFile invalid_file;
+    EXPECT_EQ(invalid_file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                         kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Error_CapabilityRulesInvalid);
+  }
+  rule_entries[0].forbidden_capabilities = 0;
+  reinterpret_cast<VkQualityCapabilityRulesHeader *>(
+      base + sections[1].section_offset)->rule_count = 3;
+  {
+    VkQualityPredictionFile invalid_file;
+    EXPECT_EQ(invalid_file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                                         kValidVersion, nullptr),
+              VkQualityPredictionFile::kFileParseResult_Error_CapabilityRulesInvalid);
+  }
+}
+
+// Physical devices of a stub Vulkan loader, the handle of a device is its
+// address in the array
+struct StubPhysicalDevice {
+  uint32_t queue_flags;
+  VkQualityDeviceCandidate properties;
+};
+
+struct StubLoader {
+  std::vector<StubPhysicalDevice> devices;
+  int32_t enumerate_result = VkQualityDeviceProbe::kResultSuccess;
+};
+
+static int32_t StubEnumeratePhysicalDevices(void *user_data, uint32_t *device_count,
+                                            void **physical_devices) {
+  StubLoader *loader = reinterpret_cast<StubLoader *>(user_data);
+  const uint32_t count = static_cast<uint32_t>(loader->devices.size());
+  if (*device_count > count) {
+    *device_count = count;
+  }
+  for (uint32_t i = 0; i < *device_count; ++i) {
+    physical_devices[i] = &loader->devices[i];
+  }
+  if (loader->enumerate_result == VkQualityDeviceProbe::kResultSuccess && *device_count < count) {
+    return VkQualityDeviceProbe::kResultIncomplete;
+  }
+  return loader->enumerate_result;
+}
+
+static void StubGetQueueFamilyFlags(void */*user_data*/, void *physical_device,
+                                    uint32_t *family_count, uint32_t *queue_flags) {
+  // A transfer only family ahead of the one the device was given
+  const StubPhysicalDevice *device = reinterpret_cast<const StubPhysicalDevice *>(physical_device);
+  queue_flags[0] = 0x4;
+  queue_flags[1] = device->queue_flags;
+  *family_count = 2;
+}
+
+static void StubGetDeviceProperties(void */*user_data*/, void *physical_device,
+                                    VkQualityDeviceCandidate &candidate) {
+  candidate = reinterpret_cast<const StubPhysicalDevice *>(physical_device)->properties;
+}
+
+static StubPhysicalDevice MakeStubDevice(const uint32_t queue_flags, const char *name,
+                                         const uint32_t api_version, const uint32_t vendor_id,
+                                         const uint32_t device_id, const uint32_t driver_version) {
+  StubPhysicalDevice device{};
+  device.queue_flags = queue_flags;
+  device.properties.physical_device_index = 0xFFFF;
+  device.properties.api_version = api_version;
+  device.properties.driver_version = driver_version;
+  device.properties.vendor_id = vendor_id;
+  device.properties.device_id = device_id;
+  strncpy(device.properties.device_name, name, sizeof(device.properties.device_name));
+  return device;
+}
+
+TEST(VkQualityDeviceProbeTests, Validity) {
+  StubLoader stub_loader;
+  VkQualityDeviceProbe::Loader loader;
+  loader.user_data = &stub_loader;
+  VkQualityDeviceCandidates candidates;
+  EXPECT_FALSE(VkQualityDeviceProbe::Probe(loader, candidates));
+
+  loader.enumerate_physical_devices = StubEnumeratePhysicalDevices;
+  loader.get_queue_family_flags = StubGetQueueFamilyFlags;
+  loader.get_device_properties = StubGetDeviceProperties;
+  EXPECT_FALSE(VkQualityDeviceProbe::Probe(loader, candidates));
+  EXPECT_EQ(candidates.count, 0U);
+
+  // Compute only devices are skipped, the candidates keep their enumeration index
+  stub_loader.devices.push_back(MakeStubDevice(0x2, "compute", VK_API_VERSION_1_3,
+                                               kFakeGpuVendorId_Google, 0x1, 0));
+  stub_loader.devices.push_back(MakeStubDevice(0x3, kTestStrings[kTestString_GpuZMistake],
+                                               VK_API_VERSION_1_3, kFakeGpuVendorId_ZMistake,
+                                               0xc0250, kFakeGpuVendor_ZMistake_MinDriverVersion));
+  stub_loader.devices.push_back(MakeStubDevice(0x1, kTestStrings[kTestString_Gpu9dfx],
+                                               VK_API_VERSION_1_3, kFakeGpuVendorId_9dfx,
+                                               0xc0250, kFakeGpuVendor_9dfx_MinDriverVersion));
+  ASSERT_TRUE(VkQualityDeviceProbe::Probe(loader, candidates));
+  ASSERT_EQ(candidates.count, 2U);
+  EXPECT_EQ(candidates.candidates[0].physical_device_index, 1U);
+  EXPECT_EQ(candidates.candidates[0].vendor_id, kFakeGpuVendorId_ZMistake);
+  EXPECT_STREQ(candidates.candidates[0].device_name, kTestStrings[kTestString_GpuZMistake]);
+  EXPECT_EQ(candidates.candidates[1].physical_device_index, 2U);
+  EXPECT_EQ(candidates.candidates[1].vendor_id, kFakeGpuVendorId_9dfx);
+  // Without a capability function the capabilities are unknown
+  EXPECT_EQ(candidates.candidates[1].capabilities, 0U);
+
+  // The GPU deny list matches the first candidate and the allow list the second
+  MemoryBuffer memory_buffer(MemoryBuffer::kDefaultBufferSize, true);
+  ConstructValidFile(memory_buffer);
+  VkQualityPredictionFile file;
+  ASSERT_EQ(file.ParseFileData(memory_buffer.GetPtr(), memory_buffer.GetUsedSize(),
+                               kValidVersion, nullptr),
+            VkQualityPredictionFile::kFileParseResult_Success);
+  DeviceInfo device_info{"notrealbrand", "notrealdevice", "", "", "", kDefaultMinAndroidApi,
+                         0, 0, 0, 0};
+  uint32_t candidate_index = 0;
+  EXPECT_EQ(VkQualityEvaluator::EvaluateCandidates(file, candidates, 0, device_info,
+                                                   candidate_index),
+            kRecommendationVulkanBecausePredictionMatch);
+  EXPECT_EQ(candidate_index, 1U);
+  EXPECT_EQ(device_info.vk_vendor_id, kFakeGpuVendorId_9dfx);
+  EXPECT_EQ(device_info.vk_device_name, kTestStrings[kTestString_Gpu9dfx]);
+
+  // A candidate limited to Vulkan 1.0 is never chosen for a Vulkan recommendation
+  candidates.candidates[1].api_version = VK_API_VERSION_1_0;
+  EXPECT_EQ(VkQualityEvaluator::EvaluateCandidates(file, candidates, 0, device_info,
+                                                   candidate_index),
+            kRecommendationGLESBecausePredictionMatch);
+  EXPECT_EQ(candidate_index, 0U);
+
+  loader.get_capabilities = [](void */*user_data*/, void */*physical_device*/,
+                                uint64_t *capabilities) -> bool {
+    *capabilities = kCapabilityDynamicRendering;
+    return true;
+  };
+  ASSERT_TRUE(VkQualityDeviceProbe::Probe(loader, candidates));
+  EXPECT_EQ(candidates.candidates[1].capabilities,
+            kCapabilityDynamicRendering | VkQualityCapabilities::kCapability_Probed);
+
+  // Capabilities that couldn't be fully read are unknown, not partial
+  loader.get_capabilities = [](void */*user_data*/, void */*physical_device*/,
+                                uint64_t *capabilities) -> bool {
+    *capabilities = kCapabilityDynamicRendering;
+    return false;
+  };
+  ASSERT_TRUE(VkQualityDeviceProbe::Probe(loader, candidates));
+  EXPECT_EQ(candidates.candidates[1].capabilities, 0U);
+
+  // More devices than fit are truncated rather than failing the probe
+  for (uint32_t i = 0; i < VkQualityDeviceProbe::kMaxPhysicalDevices; ++i) {
+    stub_loader.devices.push_back(MakeStubDevice(0x1, "extra", VK_API_VERSION_1_3, 0, i, 0));
+  }
+  ASSERT_TRUE(VkQualityDeviceProbe::Probe(loader, candidates));
+  EXPECT_EQ(candidates.count, VkQualityDeviceProbe::kMaxPhysicalDevices - 1);
+  EXPECT_EQ(candidates.candidates[candidates.count - 1].physical_device_index,
+            VkQualityDeviceProbe::kMaxPhysicalDevices - 1);
+
+  // Errors besides VK_INCOMPLETE fail the probe, an unterminated name is terminated
+  stub_loader.enumerate_result = -3;
+  EXPECT_FALSE(VkQualityDeviceProbe::Probe(loader, candidates));
+  stub_loader.enumerate_result = VkQualityDeviceProbe::kResultSuccess;
+  stub_loader.devices.resize(1);
+  stub_loader.devices[0].queue_flags = 0x1;
+  memset(stub_loader.devices[0].properties.device_name, 'x',
+         sizeof(stub_loader.devices[0].properties.device_name));
+  ASSERT_TRUE(VkQualityDeviceProbe::Probe(loader, candidates));
+  EXPECT_EQ(strlen(candidates.candidates[0].device_name),
+            sizeof(candidates.candidates[0].device_name) - 1);
+}
+
+TEST(VkQualityListWatcherTests, Validity) {
+  char watch_directory[] = "/data/local/tmp/vkqwatchXXXXXX";
+  if (mkdtemp(watch_directory) == nullptr) {
+    strcpy(watch_directory, "/tmp/vkqwatchXXXXXX");
+    if (mkdtemp(watch_directory) == nullptr) {
+      GTEST_SKIP() << "No writable temp directory";
+    }
+  }
+  const std::string directory_string(watch_directory);
+  const std::string temp_path = directory_string + "/download.tmp";
+  const std::string list_path = directory_string + "/watched.vkq";
+
+  std::mutex change_mutex;
+  std::condition_variable change_condition;
+  int change_count = 0;
+  VkQualityListWatcher watcher(directory_string, "watched.vkq", [&]() {
+    std::lock_guard<std::mutex> lock(change_mutex);
+    ++change_count;
+    change_condition.notify_all();
+  });
+  ASSERT_TRUE(watcher.Start());
+
+  // Writing an unrelated file should not trigger a change
+  FILE *fp = fopen(temp_path.c_str(), "wb");
+  ASSERT_NE(fp, nullptr);
+  fwrite(kTooSmallBuffer, sizeof(kTooSmallBuffer), 1, fp);
+  fclose(fp);
+
+  // Renaming it over the watched name should
+  EXPECT_EQ(rename(temp_path.c_str(), list_path.c_str()), 0);
+  {
+    std::unique_lock<std::mutex> lock(change_mutex);
+    change_condition.wait_for(lock, std::chrono::seconds(5), [&]() { return change_count > 0; });
+    EXPECT_EQ(change_count, 1);
+  }
+
+  watcher.Stop();
+  remove(list_path.c_str());
+  rmdir(watch_directory);
+}
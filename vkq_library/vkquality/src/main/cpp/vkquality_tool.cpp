@@ -0,0 +1,168 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Host tool for preparing quality data files for shipping
+
+#include "vkquality_compression.h"
+#include "vkquality_file_writer.h"
+#include "vkquality_patch.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace vkquality;
+
+namespace {
+
+bool ReadWholeFile(const char *path, std::vector<uint8_t> &data) {
+  FILE *fp = fopen(path, "rb");
+  if (fp == nullptr) {
+    fprintf(stderr, "Unable to open %s\n", path);
+    return false;
+  }
+  data.clear();
+  uint8_t read_buffer[64 * 1024];
+  size_t read_size;
+  while ((read_size = fread(read_buffer, 1, sizeof(read_buffer), fp)) > 0) {
+    data.insert(data.end(), read_buffer, read_buffer + read_size);
+  }
+  const bool read_error = ferror(fp) != 0;
+  fclose(fp);
+  if (read_error) {
+    fprintf(stderr, "Unable to read %s\n", path);
+  }
+  return !read_error;
+}
+
+bool WriteWholeFile(const char *path, const void *data, const size_t size) {
+  FILE *fp = fopen(path, "wb");
+  if (fp == nullptr) {
+    fprintf(stderr, "Unable to create %s\n", path);
+    return false;
+  }
+  const bool wrote = (size == 0) || (fwrite(data, size, 1, fp) == 1);
+  fclose(fp);
+  if (!wrote) {
+    fprintf(stderr, "Unable to write %s\n", path);
+  }
+  return wrote;
+}
+
+int Compress(const char *input_path, const char *output_path) {
+  std::vector<uint8_t> file_data;
+  if (!ReadWholeFile(input_path, file_data)) {
+    return EXIT_FAILURE;
+  }
+  if (VkQualityCompression::IsCompressed(file_data.data(), file_data.size())) {
+    fprintf(stderr, "%s is already compressed\n", input_path);
+    return EXIT_FAILURE;
+  }
+  const std::vector<uint8_t> container = VkQualityFileWriter::Compress(file_data);
+  if (container.empty()) {
+    fprintf(stderr, "%s is too small to be a data file\n", input_path);
+    return EXIT_FAILURE;
+  }
+  if (!WriteWholeFile(output_path, container.data(), container.size())) {
+    return EXIT_FAILURE;
+  }
+  printf("%zu -> %zu bytes\n", file_data.size(), container.size());
+  return EXIT_SUCCESS;
+}
+
+int Decompress(const char *input_path, const char *output_path) {
+  std::vector<uint8_t> container;
+  if (!ReadWholeFile(input_path, container)) {
+    return EXIT_FAILURE;
+  }
+  size_t file_size = 0;
+  void *file_data = VkQualityCompression::Decompress(container.data(), container.size(),
+                                                     file_size);
+  if (file_data == nullptr) {
+    fprintf(stderr, "%s is not a valid compressed data file\n", input_path);
+    return EXIT_FAILURE;
+  }
+  const bool wrote = WriteWholeFile(output_path, file_data, file_size);
+  free(file_data);
+  return wrote ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int Diff(const char *base_path, const char *target_path, const char *patch_path) {
+  std::vector<uint8_t> base;
+  std::vector<uint8_t> target;
+  if (!ReadWholeFile(base_path, base) || !ReadWholeFile(target_path, target)) {
+    return EXIT_FAILURE;
+  }
+  const std::vector<uint8_t> patch = VkQualityFileWriter::CreatePatch(base, target);
+  if (patch.empty()) {
+    fprintf(stderr, "%s and %s must both be data files\n", base_path, target_path);
+    return EXIT_FAILURE;
+  }
+  if (!WriteWholeFile(patch_path, patch.data(), patch.size())) {
+    return EXIT_FAILURE;
+  }
+  printf("%zu byte patch for %zu byte target\n", patch.size(), target.size());
+  return EXIT_SUCCESS;
+}
+
+int Patch(const char *base_path, const char *patch_path, const char *output_path) {
+  const VkQualityPatch::PatchResult result =
+      VkQualityPatch::ApplyPatch(base_path, patch_path, output_path);
+  switch (result) {
+    case VkQualityPatch::kPatchResult_Success:
+      return EXIT_SUCCESS;
+    case VkQualityPatch::kPatchResult_Error_MissingFile:
+      fprintf(stderr, "Unable to open %s or %s\n", base_path, patch_path);
+      break;
+    case VkQualityPatch::kPatchResult_Error_InvalidPatch:
+      fprintf(stderr, "%s is not a valid patch\n", patch_path);
+      break;
+    case VkQualityPatch::kPatchResult_Error_BaseMismatch:
+      fprintf(stderr, "%s is not the file %s was created for\n", base_path, patch_path);
+      break;
+    case VkQualityPatch::kPatchResult_Error_TargetMismatch:
+      fprintf(stderr, "Patched file failed verification\n");
+      break;
+    case VkQualityPatch::kPatchResult_Error_WriteFailed:
+      fprintf(stderr, "Unable to write %s\n", output_path);
+      break;
+  }
+  return EXIT_FAILURE;
+}
+
+void PrintUsage() {
+  fprintf(stderr,
+          "usage: vkqtool compress <input.vkq> <output.vkqz>\n"
+          "       vkqtool decompress <input.vkqz> <output.vkq>\n"
+          "       vkqtool diff <base.vkq> <target.vkq> <output.vkqp>\n"
+          "       vkqtool patch <base.vkq> <patch.vkqp> <output.vkq>\n");
+}
+
+} // anonymous namespace
+
+int main(int argc, char **argv) {
+  if (argc == 4 && strcmp(argv[1], "compress") == 0) {
+    return Compress(argv[2], argv[3]);
+  } else if (argc == 4 && strcmp(argv[1], "decompress") == 0) {
+    return Decompress(argv[2], argv[3]);
+  } else if (argc == 5 && strcmp(argv[1], "diff") == 0) {
+    return Diff(argv[2], argv[3], argv[4]);
+  } else if (argc == 5 && strcmp(argv[1], "patch") == 0) {
+    return Patch(argv[2], argv[3], argv[4]);
+  }
+  PrintUsage();
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef VKQUALITY_VERSION_H_
+#define VKQUALITY_VERSION_H_
+
+#define VKQUALITY_MAJOR_VERSION 1
+#define VKQUALITY_MINOR_VERSION 3
+#define VKQUALITY_BUGFIX_VERSION 0
+
+#define VKQUALITY_GENERATE_PACKED_VERSION(MAJOR, MINOR, BUGFIX) \
+    ((MAJOR << 16) | (MINOR << 8) | (BUGFIX))
+
+#define VKQUALITY_PACKED_VERSION                               \
+    VKQUALITY_GENERATE_PACKED_VERSION(VKQUALITY_MAJOR_VERSION, \
+                                      VKQUALITY_MINOR_VERSION, \
+                                      VKQUALITY_BUGFIX_VERSION)
+
+#define VKQUALITY_VERSION_CONCAT_NX(PREFIX, MAJOR, MINOR, BUGFIX) \
+    PREFIX##_##MAJOR##_##MINOR##_##BUGFIX
+#define VKQUALITY_VERSION_CONCAT(PREFIX, MAJOR, MINOR, BUGFIX) \
+    VKQUALITY_VERSION_CONCAT_NX(PREFIX, MAJOR, MINOR, BUGFIX)
+#define VKQUALITY_VERSION_SYMBOL                                           \
+    VKQUALITY_VERSION_CONCAT(VKQUALITY_version, VKQUALITY_MAJOR_VERSION, \
+                              VKQUALITY_MINOR_VERSION,                     \
+                              VKQUALITY_BUGFIX_VERSION)
+
+#endif // VKQUALITY_VERSION_H_
@@ -15,7 +15,9 @@
  */
 
 #include "vulkan_util.h"
+#include "vkquality_evaluator.h"
 #include <dlfcn.h>
+#include <string.h>
 #include <vector>
 #define VK_USE_PLATFORM_ANDROID_KHR
 #define VK_NO_PROTOTYPES
@@ -23,6 +25,13 @@
 
 namespace vkquality {
 
+static_assert(VkQualityEvaluator::kMinimumVulkanVersion == VK_API_VERSION_1_1,
+              "Minimum recommended Vulkan version mismatch");
+static_assert(VkQualityDeviceProbe::kQueueGraphicsBit == VK_QUEUE_GRAPHICS_BIT &&
+              VkQualityDeviceProbe::kResultSuccess == VK_SUCCESS &&
+              VkQualityDeviceProbe::kResultIncomplete == VK_INCOMPLETE,
+              "Device probe constant mismatch");
+
 uint32_t VulkanUtil::GetVulkanApiVersionForApiLevel(const int device_api_level) {
   if (device_api_level >= kMinimum_vk13_api_level) {
     return VK_API_VERSION_1_3;
@@ -45,10 +54,147 @@ vkQualityInitResult VulkanUtil::CopyDeviceVulkanInfo(DeviceInfo &device_info,
     device_info.vk_device_id = device_properties.deviceID;
     device_info.vk_vendor_id = device_properties.vendorID;
     device_info.vk_device_name = device_properties.deviceName;
+    // Capabilities aren't part of the properties, and no capability rule matches
+    device_info.vk_capabilities = 0;
     return kSuccess;
 }
 
-vkQualityInitResult VulkanUtil::GetDeviceVulkanInfo(DeviceInfo &device_info) {
+namespace {
+
+// Entry points called by the probe loader functions below
+struct ProbeFunctions {
+  VkInstance vk_instance;
+  PFN_vkEnumeratePhysicalDevices vkEnumeratePhysicalDevices;
+  PFN_vkGetPhysicalDeviceQueueFamilyProperties vkGetPhysicalDeviceQueueFamilyProperties;
+  PFN_vkGetPhysicalDeviceProperties vkGetPhysicalDeviceProperties;
+  PFN_vkGetPhysicalDeviceFeatures vkGetPhysicalDeviceFeatures;
+  // Null if the loader predates Vulkan 1.1
+  PFN_vkGetPhysicalDeviceFeatures2 vkGetPhysicalDeviceFeatures2;
+  PFN_vkEnumerateDeviceExtensionProperties vkEnumerateDeviceExtensionProperties;
+  uint32_t instance_api_version;
+};
+
+int32_t EnumeratePhysicalDevices(void *user_data, uint32_t *device_count,
+                                 void **physical_devices) {
+  const ProbeFunctions &functions = *reinterpret_cast<const ProbeFunctions *>(user_data);
+  return functions.vkEnumeratePhysicalDevices(
+      functions.vk_instance, device_count, reinterpret_cast<VkPhysicalDevice *>(physical_devices));
+}
+
+void GetQueueFamilyFlags(void *user_data, void *physical_device, uint32_t *family_count,
+                         uint32_t *queue_flags) {
+  const ProbeFunctions &functions = *reinterpret_cast<const ProbeFunctions *>(user_data);
+  VkQueueFamilyProperties queue_families[VkQualityDeviceProbe::kMaxQueueFamilies];
+  if (*family_count > VkQualityDeviceProbe::kMaxQueueFamilies) {
+    *family_count = VkQualityDeviceProbe::kMaxQueueFamilies;
+  }
+  functions.vkGetPhysicalDeviceQueueFamilyProperties(
+      reinterpret_cast<VkPhysicalDevice>(physical_device), family_count, queue_families);
+  for (uint32_t i = 0; i < *family_count; ++i) {
+    queue_flags[i] = queue_families[i].queueFlags;
+  }
+}
+
+void GetDeviceProperties(void *user_data, void *physical_device,
+                         VkQualityDeviceCandidate &candidate) {
+  const ProbeFunctions &functions = *reinterpret_cast<const ProbeFunctions *>(user_data);
+  VkPhysicalDeviceProperties device_properties{};
+  functions.vkGetPhysicalDeviceProperties(reinterpret_cast<VkPhysicalDevice>(physical_device),
+                                          &device_properties);
+  candidate.api_version = device_properties.apiVersion;
+  candidate.driver_version = device_properties.driverVersion;
+  candidate.vendor_id = device_properties.vendorID;
+  candidate.device_id = device_properties.deviceID;
+  candidate.device_type = device_properties.deviceType;
+  static_assert(sizeof(candidate.device_name) == VK_MAX_PHYSICAL_DEVICE_NAME_SIZE,
+                "Device name size mismatch");
+  memcpy(candidate.device_name, device_properties.deviceName, sizeof(candidate.device_name));
+}
+
+bool GetCapabilities(void *user_data, void *physical_device, uint64_t *capabilities) {
+  const ProbeFunctions &functions = *reinterpret_cast<const ProbeFunctions *>(user_data);
+  const VkPhysicalDevice vk_physical_device = reinterpret_cast<VkPhysicalDevice>(physical_device);
+  VkPhysicalDeviceProperties device_properties{};
+  functions.vkGetPhysicalDeviceProperties(vk_physical_device, &device_properties);
+
+  // The Vulkan 1.1 features are only reported through vkGetPhysicalDeviceFeatures2,
+  // which needs both the instance and the device to be 1.1
+  VkPhysicalDeviceSamplerYcbcrConversionFeatures ycbcr_features{};
+  ycbcr_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SAMPLER_YCBCR_CONVERSION_FEATURES;
+  VkPhysicalDeviceMultiviewFeatures multiview_features{};
+  multiview_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+  multiview_features.pNext = &ycbcr_features;
+  VkPhysicalDeviceShaderDrawParametersFeatures draw_parameters_features{};
+  draw_parameters_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_DRAW_PARAMETERS_FEATURES;
+  draw_parameters_features.pNext = &multiview_features;
+  VkPhysicalDevice16BitStorageFeatures storage_16bit_features{};
+  storage_16bit_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_16BIT_STORAGE_FEATURES;
+  storage_16bit_features.pNext = &draw_parameters_features;
+  VkPhysicalDeviceFeatures2 features{};
+  features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features.pNext = &storage_16bit_features;
+  if (functions.vkGetPhysicalDeviceFeatures2 != nullptr &&
+      functions.instance_api_version >= VK_API_VERSION_1_1 &&
+      device_properties.apiVersion >= VK_API_VERSION_1_1) {
+    functions.vkGetPhysicalDeviceFeatures2(vk_physical_device, &features);
+  } else {
+    functions.vkGetPhysicalDeviceFeatures(vk_physical_device, &features.features);
+  }
+
+  *capabilities = 0;
+  auto add_feature = [capabilities](const VkBool32 feature,
+                                    const VkQualityCapabilities::CapabilityBit capability) {
+    if (feature == VK_TRUE) {
+      *capabilities |= VkQualityCapabilities::GetBit(capability);
+    }
+  };
+  const VkPhysicalDeviceFeatures &core_features = features.features;
+  add_feature(core_features.textureCompressionETC2,
+              VkQualityCapabilities::kCapability_TextureCompressionETC2);
+  add_feature(core_features.textureCompressionASTC_LDR,
+              VkQualityCapabilities::kCapability_TextureCompressionASTC_LDR);
+  add_feature(core_features.samplerAnisotropy,
+              VkQualityCapabilities::kCapability_SamplerAnisotropy);
+  add_feature(core_features.shaderInt16, VkQualityCapabilities::kCapability_ShaderInt16);
+  add_feature(core_features.multiDrawIndirect,
+              VkQualityCapabilities::kCapability_MultiDrawIndirect);
+  add_feature(core_features.drawIndirectFirstInstance,
+              VkQualityCapabilities::kCapability_DrawIndirectFirstInstance);
+  add_feature(core_features.fragmentStoresAndAtomics,
+              VkQualityCapabilities::kCapability_FragmentStoresAndAtomics);
+  add_feature(ycbcr_features.samplerYcbcrConversion,
+              VkQualityCapabilities::kCapability_SamplerYcbcrConversion);
+  add_feature(multiview_features.multiview, VkQualityCapabilities::kCapability_Multiview);
+  add_feature(draw_parameters_features.shaderDrawParameters,
+              VkQualityCapabilities::kCapability_ShaderDrawParameters);
+  add_feature(storage_16bit_features.storageBuffer16BitAccess,
+              VkQualityCapabilities::kCapability_StorageBuffer16BitAccess);
+
+  // The extension count has no upper bound, the list is allocated once per device
+  // probe. A partial list would read as missing extensions, so any failure leaves
+  // the capabilities unknown.
+  uint32_t extension_count = 0;
+  if (functions.vkEnumerateDeviceExtensionProperties(vk_physical_device, nullptr,
+                                                     &extension_count, nullptr) != VK_SUCCESS) {
+    return false;
+  }
+  std::vector<VkExtensionProperties> extensions(extension_count);
+  if (functions.vkEnumerateDeviceExtensionProperties(
+          vk_physical_device, nullptr, &extension_count, extensions.data()) != VK_SUCCESS) {
+    return false;
+  }
+  for (uint32_t i = 0; i < extension_count; ++i) {
+    *capabilities |= VkQualityCapabilities::GetExtensionCapability(extensions[i].extensionName);
+  }
+  return true;
+}
+
+} // anonymous namespace
+
+vkQualityInitResult VulkanUtil::GetDeviceVulkanInfo(DeviceInfo &device_info,
+                                                    VkQualityDeviceCandidates &candidates) {
+  candidates.count = 0;
   void *lib_vulkan = dlopen("libvulkan.so", RTLD_NOW | RTLD_LOCAL);
   if (lib_vulkan == nullptr) {
     return kErrorNoVulkan;
@@ -56,34 +202,27 @@ vkQualityInitResult VulkanUtil::GetDeviceVulkanInfo(DeviceInfo &device_info) {
 
   auto vkCreateInstance = reinterpret_cast<PFN_vkCreateInstance>(
       dlsym(lib_vulkan, "vkCreateInstance"));
-  if (vkCreateInstance == nullptr) {
-    dlclose(lib_vulkan);
-    return kErrorNoVulkan;
-  }
   auto vkDestroyInstance = reinterpret_cast<PFN_vkDestroyInstance>(
       dlsym(lib_vulkan, "vkDestroyInstance"));
-  if (vkDestroyInstance == nullptr) {
-    dlclose(lib_vulkan);
-    return kErrorNoVulkan;
-  }
-  auto vkEnumeratePhysicalDevices =
-      reinterpret_cast<PFN_vkEnumeratePhysicalDevices>(
-          dlsym(lib_vulkan, "vkEnumeratePhysicalDevices"));
-  if (vkEnumeratePhysicalDevices == nullptr) {
-    dlclose(lib_vulkan);
-    return kErrorNoVulkan;
-  }
-  auto vkGetPhysicalDeviceQueueFamilyProperties =
+  ProbeFunctions functions{};
+  functions.vkEnumeratePhysicalDevices = reinterpret_cast<PFN_vkEnumeratePhysicalDevices>(
+      dlsym(lib_vulkan, "vkEnumeratePhysicalDevices"));
+  functions.vkGetPhysicalDeviceQueueFamilyProperties =
       reinterpret_cast<PFN_vkGetPhysicalDeviceQueueFamilyProperties>(
           dlsym(lib_vulkan, "vkGetPhysicalDeviceQueueFamilyProperties"));
-  if (vkGetPhysicalDeviceQueueFamilyProperties == nullptr) {
-    dlclose(lib_vulkan);
-    return kErrorNoVulkan;
-  }
-  auto vkGetPhysicalDeviceProperties =
-      reinterpret_cast<PFN_vkGetPhysicalDeviceProperties>(
-          dlsym(lib_vulkan, "vkGetPhysicalDeviceProperties"));
-  if (vkGetPhysicalDeviceProperties == nullptr) {
+  functions.vkGetPhysicalDeviceProperties = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties>(
+      dlsym(lib_vulkan, "vkGetPhysicalDeviceProperties"));
+  functions.vkGetPhysicalDeviceFeatures = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures>(
+      dlsym(lib_vulkan, "vkGetPhysicalDeviceFeatures"));
+  functions.vkGetPhysicalDeviceFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2>(
+      dlsym(lib_vulkan, "vkGetPhysicalDeviceFeatures2"));
+  functions.vkEnumerateDeviceExtensionProperties =
+      reinterpret_cast<PFN_vkEnumerateDeviceExtensionProperties>(
+          dlsym(lib_vulkan, "vkEnumerateDeviceExtensionProperties"));
+  if (vkCreateInstance == nullptr || vkDestroyInstance == nullptr ||
+      functions.vkEnumeratePhysicalDevices == nullptr ||
+      functions.vkGetPhysicalDeviceQueueFamilyProperties == nullptr ||
+      functions.vkGetPhysicalDeviceProperties == nullptr) {
     dlclose(lib_vulkan);
     return kErrorNoVulkan;
   }
@@ -95,66 +234,41 @@ vkQualityInitResult VulkanUtil::GetDeviceVulkanInfo(DeviceInfo &device_info) {
   app_info.pEngineName = "AGDK";
   app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
   app_info.apiVersion = VulkanUtil::GetVulkanApiVersionForApiLevel(device_info.api_level);
+  functions.instance_api_version = app_info.apiVersion;
 
   VkInstanceCreateInfo create_info{};
   create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
   create_info.pApplicationInfo = &app_info;
   create_info.enabledExtensionCount = 0;
   create_info.ppEnabledExtensionNames = nullptr;
-  create_info.pApplicationInfo = &app_info;
   create_info.enabledLayerCount = 0;
   create_info.ppEnabledLayerNames = nullptr;
   create_info.pNext = nullptr;
 
-  VkInstance vk_instance;
-  VkResult result = vkCreateInstance(&create_info, nullptr, &vk_instance);
+  VkResult result = vkCreateInstance(&create_info, nullptr, &functions.vk_instance);
   if (result != VK_SUCCESS) {
     dlclose(lib_vulkan);
     return kErrorNoVulkan;
   }
 
-  uint32_t device_count = 0;
-  result = vkEnumeratePhysicalDevices(vk_instance, &device_count, nullptr);
-  if (result != VK_SUCCESS || device_count == 0) {
-    vkDestroyInstance(vk_instance, nullptr);
-    dlclose(lib_vulkan);
-    return kErrorNoVulkan;
+  VkQualityDeviceProbe::Loader loader;
+  loader.user_data = &functions;
+  loader.enumerate_physical_devices = EnumeratePhysicalDevices;
+  loader.get_queue_family_flags = GetQueueFamilyFlags;
+  loader.get_device_properties = GetDeviceProperties;
+  // Without these the candidates have no capabilities, and no capability rule matches
+  if (functions.vkGetPhysicalDeviceFeatures != nullptr &&
+      functions.vkEnumerateDeviceExtensionProperties != nullptr) {
+    loader.get_capabilities = GetCapabilities;
   }
-  std::vector<VkPhysicalDevice> physical_devices(device_count);
-  vkEnumeratePhysicalDevices(vk_instance, &device_count, physical_devices.data());
-
-  bool found_graphics_device = false;
-  for (VkPhysicalDevice physical_device : physical_devices) {
-    uint32_t queue_family_count = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
-
-    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
-    vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count,
-                                             queue_families.data());
-
-    for (const auto &queue_family : queue_families) {
-      if (queue_family.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-        found_graphics_device = true;
-        break;
-      }
-    }
-    if (found_graphics_device) {
-      VkPhysicalDeviceProperties device_properties{};
-      vkGetPhysicalDeviceProperties(physical_device, &device_properties);
-      device_info.vk_api_version = device_properties.apiVersion;
-      device_info.vk_driver_version = device_properties.driverVersion;
-      device_info.vk_device_id = device_properties.deviceID;
-      device_info.vk_vendor_id = device_properties.vendorID;
-      device_info.vk_device_name = device_properties.deviceName;
-      break;
-    }
-  }
-  vkDestroyInstance(vk_instance, nullptr);
+  const bool found_graphics_device = VkQualityDeviceProbe::Probe(loader, candidates);
+  vkDestroyInstance(functions.vk_instance, nullptr);
 
   dlclose(lib_vulkan);
   if (!found_graphics_device) {
     return kErrorNoVulkan;
   }
+  VkQualityDeviceProbe::CopyCandidate(candidates.candidates[0], device_info);
   return kSuccess;
 }
 
@@ -162,8 +276,4 @@ int VulkanUtil::GetFutureApiLevelRecommendation() {
   return kMinimum_vk_always_api_level;
 }
 
-uint32_t VulkanUtil::GetMinimumRecommendedVulkanVersion() {
-  return VK_API_VERSION_1_1;
-}
-
 } // namespace vkquality
\ No newline at end of file
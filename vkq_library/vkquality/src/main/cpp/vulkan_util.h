@@ -17,6 +17,7 @@
 #ifndef VKQUALITY_VULKAN_UTIL_H_
 #define VKQUALITY_VULKAN_UTIL_H_
 
+#include "vkquality_device_probe.h"
 #include "vkquality_manager.h"
 
 namespace vkquality {
@@ -25,8 +26,10 @@ class VulkanUtil {
  public:
   static vkQualityInitResult CopyDeviceVulkanInfo(DeviceInfo &device_info,
       void *vk_physical_device_properties);
-  static vkQualityInitResult GetDeviceVulkanInfo(DeviceInfo &device_info);
-  static uint32_t GetMinimumRecommendedVulkanVersion();
+  // Probes every physical device into candidates, device_info receives the
+  // Vulkan fields of the first candidate
+  static vkQualityInitResult GetDeviceVulkanInfo(DeviceInfo &device_info,
+                                                 VkQualityDeviceCandidates &candidates);
   static uint32_t GetVulkanApiVersionForApiLevel(const int device_api_level);
   static int GetFutureApiLevelRecommendation();
 
@@ -19,6 +19,8 @@ import android.content.Context;
 import android.content.res.AssetManager;
 import android.util.Log;
 
+import java.nio.ByteBuffer;
+
 public class VKQuality {
     // Used to load the 'vkqualitytest' library on application startup.
     static {
@@ -28,6 +30,8 @@ public class VKQuality {
     public static final int INIT_FLAG_SKIP_STARTUP_MITIGATION = 1;
     public static final int INIT_FLAG_GLES_ONLY_STARTUP_MITIGATION_DEVICES = 2;
     public static final int INIT_FLAG_SKIP_DRIVER_FINGERPRINT_CHECK = 4;
+    public static final int INIT_FLAG_WATCH_STORAGE_PATH = 8;
+    public static final int INIT_FLAG_SKIP_ASSET_CHECKSUM = 32;
 
     public static final int INIT_SUCCESS = 0;
     public static final int ERROR_INITIALIZATION_FAILURE = -1;
@@ -66,25 +70,34 @@ public class VKQuality {
         String dataFilename = customDataFilename.isEmpty() ?
                 DEFAULT_QUALITY_FILE : customDataFilename;
 
-        if ((mFlags & INIT_FLAG_SKIP_STARTUP_MITIGATION) == 0)
-        {
-            // Startup mitigation path to check against calling vkCreateInstance
-            // on devices which may crash
-            RunStartupMitigation();
-            if (mStartupMitigation)
-            {
-                return INIT_SUCCESS;
-            }
-        }
-        else
+        if (CheckStartupMitigation())
         {
-            Log.d("VKQUALITY", "Skipping startup mitigation because of flag");
+            return INIT_SUCCESS;
         }
         return startVkQualityFlags(mAppContext.getResources().getAssets(),
                 mAppContext.getFilesDir().getAbsolutePath(),
                 dataFilename, mFlags);
     }
 
+    // Start using quality data file contents held in a direct ByteBuffer, from its
+    // position to its limit. The contents are used in place without copying, so the
+    // buffer contents must not be modified until this returns.
+    public int StartVkQualityFromBuffer(ByteBuffer dataBuffer, int flags)
+    {
+        if (!dataBuffer.isDirect())
+        {
+            return ERROR_INVALID_DATA_FILE;
+        }
+        mFlags = flags;
+
+        if (CheckStartupMitigation())
+        {
+            return INIT_SUCCESS;
+        }
+        return startVkQualityFromBuffer(dataBuffer, dataBuffer.position(),
+                dataBuffer.remaining(), mAppContext.getFilesDir().getAbsolutePath(), mFlags);
+    }
+
     public void StopVkQuality()
     {
         if (!mStartupMitigation) {
@@ -92,6 +105,15 @@ public class VKQuality {
         }
     }
 
+    public int ReloadVkQuality() {
+        if (mStartupMitigation)
+        {
+            // Mitigation recommendations don't depend on the quality data file
+            return INIT_SUCCESS;
+        }
+        return reloadVkQuality();
+    }
+
     public int GetVkQuality() {
         if (mStartupMitigation)
         {
@@ -100,6 +122,19 @@ public class VKQuality {
         return getVkQuality();
     }
 
+    private boolean CheckStartupMitigation()
+    {
+        if ((mFlags & INIT_FLAG_SKIP_STARTUP_MITIGATION) == 0)
+        {
+            // Startup mitigation path to check against calling vkCreateInstance
+            // on devices which may crash
+            RunStartupMitigation();
+            return mStartupMitigation;
+        }
+        Log.d("VKQUALITY", "Skipping startup mitigation because of flag");
+        return false;
+    }
+
     private void RunStartupMitigation()
     {
         // Certain device/SoC combinations are experiencing crashes when attempting
@@ -133,6 +168,11 @@ public class VKQuality {
     public native int startVkQualityFlags(AssetManager jasset_manager, String storage_path,
                                      String data_filename, int flags);
 
+    public native int startVkQualityFromBuffer(ByteBuffer data_buffer, int offset, int length,
+                                               String storage_path, int flags);
+
+    public native int reloadVkQuality();
+
     public native void stopVkQuality();
 
     public native int getVkQuality();